@@ -3,13 +3,40 @@
 #include <Logger.h>
 #include <imgui_internal.h>
 #include "Renderer/BatchRenderer.h"
+#include "Renderer/ImageWriter.h"
+#include "Renderer/ThreadPool.h"
+#include "Renderer/TextureManager.h"
+#include "Renderer/ShaderWatcher.h"
+#include "Renderer/RenderCommand.h"
+#include <chrono>
+#include <cstdlib>
 #include <Events/Input.h>
 
 #define MAX_SELECTED_OBJECT_ID 10000
+// UI frames to run after an input event before going back to sleep
+#define FRAMES_AFTER_EVENT 3
 namespace GUI {
 	bool Layer::m_updateLayers = true;
 
-	int ViewPort::s_selectedObject = -1;
+	std::atomic<int> ViewPort::s_selectedObject = -1;
+
+	namespace Utils {
+
+		// Attachments of every viewport in a fixed order, resizing recreates the ones the UI of a frame refers to
+		static std::vector<uint32_t> GetViewPortTextures(const std::vector<ViewPort>& viewPorts)
+		{
+			std::vector<uint32_t> textures;
+			for (const ViewPort& v : viewPorts) {
+				for (const auto& framebuffer : { v.Framebuffer, v.JumpFloodICFramebuffer, v.JumpFloodFramebuffer }) {
+					for (uint32_t i = 0; i < (uint32_t)framebuffer->GetColorAttachmentCount(); i++)
+						textures.push_back(framebuffer->GetColorAttachmentRendererID(i));
+					textures.push_back(framebuffer->GetDepthAttachmentRendererID());
+				}
+			}
+			return textures;
+		}
+
+	}
 
 	AbstractApplication* AbstractApplication::s_Instance = nullptr;
 
@@ -25,10 +52,24 @@ namespace GUI {
 		if (!m_Specification.WorkingDirectory.empty())
 			std::filesystem::current_path(m_Specification.WorkingDirectory);
 
-		m_Window = Application::Window::Create(Application::WindowProps(m_Specification.Name));
-		m_Window->SetEventCallback(APP_BIND_EVENT_FN(AbstractApplication::OnEvent));
+		if (m_Specification.Headless)
+		{
+			m_HeadlessContext = Graphics::GraphicsContext::CreateHeadless();
+			if (!m_HeadlessContext)
+			{
+				LOG_FATAL_STREAM << "Headless rendering is not available in this build, configure with GUI_HEADLESS_EGL=ON";
+				std::exit(EXIT_FAILURE);
+			}
+			m_HeadlessContext->Init();
+		}
+		else
+		{
+			m_Window = Application::Window::Create(Application::WindowProps(m_Specification.Name));
+			m_Window->SetEventCallback(APP_BIND_EVENT_FN(AbstractApplication::OnEvent));
+		}
 
 		Graphics::Renderer::Init();
+		Graphics::TextureManager::Init();
 
 		m_fbSpec.Attachments = {
 			Graphics::FramebufferTextureFormat::RGBA8,
@@ -36,35 +77,80 @@ namespace GUI {
 			Graphics::FramebufferTextureFormat::RGBA8,
 			Graphics::FramebufferTextureFormat::Depth,
 		};
-		m_fbSpec.Width = 1280;
-		m_fbSpec.Height = 720;
+		m_fbSpec.Width = m_Specification.Headless ? m_Specification.HeadlessWidth : 1280;
+		m_fbSpec.Height = m_Specification.Headless ? m_Specification.HeadlessHeight : 720;
 
 		m_ViewPorts.push_back(ViewPort(m_fbSpec, CameraType::ThreeD ,m_viewPortCount)); // Default viewport
 		m_viewPortCount++;
 
-		m_CameraBuffer = Graphics::UniformBuffer::Create(sizeof(SceneDataUBO), 0);
+		// Room for a few viewports per frame, grows when more are open
+		m_SceneDataBuffer = Graphics::UniformRingBuffer::Create(sizeof(SceneDataUBO) * 4, 0);
 
+		if (m_Specification.WatchShaders && !m_Specification.Headless)
+			Graphics::ShaderWatcher::Init("./Resources/Shaders");
+
+		// Decodes in the background, shows nothing until it is uploaded
+		m_font = Graphics::TextureManager::Get().Load("./Resources/Textures/FontAtlas.png");
 		this->CreateShaders();
 		Graphics::BatchRenderer::Init();
 
-		m_ImGuiHandler = new ImGuiHandler((GLFWwindow*)m_Window->GetNativeWindow(), "#version 330");
+		if (!m_Specification.Headless)
+			m_ImGuiHandler = new ImGuiHandler((GLFWwindow*)m_Window->GetNativeWindow(), "#version 330");
 	}
 
 	AbstractApplication::~AbstractApplication()
 	{
 		HZ_PROFILE_FUNCTION();
 
+		Graphics::ShaderWatcher::Shutdown();
+		Graphics::TextureManager::Shutdown();
 		Graphics::Renderer::Shutdown();
 	}
 
-	void AbstractApplication::CreateShaders() {
-		m_font = Graphics::Texture2D::Create("./Resources/Textures/FontAtlas.png");
-		m_gridShader = Graphics::Shader::Create("./Resources/Shaders/Grid.glsl", true);
-		m_gridShader2D = Graphics::Shader::Create("./Resources/Shaders/Grid2D.glsl", true);
-		m_JumpFlood_init = Graphics::Shader::Create("./Resources/Shaders/JumpFloodInit.glsl", true);
-		m_JumpFlood_init2 = Graphics::Shader::Create("./Resources/Shaders/JumpFloodInit2.glsl", true);
-		m_JumpFlood_pass = Graphics::Shader::Create("./Resources/Shaders/JumpFloodPass.glsl", true);
-		m_JumpFlood_composite = Graphics::Shader::Create("./Resources/Shaders/JumpFloodComposite.glsl", true);
+	void AbstractApplication::CreateShaders(bool recompile) {
+		Graphics::ShaderLibrary& library = Graphics::Renderer::GetShaderLibrary();
+		m_gridShader = library.GetVariant("./Resources/Shaders/Grid.glsl", {}, recompile);
+		m_gridShader2D = library.GetVariant("./Resources/Shaders/Grid.glsl", Graphics::ShaderVariant().Define("GRID_2D"), recompile);
+		m_gridLinesShader = library.GetVariant("./Resources/Shaders/GridLines.glsl", {}, recompile);
+		m_gridLabelsShader = library.GetVariant("./Resources/Shaders/GridLines.glsl", Graphics::ShaderVariant().Define("GRID_LABELS"), recompile);
+		// Seeded from the selection buffer
+		m_JumpFlood_init = library.GetVariant("./Resources/Shaders/JumpFloodInit.glsl", Graphics::ShaderVariant().Constant(0, true), recompile);
+		m_JumpFlood_pass = library.GetVariant("./Resources/Shaders/JumpFloodPass.glsl", {}, recompile);
+		m_JumpFlood_composite = library.GetVariant("./Resources/Shaders/JumpFloodComposite.glsl", {}, recompile);
+
+		for (auto* shader : { &m_gridShader, &m_gridShader2D, &m_gridLinesShader, &m_gridLabelsShader, &m_JumpFlood_init, &m_JumpFlood_pass, &m_JumpFlood_composite })
+			Graphics::ShaderWatcher::Watch(*shader);
+
+		// Full screen passes, the vertices come from gl_VertexID so the layouts are empty
+		auto createPipeline = [](const Graphics::Ref<Graphics::Shader>& shader, bool depthTest, const Graphics::FramebufferSpecification& target, Graphics::PrimitiveTopology topology = Graphics::PrimitiveTopology::Triangles) {
+			Graphics::PipelineSpecification spec;
+			spec.Shader = shader;
+			spec.Topology = topology;
+			spec.Depth.TestEnable = depthTest;
+			spec.SetTargetFormats(target);
+			return Graphics::Pipeline::Create(spec);
+		};
+		Graphics::FramebufferSpecification jumpFloodInitTarget, jumpFloodTarget;
+		jumpFloodInitTarget.Attachments = { Graphics::FramebufferTextureFormat::RGBA8, Graphics::FramebufferTextureFormat::Depth };
+		jumpFloodTarget.Attachments = { Graphics::FramebufferTextureFormat::RGBA8 };
+
+		m_gridPipeline = createPipeline(m_gridShader, true, m_fbSpec);
+		m_gridPipeline2D = createPipeline(m_gridShader2D, false, m_fbSpec);
+		m_gridLinesPipeline = createPipeline(m_gridLinesShader, false, m_fbSpec, Graphics::PrimitiveTopology::Lines);
+		m_gridLabelsPipeline = createPipeline(m_gridLabelsShader, false, m_fbSpec);
+		m_gridVertexArray = Graphics::VertexArray::Create();
+		m_JumpFloodInitPipeline = createPipeline(m_JumpFlood_init, true, jumpFloodInitTarget);
+		m_JumpFloodPassPipeline = createPipeline(m_JumpFlood_pass, true, jumpFloodTarget);
+		m_JumpFloodCompositePipeline = createPipeline(m_JumpFlood_composite, true, m_fbSpec);
+	}
+
+	bool AbstractApplication::AreShadersReady()
+	{
+		// Poll every shader so all of them make progress on linking
+		bool ready = Graphics::BatchRenderer::IsReady();
+		for (auto* shader : { &m_gridShader, &m_gridShader2D, &m_gridLinesShader, &m_gridLabelsShader, &m_JumpFlood_init, &m_JumpFlood_pass, &m_JumpFlood_composite })
+			ready &= (*shader)->IsReady();
+		return ready;
 	}
 
 	void AbstractApplication::PushLayer(Layer* layer)
@@ -93,6 +179,129 @@ namespace GUI {
 		std::scoped_lock<std::mutex> lock(m_MainThreadQueueMutex);
 
 		m_MainThreadQueue.emplace_back(function);
+		if (m_Window)
+			m_Window->PostEmptyEvent();
+	}
+
+	void AbstractApplication::SubmitToRenderThread(const std::function<void()>& function)
+	{
+		if (!m_RenderThread.joinable() || std::this_thread::get_id() == m_RenderThread.get_id())
+		{
+			function();
+			return;
+		}
+
+		std::scoped_lock<std::mutex> lock(m_RenderThreadQueueMutex);
+		m_RenderThreadQueue.emplace_back(function);
+	}
+
+	void AbstractApplication::RequestRedraw()
+	{
+		m_RedrawRequested = true;
+		if (m_Window)
+			m_Window->PostEmptyEvent();
+	}
+
+	void AbstractApplication::MarkAllViewPortsDirty()
+	{
+		for (ViewPort& viewPort : m_ViewPorts)
+			viewPort.MarkDirty();
+	}
+
+	RenderStatistics AbstractApplication::GetRenderStatistics()
+	{
+		std::scoped_lock<std::mutex> lock(m_RenderStatsMutex);
+		return m_RenderStats;
+	}
+
+	bool AbstractApplication::IsRedrawPending()
+	{
+		if (m_FramesToRender > 0 || m_RedrawRequested)
+			return true;
+
+		if (m_RenderThread.joinable())
+		{
+			if (m_RenderThreadBusy)
+				return true;
+		}
+		else
+		{
+			// Keep the loop running until background shader compiles have been picked up
+			if (!AreShadersReady() || Graphics::ShaderWatcher::IsReloadPending())
+				return true;
+
+			// Same for textures still decoding
+			if (Graphics::TextureManager::Get().GetPendingCount())
+				return true;
+		}
+
+		std::scoped_lock<std::mutex> sceneLock(m_SceneMutex);
+		if (std::any_of(m_ViewPorts.begin(), m_ViewPorts.end(), [](const ViewPort& v) { return v.Dirty || v.Recording; }))
+			return true;
+
+		if (std::any_of(m_LayerStack.begin(), m_LayerStack.end(), [](Layer* layer) { return layer->IsUpdateLayer(); }))
+			return true;
+
+		std::scoped_lock<std::mutex> lock(m_MainThreadQueueMutex);
+		return !m_MainThreadQueue.empty();
+	}
+
+	void AbstractApplication::DrawGridLines(const ViewPort& v)
+	{
+		const SceneDataUBO& scene = v.uboDataScene;
+		const float minor = scene.gridMinor, major = scene.gridMajor;
+		if (minor <= 0.0f || major <= 0.0f)
+			return;
+
+		// The camera bounds are relative to its position
+		const glm::vec4 bounds = {
+			scene.cameraPos.x + scene.gridMinMax.x, scene.cameraPos.y + scene.gridMinMax.z,
+			scene.cameraPos.x + scene.gridMinMax.y, scene.cameraPos.y + scene.gridMinMax.w };
+		// Index of the first multiple of spacing in [lo, hi] and how many there are
+		auto range = [](float lo, float hi, float spacing) {
+			const float first = std::ceil(lo / spacing);
+			return glm::vec2(first, std::max(std::floor(hi / spacing) - first + 1.0f, 0.0f));
+		};
+
+		static constexpr Graphics::ShaderUniformName s_Lines("u_Lines"), s_Bounds("u_Bounds"), s_Spacing("u_Spacing"),
+			s_MajorEvery("u_MajorEvery"), s_MinorAlpha("u_MinorAlpha"), s_FontSize("u_FontSize");
+
+		const glm::vec2 x = range(bounds.x, bounds.z, minor), y = range(bounds.y, bounds.w, minor);
+		// Thin lines fade out between 2 and 8 pixels apart
+		const float minorPixels = scene.gridLod.x > 0.0f ? minor / scene.gridLod.x : 8.0f;
+		m_gridLinesPipeline->Bind();
+		m_gridLinesShader->SetFloat4(s_Lines, { x.x, y.x, x.y, y.y });
+		m_gridLinesShader->SetFloat4(s_Bounds, bounds);
+		m_gridLinesShader->SetFloat(s_Spacing, minor);
+		m_gridLinesShader->SetFloat(s_MajorEvery, std::round(major / minor));
+		m_gridLinesShader->SetFloat(s_MinorAlpha, glm::clamp((minorPixels - 2.0f) / 6.0f, 0.0f, 1.0f));
+		Graphics::RenderCommand::DrawLinesInstancedBaseInstance(m_gridVertexArray, 0, 2, (uint32_t)(x.y + y.y), 0);
+
+		// Labels of every major line along the axes that are on screen, one extra on the low side because a label
+		// reaches past its line
+		const float fontSize = major * 2.0f;
+		const float reach = fontSize * 5.0f / 32.0f;
+		const glm::vec2 labelsX = bounds.y - reach <= 0.0f && bounds.w >= 0.0f ? range(bounds.x - reach, bounds.z, major) : glm::vec2(0.0f);
+		const glm::vec2 labelsY = bounds.x - reach <= 0.0f && bounds.z >= 0.0f ? range(bounds.y - reach, bounds.w, major) : glm::vec2(0.0f);
+		const uint32_t labelCount = (uint32_t)(labelsX.y + labelsY.y);
+		if (labelCount == 0)
+			return;
+
+		m_gridLabelsPipeline->Bind();
+		m_gridLabelsShader->SetFloat4(s_Lines, { labelsX.x, labelsY.x, labelsX.y, labelsY.y });
+		m_gridLabelsShader->SetFloat(s_Spacing, major);
+		m_gridLabelsShader->SetFloat(s_FontSize, fontSize);
+		Graphics::RenderCommand::Draw(*m_gridLabelsPipeline, m_gridVertexArray, labelCount * 6);
+	}
+
+	void AbstractApplication::CaptureViewPort(ViewPort& viewPort)
+	{
+		const std::filesystem::path path = m_Specification.CaptureDirectory / std::format("viewport{}_{:06}.{}", viewPort.id, viewPort.CaptureFrame++, m_Specification.CaptureExtension);
+
+		// Runs from PollCaptures on the rendering thread once the GPU copy is done, encoding happens on the thread pool
+		viewPort.Framebuffer->CaptureAttachmentAsync(0, [path](Graphics::FramebufferCapture&& capture) {
+			Graphics::ImageWriter::WriteAsync(path, std::move(capture));
+		});
 	}
 
 	void AbstractApplication::OnEvent(Application::Event& e)
@@ -101,6 +310,11 @@ namespace GUI {
 
 		LOG_TRACE_STREAM << e.ToString();
 
+		// Events come in while polling, layers handling them share their state with OnDrawUpdate on the render thread
+		std::scoped_lock<std::mutex> sceneLock(m_SceneMutex);
+
+		m_FramesToRender = FRAMES_AFTER_EVENT;
+
 		Application::EventDispatcher dispatcher(e);
 		dispatcher.Dispatch<Application::WindowCloseEvent>(APP_BIND_EVENT_FN(AbstractApplication::OnWindowClose));
 		dispatcher.Dispatch<Application::WindowResizeEvent>(APP_BIND_EVENT_FN(AbstractApplication::OnWindowResize));
@@ -111,6 +325,9 @@ namespace GUI {
 		for (ViewPort& viewPort : m_ViewPorts) {
 			if (!viewPort.ViewportHovered || !viewPort.ViewportFocused) continue;
 			viewPort.ViewPortCamera->OnEvent(e);
+			// The scene block is rebuilt once per frame, not per event
+			if (viewPort.ViewPortCamera->IsDirty())
+				viewPort.MarkDirty();
 
 			if (e.GetEventType() == Application::EventType::MouseButtonReleased) {
 
@@ -128,25 +345,44 @@ namespace GUI {
 				int mouseX = (int)mx;
 				int mouseY = (int)my;
 				LOG_TRACE_STREAM << "MouseX: " << mouseX << " MouseY: " << mouseY;
-				viewPort.Framebuffer->Bind();
-				int selectedObject = viewPort.Framebuffer->ReadPixel(1, mouseX, mouseY);
-				LOG_TRACE_STREAM << "Selected Object :" << selectedObject;
-				viewPort.Framebuffer->Unbind();
-
-				if (selectedObject != -1 && selectedObject < MAX_SELECTED_OBJECT_ID) {
-					m_ObjectSelection.objectID = selectedObject;
-					m_ObjectSelection.state = true;
-					m_emitSelectionEvent = true;
-				}
-
-				else if (m_ObjectSelection.objectID != -1) {
-					m_ObjectSelection.state = false;
-					m_emitSelectionEvent = true;
-				}
 
+				// The ID buffer is read where the context is current, the layers get the selection on this thread
+				Graphics::Ref<Graphics::Framebuffer> framebuffer = viewPort.Framebuffer;
+				SubmitToRenderThread([this, framebuffer, mouseX, mouseY]() {
+					framebuffer->Bind();
+					int selectedObject = framebuffer->ReadPixel(1, mouseX, mouseY);
+					LOG_TRACE_STREAM << "Selected Object :" << selectedObject;
+					framebuffer->Unbind();
+
+					if (m_RenderThread.joinable())
+						SubmitToMainThread([this, selectedObject]() { SelectObject(selectedObject); });
+					else
+						SelectObject(selectedObject);
+				});
 			}
 		}
 
+		for (auto it = m_LayerStack.rbegin(); it != m_LayerStack.rend(); ++it)
+		{
+			if (e.Handled)
+				break;
+			(*it)->OnEvent(e);
+		}
+	}
+
+	void AbstractApplication::SelectObject(int selectedObject)
+	{
+		if (selectedObject != -1 && selectedObject < MAX_SELECTED_OBJECT_ID) {
+			m_ObjectSelection.objectID = selectedObject;
+			m_ObjectSelection.state = true;
+			m_emitSelectionEvent = true;
+		}
+
+		else if (m_ObjectSelection.objectID != -1) {
+			m_ObjectSelection.state = false;
+			m_emitSelectionEvent = true;
+		}
+
 		if (m_emitSelectionEvent) {
 
 			//set the seectedObject static var here.
@@ -164,18 +400,9 @@ namespace GUI {
 
 			if (m_ObjectSelection.state == false) 
 				m_ObjectSelection.objectID = -1;
-		}
 
-		//Finish all event processing and then update the vieports
-		for (ViewPort& viewPort : m_ViewPorts) {
-			viewPort.update();
-		}
-
-		for (auto it = m_LayerStack.rbegin(); it != m_LayerStack.rend(); ++it)
-		{
-			if (e.Handled)
-				break;
-			(*it)->OnEvent(e);
+			// The selection outline is drawn into every viewport
+			MarkAllViewPortsDirty();
 		}
 	}
 
@@ -183,156 +410,540 @@ namespace GUI {
 	{
 		HZ_PROFILE_FUNCTION();
 
+		if (m_Specification.Headless)
+		{
+			RunHeadless();
+			return;
+		}
+
+		if (m_Specification.RenderThread)
+		{
+			RunWithRenderThread();
+			return;
+		}
+
 		while (m_Running)
 		{
 			HZ_PROFILE_SCOPE("RunLoop");
 
+			if (m_Specification.RenderOnDemand && (m_Minimized || !IsRedrawPending()))
+			{
+				// Nothing will poll while we sleep, hand off any captures still in flight first
+				for (ViewPort& v : m_ViewPorts)
+					v.Framebuffer->PollCaptures(true);
+				m_Window->WaitEvents(m_Specification.IdleWaitTimeout);
+			}
+
 			ExecuteMainThreadQueue();
+			Graphics::RenderCommand::ResetStateCacheStats();
+			if (UpdateResources())
+				MarkAllViewPortsDirty();
+
+			if (m_RedrawRequested.exchange(false) || !m_Specification.RenderOnDemand)
+				MarkAllViewPortsDirty();
 
 			if (!m_Minimized)
 			{
-				{
-					HZ_PROFILE_SCOPE("LayerStack OnUpdate");
-
-					for (Layer* layer : m_LayerStack) {
-						if (layer->IsUpdateLayer())
-						{
-							layer->OnUpdateLayer();
-							layer->UpdateLayer(false);
-							m_updateAllViewPorts = true;
-						}
-					}
-
-					Graphics::Renderer::ClearBuffers();
-					m_font->Bind();
-					LOG_TRACE_STREAM << "Begin Viewports";
-					for (ViewPort& v : m_ViewPorts) {
-						//On viewport resize
-						if ((v.ViewportSize.x != v.Framebuffer->GetSpecification().Width) || (v.ViewportSize.y != v.Framebuffer->GetSpecification().Height)) {
-							const auto& xSize = v.ViewportSize.x;
-							const auto& ySize = v.ViewportSize.y;
-							LOG_TRACE_STREAM << "Viewport resized to: " << xSize << " x " << ySize;
-							//Update here coz this runs only when viewport size changes
-							v.JumpFloodFramebuffer->Resize((uint32_t)xSize, (uint32_t)ySize);
-							v.Framebuffer->Resize((uint32_t)xSize, (uint32_t)ySize);
-							v.ViewPortCamera->SetViewportSize(xSize, ySize);
-							v.update();
-						}
-						if (!v.ViewportHovered && !v.ViewportFocused && !m_updateAllViewPorts) continue;
-						LOG_TRACE_STREAM << "Viewport: " << v.id << " Hovered: " << v.ViewportHovered << " Focused: " << v.ViewportFocused << " UpdateAll : " << m_updateAllViewPorts;
-						m_CameraBuffer->SetData(&v.uboDataScene, sizeof(v.uboDataScene));
-
-						v.Framebuffer->Bind();
-						v.Framebuffer->ClearAttachment(1, -1); // Clear ID buffer
-						Graphics::Renderer::DepthTest(true);
-
-						Graphics::BatchRenderer::BeginScene();
-						Graphics::Renderer::Clear();
-						v.Framebuffer->SetDrawBuffer(2); // Clear just the selection buffer to full transparent
-						Graphics::Renderer::Clear(0.0);
-						v.Framebuffer->DrawToAllColorBuffers();
-
-							for (Layer* layer : m_LayerStack)
-								layer->OnDrawUpdate();
-
-						Graphics::BatchRenderer::EndScene();
-						Graphics::Renderer::DisableStencil();
-
-						v.Framebuffer->SetDrawBuffer(0); // prevent drawing to id buffer from here nothing should be drawn to the id buffer anyway...
-
-
-						/////////////////////////////////////////////////////////////JUMP FLOOD - FOR SELECTED OBJECT/////////////////////////////////////////////////////////////////////////
-						if (m_ObjectSelection.objectID > -1 && m_ObjectSelection.objectID < MAX_SELECTED_OBJECT_ID) {
-
-							v.Framebuffer->Unbind();
-
-							v.JumpFloodICFramebuffer->Bind();
-							Graphics::Renderer::Clear(0.0); // Clear the jumpflood init frameBuffer
-
-							v.Framebuffer->BindColorAttachmentAsTexture(2, 2);
-
-							m_JumpFlood_init2->Bind();
-							Graphics::Renderer::DrawGridTriangles();
-							m_JumpFlood_init2->Unbind();
-
-							v.JumpFloodICFramebuffer->Unbind();
-
-							v.JumpFloodFramebuffer->Bind();
-							Graphics::Renderer::Clear(0.0); // Clear the jumpflood frameBuffer
-
-							v.JumpFloodFramebuffer->BlitBuffers(v.JumpFloodICFramebuffer->getID(), 0, 0, v.JumpFloodICFramebuffer->GetSpecification().Width, v.JumpFloodICFramebuffer->GetSpecification().Height, 0, 0, v.JumpFloodFramebuffer->GetSpecification().Width, v.JumpFloodFramebuffer->GetSpecification().Height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
-
-
-							v.JumpFloodFramebuffer->BindColorAttachmentAsTexture(0, 1);
-							int steps = 2;
-							int step = (int)glm::round(glm::pow<int>(steps - 1, 2));
-							int index = 0;
-							glm::vec2 texelSize = { 1.0f / v.Framebuffer->GetSpecification().Width, 1.0f / v.Framebuffer->GetSpecification().Height };
-							glm::float32 invTexelRatio = texelSize.y / texelSize.x;
-							while (step != 0) {
-
-								m_JumpFlood_pass->Bind();
-								m_JumpFlood_pass->SetFloat2("a_texelSize", texelSize);
-								m_JumpFlood_pass->SetFloat("a_invTexelRatio", invTexelRatio);
-								m_JumpFlood_pass->SetInt("a_step", step);
-								Graphics::Renderer::DrawGridTriangles();
-								m_JumpFlood_pass->Unbind();
-								index = (index + 1) % 2;
-								step /= 2;
-							}
-
-							v.JumpFloodFramebuffer->Unbind();
-							v.Framebuffer->Bind();
-
-							m_JumpFlood_composite->Bind();
-							Graphics::Renderer::DrawGridTriangles();
-							m_JumpFlood_composite->Unbind();
-
-						}
-						/////////////////////////////////////////////////////////////JUMP FLOOD - FOR SELECTED OBJECT/////////////////////////////////////////////////////////////////////////
-
-
-						if (v.cameraType == CameraType::ThreeD) {
-							//Grid Shader
-							m_gridShader->Bind();
-							Graphics::Renderer::DrawGridTriangles();
-							m_gridShader->Unbind();
-						}
-						else {
-							Graphics::Renderer::DepthTest(false);
-							//Grid Shader
-							m_gridShader2D->Bind();
-							Graphics::Renderer::DrawGridTriangles();
-							m_gridShader2D->Unbind();
+				UpdateLayers();
+				RenderViewPorts(m_ViewPorts, m_Specification.GridLines);
+				// The UI below reads the counters of the frame just drawn, not the ones still counting
+				SnapshotRenderStatistics();
+
+				m_ImGuiHandler->Update([&]() {
+					CoreUI();
+					for (Layer* layer : m_LayerStack)
+						layer->OnImGuiRender();
+				});
+				// The ImGui backend talks to GL directly
+				Graphics::RenderCommand::InvalidateStateCache();
+			}
+
+			m_Window->OnUpdate();
 
-							Graphics::BatchRenderer::BeginScene();
+			if (m_FramesToRender > 0)
+				m_FramesToRender--;
+		}
+	}
+
+	void AbstractApplication::RunWithRenderThread()
+	{
+		HZ_PROFILE_FUNCTION();
+
+		LOG_DEBUG_STREAM << "Rendering on a separate thread, " << m_Specification.FramesInFlight << " frame(s) in flight";
+
+		// The render thread owns the context until it stops
+		m_Window->GetContext().MakeCurrent(false);
+		m_RenderThread = std::thread(&AbstractApplication::RenderThreadLoop, this);
+
+		while (m_Running)
+		{
+			HZ_PROFILE_SCOPE("RunLoop");
 
-							for (Layer* layer : m_LayerStack)
-								layer->OnDrawUpdate();
+			// Captures still in flight are handed off by the render thread once frames stop coming
+			if (m_Specification.RenderOnDemand && (m_Minimized || !IsRedrawPending()))
+				m_Window->WaitEvents(m_Specification.IdleWaitTimeout);
 
-							Graphics::BatchRenderer::EndScene();
-							Graphics::Renderer::DepthTest(true);
-						}
+			{
+				std::scoped_lock<std::mutex> lock(m_SceneMutex);
 
-						v.Framebuffer->DrawToAllColorBuffers(); // prevent drawing to id buffer
+				ExecuteMainThreadQueue();
 
+				if (m_RedrawRequested.exchange(false) || !m_Specification.RenderOnDemand)
+					MarkAllViewPortsDirty();
 
-						v.Framebuffer->Unbind();
-					}
-					LOG_TRACE_STREAM << "End Viewports";
-					if (m_updateAllViewPorts) m_updateAllViewPorts = false;
+				if (!m_Minimized)
+					UpdateLayers();
+			}
 
-					m_ImGuiHandler->Update([&]() {
+			FramePacket packet;
+			if (!m_Minimized)
+			{
+				packet.UI = Graphics::CreateScope<ImGuiFrame>();
+				{
+					std::scoped_lock<std::mutex> lock(m_UIMutex);
+					m_ImGuiHandler->Record([&]() {
 						CoreUI();
+						std::scoped_lock<std::mutex> sceneLock(m_SceneMutex);
 						for (Layer* layer : m_LayerStack)
 							layer->OnImGuiRender();
-					});
+					}, *packet.UI);
+					packet.Textures = Utils::GetViewPortTextures(m_ViewPorts);
+				}
+				SnapshotViewPorts(packet);
+			}
+
+			{
+				std::scoped_lock<std::mutex> lock(m_RenderThreadQueueMutex);
+				packet.Commands.swap(m_RenderThreadQueue);
+			}
+			PushFramePacket(std::move(packet));
+
+			m_Window->PollEvents();
+
+			if (m_FramesToRender > 0)
+				m_FramesToRender--;
+		}
+
+		{
+			std::scoped_lock<std::mutex> lock(m_FramePacketMutex);
+			m_StopRenderThread = true;
+		}
+		m_FramePacketCondition.notify_all();
+		m_RenderThread.join();
+
+		// Submitted during the last poll, only released here now that the context is current again
+		m_Window->GetContext().MakeCurrent(true);
+		m_RenderThreadQueue.clear();
+	}
+
+	void AbstractApplication::SnapshotViewPorts(FramePacket& packet)
+	{
+		for (ViewPort& v : m_ViewPorts)
+		{
+			// The framebuffers are resized by the render thread, the camera follows the new size here
+			const glm::vec4 cameraViewport = v.ViewPortCamera->getViewport();
+			if (v.ViewportSize.x != cameraViewport.x || v.ViewportSize.y != cameraViewport.y)
+			{
+				v.ViewPortCamera->SetViewportSize(v.ViewportSize.x, v.ViewportSize.y);
+				v.MarkDirty();
+			}
+			v.UpdateIfDirty();
+		}
+
+		packet.ViewPorts = m_ViewPorts;
+		packet.GridLines = m_Specification.GridLines;
+		for (ViewPort& v : packet.ViewPorts)
+			v.ViewPortCamera = v.ViewPortCamera->Clone();
+
+		// The frame is drawn from the copies, the flags they carry are handed over with them
+		for (ViewPort& v : m_ViewPorts)
+		{
+			if ((v.Dirty || v.Recording) && (v.CaptureRequested || v.Recording))
+				v.CaptureFrame++;
+			v.Dirty = false;
+			v.CaptureRequested = false;
+			v.SceneDataDirty = false;
+		}
+	}
+
+	void AbstractApplication::RenderThreadLoop()
+	{
+		m_Window->GetContext().MakeCurrent(true);
+
+		FramePacket packet;
+		while (PopFramePacket(packet))
+		{
+			HZ_PROFILE_SCOPE("RenderLoop");
 
+			for (auto& command : packet.Commands)
+				command();
+			// Commands can hold the last reference to GL objects, like the framebuffers of a closed viewport
+			packet.Commands.clear();
+
+			Graphics::RenderCommand::ResetStateCacheStats();
+			const bool resourcesUpdated = UpdateResources();
+
+			if (packet.UI)
+			{
+				if (resourcesUpdated)
+				{
+					for (ViewPort& v : packet.ViewPorts)
+						v.MarkDirty();
+				}
+
+				// Viewports skipped while shaders link are drawn once they are ready
+				if (!RenderViewPorts(packet.ViewPorts, packet.GridLines))
+					RequestRedraw();
+				SnapshotRenderStatistics();
+
+				// Resizing recreates attachments the UI was built with
+				const std::vector<uint32_t> textures = Utils::GetViewPortTextures(packet.ViewPorts);
+				for (size_t i = 0; i < textures.size() && i < packet.Textures.size(); i++)
+				{
+					if (packet.Textures[i] != textures[i])
+						packet.UI->ReplaceTexture(packet.Textures[i], textures[i]);
+				}
+
+				{
+					std::scoped_lock<std::mutex> lock(m_UIMutex);
+					ImGuiHandler::Render(*packet.UI);
 				}
+				// The ImGui backend talks to GL directly
+				Graphics::RenderCommand::InvalidateStateCache();
+
+				// Kept until the next frame for the captures still in flight
+				m_DrawnViewPorts = std::move(packet.ViewPorts);
 			}
 
-			m_Window->OnUpdate();
+			m_RenderThreadBusy = !AreShadersReady() || Graphics::ShaderWatcher::IsReloadPending() || Graphics::TextureManager::Get().GetPendingCount();
+
+			// Wakes the main thread up for the frames that pick them up
+			if (m_RenderThreadBusy)
+				m_Window->PostEmptyEvent();
+
+			m_Window->GetContext().SwapBuffers();
+		}
+
+		for (ViewPort& v : m_DrawnViewPorts)
+			v.Framebuffer->PollCaptures(true);
+		m_DrawnViewPorts.clear();
+
+		m_Window->GetContext().MakeCurrent(false);
+	}
+
+	void AbstractApplication::PushFramePacket(FramePacket&& packet)
+	{
+		std::unique_lock<std::mutex> lock(m_FramePacketMutex);
+		m_FramePacketCondition.wait(lock, [this]() { return m_FramePackets.size() < std::max(m_Specification.FramesInFlight, 1u); });
+		m_FramePackets.push_back(std::move(packet));
+		lock.unlock();
+
+		m_FramePacketCondition.notify_all();
+	}
+
+	bool AbstractApplication::PopFramePacket(FramePacket& packet)
+	{
+		std::unique_lock<std::mutex> lock(m_FramePacketMutex);
+		auto ready = [this]() { return !m_FramePackets.empty() || m_StopRenderThread; };
+		if (!m_FramePacketCondition.wait_for(lock, std::chrono::milliseconds(100), ready))
+		{
+			// The main thread went to sleep, nothing would poll the captures until it wakes up
+			for (ViewPort& v : m_DrawnViewPorts)
+				v.Framebuffer->PollCaptures(true);
+			m_FramePacketCondition.wait(lock, ready);
 		}
+
+		if (m_FramePackets.empty())
+			return false;
+
+		packet = std::move(m_FramePackets.front());
+		m_FramePackets.pop_front();
+		lock.unlock();
+
+		m_FramePacketCondition.notify_all();
+		return true;
+	}
+
+	void AbstractApplication::UpdateLayers()
+	{
+		HZ_PROFILE_SCOPE("LayerStack OnUpdate");
+
+		for (Layer* layer : m_LayerStack) {
+			if (layer->IsUpdateLayer())
+			{
+				layer->OnUpdateLayer();
+				layer->UpdateLayer(false);
+				MarkAllViewPortsDirty();
+			}
+		}
+	}
+
+	bool AbstractApplication::UpdateResources()
+	{
+		// Edited shaders are swapped in here, between frames
+		bool updated = Graphics::ShaderWatcher::Poll();
+
+		// Decoded textures are uploaded here and replace their placeholders
+		updated |= Graphics::TextureManager::Get().Update();
+		return updated;
+	}
+
+	void AbstractApplication::BeginLayersDraw()
+	{
+		std::scoped_lock<std::mutex> lock(m_SceneMutex);
+
+		for (Layer* layer : m_LayerStack)
+			layer->OnDrawBegin();
+	}
+
+	void AbstractApplication::DrawLayers()
+	{
+		// Layer state is shared with the callbacks running on the main thread
+		std::scoped_lock<std::mutex> lock(m_SceneMutex);
+
+		for (Layer* layer : m_LayerStack)
+			layer->OnDrawUpdate();
+	}
+
+	bool AbstractApplication::RenderViewPorts(std::vector<ViewPort>& viewPorts, bool gridLines)
+	{
+		Graphics::Renderer::ClearBuffers();
+		m_font->Bind();
+		const bool shadersReady = AreShadersReady();
+		LOG_TRACE_STREAM << "Begin Viewports";
+		m_SceneDataBuffer->BeginFrame();
+		if (shadersReady)
+			BeginLayersDraw();
+		for (ViewPort& v : viewPorts) {
+			{
+				// The UI reads the attachments while it is built
+				std::scoped_lock<std::mutex> lock(m_UIMutex);
+				ResizeViewPort(v);
+			}
+			// A copy that is not drawn would take the changed block with it
+			if (v.SceneDataDirty)
+			{
+				m_SceneData[v.id].Dirty = true;
+				v.SceneDataDirty = false;
+			}
+			// Viewports keep their last frame until (re)compiled shaders are linked
+			if (!shadersReady)
+				continue;
+			if (v.Recording)
+				v.MarkDirty();
+			// Clean viewports keep showing their last framebuffer contents
+			if (!v.Dirty) continue;
+			v.Dirty = false;
+			RenderViewPort(v, gridLines);
+		}
+		m_SceneDataBuffer->EndFrame();
+		LOG_TRACE_STREAM << "End Viewports";
+
+		for (ViewPort& v : viewPorts)
+			v.Framebuffer->PollCaptures();
+
+		return shadersReady;
+	}
+
+	void AbstractApplication::SnapshotRenderStatistics()
+	{
+		std::scoped_lock<std::mutex> lock(m_RenderStatsMutex);
+		m_RenderStats.Batches = Graphics::BatchRenderer::GetStats();
+		m_RenderStats.StateCache = Graphics::RenderCommand::GetStateCacheStats();
+	}
+
+	void AbstractApplication::RunHeadless()
+	{
+		HZ_PROFILE_FUNCTION();
+
+		LOG_DEBUG_STREAM << "Rendering " << m_Specification.HeadlessFrameCount << " headless frames at " << m_Specification.HeadlessWidth << " x " << m_Specification.HeadlessHeight;
+
+		for (ViewPort& v : m_ViewPorts)
+		{
+			v.ViewportSize = { (float)m_Specification.HeadlessWidth, (float)m_Specification.HeadlessHeight };
+			v.Recording = m_Specification.HeadlessCapture;
+		}
+
+		// Captured frames should not show placeholders
+		Graphics::TextureManager::Get().Flush();
+
+		const auto start = std::chrono::steady_clock::now();
+
+		for (uint32_t frame = 0; frame < m_Specification.HeadlessFrameCount && m_Running; frame++)
+		{
+			HZ_PROFILE_SCOPE("HeadlessFrame");
+
+			ExecuteMainThreadQueue();
+			Graphics::RenderCommand::ResetStateCacheStats();
+			Graphics::TextureManager::Get().Update();
+
+			for (Layer* layer : m_LayerStack) {
+				if (layer->IsUpdateLayer())
+				{
+					layer->OnUpdateLayer();
+					layer->UpdateLayer(false);
+				}
+			}
+
+			Graphics::Renderer::ClearBuffers();
+			m_font->Bind();
+			// No window events here, every viewport is rendered every frame
+			m_SceneDataBuffer->BeginFrame();
+			BeginLayersDraw();
+			for (ViewPort& v : m_ViewPorts) {
+				ResizeViewPort(v);
+				v.Dirty = false;
+				RenderViewPort(v, m_Specification.GridLines);
+			}
+			m_SceneDataBuffer->EndFrame();
+			SnapshotRenderStatistics();
+
+			for (ViewPort& v : m_ViewPorts)
+				v.Framebuffer->PollCaptures();
+
+			m_HeadlessContext->SwapBuffers();
+		}
+
+		for (ViewPort& v : m_ViewPorts)
+			v.Framebuffer->PollCaptures(true);
+		Graphics::RenderCommand::Finish();
+
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		LOG_DEBUG_STREAM << "Headless run finished in " << seconds << "s, " << (seconds * 1000.0 / std::max(m_Specification.HeadlessFrameCount, 1u)) << "ms per frame";
+
+		// Encoding is still running on the thread pool
+		Graphics::ThreadPool::Get().WaitIdle();
+	}
+
+	void AbstractApplication::ResizeViewPort(ViewPort& v)
+	{
+		if ((v.ViewportSize.x != v.Framebuffer->GetSpecification().Width) || (v.ViewportSize.y != v.Framebuffer->GetSpecification().Height)) {
+			const auto& xSize = v.ViewportSize.x;
+			const auto& ySize = v.ViewportSize.y;
+			LOG_TRACE_STREAM << "Viewport resized to: " << xSize << " x " << ySize;
+			//Update here coz this runs only when viewport size changes
+			v.JumpFloodFramebuffer->Resize((uint32_t)xSize, (uint32_t)ySize);
+			v.Framebuffer->Resize((uint32_t)xSize, (uint32_t)ySize);
+			v.ViewPortCamera->SetViewportSize(xSize, ySize);
+			v.MarkDirty();
+		}
+	}
+
+	void AbstractApplication::RenderViewPort(ViewPort& v, bool gridLines)
+	{
+		LOG_TRACE_STREAM << "Viewport: " << v.id << " Hovered: " << v.ViewportHovered << " Focused: " << v.ViewportFocused;
+		v.UpdateIfDirty();
+		SceneDataSlot& sceneData = m_SceneData[v.id];
+		if (v.SceneDataDirty || sceneData.Dirty || !m_SceneDataBuffer->IsResident(sceneData.Allocation))
+		{
+			sceneData.Allocation = m_SceneDataBuffer->Push(&v.uboDataScene, sizeof(v.uboDataScene));
+			sceneData.Dirty = false;
+			v.SceneDataDirty = false;
+		}
+		m_SceneDataBuffer->Bind(sceneData.Allocation);
+
+		v.Framebuffer->Bind();
+		v.Framebuffer->ClearAttachment(1, -1); // Clear ID buffer
+		Graphics::Renderer::DepthTest(true);
+
+		Graphics::BatchRenderer::BeginScene(true, v.ViewPortCamera.get());
+		Graphics::Renderer::Clear();
+		v.Framebuffer->SetDrawBuffer(2); // Clear just the selection buffer to full transparent
+		Graphics::Renderer::Clear(0.0);
+		v.Framebuffer->DrawToAllColorBuffers();
+
+		DrawLayers();
+
+		Graphics::BatchRenderer::EndScene();
+		Graphics::Renderer::DisableStencil();
+
+		v.Framebuffer->SetDrawBuffer(0); // prevent drawing to id buffer from here nothing should be drawn to the id buffer anyway...
+
+
+		/////////////////////////////////////////////////////////////JUMP FLOOD - FOR SELECTED OBJECT/////////////////////////////////////////////////////////////////////////
+		if (v.uboDataScene.selectedObject > -1 && v.uboDataScene.selectedObject < MAX_SELECTED_OBJECT_ID) {
+
+			v.Framebuffer->Unbind();
+
+			v.JumpFloodICFramebuffer->Bind();
+			Graphics::Renderer::Clear(0.0); // Clear the jumpflood init frameBuffer
+
+			v.Framebuffer->BindColorAttachmentAsTexture(2, 2);
+
+			m_JumpFloodInitPipeline->Bind();
+			Graphics::Renderer::DrawGridTriangles();
+
+			v.JumpFloodICFramebuffer->Unbind();
+
+			v.JumpFloodFramebuffer->Bind();
+			Graphics::Renderer::Clear(0.0); // Clear the jumpflood frameBuffer
+
+			v.JumpFloodFramebuffer->BlitBuffers(v.JumpFloodICFramebuffer->getID(), 0, 0, v.JumpFloodICFramebuffer->GetSpecification().Width, v.JumpFloodICFramebuffer->GetSpecification().Height, 0, 0, v.JumpFloodFramebuffer->GetSpecification().Width, v.JumpFloodFramebuffer->GetSpecification().Height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+
+			v.JumpFloodFramebuffer->BindColorAttachmentAsTexture(0, 1);
+			int steps = 2;
+			int step = (int)glm::round(glm::pow<int>(steps - 1, 2));
+			int index = 0;
+			glm::vec2 texelSize = { 1.0f / v.Framebuffer->GetSpecification().Width, 1.0f / v.Framebuffer->GetSpecification().Height };
+			glm::float32 invTexelRatio = texelSize.y / texelSize.x;
+			static constexpr Graphics::ShaderUniformName s_TexelSize("a_texelSize"), s_InvTexelRatio("a_invTexelRatio"), s_Step("a_step");
+			m_JumpFloodPassPipeline->Bind();
+			while (step != 0) {
+
+				m_JumpFlood_pass->SetFloat2(s_TexelSize, texelSize);
+				m_JumpFlood_pass->SetFloat(s_InvTexelRatio, invTexelRatio);
+				m_JumpFlood_pass->SetInt(s_Step, step);
+				Graphics::Renderer::DrawGridTriangles();
+				index = (index + 1) % 2;
+				step /= 2;
+			}
+
+			v.JumpFloodFramebuffer->Unbind();
+			v.Framebuffer->Bind();
+
+			m_JumpFloodCompositePipeline->Bind();
+			Graphics::Renderer::DrawGridTriangles();
+
+		}
+		/////////////////////////////////////////////////////////////JUMP FLOOD - FOR SELECTED OBJECT/////////////////////////////////////////////////////////////////////////
+
+
+		if (v.cameraType == CameraType::ThreeD) {
+			//Grid Shader
+			m_gridPipeline->Bind();
+			Graphics::Renderer::DrawGridTriangles();
+		}
+		else if (gridLines) {
+			DrawGridLines(v);
+
+			Graphics::BatchRenderer::BeginScene(false, v.ViewPortCamera.get());
+
+			DrawLayers();
+
+			Graphics::BatchRenderer::EndScene();
+		}
+		else {
+			//Grid Shader
+			m_gridPipeline2D->Bind();
+			Graphics::Renderer::DrawGridTriangles();
+
+			Graphics::BatchRenderer::BeginScene(false, v.ViewPortCamera.get());
+
+			DrawLayers();
+
+			Graphics::BatchRenderer::EndScene();
+		}
+
+		v.Framebuffer->DrawToAllColorBuffers(); // prevent drawing to id buffer
+
+		if (v.CaptureRequested || v.Recording)
+		{
+			CaptureViewPort(v);
+			v.CaptureRequested = false;
+		}
+
+		v.Framebuffer->Unbind();
 	}
 
 	bool AbstractApplication::OnWindowClose(Application::WindowCloseEvent& e)
@@ -352,7 +963,8 @@ namespace GUI {
 		}
 
 		m_Minimized = false;
-		Graphics::Renderer::OnWindowResize(e.GetWidth(), e.GetHeight());
+		const uint32_t width = e.GetWidth(), height = e.GetHeight();
+		SubmitToRenderThread([width, height]() { Graphics::Renderer::OnWindowResize(width, height); });
 
 		return false;
 	}
@@ -437,14 +1049,19 @@ namespace GUI {
 		{
 			ImGui::Begin("Hello, world!");
 
+			// Viewports create and delete framebuffers, they come and go where the context is current
 			if (ImGui::Button("Add 3D ViewPort")) {
-				m_ViewPorts.push_back(ViewPort(m_fbSpec, CameraType::ThreeD, m_viewPortCount));
-				m_viewPortCount++;
+				SubmitToRenderThread([this, id = m_viewPortCount++]() {
+					ViewPort viewPort(m_fbSpec, CameraType::ThreeD, id);
+					SubmitToMainThread([this, viewPort]() { m_ViewPorts.push_back(viewPort); });
+				});
 			}
 			ImGui::SameLine();
 			if (ImGui::Button("Add 2D ViewPort")) {
-				m_ViewPorts.push_back(ViewPort(m_fbSpec, CameraType::TwoD, m_viewPortCount));
-				m_viewPortCount++;
+				SubmitToRenderThread([this, id = m_viewPortCount++]() {
+					ViewPort viewPort(m_fbSpec, CameraType::TwoD, id);
+					SubmitToMainThread([this, viewPort]() { m_ViewPorts.push_back(viewPort); });
+				});
 			}
 
 			glm::vec2 pos = Application::Input::GetMousePosition();
@@ -461,11 +1078,10 @@ namespace GUI {
 				float screenHeight = v.ViewportSize.y;
 
 				//ToDo: account for the vieport position.
-				glm::vec2 world = { ((pos.x / screenWidth) * (worldXmax - worldXmin)) + worldXmin , worldYmax - ((pos.y / screenHeight) * (worldYmax - worldYmin)) };
+				glm::dvec2 world = { ((pos.x / screenWidth) * (worldXmax - worldXmin)) + worldXmin , worldYmax - ((pos.y / screenHeight) * (worldYmax - worldYmin)) };
 
-				//Note: The mouse coordinates lose precision because of the below two lines 
-				world.x += v.ViewPortCamera->GetFocalPoint().x;
-				world.y += v.ViewPortCamera->GetFocalPoint().y;
+				// The bounds are relative to the eye, added in double so the mouse keeps its precision far from the origin
+				world += glm::dvec2(v.ViewPortCamera->GetEyePosition());
 
 
 				ImGui::Text("WorldX : %f -> %f", worldXmin, worldXmax);
@@ -485,12 +1101,16 @@ namespace GUI {
 			auto io = ImGui::GetIO();
 			ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / io.Framerate, io.Framerate);
 
-			ImGui::Text("Quad Count %d", Graphics::BatchRenderer::GetStats().QuadCount);
+			RenderStatistics stats = GetRenderStatistics();
+			ImGui::Text("Quad Count %d", stats.Batches.QuadCount);
+			ImGui::Text("GL state changes : %u issued | %u elided", stats.StateCache.Issued, stats.StateCache.Elided);
 			if (ImGui::Button("Recreate application SHaders")) {
-				this->CreateShaders();
+				SubmitToRenderThread([this]() { this->CreateShaders(true); });
+				MarkAllViewPortsDirty();
 			}
 			if (ImGui::Button("Recreate SHaders")) {
-				Graphics::BatchRenderer::ReCreateShaders();
+				SubmitToRenderThread([]() { Graphics::BatchRenderer::ReCreateShaders(); });
+				MarkAllViewPortsDirty();
 			}
 
 			if (ImGui::Button("Show Buffers")) {
@@ -502,7 +1122,15 @@ namespace GUI {
 
 		auto ViewPortIt = m_ViewPorts.begin();
 		while (ViewPortIt != m_ViewPorts.end()) {
-			if (!ViewPortIt->isOpen) { ViewPortIt = m_ViewPorts.erase(ViewPortIt); continue; }
+			if (!ViewPortIt->isOpen) {
+				// The copy keeps the framebuffers alive until this runs
+				SubmitToRenderThread([this, viewPort = *ViewPortIt]() {
+					viewPort.Framebuffer->PollCaptures(true);
+					m_SceneData.erase(viewPort.id);
+				});
+				ViewPortIt = m_ViewPorts.erase(ViewPortIt);
+				continue;
+			}
 			ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2{ 0, 0 });
 			ImGui::Begin(std::format("Viewport {}", ViewPortIt->id).c_str(), &ViewPortIt->isOpen);
 			ImDrawList* drawList = ImGui::GetWindowDrawList();
@@ -521,12 +1149,8 @@ namespace GUI {
 			ImVec2 viewportPanelSize = ImGui::GetContentRegionAvail();
 
 
-			glm::vec2 tmp = ViewPortIt->ViewportSize;
 			ViewPortIt->ViewportSize = { viewportPanelSize.x, viewportPanelSize.y };
-			
-			//one of the viewports has resized
-			// TODO: Make this more efficient by marking individual viewports as dirty
-			if (tmp != ViewPortIt->ViewportSize) { m_updateAllViewPorts = true; }
+			// A size change is picked up (and the viewport marked dirty) by the resize check in Run
 
 			uint64_t textureID = ViewPortIt->Framebuffer->GetColorAttachmentRendererID();
 
@@ -632,9 +1256,11 @@ namespace GUI {
 
     		ImGui::Text("Primary Monitor : %s", m_Window->GetPrimaryMonitorName());
 
-    			if(ImGui::Button("VSync")) m_Window->SetVSync(!m_Window->IsVSync());
+    			if(ImGui::Button("VSync")) SubmitToRenderThread([this]() { m_Window->SetVSync(!m_Window->IsVSync()); });
 				ImGui::SameLine();
-				if (ImGui::Button("Polygon Smooth")) { m_Window->SetPolygonSmooth(!m_Window->IsPolygonSmooth()); m_updateAllViewPorts = true; };
+				if (ImGui::Button("Polygon Smooth")) { SubmitToRenderThread([this]() { m_Window->SetPolygonSmooth(!m_Window->IsPolygonSmooth()); }); MarkAllViewPortsDirty(); }
+				ImGui::Checkbox("Render on demand", &m_Specification.RenderOnDemand);
+				if (ImGui::Checkbox("Grid as lines", &m_Specification.GridLines)) MarkAllViewPortsDirty();
 
 
 			for (ViewPort& v : m_ViewPorts) {
@@ -648,14 +1274,20 @@ namespace GUI {
 				DrawVec3Control("Transform", cameraFocalPoint);
 				if (tmp != cameraFocalPoint) {
 					v.ViewPortCamera->SetFocalPoint(cameraFocalPoint);
-					v.update();
+					v.MarkDirty();
 				}
 
 
 				auto viewDirection = v.ViewPortCamera->GetViewDirection();
 				ImGui::Text("Camera View Direction : %.3f %.3f %.3f", viewDirection.x, viewDirection.y, viewDirection.z);
 				//auto fragNormal = glm::inverseTranspose(m_ApplicationCamera.GetViewMatrix()) * glm::vec3(0.0,0.0,1.0);
-				if (ImGui::Button(std::format("Reset Camera {}", v.id).c_str())) { v.ViewPortCamera->ResetFocalPoint(); v.update(); };
+				if (ImGui::Button(std::format("Reset Camera {}", v.id).c_str())) { v.ViewPortCamera->ResetFocalPoint(); v.MarkDirty(); };
+				ImGui::SameLine();
+				if (ImGui::Button(std::format("Capture {}", v.id).c_str())) { v.CaptureRequested = true; v.MarkDirty(); };
+				ImGui::SameLine();
+				if (ImGui::Button(std::format("{} Recording {}", v.Recording ? "Stop" : "Start", v.id).c_str())) v.Recording = !v.Recording;
+				if (v.Recording)
+					ImGui::Text("Recording frame %u | %u writes pending", v.CaptureFrame, Graphics::ImageWriter::GetPendingWrites());
 				auto zoom = v.ViewPortCamera->getZoom();
 				ImGui::Text("Camera Zoom : %.20f", zoom);
 			}
@@ -1,5 +1,10 @@
 
 #include <string>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <unordered_map>
 #include "Core/Base.h"
 #include "Core/Layer.h"
 #include "Core/LayerStack.h"
@@ -10,16 +15,23 @@
 #include <Renderer/2DCamera.h>
 #include <Renderer/3DCamera.h>
 #include <Renderer/UniformBuffer.h>
+#include <Renderer/UniformRingBuffer.h>
 #include <Renderer/FrameBuffer.h>
 #include "glm/gtc/matrix_inverse.hpp"
 #include <Logger.h>
 #include <Renderer/Shader.h>
+#include <Renderer/Pipeline.h>
+#include <Renderer/VertexArray.h>
 #include <Renderer/Texture.h>
+#include <Renderer/GraphicsContext.h>
+#include <Renderer/BatchRenderer.h>
+#include <Renderer/RendererAPI.h>
 namespace GUI {
 
 	struct SceneDataUBO {
 			// Vectors are multiplied on the right.
 			glm::mat4 projViewMatrix;
+			glm::mat4 projViewMatrixRTE; //projViewMatrix for positions relative to the eye
 			glm::mat4 viewMatrix;
 			glm::mat4 viewMatrixInverse;
 			glm::mat4 viewMatrixInverseTranspose;
@@ -29,6 +41,7 @@ namespace GUI {
 			glm::vec4 viewDirection;
 			glm::vec4 gridMinMax; //xmin, xmax, ymin, ymax
 			glm::vec4 viewport; //width, height, width*height, 0
+			glm::vec4 gridLod; //world units per pixel, lod0 cell size, lod fade, 0
 			glm::f32 aspectRatio;
 			glm::f32 gridMajor;
 			glm::f32 gridMinor;
@@ -65,12 +78,20 @@ namespace GUI {
 		Graphics::Ref<Graphics::Framebuffer> JumpFloodFramebuffer;
 		Graphics::Ref<Graphics::Camera> ViewPortCamera;
 		SceneDataUBO uboDataScene;
+		// Set when uboDataScene changed, it is pushed again on the next draw
+		bool SceneDataDirty = true;
 		bool ViewportFocused = true, ViewportHovered = false;
 		glm::vec2 ViewportSize = { 1.0f, 1.0f };
 		glm::vec2 ViewportBounds[2];
 		bool isOpen = true;
+		// Set whenever the framebuffer contents are stale, clean viewports are not re-rendered
+		bool Dirty = true;
+		// Capture the next rendered frame / every rendered frame to the capture directory
+		bool CaptureRequested = false, Recording = false;
+		uint32_t CaptureFrame = 0;
 
-		static int s_selectedObject;
+		// Set on the main thread, read wherever the scene block is recomputed
+		static std::atomic<int> s_selectedObject;
 
 		explicit ViewPort(Graphics::FramebufferSpecification fbSpec, CameraType camera, uint32_t _id) : cameraType(camera), id(_id) {
 			Framebuffer = Graphics::Framebuffer::Create(fbSpec);
@@ -98,15 +119,26 @@ namespace GUI {
 			this->update();
 		}
 
+		void MarkDirty() { Dirty = true; }
+
 		inline void SetGridValues() {
 			LOG_TRACE_STREAM << "World x min and x max" << static_cast<float>(ViewPortCamera->getWorldXmin()) << " " << static_cast<float>(ViewPortCamera->getWorldXmax());
 			uboDataScene.gridMinMax = { static_cast<float>(ViewPortCamera->getWorldXmin()), static_cast<float>(ViewPortCamera->getWorldXmax()), static_cast<float>(ViewPortCamera->getWorldYmin()), static_cast<float>(ViewPortCamera->getWorldYmax()) };
 			uboDataScene.gridMajor = ViewPortCamera->getGridMajorSpacing();
 			uboDataScene.gridMinor = ViewPortCamera->getGridMinorSpacing();
 			uboDataScene.gridZoom = ViewPortCamera->getZoom();
+			uboDataScene.gridLod = ViewPortCamera->getGridLod();
 			LOG_TRACE_STREAM << "Grid Major Spacing : " << static_cast<float>(ViewPortCamera->getGridMajorSpacing()) << "Grid Minor Spacing : " << static_cast<float>(ViewPortCamera->getGridMajorSpacing());
 		}
 
+		// Recomputes the scene block only when the camera moved or the selection changed since the last call
+		bool UpdateIfDirty() {
+			if (!ViewPortCamera->IsDirty() && uboDataScene.selectedObject == s_selectedObject)
+				return false;
+			update();
+			return true;
+		}
+
 		void update() {
 			uboDataScene.viewMatrix = ViewPortCamera->GetViewMatrix();  // Set your view matrix here
 			uboDataScene.viewMatrixInverse = glm::inverse(uboDataScene.viewMatrix);
@@ -114,12 +146,15 @@ namespace GUI {
 			uboDataScene.projectionMatrix = ViewPortCamera->GetProjection();  // Set your projection matrix here
 			uboDataScene.projectionMatrixInverse = glm::inverse(uboDataScene.projectionMatrix);
 			uboDataScene.projViewMatrix = ViewPortCamera->GetViewProjection();
+			uboDataScene.projViewMatrixRTE = ViewPortCamera->GetViewProjectionRelativeTo(ViewPortCamera->GetEyePosition());
 			uboDataScene.cameraPos = glm::vec4(ViewPortCamera->GetPosition(), 1.0f);
 			uboDataScene.viewDirection = glm::vec4(ViewPortCamera->GetViewDirection(),1.0);
 			uboDataScene.viewport = ViewPortCamera->getViewport();
 			uboDataScene.aspectRatio = static_cast<float>(ViewPortCamera->getAspectRatio());
 			uboDataScene.selectedObject = s_selectedObject;
 			SetGridValues();
+			ViewPortCamera->ClearDirty();
+			SceneDataDirty = true;
 		}
 	};
 
@@ -140,6 +175,37 @@ namespace GUI {
 		std::string Name = "Abstract Application";
 		std::string WorkingDirectory;
 		ApplicationCommandLineArgs CommandLineArgs;
+		// Only re-render dirty viewports and block on events while idle
+		bool RenderOnDemand = true;
+		// Seconds to block on events while idle before running a UI frame anyway
+		double IdleWaitTimeout = 0.5;
+		// Viewport captures are written here as viewport<id>_<frame>.<CaptureExtension> (png, ppm or exr)
+		std::filesystem::path CaptureDirectory = "captures";
+		std::string CaptureExtension = "png";
+		// Recompile shaders whose source or includes change under Resources/Shaders, not used in headless mode
+		bool WatchShaders = true;
+		// Draw the 2D grid as one line per visible grid line and one quad per axis label instead of shading every
+		// pixel of the viewport, cheaper on software rasterizers
+		bool GridLines = false;
+		// Render viewports straight into framebuffers with no window or ImGui, needs a GUI_HEADLESS_EGL build
+		bool Headless = false;
+		uint32_t HeadlessWidth = 1280, HeadlessHeight = 720;
+		uint32_t HeadlessFrameCount = 1;
+		// Write every headless frame to CaptureDirectory
+		bool HeadlessCapture = true;
+		// Update layers and build the UI on this thread while a render thread that owns the context draws the frame
+		// before from a copy of the viewports. OnDrawUpdate then runs on the render thread, never at the same time as
+		// the other layer callbacks. Push layers before Run, GL work from anywhere else goes through SubmitToRenderThread.
+		bool RenderThread = false;
+		// Frames built ahead of the one being drawn, each one adds a frame of latency
+		uint32_t FramesInFlight = 1;
+	};
+
+	// Counters of the last frame drawn, copied out by whichever thread drew it
+	struct RenderStatistics
+	{
+		Graphics::Statistics Batches;
+		Graphics::StateCacheStatistics StateCache;
 	};
 
 	class AbstractApplication {
@@ -148,13 +214,15 @@ namespace GUI {
 		AbstractApplication(const ApplicationSpecification& specification);
 		virtual ~AbstractApplication();
 
-		void CreateShaders();
+		// recompile compiles the shaders from disk again instead of sharing the ones already in the shader library
+		void CreateShaders(bool recompile = false);
 
 		void OnEvent(Application::Event& e);
 
 		void PushLayer(Layer* layer);
 		void PushOverlay(Layer* layer);
 
+		// Not available in headless mode
 		Application::Window& GetWindow() { return *m_Window; }
 
 		void Close();
@@ -166,18 +234,74 @@ namespace GUI {
 		const ApplicationSpecification& GetSpecification() const { return m_Specification; }
 
 		void SubmitToMainThread(const std::function<void()>& function);
+		// Runs function where the context is current: right away without a render thread or when called on it,
+		// otherwise on the render thread before it draws the next frame
+		void SubmitToRenderThread(const std::function<void()>& function);
+		// Thread safe, re-renders every viewport on the next frame
+		void RequestRedraw();
+		// Thread safe, counters of the last frame whose viewports were drawn
+		RenderStatistics GetRenderStatistics();
 		void Run();
 	private:
+		// Everything the render thread needs to draw a frame built on the main thread
+		struct FramePacket
+		{
+			// Not set while minimized, nothing is drawn then
+			Graphics::Scope<ImGuiFrame> UI;
+			// Submitted to the render thread while the frame was built
+			std::vector<std::function<void()>> Commands;
+			// Copies of the viewports with their scene blocks computed and cameras cloned, the main thread keeps
+			// moving the originals while these are drawn
+			std::vector<ViewPort> ViewPorts;
+			bool GridLines = false;
+			// Viewport attachments the UI was built with, remapped when the render thread recreates them
+			std::vector<uint32_t> Textures;
+		};
+
+		void RunHeadless();
+		void RunWithRenderThread();
+		void RenderThreadLoop();
+		// Fills the viewports of packet and clears the flags handed over with them
+		void SnapshotViewPorts(FramePacket& packet);
+		// Blocks while FramesInFlight packets are waiting
+		void PushFramePacket(FramePacket&& packet);
+		// False once the render thread is asked to stop and every packet is drawn. Finishes the captures in flight
+		// when the main thread goes idle.
+		bool PopFramePacket(FramePacket& packet);
+
+		void UpdateLayers();
+		// True when a shader or texture was swapped in, the viewports showing it need to be drawn again
+		bool UpdateResources();
+		// False while shaders link, nothing is drawn then
+		bool RenderViewPorts(std::vector<ViewPort>& viewPorts, bool gridLines);
+		void ResizeViewPort(ViewPort& v);
+		void RenderViewPort(ViewPort& v, bool gridLines);
+		// Copies the counters out once the viewports of a frame are drawn, they are reset before the next one
+		void SnapshotRenderStatistics();
+		// Runs OnDrawBegin of every layer, once per drawn frame
+		void BeginLayersDraw();
+		// Runs OnDrawUpdate of every layer
+		void DrawLayers();
+		void DrawGridLines(const ViewPort& v);
+
 		bool OnWindowClose(Application::WindowCloseEvent& e);
 		bool OnWindowResize(Application::WindowResizeEvent& e);
 
 		void CoreUI();
 
+		void MarkAllViewPortsDirty();
+		bool IsRedrawPending();
+		bool AreShadersReady();
+		void CaptureViewPort(ViewPort& viewPort);
+		void SelectObject(int selectedObject);
+
 		void ExecuteMainThreadQueue();
 	private:
 		ApplicationSpecification m_Specification;
 		Graphics::Scope<Application::Window> m_Window;
-		ImGuiHandler* m_ImGuiHandler;
+		// Only set in headless mode, otherwise the window owns the context
+		Graphics::Scope<Graphics::GraphicsContext> m_HeadlessContext;
+		ImGuiHandler* m_ImGuiHandler = nullptr;
 		bool m_Running = true;
 		bool m_Minimized = false;
 		Application::LayerStack m_LayerStack;
@@ -190,19 +314,58 @@ namespace GUI {
 
 		Graphics::Ref<Graphics::Shader> m_gridShader;
 		Graphics::Ref<Graphics::Shader> m_gridShader2D;
+		Graphics::Ref<Graphics::Shader> m_gridLinesShader, m_gridLabelsShader;
 
-		Graphics::Ref<Graphics::Shader> m_JumpFlood_init, m_JumpFlood_init2, m_JumpFlood_pass, m_JumpFlood_composite;
+		Graphics::Ref<Graphics::Shader> m_JumpFlood_init, m_JumpFlood_pass, m_JumpFlood_composite;
+
+		Graphics::Ref<Graphics::Pipeline> m_gridPipeline, m_gridPipeline2D;
+		Graphics::Ref<Graphics::Pipeline> m_gridLinesPipeline, m_gridLabelsPipeline;
+		// Empty, the grid lines and labels are placed from gl_VertexID and gl_InstanceID
+		Graphics::Ref<Graphics::VertexArray> m_gridVertexArray;
+		Graphics::Ref<Graphics::Pipeline> m_JumpFloodInitPipeline, m_JumpFloodPassPipeline, m_JumpFloodCompositePipeline;
 
 		Graphics::Ref<Graphics::Texture> m_font;
 
 		uint32_t m_viewPortCount = 0;
-		bool m_updateAllViewPorts = false;
+		// UI frames left to run after the last input event, ImGui needs a few to settle
+		uint32_t m_FramesToRender = 1;
+		std::atomic<bool> m_RedrawRequested = false;
 
-		Graphics::Ref<Graphics::UniformBuffer> m_CameraBuffer;
+		// Scene blocks of every viewport, bound per viewport at binding 0
+		Graphics::Ref<Graphics::UniformRingBuffer> m_SceneDataBuffer;
+		struct SceneDataSlot
+		{
+			// Where the block was last pushed, pushed again only when it changed or its region is recycled
+			Graphics::UniformAllocation Allocation;
+			bool Dirty = true;
+		};
+		// By viewport id, only touched where frames are drawn. The render thread draws copies of the viewports,
+		// what it pushed has to outlive them.
+		std::unordered_map<uint32_t, SceneDataSlot> m_SceneData;
 
 		std::vector<std::function<void()>> m_MainThreadQueue;
 		std::mutex m_MainThreadQueueMutex;
 
+		std::thread m_RenderThread;
+		// Held around the layer callbacks, layers record their draws straight from their own state
+		std::mutex m_SceneMutex;
+		// Held by the main thread while it builds the UI from the viewport attachments, by the render thread while
+		// it recreates or samples them
+		std::mutex m_UIMutex;
+		std::vector<std::function<void()>> m_RenderThreadQueue;
+		std::mutex m_RenderThreadQueueMutex;
+		std::deque<FramePacket> m_FramePackets;
+		std::mutex m_FramePacketMutex;
+		std::condition_variable m_FramePacketCondition;
+		bool m_StopRenderThread = false;
+		// Shaders linking or resources uploading, written by the render thread since it polls them through GL
+		std::atomic<bool> m_RenderThreadBusy = true;
+		// Copies drawn last by the render thread, their captures are finished once the main thread goes idle
+		std::vector<ViewPort> m_DrawnViewPorts;
+
+		RenderStatistics m_RenderStats;
+		std::mutex m_RenderStatsMutex;
+
 
 		//TODO : Move to application event bus
 		ObjectSelection m_ObjectSelection = {-1, false};
@@ -15,6 +15,8 @@ namespace GUI {
 		virtual void OnDetach() = 0;
 		virtual void OnUpdateLayer() = 0;
 		virtual void OnDrawUpdate() = 0;
+		// Once per drawn frame before OnDrawUpdate runs for each viewport, on the same thread
+		virtual void OnDrawBegin() {}
 		virtual void OnEvent(Application::Event& event) = 0;
 		virtual void OnSelection(int objectId, bool state) = 0;
 		virtual void OnImGuiRender() = 0;
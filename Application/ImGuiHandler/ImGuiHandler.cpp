@@ -1,11 +1,51 @@
 #include "ImGuiHandler.h"
 
-void ImGuiHandler::NewFrame() {
-    ImGui_ImplOpenGL3_NewFrame();
+void ImGuiFrame::Copy(const ImDrawData* drawData) {
+    Clear();
+
+    m_DrawData = *drawData;
+    for (ImDrawList*& list : m_DrawData.CmdLists)
+        list = list->CloneOutput();
+}
+
+void ImGuiFrame::Clear() {
+    for (ImDrawList* list : m_DrawData.CmdLists)
+        IM_DELETE(list);
+    m_DrawData.Clear();
+}
+
+void ImGuiFrame::ReplaceTexture(uint32_t from, uint32_t to) {
+    const ImTextureID fromID = (ImTextureID)(intptr_t)from, toID = (ImTextureID)(intptr_t)to;
+
+    for (ImDrawList* list : m_DrawData.CmdLists) {
+        for (ImDrawCmd& cmd : list->CmdBuffer) {
+#if IMGUI_VERSION_NUM >= 19200
+            if (cmd.TexRef._TexData == nullptr && cmd.TexRef._TexID == fromID)
+                cmd.TexRef._TexID = toID;
+#else
+            if (cmd.TextureId == fromID)
+                cmd.TextureId = toID;
+#endif
+        }
+    }
+}
+
+void ImGuiHandler::NewFrame(bool renderer) {
+    if (renderer)
+        ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
 }
 
+void ImGuiHandler::Build(const std::function<void()>& updateFn) {
+#ifdef IMGUI_DOCKING_BRANCH_ENABLED
+    static ImGuiDockNodeFlags dockspace_flags = ImGuiDockNodeFlags_PassthruCentralNode;
+    ImGui::DockSpaceOverViewport(0, ImGui::GetMainViewport(), dockspace_flags);
+#endif
+
+    updateFn();
+}
+
 inline void ImGuiHandler::Render() {
     ImGui::Render();
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
@@ -30,19 +70,27 @@ ImGuiHandler::ImGuiHandler(GLFWwindow* window, const char* glsl_version) {
     ImGui::StyleColorsDark();
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init(glsl_version);
+    // Creates the device objects (and the font texture) while the context is current here, frames may be built on a
+    // thread the context is never current on
+    ImGui_ImplOpenGL3_NewFrame();
 }
 
 void ImGuiHandler::Update(const ImGuiUpdateFn& updateFn) {
     this->NewFrame();
+    this->Build(updateFn);
+    this->Render();
+}
 
-#ifdef IMGUI_DOCKING_BRANCH_ENABLED
-    static ImGuiDockNodeFlags dockspace_flags = ImGuiDockNodeFlags_PassthruCentralNode;
-    ImGui::DockSpaceOverViewport(0, ImGui::GetMainViewport(), dockspace_flags);
-#endif
-
-    updateFn();
+void ImGuiHandler::Record(const ImGuiUpdateFn& updateFn, ImGuiFrame& frame) {
+    this->NewFrame(false);
+    this->Build(updateFn);
+    ImGui::Render();
+    frame.Copy(ImGui::GetDrawData());
+}
 
-    this->Render();
+void ImGuiHandler::Render(ImGuiFrame& frame) {
+    ImGui_ImplOpenGL3_NewFrame();
+    ImGui_ImplOpenGL3_RenderDrawData(frame.GetDrawData());
 }
 
 void ImGuiHandler::OnAttach()
@@ -8,11 +8,36 @@
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 #include <functional>
+#include <cstdint>
 #include "Core/Layer.h"
 
+// Draw data of one frame with its own copy of the draw lists, ImGui reuses its lists on the next NewFrame
+class ImGuiFrame {
+private:
+    ImDrawData m_DrawData;
+
+public:
+    ImGuiFrame() = default;
+    ImGuiFrame(const ImGuiFrame&) = delete;
+    ImGuiFrame& operator=(const ImGuiFrame&) = delete;
+
+    ~ImGuiFrame() { Clear(); }
+
+    void Copy(const ImDrawData* drawData);
+
+    void Clear();
+
+    // Makes the commands drawing texture from draw texture to instead, for textures recreated after the frame was built
+    void ReplaceTexture(uint32_t from, uint32_t to);
+
+    ImDrawData* GetDrawData() { return &m_DrawData; }
+};
+
 class ImGuiHandler : public GUI::Layer {
 private:
-    static void NewFrame();
+    static void NewFrame(bool renderer = true);
+
+    static void Build(const std::function<void()>& updateFn);
 
     static void Render();
 
@@ -23,6 +48,12 @@ public:
 
     void Update(const ImGuiUpdateFn& updateFn);
 
+    // Builds the UI without touching GL and copies its draw data into frame
+    void Record(const ImGuiUpdateFn& updateFn, ImGuiFrame& frame);
+
+    // Draws a recorded frame, on the thread the context is current on
+    static void Render(ImGuiFrame& frame);
+
     ~ImGuiHandler() {
         ImGui_ImplOpenGL3_Shutdown();
         ImGui_ImplGlfw_Shutdown();
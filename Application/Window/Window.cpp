@@ -225,6 +225,25 @@ namespace Application {
 		m_Context->SwapBuffers();
 	}
 
+	void WindowsWindow::PollEvents()
+	{
+		HZ_PROFILE_FUNCTION();
+
+		glfwPollEvents();
+	}
+
+	void WindowsWindow::WaitEvents(double timeout)
+	{
+		HZ_PROFILE_FUNCTION();
+
+		glfwWaitEventsTimeout(timeout);
+	}
+
+	void WindowsWindow::PostEmptyEvent()
+	{
+		glfwPostEmptyEvent();
+	}
+
 	void WindowsWindow::SetVSync(bool enabled)
 	{
 		HZ_PROFILE_FUNCTION();
@@ -29,7 +29,14 @@ namespace Application {
 
 		virtual ~Window() = default;
 
+		// Polls events and presents the frame
 		virtual void OnUpdate() = 0;
+		virtual void PollEvents() = 0;
+
+		// Blocks until an event arrives or timeout (in seconds) expires
+		virtual void WaitEvents(double timeout) = 0;
+		// Wakes up a thread blocked in WaitEvents
+		virtual void PostEmptyEvent() = 0;
 
 		virtual uint32_t GetWidth() const = 0;
 		virtual uint32_t GetHeight() const = 0;
@@ -42,6 +49,7 @@ namespace Application {
 		virtual bool IsPolygonSmooth() const = 0;
 
 		virtual void* GetNativeWindow() const = 0;
+		virtual Graphics::GraphicsContext& GetContext() = 0;
 
 		virtual int GetMonitorCount() const = 0;
 		virtual const char* GetPrimaryMonitorName() const = 0;
@@ -56,6 +64,10 @@ namespace Application {
 		virtual ~WindowsWindow();
 
 		void OnUpdate() override;
+		void PollEvents() override;
+
+		void WaitEvents(double timeout) override;
+		void PostEmptyEvent() override;
 
 		unsigned int GetWidth() const override { return m_Data.Width; }
 		unsigned int GetHeight() const override { return m_Data.Height; }
@@ -68,6 +80,7 @@ namespace Application {
 		bool IsPolygonSmooth() const override;
 
 		virtual void* GetNativeWindow() const { return m_Window; }
+		Graphics::GraphicsContext& GetContext() override { return *m_Context; }
 
 		virtual int GetMonitorCount() const { return m_Data.m_Settings.monitorCount; }
 
@@ -28,18 +28,23 @@ namespace Graphics {
 		glBufferData(GL_ARRAY_BUFFER, size, vertices, GL_STATIC_DRAW);
 	}
 
+	OpenGLVertexBuffer::OpenGLVertexBuffer(const Ref<BufferRange>& range) : m_Range(range), isStatic(false)
+	{
+	}
+
 	OpenGLVertexBuffer::~OpenGLVertexBuffer()
 	{
 		
 
-		glDeleteBuffers(1, &m_RendererID);
+		if (!m_Range)
+			glDeleteBuffers(1, &m_RendererID);
 	}
 
 	void OpenGLVertexBuffer::Bind() const
 	{
 		
 
-		glBindBuffer(GL_ARRAY_BUFFER, m_RendererID);
+		glBindBuffer(GL_ARRAY_BUFFER, GetRendererID());
 	}
 
 	void OpenGLVertexBuffer::Unbind() const
@@ -52,6 +57,7 @@ namespace Graphics {
 	void OpenGLVertexBuffer::ResizeBuffer(uint32_t size)
 	{
 		assert(!isStatic, "This Vertex Buffer is Static");
+		assert(!m_Range, "Arena ranges can not be resized");
 		glBindBuffer(GL_ARRAY_BUFFER, m_RendererID);
 		glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
 	}
@@ -59,6 +65,11 @@ namespace Graphics {
 	void OpenGLVertexBuffer::SetData(const void* data, uint32_t size, uint32_t offset)
 	{
 		assert(!isStatic, "This Vertex Buffer is Static");
+		if (m_Range)
+		{
+			m_Range->SetData(data, size, offset);
+			return;
+		}
 		glBindBuffer(GL_ARRAY_BUFFER, m_RendererID);
 		glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
 	}
@@ -93,25 +104,51 @@ namespace Graphics {
 		glBufferData(GL_ARRAY_BUFFER, count * sizeof(uint32_t), nullptr, GL_DYNAMIC_DRAW);
 	}
 
+	OpenGLIndexBuffer::OpenGLIndexBuffer(const Ref<BufferRange>& range, uint32_t count)
+		: m_Range(range), m_Count(count), isStatic(false)
+	{
+		GRAPHICS_CORE_ASSERT(range->GetSize() >= count * sizeof(uint32_t), "Index buffer range is too small!");
+	}
+
 	void OpenGLIndexBuffer::SetData(const uint32_t* data, uint32_t count, uint32_t offset)
 	{
 		assert(!isStatic, "This Vertex Buffer is Static");
+		m_Type = IndexType::UInt32;
+		if (m_Range)
+		{
+			m_Range->SetData(data, count * sizeof(uint32_t), offset);
+			return;
+		}
 		glBindBuffer(GL_ARRAY_BUFFER, m_RendererID);
 		glBufferSubData(GL_ARRAY_BUFFER, offset, count * sizeof(uint32_t), data);
 	}
 
+	void OpenGLIndexBuffer::SetData(const uint16_t* data, uint32_t count, uint32_t offset)
+	{
+		assert(!isStatic, "This Vertex Buffer is Static");
+		m_Type = IndexType::UInt16;
+		if (m_Range)
+		{
+			m_Range->SetData(data, count * sizeof(uint16_t), offset);
+			return;
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, m_RendererID);
+		glBufferSubData(GL_ARRAY_BUFFER, offset, count * sizeof(uint16_t), data);
+	}
+
 	OpenGLIndexBuffer::~OpenGLIndexBuffer()
 	{
 		
 
-		glDeleteBuffers(1, &m_RendererID);
+		if (!m_Range)
+			glDeleteBuffers(1, &m_RendererID);
 	}
 
 	void OpenGLIndexBuffer::Bind() const
 	{
 		
 
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, GetRendererID());
 	}
 
 	void OpenGLIndexBuffer::Unbind() const
@@ -9,6 +9,7 @@ namespace Graphics {
 	public:
 		OpenGLVertexBuffer(uint32_t size);
 		OpenGLVertexBuffer(float* vertices, uint32_t size);
+		OpenGLVertexBuffer(const Ref<BufferRange>& range);
 		virtual ~OpenGLVertexBuffer();
 
 		virtual void Bind() const override;
@@ -20,8 +21,13 @@ namespace Graphics {
 
 		virtual const BufferLayout& GetLayout() const override { return m_Layout; }
 		virtual void SetLayout(const BufferLayout& layout) override { m_Layout = layout; }
+
+		virtual uint32_t GetRendererID() const override { return m_Range ? m_Range->GetRendererID() : m_RendererID; }
+		virtual uint64_t GetOffset() const override { return m_Range ? m_Range->GetOffset() : 0; }
 	private:
-		uint32_t m_RendererID;
+		uint32_t m_RendererID = 0;
+		// Set when the vertices live in an arena range, which owns the buffer object
+		Ref<BufferRange> m_Range;
 		BufferLayout m_Layout;
 		bool isStatic = true;
 	};
@@ -31,16 +37,24 @@ namespace Graphics {
 	public:
 		OpenGLIndexBuffer(uint32_t* indices, uint32_t count);
 		OpenGLIndexBuffer(uint32_t count);
+		OpenGLIndexBuffer(const Ref<BufferRange>& range, uint32_t count);
 		virtual ~OpenGLIndexBuffer();
 
 		virtual void Bind() const;
 		virtual void Unbind() const;
 		virtual void SetData(const uint32_t* data, uint32_t count, uint32_t offset = 0) override;
+		virtual void SetData(const uint16_t* data, uint32_t count, uint32_t offset = 0) override;
 
 		virtual uint32_t GetCount() const { return m_Count; }
+		virtual IndexType GetIndexType() const override { return m_Type; }
+
+		virtual uint32_t GetRendererID() const override { return m_Range ? m_Range->GetRendererID() : m_RendererID; }
+		virtual uint64_t GetOffset() const override { return m_Range ? m_Range->GetOffset() : 0; }
 	private:
-		uint32_t m_RendererID;
+		uint32_t m_RendererID = 0;
+		Ref<BufferRange> m_Range;
 		uint32_t m_Count;
+		IndexType m_Type = IndexType::UInt32;
 		bool isStatic = true;
 	};
 
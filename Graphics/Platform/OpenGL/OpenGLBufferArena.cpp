@@ -0,0 +1,211 @@
+#include "OpenGLBufferArena.h"
+#include "OpenGLStateCache.h"
+
+#include <Logger.h>
+#include <algorithm>
+
+namespace Graphics {
+
+	namespace Utils {
+
+		static GLenum BufferArenaUsageToGLTarget(BufferArenaUsage usage)
+		{
+			switch (usage)
+			{
+				case BufferArenaUsage::Vertex:   return GL_ARRAY_BUFFER;
+				case BufferArenaUsage::Index:    return GL_ELEMENT_ARRAY_BUFFER;
+				case BufferArenaUsage::Uniform:  return GL_UNIFORM_BUFFER;
+				case BufferArenaUsage::Storage:  return GL_SHADER_STORAGE_BUFFER;
+			}
+
+			GRAPHICS_CORE_ASSERT(false, "Unknown BufferArenaUsage!");
+			return 0;
+		}
+
+		static uint64_t DefaultAlignment(BufferArenaUsage usage)
+		{
+			GLint alignment = 0;
+			switch (usage)
+			{
+				case BufferArenaUsage::Vertex:   return 16;
+				case BufferArenaUsage::Index:    return 4;
+				case BufferArenaUsage::Uniform:  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment); break;
+				case BufferArenaUsage::Storage:  glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment); break;
+			}
+			return alignment > 0 ? (uint64_t)alignment : 256;
+		}
+
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+	// BufferArena //////////////////////////////////////////////////////////////
+	/////////////////////////////////////////////////////////////////////////////
+
+	OpenGLBufferArena::OpenGLBufferArena(const BufferArenaSpecification& spec)
+		: m_Specification(spec), m_Target(Utils::BufferArenaUsageToGLTarget(spec.Usage))
+	{
+		m_DefaultAlignment = Utils::DefaultAlignment(spec.Usage);
+	}
+
+	OpenGLBufferArena::~OpenGLBufferArena()
+	{
+		for (auto& block : m_Blocks)
+		{
+			// Ranges that outlive the arena report a renderer id of 0
+			for (OpenGLBufferRange* range : block->Ranges)
+				range->m_Block = nullptr;
+			DeleteBlock(*block);
+		}
+	}
+
+	OpenGLBufferArena::Block& OpenGLBufferArena::CreateBlock(uint64_t capacity)
+	{
+		auto& block = m_Blocks.emplace_back(CreateScope<Block>());
+		block->Allocator.Reset(capacity);
+
+		// Dynamic storage, ranges are written with glNamedBufferSubData
+		glCreateBuffers(1, &block->RendererID);
+		glNamedBufferStorage(block->RendererID, (GLsizeiptr)capacity, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+		LOG_DEBUG_STREAM << "Buffer arena " << m_Specification.DebugName << ": new " << capacity << " byte buffer, " << m_Blocks.size() << " in use";
+		return *block;
+	}
+
+	void OpenGLBufferArena::DeleteBlock(Block& block)
+	{
+		OpenGLStateCache::OnBufferDeleted(block.RendererID);
+		glDeleteBuffers(1, &block.RendererID);
+		block.RendererID = 0;
+	}
+
+	Ref<BufferRange> OpenGLBufferArena::Allocate(uint64_t size, uint64_t alignment)
+	{
+		if (alignment == 0)
+			alignment = m_DefaultAlignment;
+
+		TLSFAllocator::Allocation allocation;
+		Block* block = nullptr;
+		for (auto& candidate : m_Blocks)
+		{
+			allocation = candidate->Allocator.Allocate(size, alignment);
+			if (allocation.IsValid())
+			{
+				block = candidate.get();
+				break;
+			}
+		}
+
+		if (!block)
+		{
+			block = &CreateBlock(std::max(m_Specification.BlockSize, size + alignment - 1));
+			allocation = block->Allocator.Allocate(size, alignment);
+			GRAPHICS_CORE_ASSERT(allocation.IsValid(), "Buffer arena could not allocate from a new buffer!");
+		}
+
+		Ref<OpenGLBufferRange> range = CreateRef<OpenGLBufferRange>();
+		range->m_Arena = weak_from_this();
+		range->m_Block = block;
+		range->m_Allocation = allocation;
+		range->m_Alignment = alignment;
+		range->m_Target = m_Target;
+		block->Ranges.insert(range.get());
+		return range;
+	}
+
+	void OpenGLBufferArena::Free(OpenGLBufferRange& range)
+	{
+		Block& block = *range.m_Block;
+		block.Allocator.Free(range.m_Allocation);
+		block.Ranges.erase(&range);
+
+		// Keep the first buffer around, allocations tend to come back
+		if (block.Ranges.empty() && m_Blocks.size() > 1)
+		{
+			DeleteBlock(block);
+			m_Blocks.erase(std::find_if(m_Blocks.begin(), m_Blocks.end(), [&](const Scope<Block>& b) { return b.get() == &block; }));
+		}
+	}
+
+	void OpenGLBufferArena::Defragment()
+	{
+		const BufferArenaStatistics before = GetStatistics();
+		if (m_Blocks.size() <= 1 && before.FreeBlockCount <= 1)
+			return;
+
+		// Gather every live range in buffer then offset order so the packed layout keeps their relative order
+		std::vector<OpenGLBufferRange*> ranges;
+		uint64_t capacity = 0;
+		for (auto& block : m_Blocks)
+		{
+			const size_t first = ranges.size();
+			ranges.insert(ranges.end(), block->Ranges.begin(), block->Ranges.end());
+			std::sort(ranges.begin() + first, ranges.end(), [](const OpenGLBufferRange* a, const OpenGLBufferRange* b) { return a->GetOffset() < b->GetOffset(); });
+		}
+		for (OpenGLBufferRange* range : ranges)
+			capacity += range->GetSize() + range->m_Alignment - 1;
+
+		std::vector<Scope<Block>> oldBlocks = std::move(m_Blocks);
+		m_Blocks.clear();
+		Block& packed = CreateBlock(std::max(m_Specification.BlockSize, capacity));
+
+		for (OpenGLBufferRange* range : ranges)
+		{
+			TLSFAllocator::Allocation allocation = packed.Allocator.Allocate(range->GetSize(), range->m_Alignment);
+			GRAPHICS_CORE_ASSERT(allocation.IsValid(), "Buffer arena ran out of space while defragmenting!");
+
+			glCopyNamedBufferSubData(range->m_Block->RendererID, packed.RendererID, (GLintptr)range->GetOffset(), (GLintptr)allocation.Offset, (GLsizeiptr)range->GetSize());
+			range->m_Block = &packed;
+			range->m_Allocation = allocation;
+			packed.Ranges.insert(range);
+		}
+
+		for (auto& block : oldBlocks)
+			DeleteBlock(*block);
+		m_Generation++;
+
+		const BufferArenaStatistics after = GetStatistics();
+		LOG_DEBUG_STREAM << "Buffer arena " << m_Specification.DebugName << " defragmented: " << before.BufferCount << " -> " << after.BufferCount
+			<< " buffers, fragmentation " << before.Fragmentation << " -> " << after.Fragmentation;
+	}
+
+	BufferArenaStatistics OpenGLBufferArena::GetStatistics() const
+	{
+		BufferArenaStatistics stats;
+		stats.BufferCount = (uint32_t)m_Blocks.size();
+		for (const auto& block : m_Blocks)
+		{
+			const TLSFAllocator::Statistics blockStats = block->Allocator.GetStatistics();
+			stats.Capacity += blockStats.Capacity;
+			stats.UsedBytes += blockStats.UsedBytes;
+			stats.FreeBytes += blockStats.FreeBytes;
+			stats.LargestFreeBlock = std::max(stats.LargestFreeBlock, blockStats.LargestFreeBlock);
+			stats.AllocationCount += blockStats.AllocationCount;
+			stats.FreeBlockCount += blockStats.FreeBlockCount;
+		}
+		stats.Fragmentation = stats.FreeBytes ? 1.0f - (float)((double)stats.LargestFreeBlock / (double)stats.FreeBytes) : 0.0f;
+		return stats;
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+	// BufferRange //////////////////////////////////////////////////////////////
+	/////////////////////////////////////////////////////////////////////////////
+
+	OpenGLBufferRange::~OpenGLBufferRange()
+	{
+		if (auto arena = m_Arena.lock(); arena && m_Block)
+			arena->Free(*this);
+	}
+
+	void OpenGLBufferRange::SetData(const void* data, uint64_t size, uint64_t offset)
+	{
+		GRAPHICS_CORE_ASSERT(offset + size <= m_Allocation.Size, "Data does not fit the buffer range!");
+		glNamedBufferSubData(m_Block->RendererID, (GLintptr)(m_Allocation.Offset + offset), (GLsizeiptr)size, data);
+	}
+
+	void OpenGLBufferRange::Bind(uint32_t binding) const
+	{
+		GRAPHICS_CORE_ASSERT(m_Target == GL_UNIFORM_BUFFER || m_Target == GL_SHADER_STORAGE_BUFFER, "Only uniform and storage ranges have binding points!");
+		OpenGLStateCache::BindBufferRange(m_Target, binding, m_Block->RendererID, (GLintptr)m_Allocation.Offset, (GLsizeiptr)m_Allocation.Size);
+	}
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Renderer/BufferArena.h"
+#include "Renderer/TLSFAllocator.h"
+
+#include <glad/gl.h>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+namespace Graphics {
+
+	class OpenGLBufferRange;
+
+	class OpenGLBufferArena : public BufferArena, public std::enable_shared_from_this<OpenGLBufferArena>
+	{
+	public:
+		OpenGLBufferArena(const BufferArenaSpecification& spec);
+		virtual ~OpenGLBufferArena();
+
+		virtual Ref<BufferRange> Allocate(uint64_t size, uint64_t alignment = 0) override;
+		virtual void Defragment() override;
+
+		virtual BufferArenaStatistics GetStatistics() const override;
+		virtual uint32_t GetGeneration() const override { return m_Generation; }
+		virtual const BufferArenaSpecification& GetSpecification() const override { return m_Specification; }
+	private:
+		struct Block
+		{
+			uint32_t RendererID = 0;
+			TLSFAllocator Allocator;
+			std::unordered_set<OpenGLBufferRange*> Ranges;
+		};
+
+		Block& CreateBlock(uint64_t capacity);
+		void DeleteBlock(Block& block);
+		void Free(OpenGLBufferRange& range);
+	private:
+		BufferArenaSpecification m_Specification;
+		GLenum m_Target;
+		uint64_t m_DefaultAlignment = 16;
+		// Scoped so ranges can point at their block while the vector grows
+		std::vector<Scope<Block>> m_Blocks;
+		uint32_t m_Generation = 0;
+
+		friend class OpenGLBufferRange;
+	};
+
+	class OpenGLBufferRange : public BufferRange
+	{
+	public:
+		virtual ~OpenGLBufferRange();
+
+		virtual uint32_t GetRendererID() const override { return m_Block ? m_Block->RendererID : 0; }
+		virtual uint64_t GetOffset() const override { return m_Allocation.Offset; }
+		virtual uint64_t GetSize() const override { return m_Allocation.Size; }
+
+		virtual void SetData(const void* data, uint64_t size, uint64_t offset = 0) override;
+		virtual void Bind(uint32_t binding) const override;
+	private:
+		std::weak_ptr<OpenGLBufferArena> m_Arena;
+		OpenGLBufferArena::Block* m_Block = nullptr;
+		TLSFAllocator::Allocation m_Allocation;
+		uint64_t m_Alignment = 1;
+		GLenum m_Target = 0;
+
+		friend class OpenGLBufferArena;
+	};
+
+}
@@ -30,4 +30,9 @@ namespace Graphics {
 		glfwSwapBuffers(m_WindowHandle);
 	}
 
+	void OpenGLContext::MakeCurrent(bool current)
+	{
+		glfwMakeContextCurrent(current ? m_WindowHandle : nullptr);
+	}
+
 }
@@ -13,6 +13,7 @@ namespace Graphics {
 
 		virtual void Init() override;
 		virtual void SwapBuffers() override;
+		virtual void MakeCurrent(bool current) override;
 	private:
 		GLFWwindow* m_WindowHandle;
 	};
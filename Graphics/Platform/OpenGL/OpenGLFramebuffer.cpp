@@ -1,10 +1,12 @@
 
 #include <cstdint>
 #include "Platform/OpenGL/OpenGLFramebuffer.h"
+#include "Platform/OpenGL/OpenGLStateCache.h"
 
 #include <glad/gl.h>
 #include <Logger.h>
 #include <cassert>
+#include <cstring>
 #include <glm/ext/vector_float4.hpp>
 
 namespace Graphics {
@@ -134,16 +136,30 @@ namespace Graphics {
 
 	OpenGLFramebuffer::~OpenGLFramebuffer()
 	{
+		OpenGLStateCache::OnFramebufferDeleted(m_RendererID);
+		OpenGLStateCache::OnTexturesDeleted(m_ColorAttachments.size(), m_ColorAttachments.data());
+		OpenGLStateCache::OnTexturesDeleted(1, &m_DepthAttachment);
 		glDeleteFramebuffers(1, &m_RendererID);
 		glDeleteTextures(m_ColorAttachments.size(), m_ColorAttachments.data());
 		glDeleteTextures(1, &m_DepthAttachment);
 		glDeleteTextures(1, &m_StencilAttachment);
+
+		for (PendingCapture& slot : m_CaptureRing)
+		{
+			if (slot.Fence)
+				glDeleteSync(slot.Fence);
+			if (slot.Buffer)
+				glDeleteBuffers(1, &slot.Buffer);
+		}
 	}
 
 	void OpenGLFramebuffer::Invalidate()
 	{
 		if (m_RendererID)
 		{
+			OpenGLStateCache::OnFramebufferDeleted(m_RendererID);
+			OpenGLStateCache::OnTexturesDeleted(m_ColorAttachments.size(), m_ColorAttachments.data());
+			OpenGLStateCache::OnTexturesDeleted(1, &m_DepthAttachment);
 			glDeleteFramebuffers(1, &m_RendererID);
 			glDeleteTextures(m_ColorAttachments.size(), m_ColorAttachments.data());
 			glDeleteTextures(1, &m_DepthAttachment);
@@ -154,7 +170,7 @@ namespace Graphics {
 		}
 
 		glCreateFramebuffers(1, &m_RendererID);
-		glBindFramebuffer(GL_FRAMEBUFFER, m_RendererID);
+		OpenGLStateCache::BindFramebuffer(GL_FRAMEBUFFER, m_RendererID);
 
 		bool multisample = m_Specification.Samples > 1;
 
@@ -198,23 +214,25 @@ namespace Graphics {
 		else if (m_ColorAttachments.empty())
 		{
 			// Only depth-pass
-			glDrawBuffer(GL_NONE);
+			OpenGLStateCache::DrawBuffer(GL_NONE);
 		}
 
 		assert(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE, "Framebuffer is incomplete!");
 
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		// Attachments were set up through glBindTexture on the active unit
+		OpenGLStateCache::InvalidateTextureUnit(0);
+		OpenGLStateCache::BindFramebuffer(GL_FRAMEBUFFER, 0);
 	}
 
 	void OpenGLFramebuffer::Bind()
 	{
-		glBindFramebuffer(GL_FRAMEBUFFER, m_RendererID);
-		glViewport(0, 0, m_Specification.Width, m_Specification.Height);
+		OpenGLStateCache::BindFramebuffer(GL_FRAMEBUFFER, m_RendererID);
+		OpenGLStateCache::Viewport(0, 0, m_Specification.Width, m_Specification.Height);
 	}
 
 	void OpenGLFramebuffer::Unbind()
 	{
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		OpenGLStateCache::BindFramebuffer(GL_FRAMEBUFFER, 0);
 	}
 
 	void OpenGLFramebuffer::Resize(uint32_t width, uint32_t height)
@@ -253,26 +271,126 @@ namespace Graphics {
 	void OpenGLFramebuffer::DrawToAllColorBuffers() {
 		assert(m_ColorAttachments.size() <= 4);
 		GLenum buffers[4] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3 };
-		glDrawBuffers(m_ColorAttachments.size(), buffers);
+		OpenGLStateCache::DrawBuffers(m_ColorAttachments.size(), buffers);
 	}
 
 	void OpenGLFramebuffer::SetDrawBuffer(uint8_t index) {
 		assert(index < m_ColorAttachments.size());
-		glDrawBuffer(GL_COLOR_ATTACHMENT0 + index);
+		OpenGLStateCache::DrawBuffer(GL_COLOR_ATTACHMENT0 + index);
 	}
 
 	void OpenGLFramebuffer::BindColorAttachmentAsTexture(uint32_t index, uint32_t slot) {
 		assert(index < m_ColorAttachments.size());
-		glBindTextureUnit(slot, m_ColorAttachments[index]);
+		OpenGLStateCache::BindTextureUnit(slot, m_ColorAttachments[index]);
 	}
 
 	void OpenGLFramebuffer::BlitBuffers(uint32_t src, uint32_t srcX0, uint32_t srcY0, uint32_t srcX1, uint32_t srcY1, uint32_t dstX0, uint32_t dstY0, uint32_t dstX1, uint32_t dstY1, uint32_t mask, uint16_t filter)
 	{
-		glBindFramebuffer(GL_READ_FRAMEBUFFER, src);
-		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_RendererID);
+		OpenGLStateCache::BindFramebuffer(GL_READ_FRAMEBUFFER, src);
+		OpenGLStateCache::BindFramebuffer(GL_DRAW_FRAMEBUFFER, m_RendererID);
 		glBlitFramebuffer(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter);
-		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
-		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 		Bind();
 	}
+
+	void OpenGLFramebuffer::CaptureAttachmentAsync(uint32_t attachmentIndex, const FramebufferCaptureFn& callback)
+	{
+		assert(attachmentIndex < m_ColorAttachments.size());
+		assert(m_Specification.Samples == 1, "Multisampled attachments must be resolved before capturing");
+
+		if (m_ColorAttachmentSpecifications[attachmentIndex].TextureFormat != FramebufferTextureFormat::RGBA8)
+		{
+			LOG_WARN_STREAM << "Only RGBA8 attachments can be captured, attachment " << attachmentIndex << " skipped";
+			return;
+		}
+
+		// The ring is full which means the GPU is several captures behind, finish the oldest one first
+		if (m_CapturesInFlight == s_CaptureRingSize)
+			CompleteOldestCapture(true);
+
+		PendingCapture& slot = m_CaptureRing[m_CaptureHead];
+		const uint32_t width = m_Specification.Width, height = m_Specification.Height;
+		const uint32_t size = width * height * 4;
+
+		if (slot.Buffer == 0)
+			glCreateBuffers(1, &slot.Buffer);
+		if (slot.BufferSize < size)
+		{
+			glNamedBufferData(slot.Buffer, size, nullptr, GL_STREAM_READ);
+			slot.BufferSize = size;
+		}
+
+		glNamedFramebufferReadBuffer(m_RendererID, GL_COLOR_ATTACHMENT0 + attachmentIndex);
+		OpenGLStateCache::BindFramebuffer(GL_READ_FRAMEBUFFER, m_RendererID);
+
+		// With a pack buffer bound glReadPixels only queues the copy and returns immediately
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.Buffer);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		slot.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		slot.Capture = FramebufferCapture();
+		slot.Capture.Width = width;
+		slot.Capture.Height = height;
+		slot.Capture.Channels = 4;
+		slot.Capture.AttachmentIndex = attachmentIndex;
+		slot.Callback = callback;
+
+		m_CaptureHead = (m_CaptureHead + 1) % s_CaptureRingSize;
+		m_CapturesInFlight++;
+	}
+
+	uint32_t OpenGLFramebuffer::PollCaptures(bool wait)
+	{
+		while (m_CapturesInFlight > 0 && CompleteOldestCapture(wait))
+			;
+		return m_CapturesInFlight;
+	}
+
+	bool OpenGLFramebuffer::CompleteOldestCapture(bool wait)
+	{
+		const uint32_t tail = (m_CaptureHead + s_CaptureRingSize - m_CapturesInFlight) % s_CaptureRingSize;
+		PendingCapture& slot = m_CaptureRing[tail];
+
+		const GLuint64 timeout = wait ? 1000000000 : 0; // 1s
+		GLenum result;
+		do
+		{
+			result = glClientWaitSync(slot.Fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+		} while (wait && result == GL_TIMEOUT_EXPIRED);
+
+		if (result == GL_TIMEOUT_EXPIRED)
+			return false;
+
+		glDeleteSync(slot.Fence);
+		slot.Fence = nullptr;
+		m_CapturesInFlight--;
+
+		FramebufferCapture capture = std::move(slot.Capture);
+		FramebufferCaptureFn callback = std::move(slot.Callback);
+		slot.Callback = nullptr;
+
+		if (result == GL_WAIT_FAILED)
+		{
+			LOG_FATAL_STREAM << "Waiting on framebuffer capture failed";
+			return true;
+		}
+
+		const size_t size = (size_t)capture.Width * capture.Height * capture.Channels;
+		const void* mapped = glMapNamedBufferRange(slot.Buffer, 0, size, GL_MAP_READ_BIT);
+		if (!mapped)
+		{
+			LOG_FATAL_STREAM << "Failed to map framebuffer capture buffer";
+			return true;
+		}
+
+		// Rows stay in GL order, flipping is left to whoever consumes the capture off the main thread
+		capture.Pixels.resize(size);
+		memcpy(capture.Pixels.data(), mapped, size);
+		glUnmapNamedBuffer(slot.Buffer);
+
+		if (callback)
+			callback(std::move(capture));
+		return true;
+	}
 }
@@ -1,7 +1,9 @@
 #pragma once
 
 #include "Renderer/Framebuffer.h"
+#include <glad/gl.h>
 #include <vector>
+#include <array>
 #include <cassert>
 
 namespace Graphics {
@@ -43,6 +45,23 @@ namespace Graphics {
 		virtual const uint32_t getID() const override { return m_RendererID; }
 
 		virtual void BlitBuffers(uint32_t src, uint32_t srcX0, uint32_t srcY0, uint32_t srcX1, uint32_t srcY1, uint32_t dstX0, uint32_t dstY0, uint32_t dstX1, uint32_t dstY1, uint32_t mask, uint16_t filter) override;
+
+		virtual void CaptureAttachmentAsync(uint32_t attachmentIndex, const FramebufferCaptureFn& callback) override;
+		virtual uint32_t PollCaptures(bool wait = false) override;
+	private:
+		static const uint32_t s_CaptureRingSize = 3;
+
+		// One slot of the pixel pack buffer ring used for async captures
+		struct PendingCapture
+		{
+			GLuint Buffer = 0;
+			uint32_t BufferSize = 0;
+			GLsync Fence = nullptr;
+			FramebufferCapture Capture;
+			FramebufferCaptureFn Callback;
+		};
+
+		bool CompleteOldestCapture(bool wait);
 	private:
 		uint32_t m_RendererID = 0;
 		FramebufferSpecification m_Specification;
@@ -53,6 +72,9 @@ namespace Graphics {
 		std::vector<uint32_t> m_ColorAttachments = {};
 		uint32_t m_DepthAttachment = 100;
 		uint32_t m_StencilAttachment = 1;
+
+		std::array<PendingCapture, s_CaptureRingSize> m_CaptureRing;
+		uint32_t m_CaptureHead = 0, m_CapturesInFlight = 0;
 	};
 
 }
@@ -0,0 +1,143 @@
+#include "Platform/OpenGL/OpenGLHeadlessContext.h"
+
+#ifdef GRAPHICS_HEADLESS_EGL
+
+#include <glad/gl.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GraphicsCore.h>
+#include <Logger.h>
+#include <cstring>
+
+namespace Graphics {
+
+	namespace Utils {
+
+		static bool HasExtension(const char* extensions, const char* name)
+		{
+			if (!extensions)
+				return false;
+
+			const size_t length = strlen(name);
+			for (const char* it = strstr(extensions, name); it; it = strstr(it + length, name))
+			{
+				if ((it == extensions || it[-1] == ' ') && (it[length] == ' ' || it[length] == '\0'))
+					return true;
+			}
+			return false;
+		}
+
+		static EGLDisplay GetHeadlessDisplay()
+		{
+			// Prefer Mesa's surfaceless platform, it does not need a GPU, X or a DRM device
+			const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+			if (HasExtension(clientExtensions, "EGL_MESA_platform_surfaceless"))
+			{
+				auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+				if (getPlatformDisplay)
+				{
+					EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+					if (display != EGL_NO_DISPLAY)
+						return display;
+				}
+			}
+
+			return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+		}
+
+	}
+
+	OpenGLHeadlessContext::OpenGLHeadlessContext()
+	{
+	}
+
+	OpenGLHeadlessContext::~OpenGLHeadlessContext()
+	{
+		if (m_Display == EGL_NO_DISPLAY)
+			return;
+
+		eglMakeCurrent(m_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if (m_Surface != EGL_NO_SURFACE)
+			eglDestroySurface(m_Display, m_Surface);
+		if (m_Context != EGL_NO_CONTEXT)
+			eglDestroyContext(m_Display, m_Context);
+		eglTerminate(m_Display);
+	}
+
+	void OpenGLHeadlessContext::Init()
+	{
+		m_Display = Utils::GetHeadlessDisplay();
+		GRAPHICS_CORE_ASSERT(m_Display != EGL_NO_DISPLAY, "Failed to get an EGL display!");
+
+		EGLint major, minor;
+		EGLBoolean status = eglInitialize(m_Display, &major, &minor);
+		GRAPHICS_CORE_ASSERT(status, "Failed to initialize EGL!");
+		LOG_DEBUG_STREAM << "EGL " << major << "." << minor << " vendor: " << eglQueryString(m_Display, EGL_VENDOR);
+
+		const EGLint configAttributes[] = {
+			EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+			EGL_RED_SIZE, 8,
+			EGL_GREEN_SIZE, 8,
+			EGL_BLUE_SIZE, 8,
+			EGL_ALPHA_SIZE, 8,
+			EGL_DEPTH_SIZE, 24,
+			EGL_NONE
+		};
+		EGLConfig config;
+		EGLint configCount = 0;
+		status = eglChooseConfig(m_Display, configAttributes, &config, 1, &configCount);
+		GRAPHICS_CORE_ASSERT(status && configCount > 0, "No EGL config supports desktop OpenGL!");
+
+		eglBindAPI(EGL_OPENGL_API);
+
+		// Same profile as the windowed context, fall back to core for drivers without compatibility contexts
+		for (EGLint profile : { EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT })
+		{
+			const EGLint contextAttributes[] = {
+				EGL_CONTEXT_MAJOR_VERSION, 4,
+				EGL_CONTEXT_MINOR_VERSION, 5,
+				EGL_CONTEXT_OPENGL_PROFILE_MASK, profile,
+				EGL_NONE
+			};
+			m_Context = eglCreateContext(m_Display, config, EGL_NO_CONTEXT, contextAttributes);
+			if (m_Context != EGL_NO_CONTEXT)
+				break;
+		}
+		GRAPHICS_CORE_ASSERT(m_Context != EGL_NO_CONTEXT, "Failed to create an OpenGL 4.5 EGL context!");
+
+		// Surfaceless when supported, otherwise a tiny pbuffer just to make the context current
+		if (!Utils::HasExtension(eglQueryString(m_Display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context"))
+		{
+			const EGLint pbufferAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+			m_Surface = eglCreatePbufferSurface(m_Display, config, pbufferAttributes);
+			GRAPHICS_CORE_ASSERT(m_Surface != EGL_NO_SURFACE, "Failed to create an EGL pbuffer!");
+		}
+
+		status = eglMakeCurrent(m_Display, m_Surface, m_Surface, m_Context);
+		GRAPHICS_CORE_ASSERT(status, "Failed to make the EGL context current!");
+
+		int version = gladLoadGL((GLADloadfunc)eglGetProcAddress);
+		GRAPHICS_CORE_ASSERT(version, "Failed to initialize Glad!");
+		GRAPHICS_CORE_ASSERT(GLAD_VERSION_MAJOR(version) > 4 || (GLAD_VERSION_MAJOR(version) == 4 && GLAD_VERSION_MINOR(version) >= 5), "Headless rendering requires at least OpenGL version 4.5!");
+
+		LOG_DEBUG_STREAM << "Headless OpenGL renderer: " << glGetString(GL_RENDERER);
+	}
+
+	void OpenGLHeadlessContext::SwapBuffers()
+	{
+		// Nothing is presented, just make sure the frame gets submitted
+		glFlush();
+	}
+
+	void OpenGLHeadlessContext::MakeCurrent(bool current)
+	{
+		if (current)
+			eglMakeCurrent(m_Display, m_Surface, m_Surface, m_Context);
+		else
+			eglMakeCurrent(m_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	}
+
+}
+
+#endif
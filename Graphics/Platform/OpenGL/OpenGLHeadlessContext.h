@@ -0,0 +1,28 @@
+#pragma once
+
+#include "Renderer/GraphicsContext.h"
+
+#ifdef GRAPHICS_HEADLESS_EGL
+
+namespace Graphics {
+
+	// Surfaceless EGL context (pbuffer fallback), works on display-less machines with Mesa llvmpipe.
+	// Everything is rendered into framebuffers, there is no default framebuffer to present.
+	class OpenGLHeadlessContext : public GraphicsContext
+	{
+	public:
+		OpenGLHeadlessContext();
+		virtual ~OpenGLHeadlessContext();
+
+		virtual void Init() override;
+		virtual void SwapBuffers() override;
+		virtual void MakeCurrent(bool current) override;
+	private:
+		void* m_Display = nullptr;
+		void* m_Context = nullptr;
+		void* m_Surface = nullptr;
+	};
+
+}
+
+#endif
@@ -0,0 +1,185 @@
+#include "GraphicsCore.h"
+#include "Platform/OpenGL/OpenGLPipeline.h"
+#include "Platform/OpenGL/OpenGLStateCache.h"
+
+#include <Logger.h>
+#include <atomic>
+
+namespace Graphics {
+
+	static std::atomic<uint32_t> s_PipelineSerial = 0;
+
+	namespace Utils {
+
+		static GLenum CompareFuncToGL(CompareFunc func)
+		{
+			switch (func)
+			{
+				case CompareFunc::Never:        return GL_NEVER;
+				case CompareFunc::Less:         return GL_LESS;
+				case CompareFunc::Equal:        return GL_EQUAL;
+				case CompareFunc::LessEqual:    return GL_LEQUAL;
+				case CompareFunc::Greater:      return GL_GREATER;
+				case CompareFunc::NotEqual:     return GL_NOTEQUAL;
+				case CompareFunc::GreaterEqual: return GL_GEQUAL;
+				case CompareFunc::Always:       return GL_ALWAYS;
+			}
+
+			GRAPHICS_CORE_ASSERT(false, "Unknown CompareFunc!");
+			return GL_ALWAYS;
+		}
+
+		static GLenum BlendFactorToGL(BlendFactor factor)
+		{
+			switch (factor)
+			{
+				case BlendFactor::Zero:             return GL_ZERO;
+				case BlendFactor::One:              return GL_ONE;
+				case BlendFactor::SrcAlpha:         return GL_SRC_ALPHA;
+				case BlendFactor::OneMinusSrcAlpha: return GL_ONE_MINUS_SRC_ALPHA;
+				case BlendFactor::DstAlpha:         return GL_DST_ALPHA;
+				case BlendFactor::OneMinusDstAlpha: return GL_ONE_MINUS_DST_ALPHA;
+				case BlendFactor::SrcColor:         return GL_SRC_COLOR;
+				case BlendFactor::OneMinusSrcColor: return GL_ONE_MINUS_SRC_COLOR;
+				case BlendFactor::DstColor:         return GL_DST_COLOR;
+				case BlendFactor::OneMinusDstColor: return GL_ONE_MINUS_DST_COLOR;
+			}
+
+			GRAPHICS_CORE_ASSERT(false, "Unknown BlendFactor!");
+			return GL_ONE;
+		}
+
+		static GLenum StencilOpToGL(StencilOp op)
+		{
+			switch (op)
+			{
+				case StencilOp::Keep:          return GL_KEEP;
+				case StencilOp::Zero:          return GL_ZERO;
+				case StencilOp::Replace:       return GL_REPLACE;
+				case StencilOp::Increment:     return GL_INCR;
+				case StencilOp::IncrementWrap: return GL_INCR_WRAP;
+				case StencilOp::Decrement:     return GL_DECR;
+				case StencilOp::DecrementWrap: return GL_DECR_WRAP;
+				case StencilOp::Invert:        return GL_INVERT;
+			}
+
+			GRAPHICS_CORE_ASSERT(false, "Unknown StencilOp!");
+			return GL_KEEP;
+		}
+
+		static GLenum PolygonModeToGL(PolygonMode mode)
+		{
+			switch (mode)
+			{
+				case PolygonMode::Fill:  return GL_FILL;
+				case PolygonMode::Line:  return GL_LINE;
+				case PolygonMode::Point: return GL_POINT;
+			}
+
+			GRAPHICS_CORE_ASSERT(false, "Unknown PolygonMode!");
+			return GL_FILL;
+		}
+
+		static GLenum TopologyToGL(PrimitiveTopology topology)
+		{
+			switch (topology)
+			{
+				case PrimitiveTopology::Triangles: return GL_TRIANGLES;
+				case PrimitiveTopology::Lines:     return GL_LINES;
+				case PrimitiveTopology::Points:    return GL_POINTS;
+				case PrimitiveTopology::LineStrip:     return GL_LINE_STRIP;
+				case PrimitiveTopology::TriangleStrip: return GL_TRIANGLE_STRIP;
+			}
+
+			GRAPHICS_CORE_ASSERT(false, "Unknown PrimitiveTopology!");
+			return GL_TRIANGLES;
+		}
+
+		// Matrices take one attribute location per column, same numbering as OpenGLVertexArray::AddVertexBuffer
+		static uint32_t LocationCount(const BufferElement& element)
+		{
+			if (element.Type == ShaderDataType::Mat3 || element.Type == ShaderDataType::Mat4)
+				return element.GetComponentCount();
+			return 1;
+		}
+
+	}
+
+	OpenGLPipeline::OpenGLPipeline(const PipelineSpecification& spec)
+		: m_Specification(spec)
+	{
+		GRAPHICS_CORE_ASSERT(m_Specification.Shader, "Pipeline needs a shader!");
+
+		m_SortKey = ((uint64_t)m_Specification.Layer << 32) | s_PipelineSerial++;
+
+		m_Primitive = Utils::TopologyToGL(spec.Topology);
+		m_DepthFunc = Utils::CompareFuncToGL(spec.Depth.Func);
+		m_BlendSrc = Utils::BlendFactorToGL(spec.Blend.Src);
+		m_BlendDst = Utils::BlendFactorToGL(spec.Blend.Dst);
+		m_StencilFunc = Utils::CompareFuncToGL(spec.Stencil.Func);
+		m_StencilFail = Utils::StencilOpToGL(spec.Stencil.StencilFail);
+		m_StencilDepthFail = Utils::StencilOpToGL(spec.Stencil.DepthFail);
+		m_StencilPass = Utils::StencilOpToGL(spec.Stencil.Pass);
+		m_PolygonMode = Utils::PolygonModeToGL(spec.Raster.Mode);
+	}
+
+	void OpenGLPipeline::Bind()
+	{
+		const PipelineSpecification& spec = m_Specification;
+
+		spec.Shader->Bind();
+		if (spec.Shader->GetId() != m_ValidatedProgram)
+			Validate();
+
+		OpenGLStateCache::SetCapability(GL_DEPTH_TEST, spec.Depth.TestEnable);
+		OpenGLStateCache::DepthMask(spec.Depth.WriteEnable);
+		OpenGLStateCache::DepthFunc(m_DepthFunc);
+
+		OpenGLStateCache::SetCapability(GL_STENCIL_TEST, spec.Stencil.Enable);
+		if (spec.Stencil.Enable)
+		{
+			OpenGLStateCache::StencilMask(spec.Stencil.WriteMask);
+			OpenGLStateCache::StencilFunc(m_StencilFunc, spec.Stencil.Reference, spec.Stencil.ReadMask);
+			OpenGLStateCache::StencilOp(m_StencilFail, m_StencilDepthFail, m_StencilPass);
+		}
+
+		OpenGLStateCache::SetCapability(GL_BLEND, spec.Blend.Enable);
+		if (spec.Blend.Enable)
+			OpenGLStateCache::BlendFunc(m_BlendSrc, m_BlendDst);
+
+		OpenGLStateCache::SetCapability(GL_PRIMITIVE_RESTART_FIXED_INDEX, spec.PrimitiveRestart);
+
+		OpenGLStateCache::PolygonMode(m_PolygonMode);
+		if (spec.Topology == PrimitiveTopology::Lines || spec.Topology == PrimitiveTopology::LineStrip || spec.Raster.Mode == PolygonMode::Line)
+			OpenGLStateCache::LineWidth(spec.Raster.LineWidth);
+	}
+
+	void OpenGLPipeline::Validate()
+	{
+		m_ValidatedProgram = m_Specification.Shader->GetId();
+		// A shader that failed to compile binds program 0, its compile errors were already reported
+		if (m_ValidatedProgram == 0)
+			return;
+
+		const std::string& name = m_Specification.DebugName.empty() ? m_Specification.Shader->GetName() : m_Specification.DebugName;
+
+		std::unordered_map<std::string, uint32_t> layoutLocations;
+		uint32_t location = 0;
+		for (const BufferElement& element : m_Specification.Layout)
+		{
+			layoutLocations[element.Name] = location;
+			location += Utils::LocationCount(element);
+		}
+
+		// The layout may carry more than the shader reads (one vertex array feeds several pipelines), not less
+		for (const auto& [input, inputLocation] : m_Specification.Shader->GetVertexAttributeLocations())
+		{
+			auto it = layoutLocations.find(input);
+			if (it == layoutLocations.end())
+				LOG_WARN_STREAM << "Pipeline " << name << ": shader input " << input << " is not in the vertex layout";
+			else if (it->second != (uint32_t)inputLocation)
+				LOG_WARN_STREAM << "Pipeline " << name << ": shader input " << input << " is at location " << inputLocation << ", the vertex layout feeds it at " << it->second;
+		}
+	}
+
+}
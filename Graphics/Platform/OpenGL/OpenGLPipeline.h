@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Renderer/Pipeline.h"
+
+#include <glad/gl.h>
+
+namespace Graphics {
+
+	class OpenGLPipeline : public Pipeline
+	{
+	public:
+		OpenGLPipeline(const PipelineSpecification& spec);
+		virtual ~OpenGLPipeline() = default;
+
+		virtual void Bind() override;
+
+		virtual const PipelineSpecification& GetSpecification() const override { return m_Specification; }
+		virtual uint64_t GetSortKey() const override { return m_SortKey; }
+
+		GLenum GetPrimitive() const { return m_Primitive; }
+	private:
+		void Validate();
+	private:
+		PipelineSpecification m_Specification;
+		uint64_t m_SortKey = 0;
+
+		// Translated once, Bind() hands these straight to the state cache
+		GLenum m_Primitive;
+		GLenum m_DepthFunc;
+		GLenum m_BlendSrc, m_BlendDst;
+		GLenum m_StencilFunc;
+		GLenum m_StencilFail, m_StencilDepthFail, m_StencilPass;
+		GLenum m_PolygonMode;
+
+		// Program the layout was last checked against, a hot reload swaps the program and is checked again
+		uint32_t m_ValidatedProgram = 0;
+	};
+
+}
@@ -1,11 +1,26 @@
 #include "GraphicsCore.h"
 #include "Platform/OpenGL/OpenGLRendererAPI.h"
+#include "Platform/OpenGL/OpenGLStateCache.h"
+#include "Platform/OpenGL/OpenGLPipeline.h"
 
 #include <glad/gl.h>
 
 #include "Logger.h"
 
+#ifdef MemoryBarrier
+#undef MemoryBarrier
+#endif
+
 namespace Graphics {
+
+	namespace Utils {
+
+		static GLenum IndexTypeToGL(IndexType type)
+		{
+			return type == IndexType::UInt16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+		}
+
+	}
 	
 	void OpenGLMessageCallback(
 		unsigned source,
@@ -39,31 +54,35 @@ namespace Graphics {
 		glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, NULL, GL_FALSE);
 	#endif
 
-		glEnable(GL_BLEND);
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		OpenGLStateCache::Invalidate();
+
+		OpenGLStateCache::SetCapability(GL_BLEND, true);
+		OpenGLStateCache::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-		glEnable(GL_DEPTH_TEST);
-		glDepthFunc(GL_LEQUAL);
-		glEnable(GL_LINE_SMOOTH);
+		OpenGLStateCache::SetCapability(GL_DEPTH_TEST, true);
+		OpenGLStateCache::DepthFunc(GL_LEQUAL);
+		OpenGLStateCache::SetCapability(GL_LINE_SMOOTH, true);
 		//glEnable(GL_POLYGON_SMOOTH); // This sorta turns everything into a wireframe?
-		glEnable(GL_STENCIL_TEST);
-		glEnable(GL_MULTISAMPLE);
+		OpenGLStateCache::SetCapability(GL_STENCIL_TEST, true);
+		OpenGLStateCache::SetCapability(GL_MULTISAMPLE, true);
 	}
 
 	void OpenGLRendererAPI::SetViewport(uint32_t x, uint32_t y, uint32_t width, uint32_t height)
 	{
-		glViewport(x, y, width, height);
+		OpenGLStateCache::Viewport(x, y, width, height);
 	}
 
 	void OpenGLRendererAPI::SetClearColor(const glm::vec4& color)
 	{
-		glClearColor(color.r, color.g, color.b, color.a);
+		OpenGLStateCache::ClearColor(color.r, color.g, color.b, color.a);
 	}
 
 	void OpenGLRendererAPI::Clear(float alpha)
 	{
-		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-		glClearColor(0.2f, 0.3f, 0.3f, alpha);
+		OpenGLStateCache::PolygonMode(GL_FILL);
+		// glClear honours the depth write mask, a pipeline may have left it off
+		OpenGLStateCache::DepthMask(true);
+		OpenGLStateCache::ClearColor(0.2f, 0.3f, 0.3f, alpha);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 	}
 
@@ -73,40 +92,45 @@ namespace Graphics {
 	}
 
 	void OpenGLRendererAPI::DepthTest(bool enable) {
-		if (enable)
-			glEnable(GL_DEPTH_TEST);
-		else
-			glDisable(GL_DEPTH_TEST);
+		OpenGLStateCache::SetCapability(GL_DEPTH_TEST, enable);
 	}
 
 	void OpenGLRendererAPI::PolygonSmooth(bool enable) {
-		if (enable)
-			glEnable(GL_POLYGON_SMOOTH); // This sorta turns everything into a wireframe?
-		else
-			glDisable(GL_POLYGON_SMOOTH);
+		OpenGLStateCache::SetCapability(GL_POLYGON_SMOOTH, enable); // This sorta turns everything into a wireframe?
 	}
 
 	void OpenGLRendererAPI::ClearBuffers()
 	{
+		OpenGLStateCache::DepthMask(true);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 	}
 
 	void OpenGLRendererAPI::EnableStencil() {
-		glStencilMask(0xFF); // enable writing to the stencil buffer
+		OpenGLStateCache::StencilMask(0xFF); // enable writing to the stencil buffer
 	}
 
 	void OpenGLRendererAPI::DisableStencil() {
-		glStencilMask(0x00); // Disable writing to stencil buffer
+		OpenGLStateCache::StencilMask(0x00); // Disable writing to stencil buffer
 	}
 
 
 
 	void OpenGLRendererAPI::SetStencilFunc(unsigned int func ,bool ref,uint8_t mask) {
-		glStencilFunc(func, ref, mask);
+		OpenGLStateCache::StencilFunc(func, ref, mask);
 	}
 
 	void OpenGLRendererAPI::SetStencilOp(unsigned int sfail, unsigned int dpfail, unsigned int dppass) {
-		glStencilOp(sfail, dpfail, dppass);
+		OpenGLStateCache::StencilOp(sfail, dpfail, dppass);
+	}
+
+	void OpenGLRendererAPI::Draw(const Pipeline& pipeline, const Ref<VertexArray>& vertexArray, uint32_t count)
+	{
+		const GLenum primitive = static_cast<const OpenGLPipeline&>(pipeline).GetPrimitive();
+		vertexArray->Bind();
+		if (const auto& indexBuffer = vertexArray->GetIndexBuffer())
+			glDrawElements(primitive, count, Utils::IndexTypeToGL(indexBuffer->GetIndexType()), (const void*)indexBuffer->GetOffset());
+		else
+			glDrawArrays(primitive, 0, count);
 	}
 
 	void OpenGLRendererAPI::DrawNonIndexed(const Ref<VertexArray>& vertexArray, uint32_t count, uint32_t start)
@@ -124,7 +148,7 @@ namespace Graphics {
 		}
 		vertexArray->Bind();
 		if (indexCount < 0) indexCount = indexBuffer->GetCount();
-		glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, nullptr);
+		glDrawElements(GL_TRIANGLES, indexCount, Utils::IndexTypeToGL(indexBuffer->GetIndexType()), (const void*)indexBuffer->GetOffset());
 	}
 
 	void OpenGLRendererAPI::DrawLines(const Ref<VertexArray>& vertexArray, uint32_t vertexCount)
@@ -142,7 +166,7 @@ namespace Graphics {
 		}
 		vertexArray->Bind();
 		if (indexCount < 0) indexCount = indexBuffer->GetCount();
-		glDrawElements(GL_LINES, indexCount, GL_UNSIGNED_INT, nullptr);
+		glDrawElements(GL_LINES, indexCount, Utils::IndexTypeToGL(indexBuffer->GetIndexType()), (const void*)indexBuffer->GetOffset());
 	}
 
 	void OpenGLRendererAPI::DrawLinesInstancedBaseInstance(const Ref<VertexArray>& vertexArray, uint32_t filrst, uint32_t vertexCount, uint32_t instanceCount, uint32_t baseInstance)
@@ -151,8 +175,46 @@ namespace Graphics {
 		glDrawArraysInstancedBaseInstance(GL_LINES, filrst, vertexCount, instanceCount, baseInstance);
 	}
 
+	void OpenGLRendererAPI::Dispatch(uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ)
+	{
+		glDispatchCompute(groupsX, groupsY, groupsZ);
+	}
+
+	void OpenGLRendererAPI::DispatchIndirect(const Ref<StorageBuffer>& arguments, uint32_t offset)
+	{
+		// Not an indexed target, so not shadowed by the state cache
+		glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, arguments->GetRendererID());
+		glDispatchComputeIndirect((GLintptr)offset);
+	}
+
+	void OpenGLRendererAPI::MemoryBarrier(BarrierBits barriers)
+	{
+		if (barriers == BarrierBits::All)
+		{
+			glMemoryBarrier(GL_ALL_BARRIER_BITS);
+			return;
+		}
+
+		GLbitfield bits = 0;
+		if (barriers & BarrierBits::VertexAttribArray) bits |= GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT;
+		if (barriers & BarrierBits::ElementArray)      bits |= GL_ELEMENT_ARRAY_BARRIER_BIT;
+		if (barriers & BarrierBits::Uniform)           bits |= GL_UNIFORM_BARRIER_BIT;
+		if (barriers & BarrierBits::TextureFetch)      bits |= GL_TEXTURE_FETCH_BARRIER_BIT;
+		if (barriers & BarrierBits::ShaderImageAccess) bits |= GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+		if (barriers & BarrierBits::Command)           bits |= GL_COMMAND_BARRIER_BIT;
+		if (barriers & BarrierBits::BufferUpdate)      bits |= GL_BUFFER_UPDATE_BARRIER_BIT;
+		if (barriers & BarrierBits::ShaderStorage)     bits |= GL_SHADER_STORAGE_BARRIER_BIT;
+		if (bits)
+			glMemoryBarrier(bits);
+	}
+
+	void OpenGLRendererAPI::Finish()
+	{
+		glFinish();
+	}
+
 	void OpenGLRendererAPI::DrawWireFrameCube(const std::vector<glm::dvec3>& cube, const float& thickness) {
-		glLineWidth(thickness);
+		OpenGLStateCache::LineWidth(thickness);
 		glColor3f(1.0,1.0,1.0);
 		glBegin(GL_LINES);
 		glVertex3d(0, 0, 0);
@@ -179,17 +241,32 @@ namespace Graphics {
 
 	void OpenGLRendererAPI::SetLineWidth(float width)
 	{
-		glLineWidth(width);
+		OpenGLStateCache::LineWidth(width);
 	}
 
 	void OpenGLRendererAPI::SetRendererMode(GLint mode) 
 	{
-		glPolygonMode(GL_FRONT_AND_BACK, mode);
+		OpenGLStateCache::PolygonMode(mode);
 	}
 
 	void OpenGLRendererAPI::SetRendererModeToDefault()
 	{
-		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+		OpenGLStateCache::PolygonMode(GL_FILL);
+	}
+
+	StateCacheStatistics OpenGLRendererAPI::GetStateCacheStats() const
+	{
+		return OpenGLStateCache::GetStats();
+	}
+
+	void OpenGLRendererAPI::ResetStateCacheStats()
+	{
+		OpenGLStateCache::ResetStats();
+	}
+
+	void OpenGLRendererAPI::InvalidateStateCache()
+	{
+		OpenGLStateCache::Invalidate();
 	}
 
 }
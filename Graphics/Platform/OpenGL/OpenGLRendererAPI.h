@@ -27,6 +27,7 @@ namespace Graphics {
 
 		virtual void SetStencilOp(unsigned int sfail, unsigned int dpfail, unsigned int dppass) override;
 
+		virtual void Draw(const Pipeline& pipeline, const Ref<VertexArray>& vertexArray, uint32_t count) override;
 		virtual void DrawNonIndexed(const Ref<VertexArray>& vertexArray, uint32_t count = 0, uint32_t start = 0) override;
 		virtual void DrawIndexed(const Ref<VertexArray>& vertexArray, uint32_t indexCount = -1) override;
 		virtual void DrawLines(const Ref<VertexArray>& vertexArray, uint32_t vertexCount) override;
@@ -35,6 +36,11 @@ namespace Graphics {
 		//glDrawArraysInstancedBaseInstance(GLenum mode, GLint first, GLsizei count, GLsizei instancecount, GLuint baseinstance)
 		virtual void DrawLinesInstancedBaseInstance(const Ref<VertexArray>& vertexArray, uint32_t filrst, uint32_t vertexCount, uint32_t instanceCount, uint32_t baseInstance) override;
 
+		virtual void Dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+		virtual void DispatchIndirect(const Ref<StorageBuffer>& arguments, uint32_t offset = 0) override;
+		virtual void MemoryBarrier(BarrierBits barriers) override;
+		virtual void Finish() override;
+
 		virtual void DrawWireFrameCube(const std::vector<glm::dvec3>& cube, const float& thickness) override;
 
 		virtual void DrawGridTriangles() override;
@@ -42,6 +48,10 @@ namespace Graphics {
 		virtual void SetLineWidth(float width) override;
 		virtual void SetRendererMode(int mode) override;
 		virtual void SetRendererModeToDefault() override;
+
+		virtual StateCacheStatistics GetStateCacheStats() const override;
+		virtual void ResetStateCacheStats() override;
+		virtual void InvalidateStateCache() override;
 	};
 
 
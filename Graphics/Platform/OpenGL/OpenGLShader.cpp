@@ -1,5 +1,9 @@
 #include "GraphicsCore.h"
 #include "Platform/OpenGL/OpenGLShader.h"
+#include "Platform/OpenGL/OpenGLStateCache.h"
+#include "Platform/OpenGL/OpenGLShaderCache.h"
+#include "Renderer/ThreadPool.h"
+#include "Renderer/ShaderPreprocessor.h"
 //#include "Hazel/Core/Timer.h"
 
 #include <fstream>
@@ -29,6 +33,8 @@ namespace Graphics {
 				return GL_FRAGMENT_SHADER;
 			if (type == "geometry")
 				return GL_GEOMETRY_SHADER;
+			if (type == "compute")
+				return GL_COMPUTE_SHADER;
 
 			GRAPHICS_CORE_ASSERT(false, "Unknown shader type!");
 			return 0;
@@ -41,6 +47,7 @@ namespace Graphics {
 			case GL_VERTEX_SHADER:   return shaderc_glsl_vertex_shader;
 			case GL_FRAGMENT_SHADER: return shaderc_glsl_fragment_shader;
 			case GL_GEOMETRY_SHADER: return shaderc_glsl_geometry_shader;
+			case GL_COMPUTE_SHADER:  return shaderc_glsl_compute_shader;
 			}
 			GRAPHICS_CORE_ASSERT(false);
 			return (shaderc_shader_kind)0;
@@ -53,26 +60,90 @@ namespace Graphics {
 			case GL_VERTEX_SHADER:   return "GL_VERTEX_SHADER";
 			case GL_FRAGMENT_SHADER: return "GL_FRAGMENT_SHADER";
 			case GL_GEOMETRY_SHADER: return "GL_GEOMETRY_SHADER";
+			case GL_COMPUTE_SHADER:  return "GL_COMPUTE_SHADER";
 			}
 			GRAPHICS_CORE_ASSERT(false);
 			return nullptr;
 		}
 
-		static const char* GetCacheDirectory()
-		{
-			// TODO: make sure the assets directory is valid
-			return "resources/Shaders/cache/opengl";
-		}
-
 		static void CreateCacheDirectoryIfNeeded()
 		{
-			std::string cacheDirectory = GetCacheDirectory();
+			const std::filesystem::path& cacheDirectory = OpenGLShaderCache::GetDirectory();
 			if (!std::filesystem::exists(cacheDirectory))
 				std::filesystem::create_directories(cacheDirectory);
 
 			LOG_DEBUG_STREAM << "ShaderCache : " << std::filesystem::absolute(cacheDirectory);
 		}
 
+		// Returns 0 when there is no entry or the driver rejects it (driver update, different GPU)
+		static GLuint LoadCachedProgram(const std::filesystem::path& entryPath)
+		{
+			uint32_t format;
+			std::vector<uint8_t> binary;
+			if (!OpenGLShaderCache::LoadProgramBinary(entryPath, format, binary))
+				return 0;
+
+			GLuint program = glCreateProgram();
+			glProgramBinary(program, format, binary.data(), (GLsizei)binary.size());
+
+			GLint isLinked = GL_FALSE;
+			glGetProgramiv(program, GL_LINK_STATUS, &isLinked);
+			if (isLinked == GL_FALSE)
+			{
+				LOG_DEBUG_STREAM << "Program binary rejected by the driver, recompiling " << entryPath;
+				glDeleteProgram(program);
+				std::error_code error;
+				std::filesystem::remove(entryPath, error);
+				return 0;
+			}
+			return program;
+		}
+
+		static void StoreCachedProgram(GLuint program, const std::filesystem::path& entryPath)
+		{
+			GLint length = 0;
+			glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+			if (length <= 0)
+				return;
+
+			std::vector<uint8_t> binary(length);
+			GLenum format = 0;
+			glGetProgramBinary(program, length, &length, &format, binary.data());
+			binary.resize(length);
+			OpenGLShaderCache::StoreProgramBinary(entryPath, format, binary);
+		}
+
+		// With GL_KHR_parallel_shader_compile glLinkProgram returns right away and completion is polled instead
+		static bool EnableParallelLinking()
+		{
+			static const bool s_Enabled = []() {
+				if (GLAD_GL_KHR_parallel_shader_compile)
+				{
+					glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+					return true;
+				}
+				if (GLAD_GL_ARB_parallel_shader_compile)
+				{
+					glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+					return true;
+				}
+				return false;
+			}();
+			return s_Enabled;
+		}
+
+		// Everything besides the source that changes the compiled SPIR-V has to be part of the cache key
+		static std::string CompileSettings(shaderc_target_env env, shaderc_env_version version, bool optimize, const ShaderVariant& variant)
+		{
+			return std::format("env={} version={} optimize={} variant={}", (int)env, (int)version, optimize, variant.GetKey());
+		}
+
+		static void AddVariantDefines(shaderc::CompileOptions& options, const ShaderVariant& variant)
+		{
+			for (const auto& [name, value] : variant.Defines)
+				options.AddMacroDefinition(name, value);
+		}
+
 		static const char* GLShaderStageCachedOpenGLFileExtension(uint32_t stage)
 		{
 			switch (stage)
@@ -80,6 +151,7 @@ namespace Graphics {
 			case GL_VERTEX_SHADER:    return ".cached_opengl.vert";
 			case GL_FRAGMENT_SHADER:  return ".cached_opengl.frag";
 			case GL_GEOMETRY_SHADER:  return ".cached_opengl.geom";
+			case GL_COMPUTE_SHADER:   return ".cached_opengl.comp";
 			}
 			GRAPHICS_CORE_ASSERT(false);
 			return "";
@@ -92,6 +164,7 @@ namespace Graphics {
 			case GL_VERTEX_SHADER:    return ".cached_vulkan.vert";
 			case GL_FRAGMENT_SHADER:  return ".cached_vulkan.frag";
 			case GL_GEOMETRY_SHADER:  return ".cached_vulkan.geom";
+			case GL_COMPUTE_SHADER:   return ".cached_vulkan.comp";
 			}
 			GRAPHICS_CORE_ASSERT(false);
 			return "";
@@ -100,81 +173,185 @@ namespace Graphics {
 
 	}
 
-	OpenGLShader::OpenGLShader(const std::string& filepath, bool cache)
-		: m_FilePath(filepath), m_EnableCache(cache)
+	OpenGLShader::OpenGLShader(const std::string& filepath, const ShaderVariant& variant, bool cache, bool async)
+		: m_FilePath(filepath), m_EnableCache(cache), m_Variant(variant), m_CacheName(OpenGLShaderCache::GetCacheName(filepath, variant.GetKey()))
 	{
+		Utils::CreateCacheDirectoryIfNeeded();
 
+		// Extract name from filepath
+		auto lastSlash = filepath.find_last_of("/\\");
+		lastSlash = lastSlash == std::string::npos ? 0 : lastSlash + 1;
+		auto lastDot = filepath.rfind('.');
+		auto count = lastDot == std::string::npos ? filepath.size() - lastSlash : lastDot - lastSlash;
+		m_Name = filepath.substr(lastSlash, count);
 
-		Utils::CreateCacheDirectoryIfNeeded();
+		if (async)
+		{
+			ThreadPool::Get().Submit([this]() { CompileSources(); });
+			return;
+		}
 
-		std::string source = ReadFile(filepath);
+		CompileSources();
+		WaitUntilReady();
+	}
 
+	OpenGLShader::OpenGLShader(const std::string& name, const std::string& vertexSrc, const std::string& fragmentSrc)
+		: m_Name(name)
+	{
 
-		auto shaderSources = PreProcess(source);
 
-		PreProcessIncludes(shaderSources);
+		ShaderSources sources;
+		sources[GL_VERTEX_SHADER] = { 1, vertexSrc };
+		sources[GL_FRAGMENT_SHADER] = { 1, fragmentSrc };
 
-		LOG_DEBUG_STREAM << "//////////////////////////////////////Compiling shader " << filepath;
+
+		CompileOrGetVulkanBinaries(sources);
+		CompileOrGetOpenGLBinaries(sources);
+		FillUniformLocations();
+		m_State = CompileState::Compiled;
+		WaitUntilReady();
+	}
+
+	OpenGLShader::~OpenGLShader()
+	{
+		// The compile job holds on to this shader
+		m_State.wait(CompileState::Compiling);
+
+		if (m_State == CompileState::Linking)
 		{
-			//Timer timer;
-			try {
-				//CompileOrGetVulkanBinaries(shaderSources);
-				CompileOrGetOpenGLBinaries(shaderSources);
+			for (auto id : m_PendingShaderIDs)
+				glDeleteShader(id);
+			glDeleteProgram(m_PendingProgram);
+		}
+
+		OpenGLStateCache::OnProgramDeleted(m_RendererID);
+		glDeleteProgram(m_RendererID);
+	}
+
+	void OpenGLShader::CompileSources()
+	{
+		std::string source = ReadFile(m_FilePath);
+
+		auto shaderSources = PreProcess(source);
+
+		LOG_DEBUG_STREAM << "//////////////////////////////////////Compiling shader " << m_FilePath;
+		try {
+			PreProcessIncludes(shaderSources);
+			//CompileOrGetVulkanBinaries(shaderSources);
+			CompileOrGetOpenGLBinaries(shaderSources);
 #if IS_LOG_TRACE
-				auto& shaderDataOpenGL = m_OpenGLSPIRV;
-				auto& shaderDataVulkan = m_VulkanSPIRV;
-				LOG_TRACE_STREAM << "//////////////////////////////////////Vulkan reflection";
-				for (auto&& [stage, data] : shaderDataVulkan)
-					Reflect(stage, data);
-				LOG_TRACE_STREAM << "//////////////////////////////////////OpenGL reflection";
-					for (auto&& [stage, data] : shaderDataOpenGL)
-						Reflect(stage, data);
+			auto& shaderDataOpenGL = m_OpenGLSPIRV;
+			auto& shaderDataVulkan = m_VulkanSPIRV;
+			LOG_TRACE_STREAM << "//////////////////////////////////////Vulkan reflection";
+			for (auto&& [stage, data] : shaderDataVulkan)
+				Reflect(stage, data);
+			LOG_TRACE_STREAM << "//////////////////////////////////////OpenGL reflection";
+			for (auto&& [stage, data] : shaderDataOpenGL)
+				Reflect(stage, data);
 #endif
-				CreateProgram();
-				FillVertexAttributeLocations(shaderSources);
-
-			}
-			catch (std::runtime_error e) {
-				LOG_DEBUG_STREAM << "Shader error : " << e.what();
-				LOG_DEBUG_STREAM << "//////////////////////////////////////End Compilation";
-				return;
-			}
+			FillVertexAttributeLocations(shaderSources);
+			FillWorkGroupSize();
+			FillSpecializations();
+			FillUniformLocations();
+		}
+		catch (const std::exception& e) {
+			LOG_DEBUG_STREAM << "Shader error : " << e.what();
+			m_CompileFailed = true;
+		}
+		LOG_DEBUG_STREAM << "//////////////////////////////////////End Compilation";
 
+		m_State = CompileState::Compiled;
+		m_State.notify_all();
+	}
 
-			LOG_DEBUG_STREAM << "//////////////////////////////////////End Compilation";
+	bool OpenGLShader::IsReady()
+	{
+		if (m_State == CompileState::Compiling)
+			return false;
 
+		if (m_State == CompileState::Compiled)
+			BeginLink();
 
-			//HZ_CORE_WARN("Shader creation took {0} ms", timer.ElapsedMillis());
+		if (m_State == CompileState::Linking)
+		{
+			if (Utils::EnableParallelLinking())
+			{
+				GLint completed = GL_FALSE;
+				glGetProgramiv(m_PendingProgram, GL_COMPLETION_STATUS_KHR, &completed);
+				if (completed == GL_FALSE)
+					return false;
+			}
+			FinishLink();
 		}
 
-		// Extract name from filepath
-		auto lastSlash = filepath.find_last_of("/\\");
-		lastSlash = lastSlash == std::string::npos ? 0 : lastSlash + 1;
-		auto lastDot = filepath.rfind('.');
-		auto count = lastDot == std::string::npos ? filepath.size() - lastSlash : lastDot - lastSlash;
-		m_Name = filepath.substr(lastSlash, count);
+		return true;
 	}
 
-	OpenGLShader::OpenGLShader(const std::string& name, const std::string& vertexSrc, const std::string& fragmentSrc)
-		: m_Name(name)
+	void OpenGLShader::WaitUntilReady()
 	{
+		m_State.wait(CompileState::Compiling);
 
+		if (m_State == CompileState::Compiled)
+			BeginLink();
+		if (m_State == CompileState::Linking)
+			FinishLink();
+	}
 
-		ShaderSources sources;
-		sources[GL_VERTEX_SHADER] = {0 ,vertexSrc};
-		sources[GL_FRAGMENT_SHADER] = {0 ,fragmentSrc};
+	void OpenGLShader::Reload()
+	{
+		if (m_FilePath.empty())
+			return;
 
+		// Edited again while compiling, the running reload is stale and gets restarted once it finishes
+		if (m_Reload)
+		{
+			m_ReloadQueued = true;
+			return;
+		}
 
-		CompileOrGetVulkanBinaries(sources);
-		CompileOrGetOpenGLBinaries(sources);
-		CreateProgram();
+		LOG_DEBUG_STREAM << "Reloading shader " << m_FilePath;
+		m_Reload = CreateScope<OpenGLShader>(m_FilePath, m_Variant, m_EnableCache, true);
 	}
 
-	OpenGLShader::~OpenGLShader()
+	bool OpenGLShader::ApplyReload()
 	{
+		if (!m_Reload || !m_Reload->IsReady())
+			return false;
 
+		Scope<OpenGLShader> reloaded = std::move(m_Reload);
+		if (m_ReloadQueued)
+		{
+			m_ReloadQueued = false;
+			Reload();
+			return false;
+		}
 
+		if (reloaded->m_RendererID == 0)
+		{
+			LOG_WARN_STREAM << "Reloading " << m_FilePath << " failed, keeping the previous program";
+			return false;
+		}
+
+		// Never leave a pending link of our own behind
+		WaitUntilReady();
+
+		OpenGLStateCache::OnProgramDeleted(m_RendererID);
 		glDeleteProgram(m_RendererID);
+		m_RendererID = std::exchange(reloaded->m_RendererID, 0);
+
+		m_CompileFailed = false;
+		std::swap(m_Dependencies, reloaded->m_Dependencies);
+		std::swap(m_CacheEntries, reloaded->m_CacheEntries);
+		std::swap(m_VertexAttributeLocationCache, reloaded->m_VertexAttributeLocationCache);
+		std::swap(m_VulkanSPIRV, reloaded->m_VulkanSPIRV);
+		std::swap(m_OpenGLSPIRV, reloaded->m_OpenGLSPIRV);
+		std::swap(m_OpenGLSourceCode, reloaded->m_OpenGLSourceCode);
+		std::swap(m_Specializations, reloaded->m_Specializations);
+		std::swap(m_UniformLocations, reloaded->m_UniformLocations);
+		m_WorkGroupSize = reloaded->m_WorkGroupSize;
+
+		LOG_DEBUG_STREAM << "Reloaded shader " << m_FilePath;
+		return true;
 	}
 
 	std::string OpenGLShader::ReadFile(const std::string& filepath, uint32_t* num_lines)
@@ -220,23 +397,13 @@ namespace Graphics {
 	{
 		for (auto&& [stage, program] : shaderSources)
 		{
-			auto& source = program.Source;
-			while (source.find("#include ") != source.npos)
-				{
-					const auto pos = source.find("#include ");
-					const auto p1 = source.find('<', pos);
-					const auto p2 = source.find('>', pos);
-					if (p1 == source.npos || p2 == source.npos || p2 <= p1)
-					{
-						LOG_FATALF("Error while loading shader program: %s\n", source.c_str());
-						return;
-					}
-					const std::string name = source.substr(p1 + 1, p2 - p1 - 1);
-					uint32_t num_lines;
-					const std::string include = ReadFile(name.c_str(), &num_lines);
-					source.replace(pos, p2 - pos + 1, include.c_str());
-					program.lineOffset += num_lines;
-				}
+			ShaderPreprocessor::Result result = ShaderPreprocessor::Process(program.Source, m_FilePath, program.FirstLine);
+			program.Source = std::move(result.Source);
+			for (std::string& dependency : result.Dependencies)
+			{
+				if (std::find(m_Dependencies.begin(), m_Dependencies.end(), dependency) == m_Dependencies.end())
+					m_Dependencies.push_back(std::move(dependency));
+			}
 		}
 	}
 
@@ -248,7 +415,6 @@ namespace Graphics {
 		const char* typeToken = "#type";
 		size_t typeTokenLength = strlen(typeToken);
 		size_t pos = source.find(typeToken, 0); //Start of shader type declaration line
-		uint32_t lineOffsetFromPreviousStage = 0;
 		while (pos != std::string::npos)
 		{
 			size_t eol = source.find_first_of("\r\n", pos); //End of shader type declaration line
@@ -261,15 +427,9 @@ namespace Graphics {
 			GRAPHICS_CORE_ASSERT(nextLinePos != std::string::npos, "Syntax error");
 			pos = source.find(typeToken, nextLinePos); //Start of next shader type declaration line
 
-			shaderSources[Utils::ShaderTypeFromString(type)].lineOffset -= lineOffsetFromPreviousStage;
-			shaderSources[Utils::ShaderTypeFromString(type)].Source = (pos == std::string::npos) ? source.substr(nextLinePos) : source.substr(nextLinePos, pos - nextLinePos);
-			std::istringstream iss(shaderSources[Utils::ShaderTypeFromString(type)].Source);
-			iss.unsetf(std::ios_base::skipws);
-			
-			lineOffsetFromPreviousStage = std::count(
-					std::istream_iterator<char>(iss),
-					std::istream_iterator<char>(),
-					'\n') + 1; //Last newlines are not counted
+			ShaderProgramSource& program = shaderSources[Utils::ShaderTypeFromString(type)];
+			program.FirstLine = 1 + (uint32_t)std::count(source.begin(), source.begin() + nextLinePos, '\n');
+			program.Source = (pos == std::string::npos) ? source.substr(nextLinePos) : source.substr(nextLinePos, pos - nextLinePos);
 		}
 
 		//LOG_DEBUG_STREAM << "Vertex Shader ###### \n" << shaderSources[GL_VERTEX_SHADER];
@@ -279,40 +439,6 @@ namespace Graphics {
 		return shaderSources;
 	}
 
-	std::string OpenGLShader::ResetLineOffset(const std::string& source, const std::string& filename, int lineOffset)
-	{
-		//Sample error
-		//./Resources/Shaders/MeshNormals.glsl:96: error: 'pixelFac' : undeclared identifier
-
-		std::string result;
-		std::istringstream stream(source);
-		
-		//Find the line number in error message
-		std::string line;
-
-		while (std::getline(stream, line))
-		{
-			if (line.find(filename) != std::string::npos)
-			{
-				std::string::size_type pos = line.find(":");
-				if (pos != std::string::npos)
-				{
-					std::string::size_type pos2 = line.find(":", pos + 1);
-					if (pos2 != std::string::npos)
-					{
-						std::string lineNumber = line.substr(pos + 1, pos2 - pos - 1);
-						int errorLine = std::stoi(lineNumber);
-						errorLine -= lineOffset;
-						line.replace(pos + 1, pos2 - pos - 1, std::to_string(errorLine));
-					}
-				}
-			}
-			result += line + "\n";
-		}
-
-		return result;
-	}
-
 	void OpenGLShader::CompileOrGetVulkanBinaries(const OpenGLShader::ShaderSources& shaderSources)
 	{
 		GLuint program = glCreateProgram();
@@ -323,47 +449,30 @@ namespace Graphics {
 		const bool optimize = true;
 		if (optimize)
 			options.SetOptimizationLevel(shaderc_optimization_level_performance);
+		Utils::AddVariantDefines(options, m_Variant);
 
-		std::filesystem::path cacheDirectory = Utils::GetCacheDirectory();
+		const std::string settings = Utils::CompileSettings(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_2, optimize, m_Variant);
 
 		auto& shaderData = m_VulkanSPIRV;
 		shaderData.clear();
 		for (auto&& [stage, program] : shaderSources)
 		{
-			std::filesystem::path shaderFilePath = m_FilePath;
-			std::filesystem::path cachedPath = cacheDirectory / (shaderFilePath.filename().string() + Utils::GLShaderStageCachedVulkanFileExtension(stage));
+			const uint64_t key = OpenGLShaderCache::ComputeKey(program.Source, stage, settings);
+			const std::filesystem::path cachedPath = OpenGLShaderCache::GetEntryPath(m_CacheName, key, Utils::GLShaderStageCachedVulkanFileExtension(stage));
+			m_CacheEntries.push_back(cachedPath);
 
-			std::ifstream in(cachedPath, std::ios::in | std::ios::binary);
-			if (in.is_open() && m_EnableCache)
-			{
-				in.seekg(0, std::ios::end);
-				auto size = in.tellg();
-				in.seekg(0, std::ios::beg);
-
-				auto& data = shaderData[stage];
-				data.resize(size / sizeof(uint32_t));
-				in.read((char*)data.data(), size);
-			}
-			else
+			if (!m_EnableCache || !OpenGLShaderCache::Load(cachedPath, shaderData[stage]))
 			{
 				shaderc::SpvCompilationResult module = compiler.CompileGlslToSpv(program.Source, Utils::GLShaderStageToShaderC(stage), m_FilePath.c_str(), options);
 				if (module.GetCompilationStatus() != shaderc_compilation_status_success)
 				{
-					LOG_FATAL_STREAM << "\n" << ResetLineOffset(module.GetErrorMessage(), m_FilePath, program.lineOffset);;
+					LOG_FATAL_STREAM << "\n" << module.GetErrorMessage();
 					throw(std::runtime_error("Error in compiling shader for Vulkan"));
 					GRAPHICS_CORE_ASSERT(false);
 				}
 
 				shaderData[stage] = std::vector<uint32_t>(module.cbegin(), module.cend());
-
-				std::ofstream out(cachedPath, std::ios::out | std::ios::binary);
-				if (out.is_open())
-				{
-					auto& data = shaderData[stage];
-					out.write((char*)data.data(), data.size() * sizeof(uint32_t));
-					out.flush();
-					out.close();
-				}
+				OpenGLShaderCache::Store(cachedPath, shaderData[stage]);
 			}
 		}
 
@@ -385,27 +494,18 @@ namespace Graphics {
 		if (optimize)
 			options.SetOptimizationLevel(shaderc_optimization_level_performance);
 
-		std::filesystem::path cacheDirectory = Utils::GetCacheDirectory();
+		// Defines are already baked into the Vulkan SPIR-V
+		const std::string settings = Utils::CompileSettings(shaderc_target_env_opengl, shaderc_env_version_opengl_4_5, optimize, ShaderVariant());
 
 		shaderData.clear();
 		m_OpenGLSourceCode.clear();
 		for (auto&& [stage, spirv] : m_VulkanSPIRV)
 		{
-			std::filesystem::path shaderFilePath = m_FilePath;
-			std::filesystem::path cachedPath = cacheDirectory / (shaderFilePath.filename().string() + Utils::GLShaderStageCachedOpenGLFileExtension(stage));
+			const uint64_t key = OpenGLShaderCache::ComputeKey(std::string_view((const char*)spirv.data(), spirv.size() * sizeof(uint32_t)), stage, settings);
+			const std::filesystem::path cachedPath = OpenGLShaderCache::GetEntryPath(m_CacheName, key, Utils::GLShaderStageCachedOpenGLFileExtension(stage));
+			m_CacheEntries.push_back(cachedPath);
 
-			std::ifstream in(cachedPath, std::ios::in | std::ios::binary);
-			if (in.is_open() && m_EnableCache)
-			{
-				in.seekg(0, std::ios::end);
-				auto size = in.tellg();
-				in.seekg(0, std::ios::beg);
-
-				auto& data = shaderData[stage];
-				data.resize(size / sizeof(uint32_t));
-				in.read((char*)data.data(), size);
-			}
-			else
+			if (!m_EnableCache || !OpenGLShaderCache::Load(cachedPath, shaderData[stage]))
 			{
 				spirv_cross::CompilerGLSL glslCompiler(spirv);
 				m_OpenGLSourceCode[stage] = glslCompiler.compile();
@@ -419,15 +519,7 @@ namespace Graphics {
 				}
 
 				shaderData[stage] = std::vector<uint32_t>(module.cbegin(), module.cend());
-
-				std::ofstream out(cachedPath, std::ios::out | std::ios::binary);
-				if (out.is_open())
-				{
-					auto& data = shaderData[stage];
-					out.write((char*)data.data(), data.size() * sizeof(uint32_t));
-					out.flush();
-					out.close();
-				}
+				OpenGLShaderCache::Store(cachedPath, shaderData[stage]);
 			}
 		}
 	}
@@ -442,33 +534,24 @@ namespace Graphics {
 		const bool optimize = false;
 		if (optimize)
 			options.SetOptimizationLevel(shaderc_optimization_level_performance);
+		Utils::AddVariantDefines(options, m_Variant);
 
-		std::filesystem::path cacheDirectory = Utils::GetCacheDirectory();
+		const std::string settings = Utils::CompileSettings(shaderc_target_env_opengl, shaderc_env_version_opengl_4_5, optimize, m_Variant);
 
 		shaderData.clear();
 		m_OpenGLSourceCode.clear();
 		for (auto&& [stage, program] : shaderSources)
 		{
-			std::filesystem::path shaderFilePath = m_FilePath;
-			std::filesystem::path cachedPath = cacheDirectory / (shaderFilePath.filename().string() + Utils::GLShaderStageCachedOpenGLFileExtension(stage));
-
-			std::ifstream in(cachedPath, std::ios::in | std::ios::binary);
-			if (in.is_open() && m_EnableCache)
-			{
-				in.seekg(0, std::ios::end);
-				auto size = in.tellg();
-				in.seekg(0, std::ios::beg);
+			const uint64_t key = OpenGLShaderCache::ComputeKey(program.Source, stage, settings);
+			const std::filesystem::path cachedPath = OpenGLShaderCache::GetEntryPath(m_CacheName, key, Utils::GLShaderStageCachedOpenGLFileExtension(stage));
+			m_CacheEntries.push_back(cachedPath);
 
-				auto& data = shaderData[stage];
-				data.resize(size / sizeof(uint32_t));
-				in.read((char*)data.data(), size);
-			}
-			else
+			if (!m_EnableCache || !OpenGLShaderCache::Load(cachedPath, shaderData[stage]))
 			{
 				shaderc::SpvCompilationResult module = compiler.CompileGlslToSpv(program.Source, Utils::GLShaderStageToShaderC(stage), m_FilePath.c_str(), options);
 				if (module.GetCompilationStatus() != shaderc_compilation_status_success)
 				{
-					LOG_FATAL_STREAM << "\n" << ResetLineOffset(module.GetErrorMessage(), m_FilePath, program.lineOffset);
+					LOG_FATAL_STREAM << "\n" << module.GetErrorMessage();
 					LOG_FATAL_STREAM << "Stage :" << Utils::GLShaderStageToString(stage);
 					throw(std::runtime_error("Error in compiling shader for OPENGL"));
 
@@ -476,24 +559,63 @@ namespace Graphics {
 				}
 
 				shaderData[stage] = std::vector<uint32_t>(module.cbegin(), module.cend());
-
-				std::ofstream out(cachedPath, std::ios::out | std::ios::binary);
-				if (out.is_open())
-				{
-					auto& data = shaderData[stage];
-					out.write((char*)data.data(), data.size() * sizeof(uint32_t));
-					out.flush();
-					out.close();
-				}
+				OpenGLShaderCache::Store(cachedPath, shaderData[stage]);
 			}
 		}
 	}
 
-	void OpenGLShader::CreateProgram()
+	void OpenGLShader::BeginLink()
 	{
+		if (m_CompileFailed)
+		{
+			m_RendererID = 0;
+			m_State = CompileState::Ready;
+			return;
+		}
+
+		// The linked program depends on nothing but the SPIR-V of each stage and the driver
+		std::vector<GLenum> stages;
+		for (auto&& [stage, spirv] : m_OpenGLSPIRV)
+			stages.push_back(stage);
+		std::sort(stages.begin(), stages.end());
+
+		uint64_t programKey = OpenGLShaderCache::GetDriverKey();
+		for (GLenum stage : stages)
+		{
+			const auto& spirv = m_OpenGLSPIRV[stage];
+			programKey = OpenGLShaderCache::Hash(&stage, sizeof(stage), programKey);
+			programKey = OpenGLShaderCache::Hash(spirv.data(), spirv.size() * sizeof(uint32_t), programKey);
+
+			// Specialization happens at link time, the constants are part of the program
+			const StageSpecialization& specialization = m_Specializations[stage];
+			programKey = OpenGLShaderCache::Hash(specialization.Indices.data(), specialization.Indices.size() * sizeof(uint32_t), programKey);
+			programKey = OpenGLShaderCache::Hash(specialization.Values.data(), specialization.Values.size() * sizeof(uint32_t), programKey);
+		}
+
+		m_UseProgramCache = m_EnableCache && OpenGLShaderCache::SupportsProgramBinaries();
+		m_ProgramCachePath = OpenGLShaderCache::GetEntryPath(m_CacheName, programKey, ".cached_opengl.program");
+		if (m_UseProgramCache)
+		{
+			m_CacheEntries.push_back(m_ProgramCachePath);
+			if (GLuint cached = Utils::LoadCachedProgram(m_ProgramCachePath))
+			{
+				LOG_TRACE_STREAM << "Loaded program binary " << m_ProgramCachePath;
+				m_RendererID = cached;
+				if (!m_FilePath.empty())
+					OpenGLShaderCache::WriteManifest(m_CacheName, m_FilePath, m_Dependencies, m_CacheEntries);
+				m_State = CompileState::Ready;
+				return;
+			}
+		}
+
+		Utils::EnableParallelLinking();
+
 		GLuint program = glCreateProgram();
+		if (m_UseProgramCache)
+			glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 
-		std::vector<GLuint> shaderIDs;
+		std::vector<GLuint>& shaderIDs = m_PendingShaderIDs;
+		shaderIDs.clear();
 		for (auto&& [stage, spirv] : m_OpenGLSPIRV)
 		{
 			LOG_TRACE_STREAM << "Creating " << Utils::GLShaderStageToString(stage) << " shader";
@@ -506,13 +628,25 @@ namespace Graphics {
 			}
 			glShaderBinary(1, &shaderID, GL_SHADER_BINARY_FORMAT_SPIR_V, spirv.data(), spirv.size() * sizeof(uint32_t));
 			//std::cout << "Shader ID: " << shaderID << std::endl;
-			glSpecializeShader(shaderID, "main", 0, nullptr, nullptr);
+			const StageSpecialization& specialization = m_Specializations[stage];
+			glSpecializeShader(shaderID, "main", (GLuint)specialization.Indices.size(), specialization.Indices.data(), specialization.Values.data());
 			glAttachShader(program, shaderID);
 
 		}
 
 		glLinkProgram(program);
 
+		m_PendingProgram = program;
+		m_State = CompileState::Linking;
+	}
+
+	void OpenGLShader::FinishLink()
+	{
+		GLuint program = m_PendingProgram;
+		std::vector<GLuint>& shaderIDs = m_PendingShaderIDs;
+		m_PendingProgram = 0;
+		m_State = CompileState::Ready;
+
 		GLint isLinked;
 		glGetProgramiv(program, GL_LINK_STATUS, &isLinked);
 		if (isLinked == GL_FALSE)
@@ -522,15 +656,15 @@ namespace Graphics {
 
 			std::vector<GLchar> infoLog(maxLength);
 			glGetProgramInfoLog(program, maxLength, &maxLength, infoLog.data());
-			//HZ_CORE_ERROR("Shader linking failed ({0}):\n{1}", m_FilePath, infoLog.data());
 
 			glDeleteProgram(program);
 
 			for (auto id : shaderIDs)
 				glDeleteShader(id);
+			shaderIDs.clear();
 
-			const auto& string = std::format("Shader linking failed ({}):\n{}", infoLog.data(), program);
-			throw(std::runtime_error(string));
+			LOG_FATAL_STREAM << "Shader linking failed (" << m_FilePath << "):\n" << infoLog.data();
+			m_RendererID = 0;
 			return;
 		}
 
@@ -539,8 +673,14 @@ namespace Graphics {
 			glDetachShader(program, id);
 			glDeleteShader(id);
 		}
+		shaderIDs.clear();
+
+		if (m_UseProgramCache)
+			Utils::StoreCachedProgram(program, m_ProgramCachePath);
 
 		m_RendererID = program;
+		if (!m_FilePath.empty())
+			OpenGLShaderCache::WriteManifest(m_CacheName, m_FilePath, m_Dependencies, m_CacheEntries);
 	}
 
 
@@ -563,6 +703,84 @@ namespace Graphics {
 		}
 	}
 
+	void OpenGLShader::FillWorkGroupSize()
+	{
+		m_WorkGroupSize = glm::uvec3(0);
+		auto it = m_OpenGLSPIRV.find(GL_COMPUTE_SHADER);
+		if (it == m_OpenGLSPIRV.end())
+			return;
+
+		// A compute shader has no other stages, the program is dispatched instead of drawn
+		GRAPHICS_CORE_ASSERT(m_OpenGLSPIRV.size() == 1, "A compute shader can not be linked with other stages!");
+
+		spirv_cross::Compiler compiler(it->second);
+		for (uint32_t i = 0; i < 3; i++)
+			m_WorkGroupSize[i] = compiler.get_execution_mode_argument(spv::ExecutionModeLocalSize, i);
+	}
+
+	void OpenGLShader::FillSpecializations()
+	{
+		m_Specializations.clear();
+		std::vector<uint32_t> used;
+		for (auto&& [stage, spirv] : m_OpenGLSPIRV)
+		{
+			spirv_cross::Compiler compiler(spirv);
+			StageSpecialization& specialization = m_Specializations[stage];
+			for (const spirv_cross::SpecializationConstant& declared : compiler.get_specialization_constants())
+			{
+				auto it = std::find_if(m_Variant.Constants.begin(), m_Variant.Constants.end(), [&](const auto& constant) { return constant.first == declared.constant_id; });
+				if (it == m_Variant.Constants.end())
+					continue;
+				specialization.Indices.push_back(it->first);
+				specialization.Values.push_back(it->second);
+				used.push_back(it->first);
+			}
+		}
+
+		for (const auto& [id, value] : m_Variant.Constants)
+		{
+			if (std::find(used.begin(), used.end(), id) == used.end())
+				LOG_WARN_STREAM << "Specialization constant " << id << " is not declared in " << m_FilePath;
+		}
+	}
+
+	void OpenGLShader::FillUniformLocations()
+	{
+		// SPIR-V programs have no reliable name lookup in GL, uniforms outside blocks carry explicit locations
+		m_UniformLocations.clear();
+		for (auto&& [stage, spirv] : m_OpenGLSPIRV)
+		{
+			spirv_cross::Compiler compiler(spirv);
+			spirv_cross::ShaderResources resources = compiler.get_shader_resources();
+
+			for (const auto* uniforms : { &resources.gl_plain_uniforms, &resources.sampled_images })
+			{
+				for (const auto& resource : *uniforms)
+				{
+					if (!compiler.has_decoration(resource.id, spv::DecorationLocation))
+						continue;
+					m_UniformLocations[ShaderUniformName::HashName(resource.name.c_str())] = (int)compiler.get_decoration(resource.id, spv::DecorationLocation);
+				}
+			}
+		}
+	}
+
+	int OpenGLShader::GetUniformLocation(const ShaderUniformName& name)
+	{
+		// The table is written by the compile job
+		if (m_State != CompileState::Ready)
+			WaitUntilReady();
+
+		auto it = m_UniformLocations.find(name.Hash);
+		if (it == m_UniformLocations.end())
+		{
+			LOG_WARN_STREAM << "Uniform " << name.Name << " not found in " << m_Name;
+			// Only warn once
+			it = m_UniformLocations.emplace(name.Hash, -1).first;
+		}
+		return m_RendererID ? it->second : -1;
+	}
+
 	void OpenGLShader::Reflect(GLenum stage, const std::vector<uint32_t>& shaderData)
 	{
 		spirv_cross::Compiler compiler(shaderData);
@@ -614,116 +832,149 @@ namespace Graphics {
 
 	void OpenGLShader::Bind() const
 	{
-		glUseProgram(m_RendererID);
+		// Using a shader before it is ready has to block, finishing the link is not logically a mutation
+		if (m_State != CompileState::Ready)
+			const_cast<OpenGLShader*>(this)->WaitUntilReady();
+
+		OpenGLStateCache::UseProgram(m_RendererID);
 	}
 
 	void OpenGLShader::Unbind() const
 	{
-
-
-		glUseProgram(0);
+		OpenGLStateCache::UseProgram(0);
 	}
 
 	const uint32_t& OpenGLShader::GetVertexAttributeLocation(const std::string& name) const
     {
+		// Locations come from reflection on the compile job
+		m_State.wait(CompileState::Compiling);
+
 		auto it = m_VertexAttributeLocationCache.find(name);
 		assert(it != m_VertexAttributeLocationCache.end(), "Vertex attribute not found");
 		return it->second;
     }
 
-	void OpenGLShader::SetInt(const std::string& name, int value)
+	const std::unordered_map<std::string, int>& OpenGLShader::GetVertexAttributeLocations() const
+	{
+		m_State.wait(CompileState::Compiling);
+		return m_VertexAttributeLocationCache;
+	}
+
+	glm::uvec3 OpenGLShader::GetWorkGroupSize() const
+	{
+		m_State.wait(CompileState::Compiling);
+		return m_WorkGroupSize;
+	}
+
+	void OpenGLShader::SetInt(const ShaderUniformName& name, int value)
 	{
 
 
 		UploadUniformInt(name, value);
 	}
 
-	void OpenGLShader::SetIntArray(const std::string& name, int* values, uint32_t count)
+	void OpenGLShader::SetIntArray(const ShaderUniformName& name, int* values, uint32_t count)
 	{
 		UploadUniformIntArray(name, values, count);
 	}
 
-	void OpenGLShader::SetFloat(const std::string& name, float value)
+	void OpenGLShader::SetFloat(const ShaderUniformName& name, float value)
 	{
 
 
 		UploadUniformFloat(name, value);
 	}
 
-	void OpenGLShader::SetFloat2(const std::string& name, const glm::vec2& value)
+	void OpenGLShader::SetFloat2(const ShaderUniformName& name, const glm::vec2& value)
 	{
 
 
 		UploadUniformFloat2(name, value);
 	}
 
-	void OpenGLShader::SetFloat3(const std::string& name, const glm::vec3& value)
+	void OpenGLShader::SetFloat3(const ShaderUniformName& name, const glm::vec3& value)
 	{
 
 
 		UploadUniformFloat3(name, value);
 	}
 
-	void OpenGLShader::SetFloat4(const std::string& name, const glm::vec4& value)
+	void OpenGLShader::SetFloat4(const ShaderUniformName& name, const glm::vec4& value)
 	{
 
 
 		UploadUniformFloat4(name, value);
 	}
 
-	void OpenGLShader::SetMat4(const std::string& name, const glm::mat4& value)
+	void OpenGLShader::SetMat4(const ShaderUniformName& name, const glm::mat4& value)
 	{
 
 
 		UploadUniformMat4(name, value);
 	}
 
-void OpenGLShader::UploadUniformInt(const std::string& name, int value)
+void OpenGLShader::UploadUniformInt(const ShaderUniformName& name, int value)
 	{
-		GLint location = glGetUniformLocation(m_RendererID, name.c_str());
-		glUniform1i(location, value);
+		GLint location = GetUniformLocation(name);
+		if (location < 0)
+			return;
+		glProgramUniform1i(m_RendererID, location, value);
 	}
 
-	void OpenGLShader::UploadUniformIntArray(const std::string& name, int* values, uint32_t count)
+	void OpenGLShader::UploadUniformIntArray(const ShaderUniformName& name, int* values, uint32_t count)
 	{
-		GLint location = glGetUniformLocation(m_RendererID, name.c_str());
-		glUniform1iv(location, count, values);
+		GLint location = GetUniformLocation(name);
+		if (location < 0)
+			return;
+		glProgramUniform1iv(m_RendererID, location, count, values);
 	}
 
-	void OpenGLShader::UploadUniformFloat(const std::string& name, float value)
+	void OpenGLShader::UploadUniformFloat(const ShaderUniformName& name, float value)
 	{
-		GLint location = glGetUniformLocation(m_RendererID, name.c_str());
-		glUniform1f(location, value);
+		GLint location = GetUniformLocation(name);
+		if (location < 0)
+			return;
+		glProgramUniform1f(m_RendererID, location, value);
 	}
 
-	void OpenGLShader::UploadUniformFloat2(const std::string& name, const glm::vec2& value)
+	void OpenGLShader::UploadUniformFloat2(const ShaderUniformName& name, const glm::vec2& value)
 	{
-		GLint location = glGetUniformLocation(m_RendererID, name.c_str());
-		glUniform2f(location, value.x, value.y);
+		GLint location = GetUniformLocation(name);
+		if (location < 0)
+			return;
+		glProgramUniform2f(m_RendererID, location, value.x, value.y);
 	}
 
-	void OpenGLShader::UploadUniformFloat3(const std::string& name, const glm::vec3& value)
+	void OpenGLShader::UploadUniformFloat3(const ShaderUniformName& name, const glm::vec3& value)
 	{
-		GLint location = glGetUniformLocation(m_RendererID, name.c_str());
-		glUniform3f(location, value.x, value.y, value.z);
+		GLint location = GetUniformLocation(name);
+		if (location < 0)
+			return;
+		glProgramUniform3f(m_RendererID, location, value.x, value.y, value.z);
 	}
 
-	void OpenGLShader::UploadUniformFloat4(const std::string& name, const glm::vec4& value)
+	void OpenGLShader::UploadUniformFloat4(const ShaderUniformName& name, const glm::vec4& value)
 	{
-		GLint location = glGetUniformLocation(m_RendererID, name.c_str());
-		glUniform4f(location, value.x, value.y, value.z, value.w);
+		GLint location = GetUniformLocation(name);
+		if (location < 0)
+			return;
+		glProgramUniform4f(m_RendererID, location, value.x, value.y, value.z, value.w);
 	}
 
-	void OpenGLShader::UploadUniformMat3(const std::string& name, const glm::mat3& matrix)
+	void OpenGLShader::UploadUniformMat3(const ShaderUniformName& name, const glm::mat3& matrix)
 	{
-		GLint location = glGetUniformLocation(m_RendererID, name.c_str());
-		glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(matrix));
+		GLint location = GetUniformLocation(name);
+		if (location < 0)
+			return;
+		glProgramUniformMatrix3fv(m_RendererID, location, 1, GL_FALSE, glm::value_ptr(matrix));
 	}
 
-	void OpenGLShader::UploadUniformMat4(const std::string& name, const glm::mat4& matrix)
+	void OpenGLShader::UploadUniformMat4(const ShaderUniformName& name, const glm::mat4& matrix)
 	{
-		GLint location = glGetUniformLocation(m_RendererID, name.c_str());
-		glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(matrix));
+		GLint location = GetUniformLocation(name);
+		if (location < 0)
+			return;
+		glProgramUniformMatrix4fv(m_RendererID, location, 1, GL_FALSE, glm::value_ptr(matrix));
 	}
 
 }
@@ -2,6 +2,7 @@
 
 #include "Renderer/Shader.h"
 #include <glm/glm.hpp>
+#include <atomic>
 
 // TODO: REMOVE!
 typedef unsigned int GLenum;
@@ -11,66 +12,119 @@ namespace Graphics {
 	class OpenGLShader : public Shader
 	{
 	public:
-		OpenGLShader(const std::string& filepath, bool cache);
+		OpenGLShader(const std::string& filepath, const ShaderVariant& variant, bool cache, bool async = false);
 		OpenGLShader(const std::string& name, const std::string& vertexSrc, const std::string& fragmentSrc);
 		virtual ~OpenGLShader();
 
 		virtual void Bind() const override;
 		virtual void Unbind() const override;
 
-		virtual void SetInt(const std::string& name, int value) override;
-		virtual void SetIntArray(const std::string& name, int* values, uint32_t count) override;
-		virtual void SetFloat(const std::string& name, float value) override;
-		virtual void SetFloat2(const std::string& name, const glm::vec2& value) override;
-		virtual void SetFloat3(const std::string& name, const glm::vec3& value) override;
-		virtual void SetFloat4(const std::string& name, const glm::vec4& value) override;
-		virtual void SetMat4(const std::string& name, const glm::mat4& value) override;
+		virtual bool IsReady() override;
+		virtual void WaitUntilReady() override;
+
+		virtual void Reload() override;
+		virtual bool IsReloading() const override { return m_Reload || m_ReloadQueued; }
+		virtual bool ApplyReload() override;
+
+		virtual void SetInt(const ShaderUniformName& name, int value) override;
+		virtual void SetIntArray(const ShaderUniformName& name, int* values, uint32_t count) override;
+		virtual void SetFloat(const ShaderUniformName& name, float value) override;
+		virtual void SetFloat2(const ShaderUniformName& name, const glm::vec2& value) override;
+		virtual void SetFloat3(const ShaderUniformName& name, const glm::vec3& value) override;
+		virtual void SetFloat4(const ShaderUniformName& name, const glm::vec4& value) override;
+		virtual void SetMat4(const ShaderUniformName& name, const glm::mat4& value) override;
 
 		virtual const std::string& GetName() const override { return m_Name; }
+		virtual const std::string& GetFilePath() const override { return m_FilePath; }
+		virtual const std::vector<std::string>& GetDependencies() const override { return m_Dependencies; }
+		virtual const ShaderVariant& GetVariant() const override { return m_Variant; }
 		virtual const uint32_t& GetId() const override { return m_RendererID; }
 
 		virtual const uint32_t& GetVertexAttributeLocation(const std::string& name) const override;
+		virtual const std::unordered_map<std::string, int>& GetVertexAttributeLocations() const override;
+		virtual glm::uvec3 GetWorkGroupSize() const override;
 
-		void UploadUniformInt(const std::string& name, int value);
-		void UploadUniformIntArray(const std::string& name, int* values, uint32_t count);
+		void UploadUniformInt(const ShaderUniformName& name, int value);
+		void UploadUniformIntArray(const ShaderUniformName& name, int* values, uint32_t count);
 
-		void UploadUniformFloat(const std::string& name, float value);
-		void UploadUniformFloat2(const std::string& name, const glm::vec2& value);
-		void UploadUniformFloat3(const std::string& name, const glm::vec3& value);
-		void UploadUniformFloat4(const std::string& name, const glm::vec4& value);
+		void UploadUniformFloat(const ShaderUniformName& name, float value);
+		void UploadUniformFloat2(const ShaderUniformName& name, const glm::vec2& value);
+		void UploadUniformFloat3(const ShaderUniformName& name, const glm::vec3& value);
+		void UploadUniformFloat4(const ShaderUniformName& name, const glm::vec4& value);
 
-		void UploadUniformMat3(const std::string& name, const glm::mat3& matrix);
-		void UploadUniformMat4(const std::string& name, const glm::mat4& matrix);
+		void UploadUniformMat3(const ShaderUniformName& name, const glm::mat3& matrix);
+		void UploadUniformMat4(const ShaderUniformName& name, const glm::mat4& matrix);
 	private:
+		// Compiling runs without a GL context (on the thread pool for async shaders), linking on the main thread
+		enum class CompileState
+		{
+			Compiling,
+			Compiled,
+			Linking,
+			Ready
+		};
 
-		//-1 coz of #type in shader
 		struct ShaderProgramSource
 		{
-			int lineOffset = -1;
+			// Line of the shader file the stage starts at, kept exact in compiler messages through #line
+			uint32_t FirstLine = 1;
 			std::string Source;
 		};
 
 		using ShaderSources = std::unordered_map<GLenum, ShaderProgramSource>;
 
+		// The variant's specialization constants that a stage actually declares, glSpecializeShader rejects the rest
+		struct StageSpecialization
+		{
+			std::vector<uint32_t> Indices;
+			std::vector<uint32_t> Values;
+		};
+
 		std::string ReadFile(const std::string& filepath, uint32_t* num_lines = nullptr);
 		void PreProcessIncludes(ShaderSources& source);
 		ShaderSources PreProcess(const std::string& source);
 
-		std::string ResetLineOffset(const std::string& source, const std::string& filename, int lineOffset);
-
 		void CompileOrGetVulkanBinaries(const ShaderSources& shaderSources);
 		void CompileOrGetOpenGLBinaries();
 		void CompileOrGetOpenGLBinaries(const ShaderSources& shaderSources);
-		void CreateProgram();
+		void CompileSources();
+		void BeginLink();
+		void FinishLink();
 		void FillVertexAttributeLocations(const ShaderSources& shaderSources);
+		void FillWorkGroupSize();
+		void FillSpecializations();
+		void FillUniformLocations();
+		// -1 for names the shader does not declare (or the compiler optimized away)
+		int GetUniformLocation(const ShaderUniformName& name);
 		void Reflect(GLenum stage, const std::vector<uint32_t>& shaderData);
 	private:
-		uint32_t m_RendererID;
+		uint32_t m_RendererID = 0;
 		std::string m_FilePath;
 		std::string m_Name;
-		bool m_EnableCache;
+		bool m_EnableCache = true;
+		ShaderVariant m_Variant;
+		std::string m_CacheName;
+		std::unordered_map<GLenum, StageSpecialization> m_Specializations;
+		// Headers pulled in through #include and the cache entries this shader produced, see OpenGLShaderCache::WriteManifest
+		std::vector<std::string> m_Dependencies;
+		std::vector<std::filesystem::path> m_CacheEntries;
+
+		std::atomic<CompileState> m_State = CompileState::Compiling;
+		bool m_CompileFailed = false;
+		uint32_t m_PendingProgram = 0;
+		std::vector<uint32_t> m_PendingShaderIDs;
+		bool m_UseProgramCache = false;
+		std::filesystem::path m_ProgramCachePath;
+
+		// A reload is a separate shader compiling in the background, its program is moved over once linked
+		Scope<OpenGLShader> m_Reload;
+		bool m_ReloadQueued = false;
 
 		std::unordered_map<std::string, int> m_VertexAttributeLocationCache;
+		// local_size of a compute shader, zero for graphics programs
+		glm::uvec3 m_WorkGroupSize = glm::uvec3(0);
+		// Uniform name hash -> explicit location, reflected on the compile job
+		std::unordered_map<uint64_t, int> m_UniformLocations;
 		
 		std::unordered_map<GLenum, std::vector<uint32_t>> m_VulkanSPIRV;
 		std::unordered_map<GLenum, std::vector<uint32_t>> m_OpenGLSPIRV;
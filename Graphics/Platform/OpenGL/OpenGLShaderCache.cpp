@@ -0,0 +1,228 @@
+#include "Platform/OpenGL/OpenGLShaderCache.h"
+
+#include <glad/gl.h>
+#include <shaderc/shaderc.h>
+#include <Logger.h>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+namespace Graphics {
+
+	// Bump whenever the way sources are preprocessed or compiled changes without the settings string changing
+	static const uint32_t s_CacheFormatVersion = 1;
+
+	static const uint32_t s_SpirvMagic = 0x07230203;
+	static const uint32_t s_ProgramBinaryMagic = 0x42504C47; // "GLPB"
+
+	namespace Utils {
+
+		static std::string ToHex(uint64_t value)
+		{
+			std::ostringstream stream;
+			stream << std::hex << std::setw(16) << std::setfill('0') << value;
+			return stream.str();
+		}
+
+		static std::filesystem::path GetManifestPath(const std::string& cacheName)
+		{
+			return OpenGLShaderCache::GetDirectory() / (cacheName + ".manifest");
+		}
+
+		static void WriteAtomically(const std::filesystem::path& path, const std::vector<std::pair<const void*, size_t>>& chunks)
+		{
+			if (!std::filesystem::exists(OpenGLShaderCache::GetDirectory()))
+				std::filesystem::create_directories(OpenGLShaderCache::GetDirectory());
+
+			// Write to a temporary and rename so a reader never sees a half written entry
+			std::filesystem::path temporaryPath = path;
+			temporaryPath += ".tmp";
+			{
+				std::ofstream out(temporaryPath, std::ios::out | std::ios::binary);
+				if (!out.is_open())
+					return;
+				for (const auto& [data, size] : chunks)
+					out.write((const char*)data, size);
+			}
+
+			std::error_code error;
+			std::filesystem::rename(temporaryPath, path, error);
+			if (error)
+				std::filesystem::remove(temporaryPath, error);
+		}
+
+		static std::vector<std::filesystem::path> ReadManifestEntries(const std::filesystem::path& manifestPath)
+		{
+			std::vector<std::filesystem::path> entries;
+			std::ifstream in(manifestPath);
+			std::string tag, value;
+			while (in >> tag && std::getline(in >> std::ws, value))
+			{
+				if (tag == "entry")
+					entries.emplace_back(value);
+			}
+			return entries;
+		}
+
+	}
+
+	const std::filesystem::path& OpenGLShaderCache::GetDirectory()
+	{
+		// TODO: make sure the assets directory is valid
+		static const std::filesystem::path s_Directory = "resources/Shaders/cache/opengl";
+		return s_Directory;
+	}
+
+	uint64_t OpenGLShaderCache::Hash(const void* data, size_t size, uint64_t seed)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		uint64_t hash = seed;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	uint64_t OpenGLShaderCache::ComputeKey(std::string_view source, uint32_t stage, std::string_view settings)
+	{
+		static const uint64_t s_CompilerSeed = []() {
+			unsigned int version = 0, revision = 0;
+			shaderc_get_spv_version(&version, &revision);
+			const uint32_t compiler[] = { s_CacheFormatVersion, version, revision };
+			return Hash(compiler, sizeof(compiler));
+		}();
+
+		uint64_t key = Hash(&stage, sizeof(stage), s_CompilerSeed);
+		key = Hash(settings, key);
+		return Hash(source, key);
+	}
+
+	std::string OpenGLShaderCache::GetCacheName(const std::string& shaderPath, std::string_view variantKey)
+	{
+		// Files with the same name in different directories, and variants of one file, need their own manifest,
+		// otherwise each one would delete the others' entries
+		std::error_code error;
+		std::filesystem::path path = std::filesystem::weakly_canonical(shaderPath, error);
+		if (error)
+			path = std::filesystem::path(shaderPath).lexically_normal();
+		std::string name = path.filename().string() + "." + Utils::ToHex(Hash(path.generic_string()));
+		if (!variantKey.empty())
+			name += "." + Utils::ToHex(Hash(variantKey));
+		return name;
+	}
+
+	std::filesystem::path OpenGLShaderCache::GetEntryPath(const std::string& cacheName, uint64_t key, const char* extension)
+	{
+		// The file name is only there to make the cache browsable, the key alone identifies the entry
+		return GetDirectory() / (cacheName + "." + Utils::ToHex(key) + extension);
+	}
+
+	bool OpenGLShaderCache::Load(const std::filesystem::path& entryPath, std::vector<uint32_t>& spirv)
+	{
+		std::ifstream in(entryPath, std::ios::in | std::ios::binary);
+		if (!in.is_open())
+			return false;
+
+		in.seekg(0, std::ios::end);
+		auto size = in.tellg();
+		in.seekg(0, std::ios::beg);
+
+		// A truncated write (crash, full disk) must read as a miss rather than feed garbage to the driver
+		if (size < (std::streamoff)sizeof(uint32_t) || size % sizeof(uint32_t) != 0)
+			return false;
+
+		spirv.resize(size / sizeof(uint32_t));
+		in.read((char*)spirv.data(), size);
+		if (!in || spirv[0] != s_SpirvMagic)
+		{
+			LOG_WARN_STREAM << "Ignoring corrupt shader cache entry " << entryPath;
+			spirv.clear();
+			return false;
+		}
+		return true;
+	}
+
+	void OpenGLShaderCache::Store(const std::filesystem::path& entryPath, const std::vector<uint32_t>& spirv)
+	{
+		Utils::WriteAtomically(entryPath, { { spirv.data(), spirv.size() * sizeof(uint32_t) } });
+	}
+
+	uint64_t OpenGLShaderCache::GetDriverKey()
+	{
+		static const uint64_t s_DriverKey = []() {
+			uint64_t key = Hash(&s_CacheFormatVersion, sizeof(s_CacheFormatVersion));
+			for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+			{
+				const char* value = (const char*)glGetString(name);
+				key = Hash(value ? value : "", key);
+			}
+			return key;
+		}();
+		return s_DriverKey;
+	}
+
+	bool OpenGLShaderCache::SupportsProgramBinaries()
+	{
+		static const bool s_Supported = []() {
+			GLint formats = 0;
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+			LOG_DEBUG_STREAM << "Program binary formats : " << formats;
+			return formats > 0;
+		}();
+		return s_Supported;
+	}
+
+	bool OpenGLShaderCache::LoadProgramBinary(const std::filesystem::path& entryPath, uint32_t& format, std::vector<uint8_t>& binary)
+	{
+		std::ifstream in(entryPath, std::ios::in | std::ios::binary);
+		if (!in.is_open())
+			return false;
+
+		uint32_t header[2] = {};
+		in.read((char*)header, sizeof(header));
+		if (!in || header[0] != s_ProgramBinaryMagic)
+			return false;
+
+		format = header[1];
+		binary.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+		return !binary.empty();
+	}
+
+	void OpenGLShaderCache::StoreProgramBinary(const std::filesystem::path& entryPath, uint32_t format, const std::vector<uint8_t>& binary)
+	{
+		const uint32_t header[2] = { s_ProgramBinaryMagic, format };
+		Utils::WriteAtomically(entryPath, { { header, sizeof(header) }, { binary.data(), binary.size() } });
+	}
+
+	void OpenGLShaderCache::WriteManifest(const std::string& cacheName, const std::string& shaderPath, const std::vector<std::string>& dependencies, const std::vector<std::filesystem::path>& entries)
+	{
+		const std::filesystem::path manifestPath = Utils::GetManifestPath(cacheName);
+
+		std::error_code error;
+		for (const std::filesystem::path& previous : Utils::ReadManifestEntries(manifestPath))
+		{
+			if (std::find(entries.begin(), entries.end(), previous) == entries.end())
+			{
+				LOG_TRACE_STREAM << "Removing stale shader cache entry " << previous;
+				std::filesystem::remove(previous, error);
+			}
+		}
+
+		std::ofstream out(manifestPath);
+		if (!out.is_open())
+			return;
+
+		out << "shader " << shaderPath << "\n";
+		for (const std::string& dependency : dependencies)
+		{
+			std::ifstream in(dependency, std::ios::in | std::ios::binary);
+			std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+			out << "dependency " << Utils::ToHex(Hash(contents)) << " " << dependency << "\n";
+		}
+		for (const std::filesystem::path& entry : entries)
+			out << "entry " << entry.string() << "\n";
+	}
+
+}
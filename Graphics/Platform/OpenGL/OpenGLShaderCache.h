@@ -0,0 +1,42 @@
+#pragma once
+
+#include "GraphicsCore.h"
+
+#include <string_view>
+
+namespace Graphics {
+
+	// On disk SPIR-V cache for OpenGLShader. Entries are keyed by a hash of the fully preprocessed stage source
+	// (includes expanded, defines applied), the compile settings and the shaderc version, so an edit anywhere
+	// in a shader or its headers can never hit a stale binary.
+	class OpenGLShaderCache
+	{
+	public:
+		static const std::filesystem::path& GetDirectory();
+
+		// 64 bit FNV-1a
+		static uint64_t Hash(const void* data, size_t size, uint64_t seed = 14695981039346656037ull);
+		static uint64_t Hash(std::string_view data, uint64_t seed = 14695981039346656037ull) { return Hash(data.data(), data.size(), seed); }
+
+		static uint64_t ComputeKey(std::string_view source, uint32_t stage, std::string_view settings);
+		// Cache names keep entries of one shader (and variant) together, see GetCacheName
+		static std::string GetCacheName(const std::string& shaderPath, std::string_view variantKey);
+		static std::filesystem::path GetEntryPath(const std::string& cacheName, uint64_t key, const char* extension);
+
+		static bool Load(const std::filesystem::path& entryPath, std::vector<uint32_t>& spirv);
+		static void Store(const std::filesystem::path& entryPath, const std::vector<uint32_t>& spirv);
+
+		// Linked program binaries are only valid for the exact driver that produced them, program keys have to
+		// be seeded with this (hash of GL_VENDOR, GL_RENDERER and GL_VERSION). Needs a current context.
+		static uint64_t GetDriverKey();
+		// False when the driver exposes no program binary formats
+		static bool SupportsProgramBinaries();
+		static bool LoadProgramBinary(const std::filesystem::path& entryPath, uint32_t& format, std::vector<uint8_t>& binary);
+		static void StoreProgramBinary(const std::filesystem::path& entryPath, uint32_t format, const std::vector<uint8_t>& binary);
+
+		// Records the headers a shader pulled in and the entries it produced. Entries listed by the previous
+		// manifest that are no longer produced are stale and get deleted, so the cache does not grow on every edit.
+		static void WriteManifest(const std::string& cacheName, const std::string& shaderPath, const std::vector<std::string>& dependencies, const std::vector<std::filesystem::path>& entries);
+	};
+
+}
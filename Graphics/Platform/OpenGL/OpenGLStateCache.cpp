@@ -0,0 +1,359 @@
+#include "GraphicsCore.h"
+#include "Platform/OpenGL/OpenGLStateCache.h"
+
+#include <array>
+#include <unordered_map>
+
+namespace Graphics {
+
+	static constexpr GLuint s_UnknownObject = 0xFFFFFFFF;
+	static constexpr GLenum s_UnknownEnum = 0xFFFFFFFF;
+	static constexpr uint32_t s_MaxCachedTextureUnits = 32;
+	static constexpr uint32_t s_MaxCachedBufferBindings = 16;
+	static constexpr uint32_t s_MaxCachedDrawBuffers = 8;
+
+	struct IndexedBufferBinding
+	{
+		GLuint Buffer = s_UnknownObject;
+		GLintptr Offset = 0;
+		GLsizeiptr Size = 0; // -1 for glBindBufferBase
+	};
+
+	struct OpenGLStateData
+	{
+		GLuint Program = s_UnknownObject;
+		GLuint VertexArray = s_UnknownObject;
+		GLuint DrawFramebuffer = s_UnknownObject;
+		GLuint ReadFramebuffer = s_UnknownObject;
+		GLint Viewport[4] = { -1, -1, -1, -1 };
+
+		std::unordered_map<GLenum, bool> Capabilities;
+		// Draw buffers are framebuffer state, so they are tracked per framebuffer object
+		std::unordered_map<GLuint, uint64_t> DrawBuffers;
+
+		GLenum DepthFunc = s_UnknownEnum;
+		int8_t DepthMask = -1;
+		GLenum BlendSrc = s_UnknownEnum, BlendDst = s_UnknownEnum;
+		GLuint StencilMask = s_UnknownObject;
+		GLenum StencilFunc = s_UnknownEnum;
+		GLint StencilRef = 0;
+		GLuint StencilFuncMask = 0;
+		GLenum StencilOp[3] = { s_UnknownEnum, s_UnknownEnum, s_UnknownEnum };
+		GLenum PolygonMode = s_UnknownEnum;
+		float LineWidth = -1.0f;
+		bool ClearColorValid = false;
+		float ClearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+		std::array<GLuint, s_MaxCachedTextureUnits> TextureUnits;
+		std::array<IndexedBufferBinding, s_MaxCachedBufferBindings> UniformBuffers;
+		std::array<IndexedBufferBinding, s_MaxCachedBufferBindings> StorageBuffers;
+
+		OpenGLStateData() { TextureUnits.fill(s_UnknownObject); }
+	};
+
+	static OpenGLStateData s_State;
+	static StateCacheStatistics s_Stats;
+
+	namespace Utils {
+
+		// Counts the call and returns true when it can be skipped
+		static bool Elide(bool redundant)
+		{
+			if (redundant)
+			{
+				s_Stats.Elided++;
+				return true;
+			}
+			s_Stats.Issued++;
+			return false;
+		}
+
+		static IndexedBufferBinding* IndexedBinding(GLenum target, GLuint index)
+		{
+			if (index >= s_MaxCachedBufferBindings)
+				return nullptr;
+
+			switch (target)
+			{
+				case GL_UNIFORM_BUFFER:         return &s_State.UniformBuffers[index];
+				case GL_SHADER_STORAGE_BUFFER:  return &s_State.StorageBuffers[index];
+			}
+			return nullptr;
+		}
+
+		// Packs the draw buffer list as 4 bits per attachment plus the count in the low nibble
+		static bool EncodeDrawBuffers(GLsizei count, const GLenum* buffers, uint64_t& key)
+		{
+			if (count < 0 || count > (GLsizei)s_MaxCachedDrawBuffers)
+				return false;
+
+			key = (uint64_t)count;
+			for (GLsizei i = 0; i < count; i++)
+			{
+				uint64_t code;
+				if (buffers[i] == GL_NONE)
+					code = 0xF;
+				else if (buffers[i] >= GL_COLOR_ATTACHMENT0 && buffers[i] < GL_COLOR_ATTACHMENT0 + 14)
+					code = buffers[i] - GL_COLOR_ATTACHMENT0;
+				else
+					return false;
+				key |= code << (4 * (i + 1));
+			}
+			return true;
+		}
+
+	}
+
+	void OpenGLStateCache::Invalidate()
+	{
+		s_State = OpenGLStateData();
+	}
+
+	void OpenGLStateCache::UseProgram(GLuint program)
+	{
+		if (Utils::Elide(s_State.Program == program)) return;
+		s_State.Program = program;
+		glUseProgram(program);
+	}
+
+	void OpenGLStateCache::BindVertexArray(GLuint vertexArray)
+	{
+		if (Utils::Elide(s_State.VertexArray == vertexArray)) return;
+		s_State.VertexArray = vertexArray;
+		glBindVertexArray(vertexArray);
+	}
+
+	void OpenGLStateCache::BindFramebuffer(GLenum target, GLuint framebuffer)
+	{
+		switch (target)
+		{
+			case GL_FRAMEBUFFER:
+				if (Utils::Elide(s_State.DrawFramebuffer == framebuffer && s_State.ReadFramebuffer == framebuffer)) return;
+				s_State.DrawFramebuffer = framebuffer;
+				s_State.ReadFramebuffer = framebuffer;
+				break;
+			case GL_DRAW_FRAMEBUFFER:
+				if (Utils::Elide(s_State.DrawFramebuffer == framebuffer)) return;
+				s_State.DrawFramebuffer = framebuffer;
+				break;
+			case GL_READ_FRAMEBUFFER:
+				if (Utils::Elide(s_State.ReadFramebuffer == framebuffer)) return;
+				s_State.ReadFramebuffer = framebuffer;
+				break;
+		}
+		glBindFramebuffer(target, framebuffer);
+	}
+
+	void OpenGLStateCache::DrawBuffers(GLsizei count, const GLenum* buffers)
+	{
+		uint64_t key = 0;
+		bool cacheable = s_State.DrawFramebuffer != s_UnknownObject && Utils::EncodeDrawBuffers(count, buffers, key);
+
+		if (cacheable)
+		{
+			auto it = s_State.DrawBuffers.find(s_State.DrawFramebuffer);
+			if (Utils::Elide(it != s_State.DrawBuffers.end() && it->second == key)) return;
+			s_State.DrawBuffers[s_State.DrawFramebuffer] = key;
+		}
+		else
+		{
+			Utils::Elide(false);
+			if (s_State.DrawFramebuffer != s_UnknownObject)
+				s_State.DrawBuffers.erase(s_State.DrawFramebuffer);
+		}
+
+		if (count == 1)
+			glDrawBuffer(buffers[0]);
+		else
+			glDrawBuffers(count, buffers);
+	}
+
+	void OpenGLStateCache::Viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+	{
+		GLint* v = s_State.Viewport;
+		if (Utils::Elide(v[0] == x && v[1] == y && v[2] == width && v[3] == height)) return;
+		v[0] = x; v[1] = y; v[2] = width; v[3] = height;
+		glViewport(x, y, width, height);
+	}
+
+	void OpenGLStateCache::SetCapability(GLenum capability, bool enable)
+	{
+		auto it = s_State.Capabilities.find(capability);
+		if (Utils::Elide(it != s_State.Capabilities.end() && it->second == enable)) return;
+		s_State.Capabilities[capability] = enable;
+
+		if (enable)
+			glEnable(capability);
+		else
+			glDisable(capability);
+	}
+
+	void OpenGLStateCache::DepthFunc(GLenum func)
+	{
+		if (Utils::Elide(s_State.DepthFunc == func)) return;
+		s_State.DepthFunc = func;
+		glDepthFunc(func);
+	}
+
+	void OpenGLStateCache::DepthMask(bool enable)
+	{
+		if (Utils::Elide(s_State.DepthMask == (int8_t)enable)) return;
+		s_State.DepthMask = (int8_t)enable;
+		glDepthMask(enable ? GL_TRUE : GL_FALSE);
+	}
+
+	void OpenGLStateCache::BlendFunc(GLenum sfactor, GLenum dfactor)
+	{
+		if (Utils::Elide(s_State.BlendSrc == sfactor && s_State.BlendDst == dfactor)) return;
+		s_State.BlendSrc = sfactor;
+		s_State.BlendDst = dfactor;
+		glBlendFunc(sfactor, dfactor);
+	}
+
+	void OpenGLStateCache::StencilMask(GLuint mask)
+	{
+		if (Utils::Elide(s_State.StencilMask == mask)) return;
+		s_State.StencilMask = mask;
+		glStencilMask(mask);
+	}
+
+	void OpenGLStateCache::StencilFunc(GLenum func, GLint ref, GLuint mask)
+	{
+		if (Utils::Elide(s_State.StencilFunc == func && s_State.StencilRef == ref && s_State.StencilFuncMask == mask)) return;
+		s_State.StencilFunc = func;
+		s_State.StencilRef = ref;
+		s_State.StencilFuncMask = mask;
+		glStencilFunc(func, ref, mask);
+	}
+
+	void OpenGLStateCache::StencilOp(GLenum sfail, GLenum dpfail, GLenum dppass)
+	{
+		GLenum* op = s_State.StencilOp;
+		if (Utils::Elide(op[0] == sfail && op[1] == dpfail && op[2] == dppass)) return;
+		op[0] = sfail; op[1] = dpfail; op[2] = dppass;
+		glStencilOp(sfail, dpfail, dppass);
+	}
+
+	void OpenGLStateCache::PolygonMode(GLenum mode)
+	{
+		if (Utils::Elide(s_State.PolygonMode == mode)) return;
+		s_State.PolygonMode = mode;
+		glPolygonMode(GL_FRONT_AND_BACK, mode);
+	}
+
+	void OpenGLStateCache::LineWidth(float width)
+	{
+		if (Utils::Elide(s_State.LineWidth == width)) return;
+		s_State.LineWidth = width;
+		glLineWidth(width);
+	}
+
+	void OpenGLStateCache::ClearColor(float r, float g, float b, float a)
+	{
+		float* c = s_State.ClearColor;
+		if (Utils::Elide(s_State.ClearColorValid && c[0] == r && c[1] == g && c[2] == b && c[3] == a)) return;
+		s_State.ClearColorValid = true;
+		c[0] = r; c[1] = g; c[2] = b; c[3] = a;
+		glClearColor(r, g, b, a);
+	}
+
+	void OpenGLStateCache::BindTextureUnit(GLuint unit, GLuint texture)
+	{
+		if (unit < s_MaxCachedTextureUnits)
+		{
+			if (Utils::Elide(s_State.TextureUnits[unit] == texture)) return;
+			s_State.TextureUnits[unit] = texture;
+		}
+		else
+			Utils::Elide(false);
+
+		glBindTextureUnit(unit, texture);
+	}
+
+	void OpenGLStateCache::BindBufferBase(GLenum target, GLuint index, GLuint buffer)
+	{
+		IndexedBufferBinding* binding = Utils::IndexedBinding(target, index);
+		if (binding)
+		{
+			if (Utils::Elide(binding->Buffer == buffer && binding->Size == -1)) return;
+			*binding = { buffer, 0, -1 };
+		}
+		else
+			Utils::Elide(false);
+
+		glBindBufferBase(target, index, buffer);
+	}
+
+	void OpenGLStateCache::BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+	{
+		IndexedBufferBinding* binding = Utils::IndexedBinding(target, index);
+		if (binding)
+		{
+			if (Utils::Elide(binding->Buffer == buffer && binding->Offset == offset && binding->Size == size)) return;
+			*binding = { buffer, offset, size };
+		}
+		else
+			Utils::Elide(false);
+
+		glBindBufferRange(target, index, buffer, offset, size);
+	}
+
+	void OpenGLStateCache::OnProgramDeleted(GLuint program)
+	{
+		if (s_State.Program == program)
+			s_State.Program = s_UnknownObject;
+	}
+
+	void OpenGLStateCache::OnVertexArrayDeleted(GLuint vertexArray)
+	{
+		if (s_State.VertexArray == vertexArray)
+			s_State.VertexArray = 0;
+	}
+
+	void OpenGLStateCache::OnFramebufferDeleted(GLuint framebuffer)
+	{
+		if (s_State.DrawFramebuffer == framebuffer)
+			s_State.DrawFramebuffer = 0;
+		if (s_State.ReadFramebuffer == framebuffer)
+			s_State.ReadFramebuffer = 0;
+		s_State.DrawBuffers.erase(framebuffer);
+	}
+
+	void OpenGLStateCache::OnTexturesDeleted(GLsizei count, const GLuint* textures)
+	{
+		for (GLsizei i = 0; i < count; i++)
+		{
+			if (textures[i] == 0) continue;
+			for (GLuint& unit : s_State.TextureUnits)
+				if (unit == textures[i])
+					unit = 0;
+		}
+	}
+
+	void OpenGLStateCache::OnBufferDeleted(GLuint buffer)
+	{
+		for (auto& binding : s_State.UniformBuffers)
+			if (binding.Buffer == buffer)
+				binding = { 0, 0, -1 };
+		for (auto& binding : s_State.StorageBuffers)
+			if (binding.Buffer == buffer)
+				binding = { 0, 0, -1 };
+	}
+
+	void OpenGLStateCache::InvalidateTextureUnit(GLuint unit)
+	{
+		if (unit < s_MaxCachedTextureUnits)
+			s_State.TextureUnits[unit] = s_UnknownObject;
+	}
+
+	StateCacheStatistics OpenGLStateCache::GetStats()
+	{
+		return s_Stats;
+	}
+
+	void OpenGLStateCache::ResetStats()
+	{
+		s_Stats = StateCacheStatistics();
+	}
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <glad/gl.h>
+#include <cstdint>
+
+#include "Renderer/RendererAPI.h"
+
+namespace Graphics {
+
+	// Shadows the GL state touched by the renderer so that redundant binds and toggles never reach the driver.
+	// Everything that binds programs, VAOs, framebuffers, textures or indexed buffers must go through here,
+	// otherwise the shadow goes stale. Call Invalidate() after third party code (ImGui) has touched GL state.
+	class OpenGLStateCache
+	{
+	public:
+		static void Invalidate();
+
+		static void UseProgram(GLuint program);
+		static void BindVertexArray(GLuint vertexArray);
+		static void BindFramebuffer(GLenum target, GLuint framebuffer);
+		static void DrawBuffers(GLsizei count, const GLenum* buffers);
+		static void DrawBuffer(GLenum buffer) { DrawBuffers(1, &buffer); }
+		static void Viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+		static void SetCapability(GLenum capability, bool enable);
+		static void DepthFunc(GLenum func);
+		static void DepthMask(bool enable);
+		static void BlendFunc(GLenum sfactor, GLenum dfactor);
+		static void StencilMask(GLuint mask);
+		static void StencilFunc(GLenum func, GLint ref, GLuint mask);
+		static void StencilOp(GLenum sfail, GLenum dpfail, GLenum dppass);
+		static void PolygonMode(GLenum mode);
+		static void LineWidth(float width);
+		static void ClearColor(float r, float g, float b, float a);
+
+		static void BindTextureUnit(GLuint unit, GLuint texture);
+		static void BindBufferBase(GLenum target, GLuint index, GLuint buffer);
+		static void BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+
+		// Object deletion can silently change bindings, keep the shadow in sync.
+		static void OnProgramDeleted(GLuint program);
+		static void OnVertexArrayDeleted(GLuint vertexArray);
+		static void OnFramebufferDeleted(GLuint framebuffer);
+		static void OnTexturesDeleted(GLsizei count, const GLuint* textures);
+		static void OnBufferDeleted(GLuint buffer);
+		// glBindTexture on the active unit (unit 0) bypasses the cache.
+		static void InvalidateTextureUnit(GLuint unit);
+
+		static StateCacheStatistics GetStats();
+		static void ResetStats();
+	};
+
+}
@@ -0,0 +1,46 @@
+#include "OpenGLStorageBuffer.h"
+#include "OpenGLStateCache.h"
+
+#include <glad/gl.h>
+#include <cstdint>
+
+namespace Graphics {
+
+	OpenGLStorageBuffer::OpenGLStorageBuffer(uint32_t size, uint32_t binding)
+		: m_Size(size)
+	{
+		glCreateBuffers(1, &m_RendererID);
+		// Written and read by the GPU for the most part
+		glNamedBufferData(m_RendererID, size, nullptr, GL_DYNAMIC_COPY);
+		OpenGLStateCache::BindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, m_RendererID);
+	}
+
+	OpenGLStorageBuffer::~OpenGLStorageBuffer()
+	{
+		OpenGLStateCache::OnBufferDeleted(m_RendererID);
+		glDeleteBuffers(1, &m_RendererID);
+	}
+
+	void OpenGLStorageBuffer::SetData(const void* data, uint32_t size, uint32_t offset)
+	{
+		GRAPHICS_CORE_ASSERT(offset + size <= m_Size, "Data does not fit the storage buffer!");
+		glNamedBufferSubData(m_RendererID, offset, size, data);
+	}
+
+	void OpenGLStorageBuffer::GetData(void* data, uint32_t size, uint32_t offset) const
+	{
+		GRAPHICS_CORE_ASSERT(offset + size <= m_Size, "Range exceeds the storage buffer!");
+		glGetNamedBufferSubData(m_RendererID, offset, size, data);
+	}
+
+	void OpenGLStorageBuffer::Clear()
+	{
+		glClearNamedBufferData(m_RendererID, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+	}
+
+	void OpenGLStorageBuffer::Bind(uint32_t binding) const
+	{
+		OpenGLStateCache::BindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, m_RendererID);
+	}
+
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Renderer/StorageBuffer.h"
+
+namespace Graphics {
+
+	class OpenGLStorageBuffer : public StorageBuffer
+	{
+	public:
+		OpenGLStorageBuffer(uint32_t size, uint32_t binding);
+		virtual ~OpenGLStorageBuffer();
+
+		virtual void SetData(const void* data, uint32_t size, uint32_t offset = 0) override;
+		virtual void GetData(void* data, uint32_t size, uint32_t offset = 0) const override;
+		virtual void Clear() override;
+
+		virtual void Bind(uint32_t binding) const override;
+
+		virtual uint32_t GetSize() const override { return m_Size; }
+		virtual uint32_t GetRendererID() const override { return m_RendererID; }
+	private:
+		uint32_t m_RendererID = 0;
+		uint32_t m_Size = 0;
+	};
+}
@@ -1,11 +1,14 @@
 
 #include "OpenGLTexture.h"
+#include "OpenGLStateCache.h"
 
 
 #include <cstdint>
 #include <string>
 #include <cassert>
 #include <iostream>
+#include <fstream>
+#include <bit>
 
 #include "Logger.h"
 #include "stb_image.h"
@@ -34,11 +37,36 @@ namespace Graphics {
 		: m_Path(path)
 	{
 		LOG_DEBUG_STREAM << "Loading texture";
+		std::ifstream file(path, std::ios::binary);
+		std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+		// KTX2 and DDS carry their own mip chain, nothing to decode or generate
+		if (TextureContainer::IsContainer(bytes))
+		{
+			TextureContainer container;
+			if (TextureContainer::Read(bytes, container, path))
+			{
+				if (!GetContainerInternalFormat(container.Format) && !TextureContainer::Transcode(container))
+				{
+					LOG_FATAL_STREAM << "Texture " << path << " uses a format the driver cannot sample";
+					return;
+				}
+
+				m_IsLoaded = true;
+				m_Width = container.Width;
+				m_Height = container.Height;
+				m_InternalFormat = GetContainerInternalFormat(container.Format);
+				m_DataFormat = GL_RGBA;
+				m_RendererID = CreateFromContainer(container, container.Data.data(), false);
+			}
+			return;
+		}
+
 		int width, height, channels;
 		stbi_set_flip_vertically_on_load(1);
 		stbi_uc* data = nullptr;
 		{
-			data = stbi_load(path.c_str(), &width, &height, &channels, 0);
+			data = stbi_load_from_memory(bytes.data(), (int)bytes.size(), &width, &height, &channels, 0);
 		}
 
 		if (data)
@@ -84,9 +112,50 @@ namespace Graphics {
 		}
 	}
 
+	OpenGLTexture2D::OpenGLTexture2D(const std::string& path, const Ref<OpenGLTexture2D>& placeholder)
+		: m_Path(path)
+	{
+		Share(placeholder);
+		m_IsLoaded = false;
+	}
+
 	OpenGLTexture2D::~OpenGLTexture2D()
 	{
-		glDeleteTextures(1, &m_RendererID);
+		Release();
+	}
+
+	void OpenGLTexture2D::Release()
+	{
+		if (!m_Shared && m_RendererID)
+		{
+			OpenGLStateCache::OnTexturesDeleted(1, &m_RendererID);
+			glDeleteTextures(1, &m_RendererID);
+		}
+		m_Shared.reset();
+		m_RendererID = 0;
+	}
+
+	void OpenGLTexture2D::Share(const Ref<OpenGLTexture2D>& source)
+	{
+		Release();
+		m_Shared = source;
+		m_RendererID = source->m_RendererID;
+		m_Width = source->m_Width;
+		m_Height = source->m_Height;
+		m_InternalFormat = source->m_InternalFormat;
+		m_DataFormat = source->m_DataFormat;
+		m_IsLoaded = source->m_IsLoaded;
+	}
+
+	void OpenGLTexture2D::Adopt(uint32_t rendererID, uint32_t width, uint32_t height, GLenum internalFormat, GLenum dataFormat)
+	{
+		Release();
+		m_RendererID = rendererID;
+		m_Width = width;
+		m_Height = height;
+		m_InternalFormat = internalFormat;
+		m_DataFormat = dataFormat;
+		m_IsLoaded = true;
 	}
 
 	void OpenGLTexture2D::SetData(void* data, uint32_t size)
@@ -106,7 +175,74 @@ namespace Graphics {
 
 	void OpenGLTexture2D::Bind(uint32_t slot) const
 	{
+		OpenGLStateCache::BindTextureUnit(slot, m_RendererID);
+	}
+
+	GLenum OpenGLTexture2D::GetContainerInternalFormat(TextureContainerFormat format)
+	{
+		static GLenum s_Supported[8] = {};
+		static bool s_Queried[8] = {};
+
+		GLenum internalFormat = 0;
+		bool s3tc = false;
+		switch (format)
+		{
+			case TextureContainerFormat::RGBA8: return GL_RGBA8;
+			case TextureContainerFormat::BC1:   internalFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT; s3tc = true; break;
+			case TextureContainerFormat::BC1A:  internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT; s3tc = true; break;
+			case TextureContainerFormat::BC3:   internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT; s3tc = true; break;
+			case TextureContainerFormat::BC4:   internalFormat = GL_COMPRESSED_RED_RGTC1; break;
+			case TextureContainerFormat::BC5:   internalFormat = GL_COMPRESSED_RG_RGTC2; break;
+			case TextureContainerFormat::BC7:   internalFormat = GL_COMPRESSED_RGBA_BPTC_UNORM; break;
+			default:                            return 0;
+		}
+
+		const size_t index = (size_t)format;
+		if (!s_Queried[index])
+		{
+			// S3TC is an extension (patents kept it out of core), RGTC and BPTC are core but may still be emulated
+			GLint supported = GL_FALSE;
+			if (!s3tc || GLAD_GL_EXT_texture_compression_s3tc)
+				glGetInternalformativ(GL_TEXTURE_2D, internalFormat, GL_INTERNALFORMAT_SUPPORTED, 1, &supported);
+			s_Supported[index] = supported == GL_TRUE ? internalFormat : 0;
+			s_Queried[index] = true;
+
+			if (!s_Supported[index])
+				LOG_WARN_STREAM << "Compressed texture format 0x" << std::hex << internalFormat << std::dec << " is not supported, transcoding on the CPU";
+		}
+		return s_Supported[index];
+	}
+
+	uint32_t OpenGLTexture2D::CreateFromContainer(const TextureContainer& container, const uint8_t* base, bool generateMips)
+	{
+		const GLenum internalFormat = GetContainerInternalFormat(container.Format);
+		assert(internalFormat && "Transcode the container first!");
+
+		// Compressed formats cannot be rendered to, a missing chain is only generated for RGBA8
+		const bool generate = generateMips && container.Levels.size() == 1 && !container.IsCompressed();
+		const uint32_t levels = generate ? (uint32_t)std::bit_width(std::max(container.Width, container.Height)) : (uint32_t)container.Levels.size();
+
+		uint32_t rendererID;
+		glCreateTextures(GL_TEXTURE_2D, 1, &rendererID);
+		glTextureStorage2D(rendererID, levels, internalFormat, container.Width, container.Height);
+
+		glTextureParameteri(rendererID, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glTextureParameteri(rendererID, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTextureParameteri(rendererID, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTextureParameteri(rendererID, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		for (uint32_t level = 0; level < (uint32_t)container.Levels.size(); level++)
+		{
+			const TextureContainer::Level& data = container.Levels[level];
+			if (container.IsCompressed())
+				glCompressedTextureSubImage2D(rendererID, level, 0, 0, data.Width, data.Height, internalFormat, (GLsizei)data.Size, base + data.Offset);
+			else
+				glTextureSubImage2D(rendererID, level, 0, 0, data.Width, data.Height, GL_RGBA, GL_UNSIGNED_BYTE, base + data.Offset);
+		}
 
-		glBindTextureUnit(slot, m_RendererID);
+		if (generate && levels > 1)
+			glGenerateTextureMipmap(rendererID);
+		return rendererID;
 	}
-}
\ No newline at end of file
+}
@@ -8,6 +8,7 @@
 #include <string>
 #include <cassert>
 #include "Renderer/Texture.h"
+#include "Renderer/TextureContainer.h"
 
 
 
@@ -19,6 +20,8 @@ namespace Graphics {
 	public:
 		OpenGLTexture2D(uint32_t width, uint32_t height);
 		OpenGLTexture2D(const std::string& path);
+		// Handle given out by the texture manager, shows placeholder until the image is adopted
+		OpenGLTexture2D(const std::string& path, const Ref<OpenGLTexture2D>& placeholder);
 		virtual ~OpenGLTexture2D();
 
 		virtual uint32_t GetWidth() const override { return m_Width; }
@@ -26,6 +29,7 @@ namespace Graphics {
 		virtual uint32_t GetRendererID() const override { return m_RendererID; }
 
 		virtual const std::string& GetPath() const override { return m_Path; }
+		GLenum GetInternalFormat() const { return m_InternalFormat; }
 
 		virtual void SetData(void* data, uint32_t size) override;
 
@@ -39,12 +43,29 @@ namespace Graphics {
 		{
 			return m_RendererID == other.GetRendererID();
 		}
+
+		// Shows source's texture without owning it, keeps source alive. Used for placeholders and for images the
+		// texture manager already uploaded under another path.
+		void Share(const Ref<OpenGLTexture2D>& source);
+		// Takes ownership of a filled texture and drops what was shown before. The renderer id changes.
+		void Adopt(uint32_t rendererID, uint32_t width, uint32_t height, GLenum internalFormat, GLenum dataFormat);
+
+		// Internal format a container format is uploaded as, 0 when the driver cannot sample it and it has to be
+		// transcoded first. Queries the driver once, call on the thread owning the context.
+		static GLenum GetContainerInternalFormat(TextureContainerFormat format);
+		// Creates a texture holding every level of the container. Level data is read at base + Level::Offset, base is
+		// client memory or an offset into the bound pixel unpack buffer.
+		static uint32_t CreateFromContainer(const TextureContainer& container, const uint8_t* base, bool generateMips);
+	private:
+		void Release();
 	private:
 		std::string m_Path;
 		bool m_IsLoaded = false;
 		uint32_t m_Width, m_Height;
-		uint32_t m_RendererID;
+		uint32_t m_RendererID = 0;
 		GLenum m_InternalFormat, m_DataFormat;
+		// Set while showing another texture's object, m_RendererID is not ours to delete then
+		Ref<OpenGLTexture2D> m_Shared;
 	};
 
 }
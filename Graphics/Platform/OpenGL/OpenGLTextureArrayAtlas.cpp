@@ -0,0 +1,179 @@
+#include "OpenGLTextureArrayAtlas.h"
+#include "OpenGLStateCache.h"
+#include "OpenGLTexture.h"
+
+#include <Logger.h>
+#include <algorithm>
+
+namespace Graphics {
+
+	OpenGLTextureArrayAtlas::OpenGLTextureArrayAtlas(const TextureArrayAtlasSpecification& spec)
+		: m_Specification(spec)
+	{
+		GLint maxSize = 0, maxLayers = 0;
+		glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+		glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+		if (maxSize > 0)
+			m_Specification.LayerSize = std::min(m_Specification.LayerSize, (uint32_t)maxSize);
+		if (maxLayers > 0)
+			m_Specification.MaxLayers = std::min(m_Specification.MaxLayers, (uint32_t)maxLayers);
+		m_Specification.MaxLayers = std::max(m_Specification.MaxLayers, 1u);
+
+		Grow(1);
+	}
+
+	OpenGLTextureArrayAtlas::~OpenGLTextureArrayAtlas()
+	{
+		OpenGLStateCache::OnTexturesDeleted(1, &m_RendererID);
+		glDeleteTextures(1, &m_RendererID);
+	}
+
+	TextureAtlasEntry OpenGLTextureArrayAtlas::Get(const Ref<Texture2D>& texture)
+	{
+		auto it = m_Entries.find(texture.get());
+		if (it != m_Entries.end() && !it->second.Texture.expired() && it->second.SourceID == texture->GetRendererID())
+			return it->second.Location;
+
+		TextureAtlasEntry location;
+		if (!texture->IsLoaded())
+		{
+			location.Status = TextureAtlasStatus::Loading;
+			return location;
+		}
+
+		const uint32_t width = texture->GetWidth(), height = texture->GetHeight();
+		uint32_t layer, x, y;
+		if (!Allocate(width, height, layer, x, y))
+		{
+			const uint32_t padded = std::max(width, height) + 2 * m_Specification.Padding;
+			location.Status = padded > m_Specification.LayerSize ? TextureAtlasStatus::TooLarge : TextureAtlasStatus::Full;
+			if (location.Status == TextureAtlasStatus::TooLarge)
+				LOG_WARN_STREAM << "Texture " << texture->GetPath() << " (" << width << " x " << height << ") does not fit a " << m_Specification.LayerSize << " texel atlas layer";
+			return location;
+		}
+
+		Copy(*texture, layer, x, y);
+
+		// Inset by half a texel so bilinear filtering never reaches the padding
+		const float size = (float)m_Specification.LayerSize;
+		location.Status = TextureAtlasStatus::Packed;
+		location.Layer = (float)layer;
+		location.UVRect = glm::vec4((x + 0.5f) / size, (y + 0.5f) / size, (x + width - 0.5f) / size, (y + height - 0.5f) / size);
+
+		Entry& entry = m_Entries[texture.get()];
+		entry.Texture = texture;
+		entry.SourceID = texture->GetRendererID();
+		entry.Location = location;
+		return location;
+	}
+
+	void OpenGLTextureArrayAtlas::Reset()
+	{
+		m_Entries.clear();
+		m_Layers.clear();
+	}
+
+	void OpenGLTextureArrayAtlas::Bind(uint32_t slot) const
+	{
+		OpenGLStateCache::BindTextureUnit(slot, m_RendererID);
+	}
+
+	bool OpenGLTextureArrayAtlas::Allocate(uint32_t width, uint32_t height, uint32_t& layer, uint32_t& x, uint32_t& y)
+	{
+		const uint32_t size = m_Specification.LayerSize;
+		const uint32_t paddedWidth = width + 2 * m_Specification.Padding;
+		const uint32_t paddedHeight = height + 2 * m_Specification.Padding;
+		if (paddedWidth > size || paddedHeight > size)
+			return false;
+
+		auto place = [&](uint32_t layerIndex, Shelf& shelf) {
+			layer = layerIndex;
+			x = shelf.X + m_Specification.Padding;
+			y = shelf.Y + m_Specification.Padding;
+			shelf.X += paddedWidth;
+		};
+
+		// An existing shelf that is tall enough without wasting more than half of its height
+		for (uint32_t i = 0; i < (uint32_t)m_Layers.size(); i++)
+		{
+			for (Shelf& shelf : m_Layers[i].Shelves)
+			{
+				if (shelf.Height >= paddedHeight && shelf.Height <= paddedHeight + paddedHeight / 2 && shelf.X + paddedWidth <= size)
+				{
+					place(i, shelf);
+					return true;
+				}
+			}
+		}
+
+		// A new shelf on top of a layer in use, then a new layer, growing the array when all are open
+		for (uint32_t i = 0; i < (uint32_t)m_Layers.size(); i++)
+		{
+			if (m_Layers[i].Top + paddedHeight <= size)
+			{
+				Shelf& shelf = m_Layers[i].Shelves.emplace_back(Shelf{ m_Layers[i].Top, paddedHeight, 0 });
+				m_Layers[i].Top += paddedHeight;
+				place(i, shelf);
+				return true;
+			}
+		}
+
+		if (m_Layers.size() == m_Capacity)
+		{
+			if (m_Capacity == m_Specification.MaxLayers)
+				return false;
+			Grow(std::min(m_Capacity * 2, m_Specification.MaxLayers));
+		}
+
+		Layer& newLayer = m_Layers.emplace_back();
+		Shelf& shelf = newLayer.Shelves.emplace_back(Shelf{ 0, paddedHeight, 0 });
+		newLayer.Top = paddedHeight;
+		place((uint32_t)m_Layers.size() - 1, shelf);
+		return true;
+	}
+
+	void OpenGLTextureArrayAtlas::Grow(uint32_t capacity)
+	{
+		const uint32_t size = m_Specification.LayerSize;
+
+		uint32_t rendererID;
+		glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &rendererID);
+		glTextureStorage3D(rendererID, 1, GL_RGBA8, size, size, capacity);
+		glTextureParameteri(rendererID, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTextureParameteri(rendererID, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTextureParameteri(rendererID, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTextureParameteri(rendererID, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glClearTexImage(rendererID, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+		if (m_RendererID)
+		{
+			glCopyImageSubData(m_RendererID, GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, rendererID, GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, size, size, m_Capacity);
+			OpenGLStateCache::OnTexturesDeleted(1, &m_RendererID);
+			glDeleteTextures(1, &m_RendererID);
+		}
+
+		LOG_DEBUG_STREAM << "Texture atlas grown to " << capacity << " layers of " << size << " x " << size;
+		m_RendererID = rendererID;
+		m_Capacity = capacity;
+	}
+
+	void OpenGLTextureArrayAtlas::Copy(const Texture2D& texture, uint32_t layer, uint32_t x, uint32_t y)
+	{
+		const uint32_t width = texture.GetWidth(), height = texture.GetHeight();
+
+		// Same texel size, copied on the GPU
+		if (static_cast<const OpenGLTexture2D&>(texture).GetInternalFormat() == GL_RGBA8)
+		{
+			glCopyImageSubData(texture.GetRendererID(), GL_TEXTURE_2D, 0, 0, 0, 0, m_RendererID, GL_TEXTURE_2D_ARRAY, 0, x, y, layer, width, height, 1);
+			return;
+		}
+
+		// RGB textures are expanded to RGBA on the way through, once per texture
+		std::vector<uint8_t> pixels((size_t)width * height * 4);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glGetTextureImage(texture.GetRendererID(), 0, GL_RGBA, GL_UNSIGNED_BYTE, (GLsizei)pixels.size(), pixels.data());
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTextureSubImage3D(m_RendererID, 0, x, y, layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+	}
+
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Renderer/TextureArrayAtlas.h"
+
+#include <glad/gl.h>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace Graphics {
+
+	class OpenGLTextureArrayAtlas : public TextureArrayAtlas
+	{
+	public:
+		OpenGLTextureArrayAtlas(const TextureArrayAtlasSpecification& spec);
+		virtual ~OpenGLTextureArrayAtlas();
+
+		virtual TextureAtlasEntry Get(const Ref<Texture2D>& texture) override;
+		virtual void Reset() override;
+
+		virtual void Bind(uint32_t slot = 0) const override;
+
+		virtual uint32_t GetRendererID() const override { return m_RendererID; }
+		virtual uint32_t GetLayerCount() const override { return m_Capacity; }
+		virtual const TextureArrayAtlasSpecification& GetSpecification() const override { return m_Specification; }
+	private:
+		// A row of textures of about the same height
+		struct Shelf
+		{
+			uint32_t Y = 0, Height = 0;
+			uint32_t X = 0;
+		};
+
+		struct Layer
+		{
+			std::vector<Shelf> Shelves;
+			uint32_t Top = 0;
+		};
+
+		struct Entry
+		{
+			// Detects a new texture allocated at the address of a released one
+			std::weak_ptr<Texture2D> Texture;
+			// The texture is packed again when its renderer id changes (TextureManager swapped its image in)
+			uint32_t SourceID = 0;
+			TextureAtlasEntry Location;
+		};
+
+		bool Allocate(uint32_t width, uint32_t height, uint32_t& layer, uint32_t& x, uint32_t& y);
+		void Grow(uint32_t capacity);
+		void Copy(const Texture2D& texture, uint32_t layer, uint32_t x, uint32_t y);
+	private:
+		TextureArrayAtlasSpecification m_Specification;
+		uint32_t m_RendererID = 0;
+		uint32_t m_Capacity = 0;
+		std::vector<Layer> m_Layers;
+		std::unordered_map<const Texture2D*, Entry> m_Entries;
+	};
+
+}
@@ -0,0 +1,379 @@
+#include "OpenGLTextureManager.h"
+#include "OpenGLStateCache.h"
+
+#include "Renderer/ThreadPool.h"
+
+#include <Logger.h>
+#include "stb_image.h"
+
+#include <bit>
+#include <cstring>
+#include <fstream>
+
+namespace Graphics {
+
+	namespace Utils {
+
+		static constexpr uint64_t StagingAlignment = 64;
+
+		static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+		{
+			return (value + alignment - 1) / alignment * alignment;
+		}
+
+		// FNV-1a, mixed with the options so the same file loaded with other options is another texture
+		static uint64_t ContentKey(const std::vector<uint8_t>& bytes, const TextureLoadOptions& options)
+		{
+			uint64_t hash = 14695981039346656037ull;
+			for (uint8_t byte : bytes)
+				hash = (hash ^ byte) * 1099511628211ull;
+			hash = (hash ^ (uint64_t)options.GenerateMips) * 1099511628211ull;
+			hash = (hash ^ (uint64_t)options.FlipVertically) * 1099511628211ull;
+			return hash;
+		}
+
+		static std::string RequestKey(const std::string& path, const TextureLoadOptions& options)
+		{
+			std::string key = std::filesystem::path(path).lexically_normal().generic_string();
+			key += options.GenerateMips ? "|mips" : "|nomips";
+			key += options.FlipVertically ? "|flip" : "";
+			return key;
+		}
+
+	}
+
+	void OpenGLTextureManager::PixelsDeleter::operator()(uint8_t* pixels) const
+	{
+		stbi_image_free(pixels);
+	}
+
+	OpenGLTextureManager::OpenGLTextureManager(const TextureManagerSpecification& spec)
+		: m_Specification(spec), m_Queue(CreateRef<DecodeQueue>())
+	{
+		// Transparent, a missing image shows nothing rather than something wrong
+		m_Placeholder = CreateRef<OpenGLTexture2D>(1, 1);
+		uint32_t transparent = 0;
+		m_Placeholder->SetData(&transparent, sizeof(transparent));
+
+		// The decode jobs cannot ask the driver themselves
+		for (uint32_t format = (uint32_t)TextureContainerFormat::RGBA8; format <= (uint32_t)TextureContainerFormat::BC7; format++)
+		{
+			if (OpenGLTexture2D::GetContainerInternalFormat((TextureContainerFormat)format))
+				m_ContainerFormats |= 1u << format;
+		}
+
+		// Written through the persistent mapping, read by glTextureSubImage2D with the buffer bound for unpacking
+		m_StagingCapacity = spec.StagingBufferSize / Utils::StagingAlignment * Utils::StagingAlignment;
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glCreateBuffers(1, &m_StagingBuffer);
+		glNamedBufferStorage(m_StagingBuffer, (GLsizeiptr)m_StagingCapacity, nullptr, flags);
+		m_StagingMapped = (uint8_t*)glMapNamedBufferRange(m_StagingBuffer, 0, (GLsizeiptr)m_StagingCapacity, flags);
+	}
+
+	OpenGLTextureManager::~OpenGLTextureManager()
+	{
+		for (StagingRegion& region : m_StagingInFlight)
+		{
+			if (region.Fence)
+				glDeleteSync(region.Fence);
+		}
+
+		glUnmapNamedBuffer(m_StagingBuffer);
+		OpenGLStateCache::OnBufferDeleted(m_StagingBuffer);
+		glDeleteBuffers(1, &m_StagingBuffer);
+	}
+
+	Ref<Texture2D> OpenGLTextureManager::Load(const std::string& path, const TextureLoadOptions& options)
+	{
+		const std::string key = Utils::RequestKey(path, options);
+		if (auto it = m_Textures.find(key); it != m_Textures.end())
+		{
+			if (Ref<OpenGLTexture2D> texture = it->second.lock())
+				return texture;
+		}
+
+		Ref<OpenGLTexture2D> texture = CreateRef<OpenGLTexture2D>(path, m_Placeholder);
+		m_Textures[key] = texture;
+
+		const uint64_t requestID = m_NextRequestID++;
+		m_Requests[requestID] = texture;
+		{
+			std::scoped_lock<std::mutex> lock(m_Queue->Mutex);
+			m_Queue->InFlight++;
+		}
+
+		ThreadPool::Get().Submit([queue = m_Queue, requestID, path, options, containerFormats = m_ContainerFormats]() {
+			DecodedImage image = Decode(requestID, path, options, containerFormats);
+			std::scoped_lock<std::mutex> lock(queue->Mutex);
+			queue->Decoded.push_back(std::move(image));
+			queue->InFlight--;
+		});
+
+		return texture;
+	}
+
+	OpenGLTextureManager::DecodedImage OpenGLTextureManager::Decode(uint64_t requestID, const std::string& path, const TextureLoadOptions& options, uint32_t containerFormats)
+	{
+		DecodedImage image;
+		image.RequestID = requestID;
+		image.Path = path;
+		image.Options = options;
+
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+		{
+			LOG_FATAL_STREAM << "Could not open texture " << path;
+			return image;
+		}
+		std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		image.ContentKey = Utils::ContentKey(bytes, options);
+
+		// Block compressed payloads go to the GPU as they are, unless the driver lacks the format
+		if (TextureContainer::IsContainer(bytes))
+		{
+			TextureContainer container;
+			if (!TextureContainer::Read(bytes, container, path))
+				return image;
+			if (!(containerFormats & (1u << (uint32_t)container.Format)) && !TextureContainer::Transcode(container))
+			{
+				LOG_FATAL_STREAM << "Texture " << path << " uses a format the driver cannot sample";
+				return image;
+			}
+
+			image.Width = container.Width;
+			image.Height = container.Height;
+			image.Container = std::move(container);
+			return image;
+		}
+
+		// RGB stays RGB, everything else is expanded to RGBA
+		int width, height, channels;
+		if (!stbi_info_from_memory(bytes.data(), (int)bytes.size(), &width, &height, &channels))
+		{
+			LOG_FATAL_STREAM << "Could not decode texture " << path << ": " << stbi_failure_reason();
+			return image;
+		}
+		const int desiredChannels = channels == 3 ? 3 : 4;
+
+		stbi_set_flip_vertically_on_load_thread(options.FlipVertically);
+		image.Pixels.reset(stbi_load_from_memory(bytes.data(), (int)bytes.size(), &width, &height, &channels, desiredChannels));
+		if (!image.Pixels)
+		{
+			LOG_FATAL_STREAM << "Could not decode texture " << path << ": " << stbi_failure_reason();
+			return image;
+		}
+
+		image.Width = (uint32_t)width;
+		image.Height = (uint32_t)height;
+		image.Channels = (uint32_t)desiredChannels;
+		return image;
+	}
+
+	bool OpenGLTextureManager::Update()
+	{
+		{
+			std::scoped_lock<std::mutex> lock(m_Queue->Mutex);
+			for (DecodedImage& image : m_Queue->Decoded)
+				m_ReadyForUpload.push_back(std::move(image));
+			m_Queue->Decoded.clear();
+		}
+
+		RetireStaging(false);
+
+		bool swapped = false;
+		uint64_t budget = m_Specification.UploadBudget;
+		while (!m_ReadyForUpload.empty())
+		{
+			DecodedImage& image = m_ReadyForUpload.front();
+			auto request = m_Requests.find(image.RequestID);
+			Ref<OpenGLTexture2D> texture = request->second.lock();
+
+			// Released before it finished loading, or failed (already reported) and stays on the placeholder
+			if (!texture || !image.IsValid())
+			{
+				m_Requests.erase(request);
+				m_ReadyForUpload.pop_front();
+				continue;
+			}
+
+			if (auto content = m_Contents.find(image.ContentKey); content != m_Contents.end())
+			{
+				Ref<OpenGLTexture2D> source = content->second.lock();
+				if (source && source->IsLoaded())
+				{
+					LOG_DEBUG_STREAM << "Texture " << image.Path << " has the contents of " << source->GetPath() << ", sharing its upload";
+					texture->Share(source);
+					swapped = true;
+					m_Requests.erase(request);
+					m_ReadyForUpload.pop_front();
+					continue;
+				}
+			}
+
+			// At least one image per frame, however large
+			const uint64_t size = image.GetSize();
+			if (size > budget && budget < m_Specification.UploadBudget)
+				break;
+			// Staging buffer full, the GPU has not caught up with earlier frames yet
+			if (!Upload(*texture, image))
+				break;
+
+			budget -= std::min(size, budget);
+			m_Contents[image.ContentKey] = texture;
+			swapped = true;
+			m_Requests.erase(request);
+			m_ReadyForUpload.pop_front();
+		}
+
+		// One fence covers everything staged this frame
+		if (!m_StagingInFlight.empty() && !m_StagingInFlight.back().Fence)
+			m_StagingInFlight.back().Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+		return swapped;
+	}
+
+	void OpenGLTextureManager::Flush()
+	{
+		while (GetPendingCount())
+		{
+			ThreadPool::Get().WaitIdle();
+			const uint32_t pending = GetPendingCount();
+			Update();
+			// Nothing went out, the staging buffer is waiting on the GPU
+			if (GetPendingCount() == pending)
+				RetireStaging(true);
+		}
+	}
+
+	uint32_t OpenGLTextureManager::GetPendingCount() const
+	{
+		std::scoped_lock<std::mutex> lock(m_Queue->Mutex);
+		return m_Queue->InFlight + (uint32_t)m_Queue->Decoded.size() + (uint32_t)m_ReadyForUpload.size();
+	}
+
+	bool OpenGLTextureManager::Upload(OpenGLTexture2D& texture, const DecodedImage& image)
+	{
+		const uint64_t size = image.GetSize();
+
+		// Larger than the whole staging buffer, uploaded from client memory instead
+		uint64_t offset = 0;
+		const bool staged = size <= m_StagingCapacity;
+		if (staged && !AllocateStaging(size, offset))
+			return false;
+
+		if (!image.Container.Levels.empty())
+		{
+			const TextureContainer& container = image.Container;
+			const uint8_t* base = container.Data.data();
+			if (staged)
+			{
+				std::memcpy(m_StagingMapped + offset, container.Data.data(), size);
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_StagingBuffer);
+				base = (const uint8_t*)offset;
+			}
+
+			const uint32_t rendererID = OpenGLTexture2D::CreateFromContainer(container, base, image.Options.GenerateMips);
+			if (staged)
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+			texture.Adopt(rendererID, container.Width, container.Height, OpenGLTexture2D::GetContainerInternalFormat(container.Format), GL_RGBA);
+			return true;
+		}
+
+		const GLenum internalFormat = image.Channels == 3 ? GL_RGB8 : GL_RGBA8;
+		const GLenum dataFormat = image.Channels == 3 ? GL_RGB : GL_RGBA;
+		const uint32_t levels = image.Options.GenerateMips ? (uint32_t)std::bit_width(std::max(image.Width, image.Height)) : 1;
+
+		uint32_t rendererID;
+		glCreateTextures(GL_TEXTURE_2D, 1, &rendererID);
+		glTextureStorage2D(rendererID, levels, internalFormat, image.Width, image.Height);
+
+		glTextureParameteri(rendererID, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glTextureParameteri(rendererID, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTextureParameteri(rendererID, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTextureParameteri(rendererID, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+		// RGB rows are not 4 byte aligned
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		if (staged)
+		{
+			// With an unpack buffer bound the copy is queued and the call returns immediately
+			std::memcpy(m_StagingMapped + offset, image.Pixels.get(), size);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_StagingBuffer);
+			glTextureSubImage2D(rendererID, 0, 0, 0, image.Width, image.Height, dataFormat, GL_UNSIGNED_BYTE, (const void*)offset);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+		else
+		{
+			LOG_DEBUG_STREAM << "Texture " << image.Path << " is larger than the staging buffer, uploading directly";
+			glTextureSubImage2D(rendererID, 0, 0, 0, image.Width, image.Height, dataFormat, GL_UNSIGNED_BYTE, image.Pixels.get());
+		}
+
+		if (levels > 1)
+			glGenerateTextureMipmap(rendererID);
+
+		// Draws are queued behind the upload, the texture can be used right away
+		texture.Adopt(rendererID, image.Width, image.Height, internalFormat, dataFormat);
+		return true;
+	}
+
+	bool OpenGLTextureManager::AllocateStaging(uint64_t size, uint64_t& offset)
+	{
+		// Offsets stay aligned, so the head only meets the tail when the buffer is empty
+		size = Utils::AlignUp(size, Utils::StagingAlignment);
+
+		uint64_t begin;
+		if (m_StagingInFlight.empty())
+		{
+			if (size > m_StagingCapacity)
+				return false;
+			begin = 0;
+		}
+		else
+		{
+			const uint64_t tail = m_StagingInFlight.front().Begin;
+			if (m_StagingHead >= tail)
+			{
+				// Free at the end and, after wrapping, in front of the tail
+				if (m_StagingCapacity - m_StagingHead >= size)
+					begin = m_StagingHead;
+				else if (tail > size)
+					begin = 0;
+				else
+					return false;
+			}
+			else if (tail - m_StagingHead > size)
+				begin = m_StagingHead;
+			else
+				return false;
+		}
+
+		if (m_StagingInFlight.empty() || m_StagingInFlight.back().Fence)
+			m_StagingInFlight.push_back({ begin, begin, nullptr });
+
+		m_StagingHead = begin + size;
+		m_StagingInFlight.back().End = m_StagingHead;
+		offset = begin;
+		return true;
+	}
+
+	void OpenGLTextureManager::RetireStaging(bool waitOldest)
+	{
+		while (!m_StagingInFlight.empty() && m_StagingInFlight.front().Fence)
+		{
+			StagingRegion& region = m_StagingInFlight.front();
+			const GLuint64 timeout = waitOldest ? 1000000000ull : 0;
+			const GLenum result = glClientWaitSync(region.Fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+			if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+				break;
+
+			glDeleteSync(region.Fence);
+			m_StagingInFlight.pop_front();
+			waitOldest = false;
+		}
+
+		if (m_StagingInFlight.empty())
+			m_StagingHead = 0;
+	}
+
+}
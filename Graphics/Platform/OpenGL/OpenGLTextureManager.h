@@ -0,0 +1,87 @@
+#pragma once
+
+#include "Renderer/TextureManager.h"
+#include "Platform/OpenGL/OpenGLTexture.h"
+
+#include <glad/gl.h>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace Graphics {
+
+	class OpenGLTextureManager : public TextureManager
+	{
+	public:
+		OpenGLTextureManager(const TextureManagerSpecification& spec);
+		virtual ~OpenGLTextureManager();
+
+		virtual Ref<Texture2D> Load(const std::string& path, const TextureLoadOptions& options = {}) override;
+
+		virtual bool Update() override;
+		virtual void Flush() override;
+
+		virtual uint32_t GetPendingCount() const override;
+	private:
+		struct PixelsDeleter { void operator()(uint8_t* pixels) const; };
+
+		struct DecodedImage
+		{
+			uint64_t RequestID = 0;
+			std::string Path;
+			TextureLoadOptions Options;
+			// File contents and options, equal keys upload once
+			uint64_t ContentKey = 0;
+			std::unique_ptr<uint8_t, PixelsDeleter> Pixels;
+			uint32_t Width = 0, Height = 0, Channels = 0;
+			// KTX2 or DDS, used instead of Pixels when it has levels
+			TextureContainer Container;
+
+			bool IsValid() const { return Pixels || !Container.Levels.empty(); }
+			uint64_t GetSize() const { return Container.Levels.empty() ? (uint64_t)Width * Height * Channels : Container.Data.size(); }
+		};
+
+		// Shared with the decode jobs so a job finishing after shutdown has somewhere to put its result
+		struct DecodeQueue
+		{
+			std::mutex Mutex;
+			std::deque<DecodedImage> Decoded;
+			uint32_t InFlight = 0;
+		};
+
+		// Part of the staging buffer the GPU may still read from. The region of the current frame has no fence yet.
+		struct StagingRegion
+		{
+			uint64_t Begin = 0, End = 0;
+			GLsync Fence = nullptr;
+		};
+
+		static DecodedImage Decode(uint64_t requestID, const std::string& path, const TextureLoadOptions& options, uint32_t containerFormats);
+
+		bool Upload(OpenGLTexture2D& texture, const DecodedImage& image);
+		bool AllocateStaging(uint64_t size, uint64_t& offset);
+		void RetireStaging(bool waitOldest);
+	private:
+		TextureManagerSpecification m_Specification;
+		Ref<DecodeQueue> m_Queue;
+		std::deque<DecodedImage> m_ReadyForUpload;
+
+		uint64_t m_NextRequestID = 1;
+		std::unordered_map<uint64_t, std::weak_ptr<OpenGLTexture2D>> m_Requests;
+		// Path and options to the texture handed out for them
+		std::unordered_map<std::string, std::weak_ptr<OpenGLTexture2D>> m_Textures;
+		// Content key to the texture that owns the upload
+		std::unordered_map<uint64_t, std::weak_ptr<OpenGLTexture2D>> m_Contents;
+
+		Ref<OpenGLTexture2D> m_Placeholder;
+		// Bit per TextureContainerFormat the driver samples directly, the others are transcoded while decoding
+		uint32_t m_ContainerFormats = 0;
+
+		uint32_t m_StagingBuffer = 0;
+		uint64_t m_StagingCapacity = 0;
+		uint8_t* m_StagingMapped = nullptr;
+		uint64_t m_StagingHead = 0;
+		std::deque<StagingRegion> m_StagingInFlight;
+	};
+
+}
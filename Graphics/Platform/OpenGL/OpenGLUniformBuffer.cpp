@@ -1,4 +1,5 @@
 #include "OpenGLUniformBuffer.h"
+#include "OpenGLStateCache.h"
 
 #include <glad/gl.h>
 #include <cstdint>
@@ -9,11 +10,12 @@ namespace Graphics {
 	{
 		glCreateBuffers(1, &m_RendererID);
 		glNamedBufferData(m_RendererID, size, nullptr, GL_DYNAMIC_DRAW); // TODO: investigate usage hint
-		glBindBufferBase(GL_UNIFORM_BUFFER, binding, m_RendererID);
+		OpenGLStateCache::BindBufferBase(GL_UNIFORM_BUFFER, binding, m_RendererID);
 	}
 
 	OpenGLUniformBuffer::~OpenGLUniformBuffer()
 	{
+		OpenGLStateCache::OnBufferDeleted(m_RendererID);
 		glDeleteBuffers(1, &m_RendererID);
 	}
 
@@ -0,0 +1,153 @@
+#include "OpenGLUniformRingBuffer.h"
+#include "OpenGLStateCache.h"
+
+#include <Logger.h>
+#include <cstring>
+
+namespace Graphics {
+
+	namespace Utils {
+
+		static uint32_t AlignUp(uint32_t value, uint32_t alignment)
+		{
+			return (value + alignment - 1) / alignment * alignment;
+		}
+
+	}
+
+	OpenGLUniformRingBuffer::OpenGLUniformRingBuffer(uint32_t frameSize, uint32_t binding)
+		: m_Binding(binding)
+	{
+		GLint alignment = 0;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		if (alignment > 0)
+			m_Alignment = (uint32_t)alignment;
+
+		Allocate(frameSize);
+	}
+
+	OpenGLUniformRingBuffer::~OpenGLUniformRingBuffer()
+	{
+		for (auto& [frame, fence] : m_Fences)
+			glDeleteSync(fence);
+		Release();
+	}
+
+	void OpenGLUniformRingBuffer::Allocate(uint32_t frameSize)
+	{
+		m_FrameSize = Utils::AlignUp(frameSize, m_Alignment);
+
+		// Coherent, writes through the mapping are visible to draws issued afterwards without a flush
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glCreateBuffers(1, &m_RendererID);
+		glNamedBufferStorage(m_RendererID, (GLsizeiptr)m_FrameSize * FramesInFlight, nullptr, flags);
+		m_Mapped = (uint8_t*)glMapNamedBufferRange(m_RendererID, 0, (GLsizeiptr)m_FrameSize * FramesInFlight, flags);
+		GRAPHICS_CORE_ASSERT(m_Mapped, "Could not map uniform ring buffer!");
+
+		m_RegionLastUse.fill(0);
+		LOG_DEBUG_STREAM << "Uniform ring buffer at binding " << m_Binding << ": " << FramesInFlight << " x " << m_FrameSize << " bytes";
+	}
+
+	void OpenGLUniformRingBuffer::Release()
+	{
+		if (!m_RendererID)
+			return;
+
+		glUnmapNamedBuffer(m_RendererID);
+		OpenGLStateCache::OnBufferDeleted(m_RendererID);
+		glDeleteBuffers(1, &m_RendererID);
+		m_RendererID = 0;
+		m_Mapped = nullptr;
+	}
+
+	void OpenGLUniformRingBuffer::WaitForFrame(uint64_t frame)
+	{
+		// Fences are inserted in frame order and signal in that order
+		while (!m_Fences.empty() && m_Fences.front().first <= frame)
+		{
+			GLsync fence = m_Fences.front().second;
+			GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+			if (result == GL_TIMEOUT_EXPIRED)
+			{
+				LOG_TRACE_STREAM << "Uniform ring buffer waiting on frame " << m_Fences.front().first;
+				while (result == GL_TIMEOUT_EXPIRED)
+					result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1ms
+			}
+			glDeleteSync(fence);
+			m_Fences.pop_front();
+		}
+	}
+
+	void OpenGLUniformRingBuffer::BeginFrame()
+	{
+		GRAPHICS_CORE_ASSERT(!m_InFrame, "UniformRingBuffer::BeginFrame called twice!");
+		m_InFrame = true;
+		m_Frame++;
+		m_Head = 0;
+
+		WaitForFrame(m_RegionLastUse[m_Frame % FramesInFlight]);
+	}
+
+	void OpenGLUniformRingBuffer::EndFrame()
+	{
+		GRAPHICS_CORE_ASSERT(m_InFrame, "UniformRingBuffer::EndFrame without BeginFrame!");
+		m_InFrame = false;
+
+		m_Fences.emplace_back(m_Frame, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+
+		// Drop fences that already signalled, idle frames never reuse a region and would not wait on them
+		while (!m_Fences.empty() && glClientWaitSync(m_Fences.front().second, 0, 0) != GL_TIMEOUT_EXPIRED)
+		{
+			glDeleteSync(m_Fences.front().second);
+			m_Fences.pop_front();
+		}
+	}
+
+	UniformAllocation OpenGLUniformRingBuffer::Push(const void* data, uint32_t size)
+	{
+		GRAPHICS_CORE_ASSERT(m_InFrame, "UniformRingBuffer::Push outside of a frame!");
+
+		const uint32_t alignedSize = Utils::AlignUp(size, m_Alignment);
+		if (m_Head + alignedSize > m_FrameSize)
+		{
+			// Rare, only when more blocks are pushed in one frame than ever before. Everything in flight has to
+			// finish before the mapping goes away, blocks pushed earlier this frame stay with the old buffer.
+			LOG_DEBUG_STREAM << "Uniform ring buffer at binding " << m_Binding << " is full, growing";
+			WaitForFrame(m_Frame - 1);
+			Release();
+			Allocate(std::max(m_FrameSize * 2, alignedSize));
+			m_Generation++;
+			m_Head = 0;
+		}
+
+		const uint32_t region = m_Frame % FramesInFlight;
+		UniformAllocation allocation;
+		allocation.Offset = region * m_FrameSize + m_Head;
+		allocation.Size = size;
+		allocation.Frame = m_Frame;
+		allocation.Generation = m_Generation;
+
+		std::memcpy(m_Mapped + allocation.Offset, data, size);
+		m_Head += alignedSize;
+		m_RegionLastUse[region] = m_Frame;
+		return allocation;
+	}
+
+	bool OpenGLUniformRingBuffer::IsResident(const UniformAllocation& allocation) const
+	{
+		if (!allocation.IsValid() || allocation.Generation != m_Generation)
+			return false;
+
+		// Binding it in the frame before its region comes round again would make BeginFrame wait on that frame
+		return m_Frame - allocation.Frame < FramesInFlight - 1;
+	}
+
+	void OpenGLUniformRingBuffer::Bind(const UniformAllocation& allocation)
+	{
+		GRAPHICS_CORE_ASSERT(allocation.IsValid() && allocation.Generation == m_Generation, "Uniform allocation is no longer resident!");
+
+		m_RegionLastUse[allocation.Frame % FramesInFlight] = m_Frame;
+		OpenGLStateCache::BindBufferRange(GL_UNIFORM_BUFFER, m_Binding, m_RendererID, allocation.Offset, allocation.Size);
+	}
+
+}
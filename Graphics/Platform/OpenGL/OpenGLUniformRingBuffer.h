@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Renderer/UniformRingBuffer.h"
+
+#include <glad/gl.h>
+#include <array>
+#include <deque>
+
+namespace Graphics {
+
+	class OpenGLUniformRingBuffer : public UniformRingBuffer
+	{
+	public:
+		static constexpr uint32_t FramesInFlight = 3;
+
+		OpenGLUniformRingBuffer(uint32_t frameSize, uint32_t binding);
+		virtual ~OpenGLUniformRingBuffer();
+
+		virtual void BeginFrame() override;
+		virtual void EndFrame() override;
+
+		virtual UniformAllocation Push(const void* data, uint32_t size) override;
+		virtual bool IsResident(const UniformAllocation& allocation) const override;
+		virtual void Bind(const UniformAllocation& allocation) override;
+	private:
+		void Allocate(uint32_t frameSize);
+		void Release();
+		// Blocks until every frame up to and including frame has completed on the GPU
+		void WaitForFrame(uint64_t frame);
+	private:
+		uint32_t m_RendererID = 0;
+		uint32_t m_Binding;
+		uint32_t m_Alignment = 256;
+		uint32_t m_FrameSize = 0;
+		uint8_t* m_Mapped = nullptr;
+		// Bumped whenever the buffer is reallocated, older allocations are gone with it
+		uint32_t m_Generation = 0;
+
+		uint64_t m_Frame = 0;
+		bool m_InFrame = false;
+		uint32_t m_Head = 0;
+		// Last frame that wrote or bound each region
+		std::array<uint64_t, FramesInFlight> m_RegionLastUse = {};
+		std::deque<std::pair<uint64_t, GLsync>> m_Fences;
+	};
+
+}
@@ -1,5 +1,6 @@
 #include "GraphicsCore.h"
 #include "Platform/OpenGL/OpenGLVertexArray.h"
+#include "Platform/OpenGL/OpenGLStateCache.h"
 
 #include <glad/gl.h>
 #include <Logger.h>
@@ -38,42 +39,48 @@ namespace Graphics {
 	{
 		
 
+		OpenGLStateCache::OnVertexArrayDeleted(m_RendererID);
 		glDeleteVertexArrays(1, &m_RendererID);
 	}
 
 	void OpenGLVertexArray::Bind() const
 	{
-		
+		OpenGLStateCache::BindVertexArray(m_RendererID);
 
-		glBindVertexArray(m_RendererID);
+		// Arena ranges move when their arena defragments, the attribute pointers still address the old buffer
+		for (auto& binding : m_Bindings)
+		{
+			if (binding.RendererID != binding.Buffer->GetRendererID() || binding.Offset != binding.Buffer->GetOffset())
+				SetVertexAttributes(binding);
+		}
+		if (m_IndexBuffer && (m_IndexBufferID != m_IndexBuffer->GetRendererID()))
+		{
+			m_IndexBuffer->Bind();
+			m_IndexBufferID = m_IndexBuffer->GetRendererID();
+		}
 	}
 
 	void OpenGLVertexArray::Unbind() const
 	{
-		
-
-		glBindVertexArray(0);
+		OpenGLStateCache::BindVertexArray(0);
 	}
 
-	void OpenGLVertexArray::AddVertexBuffer(const Ref<VertexBuffer>& vertexBuffer)
+	uint32_t OpenGLVertexArray::SetVertexAttributes(VertexBufferBinding& binding) const
 	{
-		
-
-		GRAPHICS_CORE_ASSERT(vertexBuffer->GetLayout().GetElements().size(), "Vertex Buffer has no layout!");
-
-		if(m_VertexBuffers.empty()){
-			previousVertexBufferGetsLocations = false;
-		}
-		else{
-			assert(previousVertexBufferGetsLocations == false, "Previous Vertex Buffer gets locations. This Vertex Buffer must also get locations");
-		}
+		binding.RendererID = binding.Buffer->GetRendererID();
+		binding.Offset = binding.Buffer->GetOffset();
+		binding.Buffer->Bind();
 
-		glBindVertexArray(m_RendererID);
-		vertexBuffer->Bind();
+		uint32_t index = binding.FirstIndex;
+		auto nextLocation = [&](const BufferElement& element) -> GLuint
+		{
+			return binding.ShaderInput ? binding.ShaderInput->GetVertexAttributeLocation(element.Name) : index++;
+		};
 
-		const auto& layout = vertexBuffer->GetLayout();
+		const auto& layout = binding.Buffer->GetLayout();
 		for (const auto& element : layout)
 		{
+			const uint64_t offset = binding.Offset + element.Offset;
 			switch (element.Type)
 			{
 				case ShaderDataType::Float:
@@ -81,17 +88,17 @@ namespace Graphics {
 				case ShaderDataType::Float3:
 				case ShaderDataType::Float4:
 				{
-					glEnableVertexAttribArray(m_VertexBufferIndex);
-					glVertexAttribPointer(m_VertexBufferIndex,
+					GLuint location = nextLocation(element);
+					glEnableVertexAttribArray(location);
+					glVertexAttribPointer(location,
 						element.GetComponentCount(),
 						ShaderDataTypeToOpenGLBaseType(element.Type),
 						element.Normalized ? GL_TRUE : GL_FALSE,
 						layout.GetStride(),
-						(const void*)element.Offset);
+						(const void*)offset);
 					if(element.Instanced){
-						glVertexAttribDivisor(m_VertexBufferIndex, element.Divisor);
+						glVertexAttribDivisor(location, element.Divisor);
 					}
-					m_VertexBufferIndex++;
 					break;
 				}
 				case ShaderDataType::Int:
@@ -100,16 +107,16 @@ namespace Graphics {
 				case ShaderDataType::Int4:
 				case ShaderDataType::Bool:
 				{
-					glEnableVertexAttribArray(m_VertexBufferIndex);
-					glVertexAttribIPointer(m_VertexBufferIndex,
+					GLuint location = nextLocation(element);
+					glEnableVertexAttribArray(location);
+					glVertexAttribIPointer(location,
 						element.GetComponentCount(),
 						ShaderDataTypeToOpenGLBaseType(element.Type),
 						layout.GetStride(),
-						(const void*)element.Offset);
+						(const void*)offset);
 					if(element.Instanced){
-						glVertexAttribDivisor(m_VertexBufferIndex, element.Divisor);
+						glVertexAttribDivisor(location, element.Divisor);
 					}
-					m_VertexBufferIndex++;
 					break;
 				}
 				case ShaderDataType::Mat3:
@@ -118,15 +125,15 @@ namespace Graphics {
 					uint8_t count = element.GetComponentCount();
 					for (uint8_t i = 0; i < count; i++)
 					{
-						glEnableVertexAttribArray(m_VertexBufferIndex);
-						glVertexAttribPointer(m_VertexBufferIndex,
+						GLuint location = nextLocation(element);
+						glEnableVertexAttribArray(location);
+						glVertexAttribPointer(location,
 							count,
 							ShaderDataTypeToOpenGLBaseType(element.Type),
 							element.Normalized ? GL_TRUE : GL_FALSE,
 							layout.GetStride(),
-							(const void*)(element.Offset + sizeof(float) * count * i));
-						glVertexAttribDivisor(m_VertexBufferIndex, element.Divisor);
-						m_VertexBufferIndex++;
+							(const void*)(offset + sizeof(float) * count * i));
+						glVertexAttribDivisor(location, element.Divisor);
 					}
 					break;
 				}
@@ -135,6 +142,29 @@ namespace Graphics {
 			}
 		}
 
+		return index;
+	}
+
+	void OpenGLVertexArray::AddVertexBuffer(const Ref<VertexBuffer>& vertexBuffer)
+	{
+		
+
+		GRAPHICS_CORE_ASSERT(vertexBuffer->GetLayout().GetElements().size(), "Vertex Buffer has no layout!");
+
+		if(m_VertexBuffers.empty()){
+			previousVertexBufferGetsLocations = false;
+		}
+		else{
+			assert(previousVertexBufferGetsLocations == false, "Previous Vertex Buffer gets locations. This Vertex Buffer must also get locations");
+		}
+
+		OpenGLStateCache::BindVertexArray(m_RendererID);
+
+		VertexBufferBinding& binding = m_Bindings.emplace_back();
+		binding.Buffer = vertexBuffer;
+		binding.FirstIndex = m_VertexBufferIndex;
+		m_VertexBufferIndex = SetVertexAttributes(binding);
+
 		m_VertexBuffers.push_back(vertexBuffer);
 	}
 
@@ -149,72 +179,12 @@ namespace Graphics {
 			assert(previousVertexBufferGetsLocations, "Previous Vertex Buffer does not get locations. This Vertex Buffer must also not get locations");
 		}
 
-		glBindVertexArray(m_RendererID);
-		vertexBuffer->Bind();
+		OpenGLStateCache::BindVertexArray(m_RendererID);
 
-		const auto& layout = vertexBuffer->GetLayout();
-		for (const auto& element : layout)
-		{
-			switch (element.Type)
-			{
-				case ShaderDataType::Float:
-				case ShaderDataType::Float2:
-				case ShaderDataType::Float3:
-				case ShaderDataType::Float4:
-				{
-					int location = shaderInput->GetVertexAttributeLocation(element.Name);
-					glEnableVertexAttribArray(location);
-					glVertexAttribPointer(location,
-						element.GetComponentCount(),
-						ShaderDataTypeToOpenGLBaseType(element.Type),
-						element.Normalized ? GL_TRUE : GL_FALSE,
-						layout.GetStride(),
-						(const void*)element.Offset);
-					if(element.Instanced){
-						glVertexAttribDivisor(location, element.Divisor);
-					}
-					break;
-				}
-				case ShaderDataType::Int:
-				case ShaderDataType::Int2:
-				case ShaderDataType::Int3:
-				case ShaderDataType::Int4:
-				case ShaderDataType::Bool:
-				{
-					int location = shaderInput->GetVertexAttributeLocation(element.Name);
-					glEnableVertexAttribArray(location);
-					glVertexAttribIPointer(location,
-						element.GetComponentCount(),
-						ShaderDataTypeToOpenGLBaseType(element.Type),
-						layout.GetStride(),
-						(const void*)element.Offset);
-					if(element.Instanced){
-						glVertexAttribDivisor(location, element.Divisor);
-					}
-					break;
-				}
-				case ShaderDataType::Mat3:
-				case ShaderDataType::Mat4:
-				{
-					uint8_t count = element.GetComponentCount();
-					for (uint8_t i = 0; i < count; i++)
-					{
-						int location = shaderInput->GetVertexAttributeLocation(element.Name);
-						glEnableVertexAttribArray(location);
-						glVertexAttribPointer(location,
-							count,
-							ShaderDataTypeToOpenGLBaseType(element.Type),
-							element.Normalized ? GL_TRUE : GL_FALSE,
-							layout.GetStride(),
-							(const void*)(element.Offset + sizeof(float) * count * i));
-						glVertexAttribDivisor(location, element.Divisor);
-					}
-					break;
-				}
-				default:
-					GRAPHICS_CORE_ASSERT(false, "Unknown ShaderDataType!");
-			}
-		}
+		VertexBufferBinding& binding = m_Bindings.emplace_back();
+		binding.Buffer = vertexBuffer;
+		binding.ShaderInput = shaderInput;
+		SetVertexAttributes(binding);
 
 		m_VertexBuffers.push_back(vertexBuffer);
 	}
@@ -227,10 +197,11 @@ namespace Graphics {
 			LOG_DEBUG_STREAM << "Removing Index buffer";
 			m_IndexBuffer->~IndexBuffer();
 		}
-		glBindVertexArray(m_RendererID);
+		OpenGLStateCache::BindVertexArray(m_RendererID);
 		indexBuffer->Bind();
 
 		m_IndexBuffer = indexBuffer;
+		m_IndexBufferID = indexBuffer->GetRendererID();
 	}
 
 }
@@ -20,11 +20,27 @@ namespace Graphics {
 
 		virtual const std::vector<Ref<VertexBuffer>>& GetVertexBuffers() const { return m_VertexBuffers; }
 		virtual const Ref<IndexBuffer>& GetIndexBuffer() const { return m_IndexBuffer; }
+	private:
+		struct VertexBufferBinding
+		{
+			Ref<VertexBuffer> Buffer;
+			// Locations come from the shader when set, otherwise they count up from FirstIndex
+			Ref<Shader> ShaderInput;
+			uint32_t FirstIndex = 0;
+			// Buffer object and offset the attribute pointers were last set up with
+			uint32_t RendererID = 0;
+			uint64_t Offset = 0;
+		};
+
+		// Returns the attribute index after the last one used
+		uint32_t SetVertexAttributes(VertexBufferBinding& binding) const;
 	private:
 		uint32_t m_RendererID = 0;
 		uint32_t m_VertexBufferIndex = 0;
 		std::vector<Ref<VertexBuffer>> m_VertexBuffers;
+		mutable std::vector<VertexBufferBinding> m_Bindings;
 		Ref<IndexBuffer> m_IndexBuffer = nullptr;
+		mutable uint32_t m_IndexBufferID = 0;
 		bool previousVertexBufferGetsLocations = false;
 	};
 
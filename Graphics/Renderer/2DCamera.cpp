@@ -3,6 +3,7 @@
 #include <GLFW/glfw3.h>
 #include <Events/Input.h>
 #include <array>
+#include <cmath>
 #include <Logger.h>
 
 #define LABEL_PIXELS 80
@@ -12,6 +13,9 @@ public:
 	double base = 10;
 	std::array<double, 3> major = { 5, 5, 5 };
 	std::array<double, 3> minor = { 10, 10, 10 };
+	// Cell size of LOD 0 and the pixels between lines before the next LOD takes over, as in GridParameters.h
+	double lodMajorSize = 0.000000005;
+	double lodMinPixelsBetweenCells = 2.0;
 };
 
 double s(double screenWidth, double vXmax, double vXmin) {
@@ -54,6 +58,18 @@ void GetSpacing(double viewPortWidth, double xMin, double xMax, float& gridMajor
 	n(sVal, GridCalc(), gridMajor, gridMinor);
 }
 
+// What gridColor in GridCalculation.h derives per fragment from the uv derivatives. An orthographic view has the same
+// world size per pixel everywhere, so it is done once here: (world units per pixel, LOD 0 cell size, LOD fade, 0)
+glm::vec4 GetLod(double viewPortWidth, double xMin, double xMax) {
+	GridCalc e;
+	double pixelSize = (xMax - xMin) / viewPortWidth;
+	// length(dudv) of the shader, one pixel along each axis
+	double texel = pixelSize * std::sqrt(2.0);
+	double lodLevel = std::max(0.0, std::log10(texel * e.lodMinPixelsBetweenCells / e.lodMajorSize) + 1.0);
+	double lod0 = e.lodMajorSize * std::pow(e.base, std::floor(lodLevel));
+	return glm::vec4(pixelSize, lod0, lodLevel - std::floor(lodLevel), 0.0);
+}
+
 Graphics::TwoDCamera::TwoDCamera(float nearClip = -100.0f, float farClip = 100.0f)
 	: m_NearClip(nearClip), m_FarClip(farClip), Camera(glm::ortho(-5.0f, 5.0f, -5.0f, 5.0f, nearClip, farClip))
 {
@@ -108,13 +124,17 @@ void Graphics::TwoDCamera::UpdateProjection()
 
 	m_Projection = glm::ortho(left, right, down, up, m_NearClip, m_FarClip);
 
+	GetSpacing(m_ViewportWidth, worldXmin, worldXmax, gridMajorSpacing, gridMinorSpacing);
+	gridLod = GetLod(m_ViewportWidth, worldXmin, worldXmax);
+	MarkDirty();
 }
 
 void Graphics::TwoDCamera::UpdateView()
 {
 
 	m_Yaw = m_Pitch = 0.0f; // Lock the camera's rotation
-	m_Position = CalculatePosition();
+	m_Eye = CalculatePosition();
+	m_Position = glm::vec3(m_Eye);
 
 	//glm::quat orientation = GetOrientation();
 	//m_ViewMatrix = glm::translate(glm::mat4(1.0f), m_Position) * glm::toMat4(orientation);
@@ -124,6 +144,7 @@ void Graphics::TwoDCamera::UpdateView()
 	glm::mat4 transform = glm::translate(glm::mat4(1.0f), m_Position);
 
 	m_ViewMatrix = glm::inverse(transform);
+	MarkDirty();
 }
 
 
@@ -133,7 +154,6 @@ bool Graphics::TwoDCamera::OnMouseScroll(Application::MouseScrolledEvent& e)
 	MouseZoom(delta);
 	UpdateProjection();
 	UpdateView();
-	GetSpacing(m_ViewportWidth, worldXmin, worldXmax, gridMajorSpacing, gridMinorSpacing);
 	return false;
 }
 
@@ -145,11 +165,10 @@ bool Graphics::TwoDCamera::OnMouseMove(Application::MouseMovedEvent& e)
 	glm::vec2 delta = (mouse - m_InitialMousePosition);
 	m_InitialMousePosition = mouse;
 
-	if (!mLeft && !mRight) return false;
-
+	// Only a left drag pans, anything else leaves the camera (and its dirty flag) alone
+	if (!mLeft) return false;
 
-	if (mLeft)
-		MousePan(delta);
+	MousePan(delta);
 
 	UpdateProjection();
 	UpdateView();
@@ -159,9 +178,10 @@ bool Graphics::TwoDCamera::OnMouseMove(Application::MouseMovedEvent& e)
 void Graphics::TwoDCamera::MousePan(const glm::vec2& delta)
 {
 	//Note: View will always lag behind the mouse due to delta being used. The pan has to "wait" for a change.
-	glm::vec2 scale = {(this->worldXmax - this->worldXmin) / this->m_ViewportWidth, (this->worldYmax - this->worldYmin)/ this->m_ViewportHeight };
-	auto C = delta * scale;
-	m_FocalPoint += glm::vec3(-C.x, C.y, 0.0);
+	// In double: a float step added to a float focal point far from the origin would be rounded away
+	glm::dvec2 scale = {(this->worldXmax - this->worldXmin) / this->m_ViewportWidth, (this->worldYmax - this->worldYmin)/ this->m_ViewportHeight };
+	glm::dvec2 C = glm::dvec2(delta) * scale;
+	m_FocalPoint += glm::dvec3(-C.x, C.y, 0.0);
 }
 
 void Graphics::TwoDCamera::MouseRotate(const glm::vec2& delta)
@@ -187,9 +207,9 @@ void Graphics::TwoDCamera::MouseZoom(float delta)
 	//UpdateProjection();
 }
 
-glm::vec3 Graphics::TwoDCamera::CalculatePosition() const
+glm::dvec3 Graphics::TwoDCamera::CalculatePosition() const
 {
-	return m_FocalPoint - GetForwardDirection() * m_Distance;
+	return m_FocalPoint - glm::dvec3(GetForwardDirection()) * (double)m_Distance;
 }
 
 float Graphics::TwoDCamera::RotationSpeed() const
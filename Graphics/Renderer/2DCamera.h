@@ -16,6 +16,8 @@ namespace Graphics {
 
 		void OnEvent(Application::Event& event);
 
+		Ref<Camera> Clone() const override { return CreateRef<TwoDCamera>(*this); }
+
 		inline float GetDistance() const { return m_Distance; }
 		inline void SetDistance(float distance) { m_Distance = distance; }
 
@@ -28,6 +30,7 @@ namespace Graphics {
 		glm::vec3 GetRightDirection() const;
 		glm::vec3 GetForwardDirection() const;
 		const glm::vec3& GetPosition() const { return m_Position; }
+		glm::dvec3 GetEyePosition() const { return m_Eye; }
 		glm::quat GetOrientation() const;
 		glm::vec3 GetViewDirection() const;
 
@@ -37,12 +40,12 @@ namespace Graphics {
 
 		void SetMousePos(glm::vec2 mousePos) { m_InitialMousePosition = mousePos; }
 
-		void ResetFocalPoint() { m_FocalPoint = { 0.0f, 0.0f, 0.0f }; UpdateView();}
+		void ResetFocalPoint() { m_FocalPoint = { 0.0, 0.0, 0.0 }; UpdateView();}
 
 		void SetPosition(const glm::vec3& position) { m_Position = position; UpdateView(); }
 
-		glm::vec3 GetFocalPoint() { return m_FocalPoint; }
-		void SetFocalPoint(glm::vec3 point) { m_FocalPoint = point; UpdateView(); }
+		glm::vec3 GetFocalPoint() { return glm::vec3(m_FocalPoint); }
+		void SetFocalPoint(glm::vec3 point) { m_FocalPoint = glm::dvec3(point); UpdateView(); }
 
 		double getWorldXmin() const { return worldXmin; }
 		double getWorldXmax() const { return worldXmax; }
@@ -53,6 +56,7 @@ namespace Graphics {
 		double getAspectRatio() const { return m_AspectRatio; }
 		double getGridMinorSpacing() const { return gridMinorSpacing; }
 		double getGridMajorSpacing() const { return gridMajorSpacing; }
+		glm::vec4 getGridLod() const { return gridLod; }
 		double getZoom() const { return m_zoom;  }
 	private:
 		void UpdateProjection();
@@ -67,7 +71,7 @@ namespace Graphics {
 		void MouseRotate(const glm::vec2& delta);
 		void MouseZoom(float delta);
 
-		glm::vec3 CalculatePosition() const;
+		glm::dvec3 CalculatePosition() const;
 
 		float RotationSpeed() const;
 		float ZoomSpeed() const;
@@ -75,8 +79,10 @@ namespace Graphics {
 		float m_FOV = 45.0f, m_AspectRatio = 1.778f, m_NearClip = 0.1f, m_FarClip = 1000.0f;
 
 		glm::mat4 m_ViewMatrix;
+		// Focal point and eye are kept in double, m_Position is the eye rounded for the float matrices
+		glm::dvec3 m_FocalPoint = { 0.0, 0.0, 0.0 };
+		glm::dvec3 m_Eye = { 0.0, 0.0, 0.0 };
 		glm::vec3 m_Position = { 0.0f, 0.0f, 0.0f };
-		glm::vec3 m_FocalPoint = { 0.0f, 0.0f, 0.0f };
 
 		glm::vec2 m_InitialMousePosition = { 0.0f, 0.0f };
 
@@ -89,6 +95,7 @@ namespace Graphics {
 
 		double worldXmin = 0, worldXmax = 0, worldYmin = 0, worldYmax = 0;
 		float gridMinorSpacing = 0.0f, gridMajorSpacing = 0.0f;
+		glm::vec4 gridLod = glm::vec4(0.0f);
 	};
 
 }
\ No newline at end of file
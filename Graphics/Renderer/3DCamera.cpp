@@ -51,16 +51,19 @@ void Graphics::ThreeDCamera::UpdateProjection()
 {
 	m_AspectRatio = m_ViewportWidth / m_ViewportHeight;
 	m_Projection = glm::perspective(glm::radians(m_FOV), m_AspectRatio, m_NearClip, m_FarClip);
+	MarkDirty();
 }
 
 void Graphics::ThreeDCamera::UpdateView()
 {
 	// m_Yaw = m_Pitch = 0.0f; // Lock the camera's rotation
-	m_Position = CalculatePosition();
+	m_Eye = CalculatePosition();
+	m_Position = glm::vec3(m_Eye);
 
 	glm::quat orientation = GetOrientation();
 	m_ViewMatrix = glm::translate(glm::mat4(1.0f), m_Position) * glm::toMat4(orientation);
 	m_ViewMatrix = glm::inverse(m_ViewMatrix);
+	MarkDirty();
 }
 
 
@@ -83,6 +86,8 @@ bool Graphics::ThreeDCamera::OnMouseMove(Application::MouseMovedEvent& e)
 		MouseRotate(delta);
 	else if (Application::Input::IsMouseButtonPressed(Application::Mouse::ButtonRight))
 		MousePan(delta);
+	else
+		return false; // Hovering does not move the camera
 
 	UpdateView();
 	return false;
@@ -91,8 +96,8 @@ bool Graphics::ThreeDCamera::OnMouseMove(Application::MouseMovedEvent& e)
 void Graphics::ThreeDCamera::MousePan(const glm::vec2& delta)
 {
 	auto [xSpeed, ySpeed] = PanSpeed();
-	m_FocalPoint += -GetRightDirection() * delta.x * xSpeed * m_Distance;
-	m_FocalPoint += GetUpDirection() * delta.y * ySpeed * m_Distance;
+	m_FocalPoint += glm::dvec3(-GetRightDirection() * delta.x * xSpeed * m_Distance);
+	m_FocalPoint += glm::dvec3(GetUpDirection() * delta.y * ySpeed * m_Distance);
 }
 
 void Graphics::ThreeDCamera::MouseRotate(const glm::vec2& delta)
@@ -107,14 +112,14 @@ void Graphics::ThreeDCamera::MouseZoom(float delta)
 	m_Distance -= delta * ZoomSpeed();
 	if (m_Distance < 0.01f)
 	{
-		m_FocalPoint += GetForwardDirection();
+		m_FocalPoint += glm::dvec3(GetForwardDirection());
 		m_Distance = 1.0f;
 	}
 }
 
-glm::vec3 Graphics::ThreeDCamera::CalculatePosition() const
+glm::dvec3 Graphics::ThreeDCamera::CalculatePosition() const
 {
-	return m_FocalPoint - GetForwardDirection() * m_Distance;
+	return m_FocalPoint - glm::dvec3(GetForwardDirection()) * (double)m_Distance;
 }
 
 std::pair<float, float> Graphics::ThreeDCamera::PanSpeed() const
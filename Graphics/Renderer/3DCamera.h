@@ -17,6 +17,8 @@ namespace Graphics {
 
 		void OnEvent(Application::Event& event);
 
+		Ref<Camera> Clone() const override { return CreateRef<ThreeDCamera>(*this); }
+
 		inline float GetDistance() const { return m_Distance; }
 		inline void SetDistance(float distance) { m_Distance = distance; }
 
@@ -29,6 +31,7 @@ namespace Graphics {
 		glm::vec3 GetRightDirection() const;
 		glm::vec3 GetForwardDirection() const;
 		const glm::vec3& GetPosition() const { return m_Position; }
+		glm::dvec3 GetEyePosition() const { return m_Eye; }
 		glm::quat GetOrientation() const;
 		glm::vec3 GetViewDirection() const;
 
@@ -46,18 +49,20 @@ namespace Graphics {
 
 		double getGridMinorSpacing() const { return 0; }
 		double getGridMajorSpacing() const { return 0; }
+		// The ground plane is seen in perspective, its LOD changes across the screen and stays in the shader
+		glm::vec4 getGridLod() const { return glm::vec4(0.0f); }
 
 
 		//bool OnMouseScroll(double offset);
 
 		void SetMousePos(glm::vec2 mousePos) { m_InitialMousePosition = mousePos; }
 
-		void ResetFocalPoint() { m_FocalPoint = { 0.0f, 0.0f, 0.0f }; UpdateView(); }
+		void ResetFocalPoint() { m_FocalPoint = { 0.0, 0.0, 0.0 }; UpdateView(); }
 
 		void SetPosition(const glm::vec3& position) { m_Position = position; UpdateView(); }
 
-		glm::vec3 GetFocalPoint() { return m_FocalPoint; }
-		void SetFocalPoint(glm::vec3 point) { m_FocalPoint = point; UpdateView(); }
+		glm::vec3 GetFocalPoint() { return glm::vec3(m_FocalPoint); }
+		void SetFocalPoint(glm::vec3 point) { m_FocalPoint = glm::dvec3(point); UpdateView(); }
 
 	private:
 		void UpdateProjection();
@@ -72,7 +77,7 @@ namespace Graphics {
 		void MouseRotate(const glm::vec2& delta);
 		void MouseZoom(float delta);
 
-		glm::vec3 CalculatePosition() const;
+		glm::dvec3 CalculatePosition() const;
 
 		std::pair<float, float> PanSpeed() const;
 		float RotationSpeed() const;
@@ -81,8 +86,10 @@ namespace Graphics {
 		float m_FOV = 45.0f, m_AspectRatio = 1.778f, m_NearClip = 1.0f, m_FarClip = 1000.0f;
 
 		glm::mat4 m_ViewMatrix;
+		// Focal point and eye are kept in double, m_Position is the eye rounded for the float matrices
+		glm::dvec3 m_FocalPoint = { 0.0, 0.0, 0.0 };
+		glm::dvec3 m_Eye = { 0.0, 0.0, 0.0 };
 		glm::vec3 m_Position = { 0.0f, 0.0f, 0.0f };
-		glm::vec3 m_FocalPoint = { 0.0f, 0.0f, 0.0f };
 
 		glm::vec2 m_InitialMousePosition = { 0.0f, 0.0f };
 
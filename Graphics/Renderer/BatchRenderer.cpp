@@ -1,13 +1,17 @@
 #include "BatchRenderer.h"
 #include <Renderer/Renderer.h>
 #include <Renderer/Shader.h>
+#include <Renderer/Pipeline.h>
+#include <Renderer/ShaderWatcher.h>
 #include <Renderer/VertexArray.h>
 #include <Renderer/UniformBuffer.h>
+#include <Renderer/StorageBuffer.h>
 #include <Renderer/Texture.h>
 #include <glm/gtc/type_ptr.hpp>
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/rotate_vector.hpp>
 #include <Logger.h>
+#include <bit>
 
 namespace Graphics {
 		struct UBODataFragment {
@@ -20,6 +24,8 @@ namespace Graphics {
 			glm::vec3 Position;
 			glm::vec3 Normal;
 			glm::vec4 Color;
+			// Render origin slot of the mesh, Position is relative to it
+			int Origin;
 		};
 
 		struct TriangleVertex
@@ -29,23 +35,49 @@ namespace Graphics {
 			glm::vec4 Color;
 		};
 		
-		struct QuadVertex
+		// Vertex pulling records, one per primitive. std430 layouts of the records in Resources/Shaders/PulledPrimitives.h
+		struct QuadRecord
 		{
+			glm::vec3 P0;
 			int aID;
-			glm::vec3 Position;
+			glm::vec3 P1;
+			int Origin;
+			glm::vec3 P2;
+			float Pad1;
+			glm::vec3 P3;
+			float Pad2;
 			glm::vec4 Color;
 		};
-		
-		struct CircleVertex
+		static_assert(sizeof(QuadRecord) == 80, "QuadRecord must match the std430 layout");
+
+		struct CircleRecord
 		{
+			glm::vec3 Center;
+			float Radius;
+			glm::vec4 Color;
 			int aID;
-			glm::vec3 Position;
-			glm::vec3 CirclePosition;
-			glm::vec3 Normal;
+			int Origin;
+			float Pad[2];
+		};
+		static_assert(sizeof(CircleRecord) == 48, "CircleRecord must match the std430 layout");
+
+		struct LineRecord
+		{
+			glm::vec3 From;
+			int aID;
+			glm::vec3 To;
+			int Origin;
 			glm::vec4 Color;
-			float Radius;
 		};
-		
+		static_assert(sizeof(LineRecord) == 48, "LineRecord must match the std430 layout");
+
+		// Storage buffer bindings of the records, SSBO_PULLED_* in PulledPrimitives.h
+		static constexpr uint32_t PulledQuadsBinding = 3;
+		static constexpr uint32_t PulledCirclesBinding = 4;
+		static constexpr uint32_t PulledLinesBinding = 5;
+		// SSBO_RENDER_ORIGINS in GLBufferDeclarations.h
+		static constexpr uint32_t RenderOriginsBinding = 6;
+
 		struct LineVertex
 		{
 			int aID;
@@ -53,7 +85,34 @@ namespace Graphics {
 			glm::vec4 Color;
 		};
 
+		struct BatchPipelines
+		{
+			Graphics::Ref<Graphics::Pipeline> StaticTriangle;
+			Graphics::Ref<Graphics::Pipeline> Triangle;
+			Graphics::Ref<Graphics::Pipeline> Quad;
+			Graphics::Ref<Graphics::Pipeline> Circle;
+			Graphics::Ref<Graphics::Pipeline> Line;
+			Graphics::Ref<Graphics::Pipeline> IndexedLine;
+			Graphics::Ref<Graphics::Pipeline> Polyline;
+		};
+
+		struct BatchDraw
+		{
+			Graphics::Pipeline* Pipeline;
+			const Graphics::Ref<Graphics::VertexArray>* VertexArray;
+			uint32_t Count;
+		};
+
+		// A mesh passed to addData, with the render origin slot its uploaded vertices are relative to
+		struct StoredMesh {
+			glm::dvec3 origin;
+			uint32_t originSlot = 0;
+			size_t firstVertex = 0;
+			size_t vertexCount = 0;
+		};
+
 		struct DrawList {
+			std::vector<StoredMesh> meshes;
 			std::vector<double> vertices;
 			std::vector<double> normals;
 			std::vector<uint32_t> indices;
@@ -72,9 +131,6 @@ namespace Graphics {
 			bool updateData = true;
 			int currentRenderMode = 0x1B02; // this is GL_FILL the default opengl polygon mode
 		
-			Graphics::Ref<Graphics::VertexArray> QuadVertexArray;
-			Graphics::Ref<Graphics::VertexBuffer> QuadVertexBuffer;
-			Graphics::Ref<Graphics::Shader> QuadShader;
 			//Graphics::Ref<Graphics::Texture2D> WhiteTexture;
 		
 			Graphics::Ref<Graphics::VertexArray> StaticTriangleVertexArray;
@@ -89,24 +145,58 @@ namespace Graphics {
 			Graphics::Ref<Graphics::Shader> TriangleShader;
 
 
-			Graphics::Ref<Graphics::VertexArray> CircleVertexArray;
-			Graphics::Ref<Graphics::VertexBuffer> CircleVertexBuffer;
+			// Quads, circles and lines are pulled from their records by the shaders (gl_VertexID picks record and
+			// corner), drawn over a vertex array without buffers. No vertex layout and no quad index buffer.
+			Graphics::Ref<Graphics::VertexArray> PulledVertexArray;
+			Graphics::Ref<Graphics::StorageBuffer> QuadRecordBuffer;
+			Graphics::Ref<Graphics::StorageBuffer> CircleRecordBuffer;
+			Graphics::Ref<Graphics::StorageBuffer> LineRecordBuffer;
+			Graphics::Ref<Graphics::Shader> QuadShader;
 			Graphics::Ref<Graphics::Shader> CircleShader;
-		
-			Graphics::Ref<Graphics::VertexArray> LineVertexArray;
-			Graphics::Ref<Graphics::VertexBuffer> LineVertexBuffer;
+			Graphics::Ref<Graphics::Shader> PulledLineShader;
 
 			Graphics::Ref<Graphics::VertexArray> IndexedLineVertexArray;
 			Graphics::Ref<Graphics::VertexBuffer> IndexedLineVertexBuffer;
 			Graphics::Ref<Graphics::IndexBuffer> IndexedLineIndexBuffer;
+
+			// Line strips, one vertex per point, strips separated by the primitive restart index
+			Graphics::Ref<Graphics::VertexArray> PolylineVertexArray;
+			Graphics::Ref<Graphics::VertexBuffer> PolylineVertexBuffer;
+			Graphics::Ref<Graphics::IndexBuffer> PolylineIndexBuffer;
 			Graphics::Ref<Graphics::Shader> LineShader;
 
 			Graphics::Ref<Graphics::Shader> SelectedObjectShader;
+			Graphics::Ref<Graphics::Shader> SelectedStaticShader;
+			Graphics::Ref<Graphics::Shader> SelectedQuadShader;
+			Graphics::Ref<Graphics::Shader> SelectedCircleShader;
+			Graphics::Ref<Graphics::Shader> SelectedLineShader;
+
+			// [0] depth tested, [1] drawn over everything (2D viewports)
+			BatchPipelines Pipelines[2];
+			// The selection mask is drawn over every array without depth test, one pipeline per vertex layout
+			BatchPipelines SelectedPipelines;
+			BatchPipelines* ScenePipelines = &Pipelines[0];
+			std::vector<BatchDraw> Draws;
+
+			// What positions are uploaded relative to, the eye of the viewport being drawn
+			glm::dvec3 SceneOrigin = glm::dvec3(0.0);
+			const Camera* SceneCamera = nullptr;
+			// Render origins: slot 0 is the scene origin, the others belong to stored meshes and retained batches.
+			// Their offsets from the scene origin are uploaded again whenever a slot or the scene origin changed.
+			std::vector<glm::dvec3> RenderOrigins = { glm::dvec3(0.0) };
+			std::vector<uint32_t> FreeRenderOrigins;
+			bool RenderOriginsDirty = true;
+			std::vector<glm::vec4> OriginOffsets;
+			Graphics::Ref<Graphics::StorageBuffer> OriginBuffer;
+			// Records of every retained batch, tiles share a few large buffers instead of three buffers each
+			Graphics::Ref<Graphics::BufferArena> RetainedRecords;
+			// Slot the records being drawn are relative to, a retained batch's slot between BeginRetained and EndRetained
+			uint32_t RecordOrigin = 0;
+			bool Retained = false;
+			std::vector<QuadRecord> SceneQuads;
+			std::vector<CircleRecord> SceneCircles;
+			std::vector<LineRecord> SceneLines;
 	
-			uint32_t QuadIndexCount = 0;
-			QuadVertex* QuadVertexBufferBase = nullptr;
-			QuadVertex* QuadVertexBufferPtr = nullptr;
-		
 			uint32_t StaticTriangleIndexCount = 0;
 			StaticTriangleVertex* StaticTriangleVertexBufferBase = nullptr;
 			StaticTriangleVertex* StaticTriangleVertexBufferPtr = nullptr;
@@ -119,13 +209,9 @@ namespace Graphics {
 			uint32_t* TriangleIndexBufferPtr = nullptr;
 			uint32_t TriangleVertexBufferOffset = 0;
 		
-			uint32_t CircleIndexCount = 0;
-			CircleVertex* CircleVertexBufferBase = nullptr;
-			CircleVertex* CircleVertexBufferPtr = nullptr;
-		
-			uint32_t LineVertexCount = 0;
-			LineVertex* LineVertexBufferBase = nullptr;
-			LineVertex* LineVertexBufferPtr = nullptr;
+			std::vector<QuadRecord> Quads;
+			std::vector<CircleRecord> Circles;
+			std::vector<LineRecord> Lines;
 
 			uint32_t IndexedLineIndexCount = 0;
 			LineVertex* IndexedLineVertexBufferBase = nullptr;
@@ -134,6 +220,16 @@ namespace Graphics {
 			uint32_t* IndexedLineIndexBufferPtr = nullptr;
 			uint32_t IndexedLineVertexBufferOffset = 0;
 
+			uint32_t PolylineIndexCount = 0;
+			LineVertex* PolylineVertexBufferBase = nullptr;
+			LineVertex* PolylineVertexBufferPtr = nullptr;
+			uint32_t* PolylineIndexBufferBase = nullptr;
+			uint32_t* PolylineIndexBufferPtr = nullptr;
+			uint32_t PolylineVertexBufferOffset = 0;
+
+			// Staging for batches uploaded with 16-bit indices
+			std::vector<uint16_t> Indices16;
+		
 		
 			float LineWidth = 2.0f;
 		
@@ -154,6 +250,41 @@ namespace Graphics {
 		
 		static Renderer2DData s_Data;
 
+		// Restart index of 32-bit batches, truncated to 16 bits it is the 16-bit restart index as well
+		static constexpr uint32_t PrimitiveRestartIndex = 0xFFFFFFFF;
+
+		// Dynamic positions are taken relative to the scene origin in double before they are rounded to float. While
+		// retaining they are given relative to the batch origin already.
+		static glm::vec3 ToScene(const glm::dvec3& position)
+		{
+			return glm::vec3(s_Data.Retained ? position : position - s_Data.SceneOrigin);
+		}
+
+		static glm::vec3 ToScene(const glm::vec3& position)
+		{
+			return ToScene(glm::dvec3(position));
+		}
+
+		static uint32_t AcquireRenderOrigin(const glm::dvec3& origin)
+		{
+			uint32_t slot = (uint32_t)s_Data.RenderOrigins.size();
+			if (!s_Data.FreeRenderOrigins.empty())
+			{
+				slot = s_Data.FreeRenderOrigins.back();
+				s_Data.FreeRenderOrigins.pop_back();
+				s_Data.RenderOrigins[slot] = origin;
+			}
+			else
+				s_Data.RenderOrigins.push_back(origin);
+			s_Data.RenderOriginsDirty = true;
+			return slot;
+		}
+
+		static void ReleaseRenderOrigin(uint32_t slot)
+		{
+			s_Data.FreeRenderOrigins.push_back(slot);
+		}
+
 		//Get quad vertices with position at center
 		void BatchRenderer::QuadVertices(glm::vec3 position, float size)
 		{
@@ -176,12 +307,111 @@ namespace Graphics {
 			return s_Data.Stats;
 		}
 
-		inline void CreateShaders() {
-			s_Data.StaticTriangleShader = Graphics::Shader::Create("./Resources/Shaders/BasicShader.glsl", false);
-			s_Data.TriangleShader = Graphics::Shader::Create("./Resources/Shaders/TriangleShader.glsl", false);
-			s_Data.CircleShader = Graphics::Shader::Create("./Resources/Shaders/CircleShader.glsl", false);
-			s_Data.LineShader = Graphics::Shader::Create("./Resources/Shaders/LineShader.glsl", false);
-			s_Data.SelectedObjectShader = Graphics::Shader::Create("./Resources/Shaders/SelectedObject.glsl", false);
+		static std::array<Graphics::Ref<Graphics::Shader>*, 11> GetShaders()
+		{
+			return { &s_Data.StaticTriangleShader, &s_Data.TriangleShader, &s_Data.QuadShader, &s_Data.CircleShader, &s_Data.LineShader, &s_Data.PulledLineShader,
+				&s_Data.SelectedObjectShader, &s_Data.SelectedStaticShader, &s_Data.SelectedQuadShader, &s_Data.SelectedCircleShader, &s_Data.SelectedLineShader };
+		}
+
+		inline void CreateShaders(bool recompile = false) {
+			Graphics::ShaderLibrary& library = Graphics::Renderer::GetShaderLibrary();
+			s_Data.StaticTriangleShader = library.GetVariant("./Resources/Shaders/BasicShader.glsl", {}, recompile);
+			s_Data.TriangleShader = library.GetVariant("./Resources/Shaders/TriangleShader.glsl", {}, recompile);
+			s_Data.QuadShader = library.GetVariant("./Resources/Shaders/TriangleShader.glsl", Graphics::ShaderVariant().Define("PULL_QUADS"), recompile);
+			s_Data.CircleShader = library.GetVariant("./Resources/Shaders/CircleShader.glsl", {}, recompile);
+			s_Data.LineShader = library.GetVariant("./Resources/Shaders/LineShader.glsl", {}, recompile);
+			s_Data.PulledLineShader = library.GetVariant("./Resources/Shaders/LineShader.glsl", Graphics::ShaderVariant().Define("PULL_LINES"), recompile);
+			s_Data.SelectedObjectShader = library.GetVariant("./Resources/Shaders/SelectedObject.glsl", {}, recompile);
+			s_Data.SelectedStaticShader = library.GetVariant("./Resources/Shaders/SelectedObject.glsl", Graphics::ShaderVariant().Define("RENDER_ORIGINS"), recompile);
+			s_Data.SelectedQuadShader = library.GetVariant("./Resources/Shaders/SelectedObject.glsl", Graphics::ShaderVariant().Define("PULL_QUADS"), recompile);
+			s_Data.SelectedCircleShader = library.GetVariant("./Resources/Shaders/SelectedObject.glsl", Graphics::ShaderVariant().Define("PULL_CIRCLES"), recompile);
+			s_Data.SelectedLineShader = library.GetVariant("./Resources/Shaders/SelectedObject.glsl", Graphics::ShaderVariant().Define("PULL_LINES"), recompile);
+
+			for (auto* shader : GetShaders())
+				Graphics::ShaderWatcher::Watch(*shader);
+		}
+
+		// Pulled primitives pass an empty layout, their shaders have no vertex inputs
+		static Graphics::Ref<Graphics::Pipeline> CreatePipeline(const Graphics::Ref<Graphics::Shader>& shader, const Graphics::BufferLayout& layout,
+			Graphics::PrimitiveTopology topology, bool depthTest, uint32_t layer)
+		{
+			Graphics::PipelineSpecification spec;
+			spec.Shader = shader;
+			spec.Layout = layout;
+			spec.Topology = topology;
+			spec.PrimitiveRestart = topology == Graphics::PrimitiveTopology::LineStrip;
+			spec.Depth.TestEnable = depthTest;
+			spec.Layer = layer;
+			return Graphics::Pipeline::Create(spec);
+		}
+
+		// Pipelines hold the shaders, recreated together with them
+		static void CreatePipelines()
+		{
+			for (uint32_t i = 0; i < 2; i++)
+			{
+				const bool depthTest = i == 0;
+				BatchPipelines& pipelines = s_Data.Pipelines[i];
+				pipelines.StaticTriangle = CreatePipeline(s_Data.StaticTriangleShader, s_Data.StaticTriangleVertexBuffer->GetLayout(), Graphics::PrimitiveTopology::Triangles, depthTest, 0);
+				pipelines.Triangle = CreatePipeline(s_Data.TriangleShader, s_Data.TriangleVertexBuffer->GetLayout(), Graphics::PrimitiveTopology::Triangles, depthTest, 0);
+				pipelines.Quad = CreatePipeline(s_Data.QuadShader, {}, Graphics::PrimitiveTopology::Triangles, depthTest, 0);
+				pipelines.Circle = CreatePipeline(s_Data.CircleShader, {}, Graphics::PrimitiveTopology::Triangles, depthTest, 0);
+				pipelines.Line = CreatePipeline(s_Data.PulledLineShader, {}, Graphics::PrimitiveTopology::Lines, depthTest, 0);
+				pipelines.IndexedLine = CreatePipeline(s_Data.LineShader, s_Data.IndexedLineVertexBuffer->GetLayout(), Graphics::PrimitiveTopology::Lines, depthTest, 0);
+				pipelines.Polyline = CreatePipeline(s_Data.LineShader, s_Data.PolylineVertexBuffer->GetLayout(), Graphics::PrimitiveTopology::LineStrip, depthTest, 0);
+			}
+
+			BatchPipelines& selected = s_Data.SelectedPipelines;
+			selected.StaticTriangle = CreatePipeline(s_Data.SelectedStaticShader, s_Data.StaticTriangleVertexBuffer->GetLayout(), Graphics::PrimitiveTopology::Triangles, false, 1);
+			selected.Triangle = CreatePipeline(s_Data.SelectedObjectShader, s_Data.TriangleVertexBuffer->GetLayout(), Graphics::PrimitiveTopology::Triangles, false, 1);
+			selected.Quad = CreatePipeline(s_Data.SelectedQuadShader, {}, Graphics::PrimitiveTopology::Triangles, false, 1);
+			selected.Circle = CreatePipeline(s_Data.SelectedCircleShader, {}, Graphics::PrimitiveTopology::Triangles, false, 1);
+			selected.Line = CreatePipeline(s_Data.SelectedLineShader, {}, Graphics::PrimitiveTopology::Lines, false, 1);
+			selected.IndexedLine = CreatePipeline(s_Data.SelectedObjectShader, s_Data.IndexedLineVertexBuffer->GetLayout(), Graphics::PrimitiveTopology::Lines, false, 1);
+			selected.Polyline = CreatePipeline(s_Data.SelectedObjectShader, s_Data.PolylineVertexBuffer->GetLayout(), Graphics::PrimitiveTopology::LineStrip, false, 1);
+		}
+
+		// The record buffer grows to the next power of two that fits the batch, so it is recreated only a few times
+		template<typename Record>
+		static void UploadRecords(Graphics::Ref<Graphics::StorageBuffer>& buffer, const std::vector<Record>& records, uint32_t binding)
+		{
+			const uint32_t size = (uint32_t)(records.size() * sizeof(Record));
+			if (!buffer || buffer->GetSize() < size)
+				buffer = Graphics::StorageBuffer::Create(std::bit_ceil(size), binding);
+			buffer->SetData(records.data(), size);
+			buffer->Bind(binding);
+		}
+
+		// Every pulled record and stored vertex reads its origin offset, so the buffer is bound before any batch draw
+		static void UploadRenderOrigins()
+		{
+			if (!s_Data.RenderOriginsDirty)
+			{
+				s_Data.OriginBuffer->Bind(RenderOriginsBinding);
+				return;
+			}
+
+			s_Data.OriginOffsets.resize(s_Data.RenderOrigins.size());
+			s_Data.OriginOffsets[0] = glm::vec4(0.0f);
+			for (size_t i = 1; i < s_Data.RenderOrigins.size(); i++)
+				s_Data.OriginOffsets[i] = glm::vec4(glm::vec3(s_Data.RenderOrigins[i] - s_Data.SceneOrigin), 0.0f);
+			UploadRecords(s_Data.OriginBuffer, s_Data.OriginOffsets, RenderOriginsBinding);
+			s_Data.RenderOriginsDirty = false;
+		}
+
+		// 16-bit indices when every vertex of the batch is addressable below the 16-bit restart index
+		static void UploadIndices(const Graphics::Ref<Graphics::IndexBuffer>& indexBuffer, const uint32_t* indices, uint32_t count, uint32_t vertexCount)
+		{
+			if (vertexCount >= 0xFFFF)
+			{
+				indexBuffer->SetData(indices, count, 0);
+				return;
+			}
+
+			s_Data.Indices16.resize(count);
+			for (uint32_t i = 0; i < count; i++)
+				s_Data.Indices16[i] = (uint16_t)indices[i];
+			indexBuffer->SetData(s_Data.Indices16.data(), count, 0);
 		}
 
 		void BatchRenderer::Init()
@@ -194,7 +424,8 @@ namespace Graphics {
 				{ Graphics::ShaderDataType::Int, "aID"},
 				{ Graphics::ShaderDataType::Float3, "aPos"},
 				{ Graphics::ShaderDataType::Float3, "aNormal"},
-				{ Graphics::ShaderDataType::Float4, "aColor"}
+				{ Graphics::ShaderDataType::Float4, "aColor"},
+				{ Graphics::ShaderDataType::Int, "aOrigin"}
 			});
 			s_Data.StaticTriangleVertexArray->AddVertexBuffer(s_Data.StaticTriangleVertexBuffer);
 			s_Data.StaticTriangleIndexBuffer = Graphics::IndexBuffer::Create(s_Data.MaxIndices);
@@ -218,52 +449,13 @@ namespace Graphics {
 			s_Data.TriangleVertexBufferBase = new TriangleVertex[s_Data.MaxVertices];
 			s_Data.TriangleIndexBufferBase = new uint32_t[s_Data.MaxIndices];
 
-			uint32_t* quadIndices = new uint32_t[s_Data.MaxIndices];
-
-			uint32_t offset = 0;
-			for (uint32_t i = 0; i < s_Data.MaxIndices; i += 6)
-			{
-				quadIndices[i + 0] = offset + 0;
-				quadIndices[i + 1] = offset + 1;
-				quadIndices[i + 2] = offset + 2;
-
-				quadIndices[i + 3] = offset + 2;
-				quadIndices[i + 4] = offset + 3;
-				quadIndices[i + 5] = offset + 0;
-
-				offset += 4;
-			}
-
-			// Circles
-			s_Data.CircleVertexArray = Graphics::VertexArray::Create();
-
-			s_Data.CircleVertexBuffer = Graphics::VertexBuffer::Create(s_Data.MaxVertices * sizeof(CircleVertex));
-			s_Data.CircleVertexBuffer->SetLayout({
-				{ Graphics::ShaderDataType::Int, "aID"},
-				{ Graphics::ShaderDataType::Float3, "aPos" },
-				{ Graphics::ShaderDataType::Float3, "aCirclePos" },
-				{ Graphics::ShaderDataType::Float3, "aNormal" },
-				{ Graphics::ShaderDataType::Float4, "aColor" },
-				{ Graphics::ShaderDataType::Float, "aRadius" },
-			});
-			s_Data.CircleVertexArray->AddVertexBuffer(s_Data.CircleVertexBuffer);
-			Graphics::Ref<Graphics::IndexBuffer> quadIB = Graphics::IndexBuffer::Create(quadIndices, s_Data.MaxIndices);
-			s_Data.CircleVertexArray->SetIndexBuffer(quadIB); // Use quad IB
-			s_Data.CircleVertexBufferBase =  new CircleVertex[s_Data.MaxVertices];
-			delete[] quadIndices;
-
-			//Lines
-			s_Data.LineVertexArray = Graphics::VertexArray::Create();
-
-			s_Data.LineVertexBuffer = Graphics::VertexBuffer::Create(s_Data.MaxVertices * sizeof(LineVertex));
-			s_Data.LineVertexBuffer->SetLayout({
-				{ Graphics::ShaderDataType::Int, "aID"},
-				{ Graphics::ShaderDataType::Float3, "aPos" },
-				{ Graphics::ShaderDataType::Float4, "aColor" },
-
-			});
-			s_Data.LineVertexArray->AddVertexBuffer(s_Data.LineVertexBuffer);
-			s_Data.LineVertexBufferBase = new LineVertex[s_Data.MaxVertices];
+			// Quads, circles and lines: record buffers are created by the first flush that has records
+			s_Data.PulledVertexArray = Graphics::VertexArray::Create();
+			Graphics::BufferArenaSpecification retainedSpec;
+			retainedSpec.Usage = Graphics::BufferArenaUsage::Storage;
+			retainedSpec.BlockSize = 16ull * 1024 * 1024;
+			retainedSpec.DebugName = "Retained records";
+			s_Data.RetainedRecords = Graphics::BufferArena::Create(retainedSpec);
 
 
 			//IndexedLines
@@ -282,7 +474,24 @@ namespace Graphics {
 			s_Data.IndexedLineVertexBufferBase = new LineVertex[s_Data.MaxVertices];
 			s_Data.IndexedLineIndexBufferBase = new uint32_t[s_Data.MaxIndices];
 
+			//Polylines
+			s_Data.PolylineVertexArray = Graphics::VertexArray::Create();
+
+			s_Data.PolylineVertexBuffer = Graphics::VertexBuffer::Create(s_Data.MaxVertices * sizeof(LineVertex));
+			s_Data.PolylineVertexBuffer->SetLayout({
+				{ Graphics::ShaderDataType::Int, "aID"},
+				{ Graphics::ShaderDataType::Float3, "aPos" },
+				{ Graphics::ShaderDataType::Float4, "aColor" },
+			});
+			s_Data.PolylineVertexArray->AddVertexBuffer(s_Data.PolylineVertexBuffer);
+			s_Data.PolylineIndexBuffer = Graphics::IndexBuffer::Create(s_Data.MaxIndices);
+			s_Data.PolylineVertexArray->SetIndexBuffer(s_Data.PolylineIndexBuffer);
+
+			s_Data.PolylineVertexBufferBase = new LineVertex[s_Data.MaxVertices];
+			s_Data.PolylineIndexBufferBase = new uint32_t[s_Data.MaxIndices];
+
 			CreateShaders();
+			CreatePipelines();
 
 			glm::vec4 triangleColor = glm::vec4(1.0f, 0.5f, 0.2f, 1.0f);
 			UBODataFragment uboDataFragment = UBODataFragment(triangleColor);
@@ -292,18 +501,33 @@ namespace Graphics {
 		}
 
 		void BatchRenderer::ReCreateShaders() {
-			CreateShaders();
+			CreateShaders(true);
+			CreatePipelines();
+		}
+
+		bool BatchRenderer::IsReady()
+		{
+			// Poll every shader so all of them make progress on linking
+			bool ready = true;
+			for (auto* shader : GetShaders())
+				ready &= (*shader)->IsReady();
+			return ready;
 		}
 
 		void BatchRenderer::Shutdown()
 		{
-			delete[] s_Data.QuadVertexBufferBase;
 			delete[] s_Data.StaticTriangleVertexBufferBase;
+			delete[] s_Data.PolylineVertexBufferBase;
+			delete[] s_Data.PolylineIndexBufferBase;
 		}
 
-		void BatchRenderer::BeginScene()
+		void BatchRenderer::BeginScene(bool depthTest, const Camera* camera)
 		{
 			s_Data.inScene = true;
+			s_Data.ScenePipelines = &s_Data.Pipelines[depthTest ? 0 : 1];
+			s_Data.SceneCamera = camera;
+			s_Data.SceneOrigin = camera ? camera->GetEyePosition() : glm::dvec3(0.0);
+			s_Data.RenderOriginsDirty = true;
 			StartBatch();
 		}
 
@@ -317,46 +541,147 @@ namespace Graphics {
 			return s_Data.updateData;
 		}
 
+		const Camera* BatchRenderer::GetSceneCamera()
+		{
+			return s_Data.inScene ? s_Data.SceneCamera : nullptr;
+		}
+
+		bool BatchRenderer::GetSceneDepthTest()
+		{
+			return s_Data.ScenePipelines == &s_Data.Pipelines[0];
+		}
+
 		void BatchRenderer::EndScene()
 		{
+			assert(!s_Data.Retained);
 			Flush();
 			s_Data.inScene = false;
+			s_Data.SceneCamera = nullptr;
+		}
+
+		RetainedBatch::~RetainedBatch()
+		{
+			ReleaseRenderOrigin(m_Origin);
+		}
+
+		void BatchRenderer::BeginRetained(const glm::dvec3& origin)
+		{
+			assert(s_Data.inScene && !s_Data.Retained);
+			s_Data.Retained = true;
+			s_Data.RecordOrigin = AcquireRenderOrigin(origin);
+			s_Data.SceneQuads.swap(s_Data.Quads);
+			s_Data.SceneCircles.swap(s_Data.Circles);
+			s_Data.SceneLines.swap(s_Data.Lines);
 		}
 
-		//Draw the selected object
+		// Sized to fit, a retained batch is never written again
+		template<typename Record>
+		static Graphics::Ref<Graphics::BufferRange> CreateRecordRange(const std::vector<Record>& records)
+		{
+			if (records.empty())
+				return nullptr;
+			const uint64_t size = records.size() * sizeof(Record);
+			Graphics::Ref<Graphics::BufferRange> range = s_Data.RetainedRecords->Allocate(size);
+			range->SetData(records.data(), size);
+			return range;
+		}
+
+		Graphics::Ref<RetainedBatch> BatchRenderer::EndRetained()
+		{
+			assert(s_Data.Retained);
+			Graphics::Ref<RetainedBatch> batch = Graphics::CreateRef<RetainedBatch>();
+			batch->m_Origin = s_Data.RecordOrigin;
+			batch->m_Quads = CreateRecordRange(s_Data.Quads);
+			batch->m_Circles = CreateRecordRange(s_Data.Circles);
+			batch->m_Lines = CreateRecordRange(s_Data.Lines);
+			batch->m_QuadCount = (uint32_t)s_Data.Quads.size();
+			batch->m_CircleCount = (uint32_t)s_Data.Circles.size();
+			batch->m_LineCount = (uint32_t)s_Data.Lines.size();
+			batch->m_Size = s_Data.Quads.size() * sizeof(QuadRecord) + s_Data.Circles.size() * sizeof(CircleRecord) + s_Data.Lines.size() * sizeof(LineRecord);
+
+			s_Data.Quads.clear();
+			s_Data.Circles.clear();
+			s_Data.Lines.clear();
+			s_Data.SceneQuads.swap(s_Data.Quads);
+			s_Data.SceneCircles.swap(s_Data.Circles);
+			s_Data.SceneLines.swap(s_Data.Lines);
+			s_Data.RecordOrigin = 0;
+			s_Data.Retained = false;
+			return batch;
+		}
+
+		void BatchRenderer::DrawRetained(const RetainedBatch& batch)
+		{
+			assert(s_Data.inScene && !s_Data.Retained);
+			UploadRenderOrigins();
+
+			// Drawn right away, its ranges take the record bindings until the batch is flushed
+			auto draw = [](const Graphics::Ref<Graphics::BufferRange>& range, uint32_t binding, uint32_t count, Graphics::Pipeline* pipeline, Graphics::Pipeline* selected) {
+				if (!range)
+					return;
+				range->Bind(binding);
+				pipeline->Bind();
+				Graphics::RenderCommand::Draw(*pipeline, s_Data.PulledVertexArray, count);
+				selected->Bind();
+				Graphics::RenderCommand::Draw(*selected, s_Data.PulledVertexArray, count);
+			};
+			BatchPipelines& pipelines = *s_Data.ScenePipelines;
+			draw(batch.m_Quads, PulledQuadsBinding, batch.m_QuadCount * 6, pipelines.Quad.get(), s_Data.SelectedPipelines.Quad.get());
+			draw(batch.m_Circles, PulledCirclesBinding, batch.m_CircleCount * 6, pipelines.Circle.get(), s_Data.SelectedPipelines.Circle.get());
+			draw(batch.m_Lines, PulledLinesBinding, batch.m_LineCount * 2, pipelines.Line.get(), s_Data.SelectedPipelines.Line.get());
+		}
+
+		//Queue the selected object mask, drawn over the scene
 		void BatchRenderer::DrawSelected() {
 			//All of the vertex array will still be vaild
-			Renderer::DepthTest(false);
-			s_Data.SelectedObjectShader->Bind();
+			BatchPipelines& pipelines = s_Data.SelectedPipelines;
 			if (s_Data.StaticTriangleIndexCount)
-			{
-				Graphics::RenderCommand::DrawIndexed(s_Data.StaticTriangleVertexArray, s_Data.storage.indices.size());
-			}
+				s_Data.Draws.push_back({ pipelines.StaticTriangle.get(), &s_Data.StaticTriangleVertexArray, (uint32_t)s_Data.storage.indices.size() });
 
-			if (s_Data.TriangleIndexCount) {
-				Graphics::RenderCommand::DrawIndexed(s_Data.TriangleVertexArray, s_Data.TriangleIndexCount);
-			}
+			if (s_Data.TriangleIndexCount)
+				s_Data.Draws.push_back({ pipelines.Triangle.get(), &s_Data.TriangleVertexArray, s_Data.TriangleIndexCount });
 
-			if (s_Data.CircleIndexCount)
-			{
-				Graphics::RenderCommand::DrawIndexed(s_Data.CircleVertexArray, s_Data.CircleIndexCount);
-			}
+			if (!s_Data.Quads.empty())
+				s_Data.Draws.push_back({ pipelines.Quad.get(), &s_Data.PulledVertexArray, (uint32_t)s_Data.Quads.size() * 6 });
 
-			if (s_Data.LineVertexCount)
-			{
-				Graphics::RenderCommand::DrawLines(s_Data.LineVertexArray, s_Data.LineVertexCount);
-			}
+			if (!s_Data.Circles.empty())
+				s_Data.Draws.push_back({ pipelines.Circle.get(), &s_Data.PulledVertexArray, (uint32_t)s_Data.Circles.size() * 6 });
+
+			if (!s_Data.Lines.empty())
+				s_Data.Draws.push_back({ pipelines.Line.get(), &s_Data.PulledVertexArray, (uint32_t)s_Data.Lines.size() * 2 });
 
 			if (s_Data.IndexedLineIndexCount)
+				s_Data.Draws.push_back({ pipelines.IndexedLine.get(), &s_Data.IndexedLineVertexArray, s_Data.IndexedLineIndexCount });
+
+			if (s_Data.PolylineIndexCount)
+				s_Data.Draws.push_back({ pipelines.Polyline.get(), &s_Data.PolylineVertexArray, s_Data.PolylineIndexCount });
+		}
+
+		void BatchRenderer::SubmitDraws()
+		{
+			// Stable, so draws sharing a pipeline keep their submission order. Sort keys follow pipeline creation
+			// order, which is the order the primitives have always been drawn in.
+			std::stable_sort(s_Data.Draws.begin(), s_Data.Draws.end(), [](const BatchDraw& a, const BatchDraw& b) {
+				return a.Pipeline->GetSortKey() < b.Pipeline->GetSortKey();
+			});
+
+			Graphics::Pipeline* bound = nullptr;
+			for (const BatchDraw& draw : s_Data.Draws)
 			{
-				Graphics::RenderCommand::DrawLinesIndexed(s_Data.IndexedLineVertexArray, s_Data.IndexedLineIndexCount);
+				if (draw.Pipeline != bound)
+				{
+					draw.Pipeline->Bind();
+					bound = draw.Pipeline;
+				}
+				Graphics::RenderCommand::Draw(*draw.Pipeline, *draw.VertexArray, draw.Count);
 			}
-			s_Data.SelectedObjectShader->Unbind();
-			Renderer::DepthTest(true);
+			s_Data.Draws.clear();
 		}
 
 		void BatchRenderer::Flush()
 		{
+			BatchPipelines& pipelines = *s_Data.ScenePipelines;
+			UploadRenderOrigins();
 
 			if (s_Data.StaticTriangleIndexCount)
 			{
@@ -367,18 +692,10 @@ namespace Graphics {
 					s_Data.StaticTriangleVertexBuffer->SetData(s_Data.StaticTriangleVertexBufferBase, dataSize);
 					s_Data.StaticTriangleVertexBufferOffset += dataSize;
 
-
-					uint32_t* triangleIndices = new uint32_t[s_Data.storage.indices.size()];
-					for (size_t i = 0; i < s_Data.storage.indices.size(); i++) {
-						triangleIndices[i] = s_Data.storage.indices.at(i);
-					}
-					s_Data.StaticTriangleIndexBuffer->SetData(triangleIndices, s_Data.storage.indices.size(), 0);
-					delete[] triangleIndices;
+					UploadIndices(s_Data.StaticTriangleIndexBuffer, s_Data.storage.indices.data(), (uint32_t)s_Data.storage.indices.size(), (uint32_t)(s_Data.storage.vertices.size() / 3));
 				}
 
-				s_Data.StaticTriangleShader->Bind();
-				Graphics::RenderCommand::DrawIndexed(s_Data.StaticTriangleVertexArray, s_Data.storage.indices.size());
-				s_Data.StaticTriangleShader->Unbind();
+				s_Data.Draws.push_back({ pipelines.StaticTriangle.get(), &s_Data.StaticTriangleVertexArray, (uint32_t)s_Data.storage.indices.size() });
 				//s_Data.Stats.DrawCalls++;
 				//s_Data.TriangleIndices.clear();
 			}
@@ -386,54 +703,55 @@ namespace Graphics {
 			if (s_Data.TriangleIndexCount) {
 				uint32_t dataSize = (uint32_t)((uint8_t*)s_Data.TriangleVertexBufferPtr - (uint8_t*)s_Data.TriangleVertexBufferBase);
 				s_Data.TriangleVertexBuffer->SetData(s_Data.TriangleVertexBufferBase, dataSize, 0);
-				s_Data.TriangleIndexBuffer->SetData(s_Data.TriangleIndexBufferBase, s_Data.TriangleIndexCount, 0);
+				UploadIndices(s_Data.TriangleIndexBuffer, s_Data.TriangleIndexBufferBase, s_Data.TriangleIndexCount, s_Data.TriangleVertexBufferOffset);
 
-				s_Data.TriangleShader->Bind();
-				Graphics::RenderCommand::DrawIndexed(s_Data.TriangleVertexArray, s_Data.TriangleIndexCount);
-				s_Data.TriangleShader->Unbind();
+				s_Data.Draws.push_back({ pipelines.Triangle.get(), &s_Data.TriangleVertexArray, s_Data.TriangleIndexCount });
 			}
 
-			if (s_Data.CircleIndexCount)
+			// 6 vertices per quad and circle, 2 per line, the shaders pull them from the bound records
+			if (!s_Data.Quads.empty())
 			{
-				uint32_t dataSize = (uint32_t)((uint8_t*)s_Data.CircleVertexBufferPtr - (uint8_t*)s_Data.CircleVertexBufferBase);
-				s_Data.CircleVertexBuffer->SetData(s_Data.CircleVertexBufferBase, dataSize, 0);
+				UploadRecords(s_Data.QuadRecordBuffer, s_Data.Quads, PulledQuadsBinding);
+				s_Data.Draws.push_back({ pipelines.Quad.get(), &s_Data.PulledVertexArray, (uint32_t)s_Data.Quads.size() * 6 });
+			}
 
-				s_Data.CircleShader->Bind();
-				Graphics::RenderCommand::DrawIndexed(s_Data.CircleVertexArray, s_Data.CircleIndexCount);
-				s_Data.CircleShader->Unbind();
+			if (!s_Data.Circles.empty())
+			{
+				UploadRecords(s_Data.CircleRecordBuffer, s_Data.Circles, PulledCirclesBinding);
+				s_Data.Draws.push_back({ pipelines.Circle.get(), &s_Data.PulledVertexArray, (uint32_t)s_Data.Circles.size() * 6 });
 				//s_Data.Stats.DrawCalls++;
 			}
 
-			if (s_Data.LineVertexCount)
+			if (!s_Data.Lines.empty())
 			{
-				uint32_t dataSize = (uint32_t)((uint8_t*)s_Data.LineVertexBufferPtr - (uint8_t*)s_Data.LineVertexBufferBase);
-				s_Data.LineVertexBuffer->SetData(s_Data.LineVertexBufferBase, dataSize, 0);
-
-				s_Data.LineShader->Bind();
-				Graphics::RenderCommand::DrawLines(s_Data.LineVertexArray, s_Data.LineVertexCount);
-				s_Data.LineShader->Unbind();
+				UploadRecords(s_Data.LineRecordBuffer, s_Data.Lines, PulledLinesBinding);
+				s_Data.Draws.push_back({ pipelines.Line.get(), &s_Data.PulledVertexArray, (uint32_t)s_Data.Lines.size() * 2 });
 			}
 
 			if (s_Data.IndexedLineIndexCount)
 			{
 				uint32_t dataSize = (uint32_t)((uint8_t*)s_Data.IndexedLineVertexBufferPtr - (uint8_t*)s_Data.IndexedLineVertexBufferBase);
 				s_Data.IndexedLineVertexBuffer->SetData(s_Data.IndexedLineVertexBufferBase, dataSize, 0);
-				s_Data.IndexedLineIndexBuffer->SetData(s_Data.IndexedLineIndexBufferBase, s_Data.IndexedLineIndexCount, 0);
+				UploadIndices(s_Data.IndexedLineIndexBuffer, s_Data.IndexedLineIndexBufferBase, s_Data.IndexedLineIndexCount, s_Data.IndexedLineVertexBufferOffset);
 
-				s_Data.LineShader->Bind();
-				Graphics::RenderCommand::DrawLinesIndexed(s_Data.IndexedLineVertexArray, s_Data.IndexedLineIndexCount);
-				s_Data.LineShader->Unbind();
+				s_Data.Draws.push_back({ pipelines.IndexedLine.get(), &s_Data.IndexedLineVertexArray, s_Data.IndexedLineIndexCount });
 			}
 
-			DrawSelected();
+			if (s_Data.PolylineIndexCount)
+			{
+				uint32_t dataSize = (uint32_t)((uint8_t*)s_Data.PolylineVertexBufferPtr - (uint8_t*)s_Data.PolylineVertexBufferBase);
+				s_Data.PolylineVertexBuffer->SetData(s_Data.PolylineVertexBufferBase, dataSize, 0);
+				UploadIndices(s_Data.PolylineIndexBuffer, s_Data.PolylineIndexBufferBase, s_Data.PolylineIndexCount, s_Data.PolylineVertexBufferOffset);
+
+				s_Data.Draws.push_back({ pipelines.Polyline.get(), &s_Data.PolylineVertexArray, s_Data.PolylineIndexCount });
+			}
 
+			DrawSelected();
+			SubmitDraws();
 		}
 
 		void BatchRenderer::StartBatch()
 		{
-			s_Data.QuadIndexCount = 0;
-			s_Data.QuadVertexBufferPtr = s_Data.QuadVertexBufferBase;
-
 			//s_Data.StaticTriangleIndexCount = 0;
 			s_Data.StaticTriangleVertexBufferPtr = s_Data.StaticTriangleVertexBufferBase;
 
@@ -442,24 +760,33 @@ namespace Graphics {
 			s_Data.TriangleVertexBufferPtr = s_Data.TriangleVertexBufferBase;
 			s_Data.TriangleIndexBufferPtr = s_Data.TriangleIndexBufferBase;
 
-			s_Data.CircleIndexCount = 0;
-			s_Data.CircleVertexBufferPtr = s_Data.CircleVertexBufferBase;
-
-			s_Data.LineVertexCount = 0;
-			s_Data.LineVertexBufferPtr = s_Data.LineVertexBufferBase;
+			s_Data.Quads.clear();
+			s_Data.Circles.clear();
+			s_Data.Lines.clear();
 
 			s_Data.IndexedLineIndexCount = 0;
 			s_Data.IndexedLineVertexBufferOffset = 0;
 			s_Data.IndexedLineVertexBufferPtr = s_Data.IndexedLineVertexBufferBase;
 			s_Data.IndexedLineIndexBufferPtr = s_Data.IndexedLineIndexBufferBase;
 
+			s_Data.PolylineIndexCount = 0;
+			s_Data.PolylineVertexBufferOffset = 0;
+			s_Data.PolylineVertexBufferPtr = s_Data.PolylineVertexBufferBase;
+			s_Data.PolylineIndexBufferPtr = s_Data.PolylineIndexBufferBase;
+
 			if (s_Data.storage.updateBatch) {
-				for (size_t i = 0; i < s_Data.storage.vertices.size(); i += 3) {
-					s_Data.StaticTriangleVertexBufferPtr->aID = -1;
-					s_Data.StaticTriangleVertexBufferPtr->Position = glm::vec3(static_cast<float>(s_Data.storage.vertices.at(i)), static_cast<float>(s_Data.storage.vertices.at(i + 1)), static_cast<float>(s_Data.storage.vertices.at(i + 2)));
-					s_Data.StaticTriangleVertexBufferPtr->Normal = glm::vec3(1.0f,0.0f,0.0f);
-					s_Data.StaticTriangleVertexBufferPtr->Color = glm::vec4(1.0f);
-					s_Data.StaticTriangleVertexBufferPtr++;
+				// Rounded to float only after the mesh origin is taken out, so the offsets keep their precision
+				for (size_t m = 0; m < s_Data.storage.meshes.size(); m++) {
+					const StoredMesh& mesh = s_Data.storage.meshes[m];
+					for (size_t v = mesh.firstVertex; v < mesh.firstVertex + mesh.vertexCount; v++) {
+						const double* position = &s_Data.storage.vertices[v * 3];
+						s_Data.StaticTriangleVertexBufferPtr->aID = -1;
+						s_Data.StaticTriangleVertexBufferPtr->Position = glm::vec3(glm::dvec3(position[0], position[1], position[2]) - mesh.origin);
+						s_Data.StaticTriangleVertexBufferPtr->Normal = glm::vec3(1.0f,0.0f,0.0f);
+						s_Data.StaticTriangleVertexBufferPtr->Color = glm::vec4(1.0f);
+						s_Data.StaticTriangleVertexBufferPtr->Origin = (int)mesh.originSlot;
+						s_Data.StaticTriangleVertexBufferPtr++;
+					}
 				}
 
 				s_Data.StaticTriangleIndexCount = s_Data.storage.indices.size();
@@ -478,6 +805,20 @@ namespace Graphics {
 			assert((vertices.size() % 3) == 0);
 			LOG_DEBUG_STREAM << "Adding data..." << " Vertices: " << vertices.size() << " Normals: " << vertexNormals.size() << " Indices : " << indices.size();
 
+			StoredMesh& mesh = s_Data.storage.meshes.emplace_back();
+			mesh.firstVertex = s_Data.storage.vertices.size() / 3;
+			mesh.vertexCount = vertices.size() / 3;
+			if (!vertices.empty()) {
+				glm::dvec3 lower(vertices[0], vertices[1], vertices[2]), upper = lower;
+				for (size_t i = 3; i < vertices.size(); i += 3) {
+					const glm::dvec3 position(vertices[i], vertices[i + 1], vertices[i + 2]);
+					lower = glm::min(lower, position);
+					upper = glm::max(upper, position);
+				}
+				mesh.origin = (lower + upper) * 0.5;
+			}
+			mesh.originSlot = AcquireRenderOrigin(mesh.origin);
+
 			s_Data.storage.vertices.insert(s_Data.storage.vertices.end(), vertices.begin(), vertices.end());
 
 			if (vertexNormals.empty()) {
@@ -503,10 +844,11 @@ namespace Graphics {
 
 		void BatchRenderer::DrawMesh(const std::vector<double>& vertices, const std::vector<uint32_t>& indices, const glm::vec4& color, const int id) {
 			assert((s_Data.inScene) && (vertices.size() % 3 == 0));
+			assert(!s_Data.Retained);
 
 			for (size_t i = 0; i < vertices.size(); i += 3) {
 				s_Data.TriangleVertexBufferPtr->aID = id;
-				s_Data.TriangleVertexBufferPtr->Position = glm::vec3(static_cast<float>(vertices.at(i)), static_cast<float>(vertices.at(i + 1)), static_cast<float>(vertices.at(i + 2)));
+				s_Data.TriangleVertexBufferPtr->Position = ToScene(glm::dvec3(vertices.at(i), vertices.at(i + 1), vertices.at(i + 2)));
 				s_Data.TriangleVertexBufferPtr->Color = color;
 				s_Data.TriangleVertexBufferPtr++;
 			}
@@ -523,19 +865,13 @@ namespace Graphics {
 		void BatchRenderer::DrawCircle(const glm::vec3& position, float radius ,const glm::vec4& color, const int id) {
 			assert(s_Data.inScene);
 
-			QuadVertices(position, radius*2);
-
-			for (unsigned int i = 0; i < 4; i++) {
-				s_Data.CircleVertexBufferPtr->aID = id;
-				s_Data.CircleVertexBufferPtr->Position = s_Data.quadVertices[i];
-				s_Data.CircleVertexBufferPtr->CirclePosition = glm::vec3(static_cast<float>(position.x), static_cast<float>(position.y), static_cast<float>(position.z));
-				s_Data.CircleVertexBufferPtr->Normal = glm::vec3(static_cast <float>(0.0));
-				s_Data.CircleVertexBufferPtr->Color = color;
-				s_Data.CircleVertexBufferPtr->Radius = radius;
-				s_Data.CircleVertexBufferPtr++;
-			}
-
-			s_Data.CircleIndexCount += 6;
+			// The shader spans the quad around the center, radius wide on each side
+			CircleRecord& circle = s_Data.Circles.emplace_back();
+			circle.Center = ToScene(position);
+			circle.Radius = radius;
+			circle.Color = color;
+			circle.aID = id;
+			circle.Origin = (int)s_Data.RecordOrigin;
 
 			//s_Data.Stats.QuadCount++;
 		}
@@ -550,18 +886,12 @@ namespace Graphics {
 		void BatchRenderer::DrawLine(const glm::vec3& from, const glm::vec3& to, const glm::vec4& color, const int id) {
 			assert(s_Data.inScene);
 
-			s_Data.LineVertexBufferPtr->aID = id;
-			s_Data.LineVertexBufferPtr->Position = glm::vec3(from);
-			s_Data.LineVertexBufferPtr->Color = color;
-			s_Data.LineVertexBufferPtr++;
-
-			s_Data.LineVertexBufferPtr->aID = id;
-			s_Data.LineVertexBufferPtr->Position = glm::vec3(to);
-			s_Data.LineVertexBufferPtr->Color = color;
-			s_Data.LineVertexBufferPtr++;
-
-			s_Data.LineVertexCount += 2;
-
+			LineRecord& line = s_Data.Lines.emplace_back();
+			line.From = ToScene(from);
+			line.To = ToScene(to);
+			line.Color = color;
+			line.aID = id;
+			line.Origin = (int)s_Data.RecordOrigin;
 		}
 
 		void BatchRenderer::DrawLine(const glm::vec2& from, const glm::vec2& to, const glm::vec4& color, const int id)
@@ -587,12 +917,12 @@ namespace Graphics {
 		}
 
 		void BatchRenderer::DrawLines(const std::vector<glm::vec3>& points, const std::vector<uint32_t>& indices, const glm::vec4& color, const int id, bool withArrows) {
-			assert((s_Data.inScene));
+			assert((s_Data.inScene) && !s_Data.Retained);
 			int count = 0;
 			float arrowSize = 0.5f;
 			for (size_t i = 0; i < points.size(); i ++) {
 				s_Data.IndexedLineVertexBufferPtr->aID = i;
-				s_Data.IndexedLineVertexBufferPtr->Position = points.at(i);
+				s_Data.IndexedLineVertexBufferPtr->Position = ToScene(points.at(i));
 				s_Data.IndexedLineVertexBufferPtr->Color = color;
 				s_Data.IndexedLineVertexBufferPtr++;
 			}
@@ -610,7 +940,7 @@ namespace Graphics {
 					glm::vec3 arrowBase = points.at(indices[i]) - (direction * 0.15f);
 
 					s_Data.IndexedLineVertexBufferPtr->aID = id;
-					s_Data.IndexedLineVertexBufferPtr->Position = arrowBase + (perpendicular * (0.15f/2.0f));
+					s_Data.IndexedLineVertexBufferPtr->Position = ToScene(arrowBase + (perpendicular * (0.15f/2.0f)));
 					s_Data.IndexedLineVertexBufferPtr->Color = color;
 					s_Data.IndexedLineVertexBufferPtr++;
 
@@ -621,7 +951,7 @@ namespace Graphics {
 					s_Data.IndexedLineIndexBufferPtr++;
 
 					s_Data.IndexedLineVertexBufferPtr->aID = id;
-					s_Data.IndexedLineVertexBufferPtr->Position = arrowBase - (perpendicular * (0.15f / 2.0f));
+					s_Data.IndexedLineVertexBufferPtr->Position = ToScene(arrowBase - (perpendicular * (0.15f / 2.0f)));
 					s_Data.IndexedLineVertexBufferPtr->Color = color;
 					s_Data.IndexedLineVertexBufferPtr++;
 
@@ -638,45 +968,49 @@ namespace Graphics {
 			s_Data.IndexedLineVertexBufferOffset += (points.size() + count);
 		}
 
-		void BatchRenderer::DrawQuad(const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, const glm::vec3& p4, const glm::vec4& color, const int id) {
-			assert(s_Data.inScene);
-			s_Data.TriangleVertexBufferPtr->aID = id;
-			s_Data.TriangleVertexBufferPtr->Position = glm::vec3(p1.x, p1.y, p1.z);
-			s_Data.TriangleVertexBufferPtr->Color = color;
-			s_Data.TriangleVertexBufferPtr++;
-
-			s_Data.TriangleVertexBufferPtr->aID = id;
-			s_Data.TriangleVertexBufferPtr->Position = glm::vec3(p2.x, p2.y, p2.z);
-			s_Data.TriangleVertexBufferPtr->Color = color;
-			s_Data.TriangleVertexBufferPtr++;
+		void BatchRenderer::DrawPolyline(const std::vector<glm::vec3>& points, const glm::vec4& color, const int id, bool closed) {
+			assert(s_Data.inScene && !s_Data.Retained);
+			if (points.size() < 2)
+				return;
 
-			s_Data.TriangleVertexBufferPtr->aID = id;
-			s_Data.TriangleVertexBufferPtr->Position = glm::vec3(p3.x, p3.y, p3.z);
-			s_Data.TriangleVertexBufferPtr->Color = color;
-			s_Data.TriangleVertexBufferPtr++;
+			// Ends the previous strip
+			if (s_Data.PolylineIndexCount) {
+				*s_Data.PolylineIndexBufferPtr = PrimitiveRestartIndex;
+				s_Data.PolylineIndexBufferPtr++;
+				s_Data.PolylineIndexCount++;
+			}
 
-			s_Data.TriangleVertexBufferPtr->aID = id;
-			s_Data.TriangleVertexBufferPtr->Position = glm::vec3(p4.x, p4.y, p4.z);
-			s_Data.TriangleVertexBufferPtr->Color = color;
-			s_Data.TriangleVertexBufferPtr++;
+			for (size_t i = 0; i < points.size(); i++) {
+				s_Data.PolylineVertexBufferPtr->aID = id;
+				s_Data.PolylineVertexBufferPtr->Position = ToScene(points[i]);
+				s_Data.PolylineVertexBufferPtr->Color = color;
+				s_Data.PolylineVertexBufferPtr++;
 
-			*s_Data.TriangleIndexBufferPtr = 0 + s_Data.TriangleVertexBufferOffset;
-			s_Data.TriangleIndexBufferPtr++;
-			*s_Data.TriangleIndexBufferPtr = 1 + s_Data.TriangleVertexBufferOffset;
-			s_Data.TriangleIndexBufferPtr++;
-			*s_Data.TriangleIndexBufferPtr = 2 + s_Data.TriangleVertexBufferOffset;
-			s_Data.TriangleIndexBufferPtr++;
-			*s_Data.TriangleIndexBufferPtr = 2 + s_Data.TriangleVertexBufferOffset;
-			s_Data.TriangleIndexBufferPtr++;
-			*s_Data.TriangleIndexBufferPtr = 3 + s_Data.TriangleVertexBufferOffset;
-			s_Data.TriangleIndexBufferPtr++;
-			*s_Data.TriangleIndexBufferPtr = 0 + s_Data.TriangleVertexBufferOffset;
-			s_Data.TriangleIndexBufferPtr++;
+				*s_Data.PolylineIndexBufferPtr = (uint32_t)i + s_Data.PolylineVertexBufferOffset;
+				s_Data.PolylineIndexBufferPtr++;
+			}
+			s_Data.PolylineIndexCount += (uint32_t)points.size();
 
+			if (closed) {
+				*s_Data.PolylineIndexBufferPtr = s_Data.PolylineVertexBufferOffset;
+				s_Data.PolylineIndexBufferPtr++;
+				s_Data.PolylineIndexCount++;
+			}
 
+			s_Data.PolylineVertexBufferOffset += (uint32_t)points.size();
+		}
 
-			s_Data.TriangleIndexCount += 6;
-			s_Data.TriangleVertexBufferOffset += 4;
+		void BatchRenderer::DrawQuad(const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, const glm::vec3& p4, const glm::vec4& color, const int id) {
+			assert(s_Data.inScene);
+			// Split 0 1 2 / 2 3 0 by the shader
+			QuadRecord& quad = s_Data.Quads.emplace_back();
+			quad.P0 = ToScene(p1);
+			quad.P1 = ToScene(p2);
+			quad.P2 = ToScene(p3);
+			quad.P3 = ToScene(p4);
+			quad.Color = color;
+			quad.aID = id;
+			quad.Origin = (int)s_Data.RecordOrigin;
 		}
 
 		void BatchRenderer::DrawQuad(const glm::vec2& p1, const glm::vec2& p2, const glm::vec2& p3, const glm::vec2& p4, const glm::vec4& color, const int id) {
@@ -722,7 +1056,7 @@ namespace Graphics {
 		//Draws Cap at start point
 		void BatchRenderer::DrawCap(const glm::vec3& start, const glm::vec3& end, float thickness, const glm::vec4& color, const int id) {
 			//Line Caps - params: center point to draw at and two points to the side.
-			assert(s_Data.inScene);
+			assert(s_Data.inScene && !s_Data.Retained);
 
 			glm::vec2 direction = glm::normalize(end - start);
 			glm::vec2 normal = glm::vec2(direction.y, -direction.x);
@@ -732,7 +1066,7 @@ namespace Graphics {
 			float angleIncrement = glm::pi<float>() / static_cast<float>(segments);
 
 			s_Data.TriangleVertexBufferPtr->aID = id;
-			s_Data.TriangleVertexBufferPtr->Position = glm::vec3(start.x, start.y, start.z);
+			s_Data.TriangleVertexBufferPtr->Position = ToScene(start);
 			s_Data.TriangleVertexBufferPtr->Color = color;
 			s_Data.TriangleVertexBufferPtr++;
 
@@ -740,7 +1074,7 @@ namespace Graphics {
 			for (int i = 0; i <= segments; i++) {
 				float angle = angleIncrement * 1 * i;
 				s_Data.TriangleVertexBufferPtr->aID = id;
-				s_Data.TriangleVertexBufferPtr->Position = glm::vec3(glm::vec2(start) - (glm::rotate(normal, angle) * radius),start.z);
+				s_Data.TriangleVertexBufferPtr->Position = ToScene(glm::vec3(glm::vec2(start) - (glm::rotate(normal, angle) * radius),start.z));
 				s_Data.TriangleVertexBufferPtr->Color = color;
 				s_Data.TriangleVertexBufferPtr++;
 
@@ -4,7 +4,11 @@
 #include <glm/ext/vector_float2.hpp>
 #include <glm/ext/vector_float3.hpp>
 #include <glm/ext/vector_float4.hpp>
+#include <glm/ext/vector_double3.hpp>
 #include <Renderer/Framebuffer.h>
+#include <Renderer/StorageBuffer.h>
+#include <Renderer/BufferArena.h>
+#include <Renderer/Camera.h>
 
 
 
@@ -20,20 +24,43 @@ namespace Graphics {
 			uint32_t GetTotalIndexCount() const { return QuadCount * 6; }
 		};
 
+		// Quads, circles and lines recorded once into ranges of the retained record arena, see BatchRenderer::BeginRetained
+		class RetainedBatch {
+		public:
+			~RetainedBatch();
+
+			// GPU bytes of the records
+			uint64_t GetSize() const { return m_Size; }
+		private:
+			friend class BatchRenderer;
+			Graphics::Ref<Graphics::BufferRange> m_Quads, m_Circles, m_Lines;
+			uint32_t m_QuadCount = 0, m_CircleCount = 0, m_LineCount = 0;
+			uint32_t m_Origin = 0;
+			uint64_t m_Size = 0;
+		};
+
 		class BatchRenderer {
 		public:
 			static void Init();
 			static Statistics GetStats();
 			static void ReCreateShaders();
+			// Shaders compile in the background, drawing before this returns true blocks on them
+			static bool IsReady();
 			static void Shutdown();
 
 			static void setRenderMode(int mode);
 
-			static void BeginScene();
+			// depthTest false draws the batch over everything already in the framebuffer (2D viewports). Positions are
+			// uploaded relative to the camera eye, to be drawn with the scene's projViewMatrixRTE.
+			static void BeginScene(bool depthTest = true, const Camera* camera = nullptr);
+			// Camera of the scene being drawn, for callers that pick what to draw from the view. Null outside a scene.
+			static const Camera* GetSceneCamera();
+			static bool GetSceneDepthTest();
 
 			static void setUpdateRequired(bool _state);
 			static bool getUpdateRequired();
 
+			// Kept in double, each call is one mesh whose vertices are uploaded once relative to its bounds center
 			static void addData(const std::vector<double>& vertices, const std::vector<double>& vertexNormals, const std::vector<uint32_t>& indices, const int id = -1);
 
 			static void DrawMesh(const std::vector<double>& vertices, const std::vector<uint32_t>& indices, const glm::vec4& color, const int id = -1);
@@ -52,6 +79,10 @@ namespace Graphics {
 
 			static void DrawLines(const std::vector<glm::vec3>& points, const std::vector<uint32_t>& indices, const glm::vec4& color, const int id = -1, bool withArrows = false);
 
+			// Connected line through points, drawn as one strip: each point is stored once instead of once per
+			// segment end. closed joins the last point back to the first.
+			static void DrawPolyline(const std::vector<glm::vec3>& points, const glm::vec4& color, const int id = -1, bool closed = false);
+
 
 			static void DrawQuad(const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, const glm::vec3& p4, const glm::vec4& color, const int id = -1);
 
@@ -76,6 +107,14 @@ namespace Graphics {
 
 
 
+			// Quads, circles and lines drawn until EndRetained go into a batch of their own instead of the frame's, with
+			// positions given relative to origin. The batch is uploaded once and drawn by DrawRetained every frame
+			// without being submitted again, panning only moves its origin. Between BeginScene and EndScene.
+			static void BeginRetained(const glm::dvec3& origin);
+			static Graphics::Ref<RetainedBatch> EndRetained();
+			// Drawn at once, under the primitives batched for this scene
+			static void DrawRetained(const RetainedBatch& batch);
+
 			static void EndScene();
 			static void Flush();
 		private:
@@ -88,6 +127,7 @@ namespace Graphics {
 			static void NextBatch();
 
 			static void DrawSelected();
+			static void SubmitDraws();
 		};
 
 }
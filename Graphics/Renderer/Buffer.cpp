@@ -31,6 +31,18 @@ namespace Graphics {
 		return nullptr;
 	}
 
+	Ref<VertexBuffer> VertexBuffer::Create(const Ref<BufferRange>& range)
+	{
+		switch (Renderer::GetAPI())
+		{
+			case RendererAPI::API::None:    GRAPHICS_CORE_ASSERT(false, "RendererAPI::None is currently not supported!"); return nullptr;
+			case RendererAPI::API::OpenGL:  return CreateRef<OpenGLVertexBuffer>(range);
+		}
+
+		GRAPHICS_CORE_ASSERT(false, "Unknown RendererAPI!");
+		return nullptr;
+	}
+
 	Ref<IndexBuffer> IndexBuffer::Create(uint32_t* indices, uint32_t size)
 	{
 		switch (Renderer::GetAPI())
@@ -55,5 +67,16 @@ namespace Graphics {
 		return nullptr;
 	}
 
+	Ref<IndexBuffer> IndexBuffer::Create(const Ref<BufferRange>& range, uint32_t count)
+	{
+		switch (Renderer::GetAPI())
+		{
+			case RendererAPI::API::None:    GRAPHICS_CORE_ASSERT(false, "RendererAPI::None is currently not supported!"); return nullptr;
+			case RendererAPI::API::OpenGL:  return CreateRef<OpenGLIndexBuffer>(range, count);
+		}
+
+		GRAPHICS_CORE_ASSERT(false, "Unknown RendererAPI!");
+		return nullptr;
+	}
 
-}
\ No newline at end of file
+}
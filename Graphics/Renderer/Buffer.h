@@ -1,5 +1,6 @@
 #pragma once
 #include "GraphicsCore.h"
+#include "Renderer/BufferArena.h"
 #include <string>
 #include <vector>
 
@@ -120,11 +121,23 @@ namespace Graphics {
 		virtual const BufferLayout& GetLayout() const = 0;
 		virtual void SetLayout(const BufferLayout& layout) = 0;
 
+		// Buffer object and byte offset of the first vertex, non zero offsets only for arena ranges
+		virtual uint32_t GetRendererID() const = 0;
+		virtual uint64_t GetOffset() const = 0;
+
 		static Ref<VertexBuffer> Create(uint32_t size);
 		static Ref<VertexBuffer> Create(float* vertices, uint32_t size);
+		// Vertices live in range, which can share its buffer with other vertex buffers of the same arena
+		static Ref<VertexBuffer> Create(const Ref<BufferRange>& range);
+	};
+
+	enum class IndexType
+	{
+		UInt16 = 0, UInt32
 	};
 
-	// Currently Hazel only supports 32-bit index buffers
+	// Index buffers are sized for 32-bit indices. The index type follows the last SetData, 16-bit indices halve
+	// the upload and the fetch for batches whose vertices all fit below 0xFFFF.
 	class IndexBuffer
 	{
 	public:
@@ -134,12 +147,20 @@ namespace Graphics {
 		virtual void Unbind() const = 0;
 
 		virtual uint32_t GetCount() const = 0;
+		virtual IndexType GetIndexType() const = 0;
+
+		virtual uint32_t GetRendererID() const = 0;
+		virtual uint64_t GetOffset() const = 0;
 
 		static Ref<IndexBuffer> Create(uint32_t* indices, uint32_t count);
 
 		static Ref<IndexBuffer> Create(uint32_t count);
 
+		// count indices in range, which has to hold at least count * sizeof(uint32_t) bytes
+		static Ref<IndexBuffer> Create(const Ref<BufferRange>& range, uint32_t count);
+
 		virtual void SetData(const uint32_t* data, uint32_t count, uint32_t offset = 0) = 0;
+		virtual void SetData(const uint16_t* data, uint32_t count, uint32_t offset = 0) = 0;
 	};
 
 }
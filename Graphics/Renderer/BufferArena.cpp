@@ -0,0 +1,21 @@
+#include "GraphicsCore.h"
+#include "BufferArena.h"
+
+#include "Renderer/Renderer.h"
+#include "Platform/OpenGL/OpenGLBufferArena.h"
+
+namespace Graphics {
+
+	Ref<BufferArena> BufferArena::Create(const BufferArenaSpecification& spec)
+	{
+		switch (Renderer::GetAPI())
+		{
+			case RendererAPI::API::None:    GRAPHICS_CORE_ASSERT(false, "RendererAPI::None is currently not supported!"); return nullptr;
+			case RendererAPI::API::OpenGL:  return CreateRef<OpenGLBufferArena>(spec);
+		}
+
+		GRAPHICS_CORE_ASSERT(false, "Unknown RendererAPI!");
+		return nullptr;
+	}
+
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "GraphicsCore.h"
+#include <cstdint>
+#include <string>
+
+namespace Graphics {
+
+	enum class BufferArenaUsage
+	{
+		Vertex, Index, Uniform, Storage
+	};
+
+	struct BufferArenaSpecification
+	{
+		BufferArenaUsage Usage = BufferArenaUsage::Vertex;
+		// Size of each backing buffer, a larger allocation gets a buffer of its own size
+		uint64_t BlockSize = 64ull * 1024 * 1024;
+		std::string DebugName;
+	};
+
+	struct BufferArenaStatistics
+	{
+		uint32_t BufferCount = 0;
+		uint64_t Capacity = 0;
+		uint64_t UsedBytes = 0;
+		uint64_t FreeBytes = 0;
+		uint64_t LargestFreeBlock = 0;
+		uint32_t AllocationCount = 0;
+		uint32_t FreeBlockCount = 0;
+		// 0 when the free space of every buffer is one block, approaches 1 as it splinters
+		float Fragmentation = 0.0f;
+	};
+
+	// A sub range of one of an arena's buffers, handed back to the arena when the last reference goes away.
+	// Defragment can move it to another buffer and offset, read both again after GetGeneration changed.
+	class BufferRange
+	{
+	public:
+		virtual ~BufferRange() = default;
+
+		virtual uint32_t GetRendererID() const = 0;
+		virtual uint64_t GetOffset() const = 0;
+		virtual uint64_t GetSize() const = 0;
+
+		// offset is relative to the start of the range
+		virtual void SetData(const void* data, uint64_t size, uint64_t offset = 0) = 0;
+		// Binds the range to an indexed binding point, uniform and storage arenas only
+		virtual void Bind(uint32_t binding) const = 0;
+	};
+
+	// Hands out ranges of a few large GPU buffers instead of one buffer object per vertex, index, uniform or
+	// storage buffer. Ranges of the same arena can share a buffer, so draws over them need no rebind and
+	// can be merged with base vertex multi draws.
+	class BufferArena
+	{
+	public:
+		virtual ~BufferArena() = default;
+
+		// alignment 0 uses the usage's default: the offset alignment for uniform and storage ranges, 16 bytes for
+		// vertices and 4 for indices. Pass the vertex stride to address a range with a base vertex.
+		virtual Ref<BufferRange> Allocate(uint64_t size, uint64_t alignment = 0) = 0;
+
+		// Packs every live range into one buffer and releases the rest. Copies on the GPU, bumps the generation.
+		virtual void Defragment() = 0;
+
+		virtual BufferArenaStatistics GetStatistics() const = 0;
+		virtual uint32_t GetGeneration() const = 0;
+		virtual const BufferArenaSpecification& GetSpecification() const = 0;
+
+		static Ref<BufferArena> Create(const BufferArenaSpecification& spec);
+	};
+
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include "GraphicsCore.h"
 #include "Events/Event.h"
 
 namespace Graphics {
@@ -16,6 +17,9 @@ namespace Graphics {
 
 		virtual void OnEvent(Application::Event& event) = 0;
 
+		// Copy of the camera in its current state, for drawing a frame while this one keeps moving
+		virtual Ref<Camera> Clone() const = 0;
+
 		virtual inline void SetViewportSize(float width, float height) = 0;
 
 		const glm::mat4& GetProjection() const { return m_Projection; }
@@ -31,8 +35,12 @@ namespace Graphics {
 
 		virtual double getGridMinorSpacing() const = 0;
 		virtual double getGridMajorSpacing() const = 0;
+		// (world units per pixel, LOD 0 cell size, LOD fade, 0) when the grid LOD is the same over the whole view
+		virtual glm::vec4 getGridLod() const = 0;
 
 		virtual const glm::vec3& GetPosition() const = 0;
+		// The eye in double precision, GetPosition is it rounded to float
+		virtual glm::dvec3 GetEyePosition() const = 0;
 		virtual glm::vec3 GetViewDirection() const = 0;
 
 		virtual void ResetFocalPoint() = 0;
@@ -42,8 +50,26 @@ namespace Graphics {
 		virtual glm::mat4 GetViewMatrix() const = 0;
 		virtual glm::mat4 GetViewProjection() const = 0;
 
+		// View projection of positions given relative to origin. The translation is taken from the double eye, so
+		// with origin near the eye the matrix stays exact however far both are from the world origin.
+		glm::mat4 GetViewProjectionRelativeTo(const glm::dvec3& origin) const
+		{
+			const glm::dmat3 rotation = glm::dmat3(glm::mat3(GetViewMatrix()));
+			glm::dmat4 view = glm::dmat4(rotation);
+			view[3] = glm::dvec4(rotation * (origin - GetEyePosition()), 1.0);
+			return glm::mat4(glm::dmat4(m_Projection) * view);
+		}
+
+		// Set whenever the view or projection changed, whoever derives data from the matrices clears it
+		bool IsDirty() const { return m_Dirty; }
+		void ClearDirty() { m_Dirty = false; }
+
+	protected:
+		void MarkDirty() { m_Dirty = true; }
+
 	protected:
 		glm::mat4 m_Projection = glm::mat4(1.0f);
+		bool m_Dirty = true;
 	};
 
 }
\ No newline at end of file
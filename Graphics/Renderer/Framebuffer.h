@@ -48,6 +48,18 @@ namespace Graphics {
 		bool SwapChainTarget = false;
 	};
 
+	// CPU copy of a color attachment produced by Framebuffer::CaptureAttachmentAsync
+	struct FramebufferCapture
+	{
+		uint32_t Width = 0, Height = 0;
+		uint32_t Channels = 4;
+		uint32_t AttachmentIndex = 0;
+		// 8 bits per channel, tightly packed rows, bottom row first (GL order)
+		std::vector<uint8_t> Pixels;
+	};
+
+	using FramebufferCaptureFn = std::function<void(FramebufferCapture&&)>;
+
 	class Framebuffer
 	{
 	public:
@@ -82,6 +94,12 @@ namespace Graphics {
 		virtual const uint32_t getID() const = 0;
 
 		virtual void BlitBuffers(uint32_t src, uint32_t srcX0, uint32_t srcY0, uint32_t srcX1, uint32_t srcY1, uint32_t dstX0, uint32_t dstY0, uint32_t dstX1, uint32_t dstY1, uint32_t mask, uint16_t filter) = 0;
+
+		// Queues a GPU side copy of an RGBA8 color attachment. The callback is invoked from PollCaptures
+		// once the copy has landed, so the render loop never waits on the readback.
+		virtual void CaptureAttachmentAsync(uint32_t attachmentIndex, const FramebufferCaptureFn& callback) = 0;
+		// Hands finished captures to their callbacks in submission order. Returns the number still in flight.
+		virtual uint32_t PollCaptures(bool wait = false) = 0;
 	};
 
 
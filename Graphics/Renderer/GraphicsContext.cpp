@@ -3,6 +3,7 @@
 
 #include "Renderer/Renderer.h"
 #include "Platform/OpenGL/OpenGLContext.h"
+#include "Platform/OpenGL/OpenGLHeadlessContext.h"
 
 namespace Graphics {
 
@@ -18,4 +19,20 @@ namespace Graphics {
 		return nullptr;
 	}
 
+	Scope<GraphicsContext> GraphicsContext::CreateHeadless()
+	{
+		switch (Renderer::GetAPI())
+		{
+			case RendererAPI::API::None:    GRAPHICS_CORE_ASSERT(false, "RendererAPI::None is currently not supported!"); return nullptr;
+#ifdef GRAPHICS_HEADLESS_EGL
+			case RendererAPI::API::OpenGL:  return CreateScope<OpenGLHeadlessContext>();
+#else
+			case RendererAPI::API::OpenGL:  GRAPHICS_CORE_ASSERT(false, "Headless rendering requires building with GUI_HEADLESS_EGL!"); return nullptr;
+#endif
+		}
+
+		GRAPHICS_CORE_ASSERT(false, "Unknown RendererAPI!");
+		return nullptr;
+	}
+
 }
\ No newline at end of file
@@ -9,8 +9,12 @@ namespace Graphics {
 
 		virtual void Init() = 0;
 		virtual void SwapBuffers() = 0;
+		// A context is current on one thread at a time, release it before making it current on another
+		virtual void MakeCurrent(bool current) = 0;
 
 		static Scope<GraphicsContext> Create(void* window);
+		// Context without a window or display for offscreen rendering, only available with GRAPHICS_HEADLESS_EGL
+		static Scope<GraphicsContext> CreateHeadless();
 	};
 
 }
\ No newline at end of file
@@ -0,0 +1,352 @@
+#include "Renderer/ImageWriter.h"
+#include "Renderer/ThreadPool.h"
+
+#include <Logger.h>
+#include <array>
+#include <fstream>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <exception>
+
+namespace Graphics {
+
+	// Above this many queued frames the disk cannot keep up with the capture rate
+	static const uint32_t s_PendingWriteWarning = 32;
+
+	static std::atomic<uint32_t> s_PendingWrites = 0;
+
+	namespace Utils {
+
+		// Captures are stored bottom row first, files want the top row first
+		static const uint8_t* CaptureRow(const FramebufferCapture& capture, uint32_t y)
+		{
+			const size_t rowSize = (size_t)capture.Width * capture.Channels;
+			return capture.Pixels.data() + (capture.Height - 1 - y) * rowSize;
+		}
+
+		static void PutU32BE(std::vector<uint8_t>& out, uint32_t value)
+		{
+			out.push_back((uint8_t)(value >> 24));
+			out.push_back((uint8_t)(value >> 16));
+			out.push_back((uint8_t)(value >> 8));
+			out.push_back((uint8_t)value);
+		}
+
+		template<typename T>
+		static void PutLE(std::vector<uint8_t>& out, T value)
+		{
+			for (size_t i = 0; i < sizeof(T); i++)
+				out.push_back((uint8_t)((uint64_t)value >> (i * 8)));
+		}
+
+		static void PutFloat(std::vector<uint8_t>& out, float value)
+		{
+			uint32_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			PutLE<uint32_t>(out, bits);
+		}
+
+		static void PutString(std::vector<uint8_t>& out, const char* str)
+		{
+			out.insert(out.end(), str, str + strlen(str) + 1);
+		}
+
+		static uint32_t Crc32(const uint8_t* data, size_t size, uint32_t crc = 0)
+		{
+			static const std::array<uint32_t, 256> s_Table = []() {
+				std::array<uint32_t, 256> table{};
+				for (uint32_t i = 0; i < 256; i++)
+				{
+					uint32_t c = i;
+					for (int k = 0; k < 8; k++)
+						c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+					table[i] = c;
+				}
+				return table;
+			}();
+
+			crc = ~crc;
+			for (size_t i = 0; i < size; i++)
+				crc = s_Table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+			return ~crc;
+		}
+
+		static void PutPngChunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data)
+		{
+			PutU32BE(out, (uint32_t)data.size());
+			const size_t start = out.size();
+			out.insert(out.end(), type, type + 4);
+			out.insert(out.end(), data.begin(), data.end());
+			PutU32BE(out, Crc32(out.data() + start, out.size() - start));
+		}
+
+		// Zlib stream made of stored deflate blocks. Captures are written at frame rate so encode speed
+		// matters more than file size here, run the sequence through an optimiser afterwards if needed.
+		static std::vector<uint8_t> EncodePng(const FramebufferCapture& capture)
+		{
+			const size_t rowSize = (size_t)capture.Width * capture.Channels;
+
+			std::vector<uint8_t> raw;
+			raw.reserve((rowSize + 1) * capture.Height);
+			for (uint32_t y = 0; y < capture.Height; y++)
+			{
+				raw.push_back(0); // Filter: none
+				const uint8_t* row = CaptureRow(capture, y);
+				raw.insert(raw.end(), row, row + rowSize);
+			}
+
+			std::vector<uint8_t> zlib;
+			zlib.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+			zlib.push_back(0x78);
+			zlib.push_back(0x01);
+
+			uint32_t adlerA = 1, adlerB = 0;
+			size_t offset = 0;
+			do
+			{
+				const uint16_t blockSize = (uint16_t)std::min<size_t>(raw.size() - offset, 65535);
+				const bool last = offset + blockSize == raw.size();
+				zlib.push_back(last ? 1 : 0);
+				PutLE<uint16_t>(zlib, blockSize);
+				PutLE<uint16_t>(zlib, (uint16_t)~blockSize);
+				zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + blockSize);
+
+				for (size_t i = offset; i < offset + blockSize; i++)
+				{
+					adlerA = (adlerA + raw[i]) % 65521;
+					adlerB = (adlerB + adlerA) % 65521;
+				}
+				offset += blockSize;
+			} while (offset < raw.size());
+			PutU32BE(zlib, (adlerB << 16) | adlerA);
+
+			std::vector<uint8_t> header;
+			PutU32BE(header, capture.Width);
+			PutU32BE(header, capture.Height);
+			header.push_back(8); // Bit depth
+			header.push_back(capture.Channels == 4 ? 6 : 2); // RGBA : RGB
+			header.push_back(0); // Compression
+			header.push_back(0); // Filter
+			header.push_back(0); // Interlace
+
+			static const uint8_t s_Signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+			std::vector<uint8_t> out(std::begin(s_Signature), std::end(s_Signature));
+			out.reserve(zlib.size() + 64);
+			PutPngChunk(out, "IHDR", header);
+			PutPngChunk(out, "IDAT", zlib);
+			PutPngChunk(out, "IEND", {});
+			return out;
+		}
+
+		static std::vector<uint8_t> EncodePpm(const FramebufferCapture& capture)
+		{
+			const std::string header = "P6\n" + std::to_string(capture.Width) + " " + std::to_string(capture.Height) + "\n255\n";
+
+			std::vector<uint8_t> out(header.begin(), header.end());
+			out.reserve(header.size() + (size_t)capture.Width * capture.Height * 3);
+			for (uint32_t y = 0; y < capture.Height; y++)
+			{
+				const uint8_t* row = CaptureRow(capture, y);
+				for (uint32_t x = 0; x < capture.Width; x++)
+					out.insert(out.end(), row + x * capture.Channels, row + x * capture.Channels + 3);
+			}
+			return out;
+		}
+
+		static uint16_t FloatToHalf(float value)
+		{
+			uint32_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+
+			const uint32_t sign = (bits >> 16) & 0x8000;
+			const int32_t exponent = (int32_t)((bits >> 23) & 0xFF) - 127 + 15;
+			uint32_t mantissa = bits & 0x7FFFFF;
+
+			if (exponent <= 0)
+				return (uint16_t)sign; // Values here are in [0, 1], flush denormals
+			if (exponent >= 31)
+				return (uint16_t)(sign | 0x7C00);
+
+			// Round to nearest
+			mantissa += 0x1000;
+			if (mantissa & 0x800000)
+				return (uint16_t)(sign | ((exponent + 1) << 10));
+			return (uint16_t)(sign | (exponent << 10) | (mantissa >> 13));
+		}
+
+		static std::array<uint16_t, 256> SrgbToLinearHalfTable()
+		{
+			std::array<uint16_t, 256> table{};
+			for (int i = 0; i < 256; i++)
+			{
+				const float c = i / 255.0f;
+				table[i] = FloatToHalf(c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f));
+			}
+			return table;
+		}
+
+		static void PutExrAttribute(std::vector<uint8_t>& out, const char* name, const char* type, const std::vector<uint8_t>& value)
+		{
+			PutString(out, name);
+			PutString(out, type);
+			PutLE<int32_t>(out, (int32_t)value.size());
+			out.insert(out.end(), value.begin(), value.end());
+		}
+
+		// Single part scanline file without compression, one scanline per block
+		static std::vector<uint8_t> EncodeExr(const FramebufferCapture& capture)
+		{
+			static const std::array<uint16_t, 256> s_SrgbToLinear = SrgbToLinearHalfTable();
+
+			// Channels have to be stored in alphabetical order
+			const bool hasAlpha = capture.Channels == 4;
+			const std::vector<std::pair<const char*, uint32_t>> channels = hasAlpha
+				? std::vector<std::pair<const char*, uint32_t>>{ { "A", 3 }, { "B", 2 }, { "G", 1 }, { "R", 0 } }
+				: std::vector<std::pair<const char*, uint32_t>>{ { "B", 2 }, { "G", 1 }, { "R", 0 } };
+
+			std::vector<uint8_t> channelList;
+			for (const auto& [name, index] : channels)
+			{
+				PutString(channelList, name);
+				PutLE<int32_t>(channelList, 1); // HALF
+				PutLE<uint32_t>(channelList, 0); // pLinear + reserved
+				PutLE<int32_t>(channelList, 1); // xSampling
+				PutLE<int32_t>(channelList, 1); // ySampling
+			}
+			channelList.push_back(0);
+
+			std::vector<uint8_t> window;
+			PutLE<int32_t>(window, 0);
+			PutLE<int32_t>(window, 0);
+			PutLE<int32_t>(window, (int32_t)capture.Width - 1);
+			PutLE<int32_t>(window, (int32_t)capture.Height - 1);
+
+			std::vector<uint8_t> one;
+			PutFloat(one, 1.0f);
+
+			std::vector<uint8_t> out;
+			PutLE<uint32_t>(out, 20000630); // Magic
+			PutLE<uint32_t>(out, 2); // Version, single part scanline
+			PutExrAttribute(out, "channels", "chlist", channelList);
+			PutExrAttribute(out, "compression", "compression", { 0 });
+			PutExrAttribute(out, "dataWindow", "box2i", window);
+			PutExrAttribute(out, "displayWindow", "box2i", window);
+			PutExrAttribute(out, "lineOrder", "lineOrder", { 0 });
+			PutExrAttribute(out, "pixelAspectRatio", "float", one);
+			PutExrAttribute(out, "screenWindowCenter", "v2f", std::vector<uint8_t>(8, 0));
+			PutExrAttribute(out, "screenWindowWidth", "float", one);
+			out.push_back(0); // End of header
+
+			const uint32_t lineDataSize = capture.Width * (uint32_t)channels.size() * sizeof(uint16_t);
+			const size_t lineBlockSize = 8 + lineDataSize;
+			const size_t firstBlock = out.size() + (size_t)capture.Height * sizeof(uint64_t);
+
+			out.reserve(firstBlock + lineBlockSize * capture.Height);
+			for (uint32_t y = 0; y < capture.Height; y++)
+				PutLE<uint64_t>(out, firstBlock + y * lineBlockSize);
+
+			for (uint32_t y = 0; y < capture.Height; y++)
+			{
+				PutLE<int32_t>(out, (int32_t)y);
+				PutLE<uint32_t>(out, lineDataSize);
+
+				const uint8_t* row = CaptureRow(capture, y);
+				for (const auto& [name, index] : channels)
+				{
+					for (uint32_t x = 0; x < capture.Width; x++)
+					{
+						const uint8_t value = row[x * capture.Channels + index];
+						// Alpha is already linear
+						PutLE<uint16_t>(out, index == 3 ? FloatToHalf(value / 255.0f) : s_SrgbToLinear[value]);
+					}
+				}
+			}
+			return out;
+		}
+
+	}
+
+	ImageFileFormat ImageWriter::FormatFromPath(const std::filesystem::path& path)
+	{
+		std::string extension = path.extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+
+		if (extension == ".ppm")
+			return ImageFileFormat::PPM;
+		if (extension == ".exr")
+			return ImageFileFormat::EXR;
+		return ImageFileFormat::PNG;
+	}
+
+	bool ImageWriter::Write(const std::filesystem::path& path, const FramebufferCapture& capture)
+	{
+		return Write(path, capture, FormatFromPath(path));
+	}
+
+	bool ImageWriter::Write(const std::filesystem::path& path, const FramebufferCapture& capture, ImageFileFormat format)
+	{
+		if (capture.Width == 0 || capture.Height == 0 || (capture.Channels != 3 && capture.Channels != 4)
+			|| capture.Pixels.size() < (size_t)capture.Width * capture.Height * capture.Channels)
+		{
+			LOG_WARN_STREAM << "Invalid capture, not writing " << path.string();
+			return false;
+		}
+
+		std::vector<uint8_t> encoded;
+		switch (format)
+		{
+			case ImageFileFormat::PNG: encoded = Utils::EncodePng(capture); break;
+			case ImageFileFormat::PPM: encoded = Utils::EncodePpm(capture); break;
+			case ImageFileFormat::EXR: encoded = Utils::EncodeExr(capture); break;
+		}
+
+		if (path.has_parent_path())
+		{
+			std::error_code error;
+			std::filesystem::create_directories(path.parent_path(), error);
+		}
+
+		std::ofstream out(path, std::ios::out | std::ios::binary);
+		if (!out.is_open())
+		{
+			LOG_WARN_STREAM << "Could not open file " << path.string() << " for writing";
+			return false;
+		}
+		out.write((const char*)encoded.data(), encoded.size());
+		return out.good();
+	}
+
+	void ImageWriter::WriteAsync(std::filesystem::path path, FramebufferCapture&& capture)
+	{
+		const uint32_t pending = ++s_PendingWrites;
+		if (pending == s_PendingWriteWarning)
+			LOG_WARN_STREAM << "Image writes are falling behind, " << pending << " captures queued";
+
+		// std::function needs a copyable callable, share the pixels instead of copying them
+		auto shared = CreateRef<FramebufferCapture>(std::move(capture));
+		ThreadPool::Get().Submit([path = std::move(path), shared]() {
+			// Encoders and the filesystem can throw, the write still has to leave the pending count
+			try
+			{
+				Write(path, *shared);
+			}
+			catch (const std::exception& e)
+			{
+				LOG_WARN_STREAM << "Could not write " << path.string() << ": " << e.what();
+			}
+			catch (...)
+			{
+				LOG_WARN_STREAM << "Could not write " << path.string();
+			}
+			s_PendingWrites--;
+		});
+	}
+
+	uint32_t ImageWriter::GetPendingWrites()
+	{
+		return s_PendingWrites;
+	}
+
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "GraphicsCore.h"
+#include "Renderer/Framebuffer.h"
+
+namespace Graphics {
+
+	enum class ImageFileFormat
+	{
+		PNG,
+		PPM,
+		// Uncompressed half float RGBA, colors are converted from sRGB to linear
+		EXR
+	};
+
+	// Encodes framebuffer captures to disk. The encoders are self contained so captures do not pull in an image library.
+	class ImageWriter
+	{
+	public:
+		// Picks the format from the extension, unknown extensions fall back to PNG
+		static ImageFileFormat FormatFromPath(const std::filesystem::path& path);
+
+		static bool Write(const std::filesystem::path& path, const FramebufferCapture& capture);
+		static bool Write(const std::filesystem::path& path, const FramebufferCapture& capture, ImageFileFormat format);
+
+		// Encodes on the shared thread pool, the capture is moved so the caller can keep rendering
+		static void WriteAsync(std::filesystem::path path, FramebufferCapture&& capture);
+
+		// Writes queued by WriteAsync that have not finished yet
+		static uint32_t GetPendingWrites();
+	};
+
+}
@@ -0,0 +1,34 @@
+#include "GraphicsCore.h"
+#include "Renderer/Pipeline.h"
+
+#include "Renderer/Renderer.h"
+#include "Platform/OpenGL/OpenGLPipeline.h"
+
+namespace Graphics {
+
+	void PipelineSpecification::SetTargetFormats(const FramebufferSpecification& framebuffer)
+	{
+		ColorFormats.clear();
+		DepthFormat = FramebufferTextureFormat::None;
+		for (const FramebufferTextureSpecification& attachment : framebuffer.Attachments.Attachments)
+		{
+			if (attachment.TextureFormat == FramebufferTextureFormat::DEPTH24STENCIL8)
+				DepthFormat = attachment.TextureFormat;
+			else
+				ColorFormats.push_back(attachment.TextureFormat);
+		}
+	}
+
+	Ref<Pipeline> Pipeline::Create(const PipelineSpecification& spec)
+	{
+		switch (Renderer::GetAPI())
+		{
+			case RendererAPI::API::None:    GRAPHICS_CORE_ASSERT(false, "RendererAPI::None is currently not supported!"); return nullptr;
+			case RendererAPI::API::OpenGL:  return CreateRef<OpenGLPipeline>(spec);
+		}
+
+		GRAPHICS_CORE_ASSERT(false, "Unknown RendererAPI!");
+		return nullptr;
+	}
+
+}
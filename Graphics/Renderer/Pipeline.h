@@ -0,0 +1,112 @@
+#pragma once
+
+#include "GraphicsCore.h"
+#include "Renderer/Buffer.h"
+#include "Renderer/Framebuffer.h"
+#include "Renderer/Shader.h"
+
+namespace Graphics {
+
+	enum class CompareFunc
+	{
+		Never = 0, Less, Equal, LessEqual, Greater, NotEqual, GreaterEqual, Always
+	};
+
+	enum class BlendFactor
+	{
+		Zero = 0, One, SrcAlpha, OneMinusSrcAlpha, DstAlpha, OneMinusDstAlpha, SrcColor, OneMinusSrcColor, DstColor, OneMinusDstColor
+	};
+
+	enum class StencilOp
+	{
+		Keep = 0, Zero, Replace, Increment, IncrementWrap, Decrement, DecrementWrap, Invert
+	};
+
+	enum class PolygonMode
+	{
+		Fill = 0, Line, Point
+	};
+
+	enum class PrimitiveTopology
+	{
+		Triangles = 0, Lines, Points, LineStrip, TriangleStrip
+	};
+
+	struct DepthState
+	{
+		bool TestEnable = true;
+		bool WriteEnable = true;
+		CompareFunc Func = CompareFunc::LessEqual;
+	};
+
+	struct StencilState
+	{
+		bool Enable = false;
+		uint8_t WriteMask = 0x00;
+		CompareFunc Func = CompareFunc::Always;
+		uint8_t Reference = 0;
+		uint8_t ReadMask = 0xFF;
+		StencilOp StencilFail = StencilOp::Keep;
+		StencilOp DepthFail = StencilOp::Keep;
+		StencilOp Pass = StencilOp::Keep;
+	};
+
+	struct BlendState
+	{
+		bool Enable = true;
+		BlendFactor Src = BlendFactor::SrcAlpha;
+		BlendFactor Dst = BlendFactor::OneMinusSrcAlpha;
+	};
+
+	struct RasterState
+	{
+		PolygonMode Mode = PolygonMode::Fill;
+		float LineWidth = 1.0f;
+	};
+
+	struct PipelineSpecification
+	{
+		Ref<Graphics::Shader> Shader;
+		// Layout the vertex arrays drawn with this pipeline are built from, validated against the shader inputs
+		BufferLayout Layout;
+		PrimitiveTopology Topology = PrimitiveTopology::Triangles;
+		// The largest value of the index type (0xFFFF or 0xFFFFFFFF) ends the current strip and starts a new one,
+		// so many strips go out in one draw
+		bool PrimitiveRestart = false;
+
+		DepthState Depth;
+		StencilState Stencil;
+		BlendState Blend;
+		RasterState Raster;
+
+		// Render target formats, OpenGL does not need them but an explicit API bakes them into the pipeline
+		std::vector<FramebufferTextureFormat> ColorFormats;
+		FramebufferTextureFormat DepthFormat = FramebufferTextureFormat::None;
+
+		// Draws are sorted by layer first, pipelines in a higher layer are drawn after (on top of) lower ones
+		uint32_t Layer = 0;
+		std::string DebugName;
+
+		// Takes the render target formats from the attachments of the framebuffer the pipeline draws into
+		void SetTargetFormats(const FramebufferSpecification& framebuffer);
+	};
+
+	// Immutable bundle of a shader, its vertex layout and all fixed function state for a draw. Everything is
+	// translated once at creation, Bind() only diffs against the current state. Polygon smooth is a window wide
+	// setting (Renderer::PolygonSmooth) and deliberately not part of a pipeline.
+	class Pipeline
+	{
+	public:
+		virtual ~Pipeline() = default;
+
+		virtual void Bind() = 0;
+
+		virtual const PipelineSpecification& GetSpecification() const = 0;
+		// Layer in the high bits, creation order in the low bits. Sorting draws by this groups draws of the same
+		// pipeline together while keeping the layer order.
+		virtual uint64_t GetSortKey() const = 0;
+
+		static Ref<Pipeline> Create(const PipelineSpecification& spec);
+	};
+
+}
@@ -2,6 +2,8 @@
 
 #include "Renderer/RendererAPI.h"
 
+#include <algorithm>
+
 namespace Graphics {
 
 	class RenderCommand
@@ -64,6 +66,11 @@ namespace Graphics {
 			s_RendererAPI->SetStencilOp(sfail, dpfail, dppass);
 		};
 
+		static void Draw(const Pipeline& pipeline, const Ref<VertexArray>& vertexArray, uint32_t count)
+		{
+			s_RendererAPI->Draw(pipeline, vertexArray, count);
+		}
+
 		static void DrawNonIndexed(const Ref<VertexArray>& vertexArray, uint32_t count = 0, uint32_t start = 0)
 		{
 			s_RendererAPI->DrawNonIndexed(vertexArray, count, start);
@@ -97,6 +104,33 @@ namespace Graphics {
 			s_RendererAPI->DrawGridTriangles();
 		}
 
+		static void Dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1)
+		{
+			s_RendererAPI->Dispatch(groupsX, groupsY, groupsZ);
+		}
+
+		// Enough work groups of shader to cover count invocations along x
+		static void DispatchFor(const Ref<Shader>& shader, uint32_t count)
+		{
+			const uint32_t groupSize = std::max(shader->GetWorkGroupSize().x, 1u);
+			s_RendererAPI->Dispatch((count + groupSize - 1) / groupSize);
+		}
+
+		static void DispatchIndirect(const Ref<StorageBuffer>& arguments, uint32_t offset = 0)
+		{
+			s_RendererAPI->DispatchIndirect(arguments, offset);
+		}
+
+		static void MemoryBarrier(BarrierBits barriers)
+		{
+			s_RendererAPI->MemoryBarrier(barriers);
+		}
+
+		static void Finish()
+		{
+			s_RendererAPI->Finish();
+		}
+
 		static void SetLineWidth(float width)
 		{
 			s_RendererAPI->SetLineWidth(width);
@@ -111,6 +145,22 @@ namespace Graphics {
 		{
 			s_RendererAPI->SetRendererModeToDefault();
 		}
+
+		static StateCacheStatistics GetStateCacheStats()
+		{
+			return s_RendererAPI->GetStateCacheStats();
+		}
+
+		static void ResetStateCacheStats()
+		{
+			s_RendererAPI->ResetStateCacheStats();
+		}
+
+		// Must be called after anything outside the renderer (ImGui) has changed GL state
+		static void InvalidateStateCache()
+		{
+			s_RendererAPI->InvalidateStateCache();
+		}
 	private:
 		static Scope<RendererAPI> s_RendererAPI;
 	};
@@ -4,6 +4,7 @@
 namespace Graphics {
 
 	Scope<Renderer::SceneData> Renderer::s_SceneData = CreateScope<Renderer::SceneData>();
+	Scope<ShaderLibrary> Renderer::s_ShaderLibrary = CreateScope<ShaderLibrary>();
 
 	void Renderer::Init()
 	{
@@ -15,6 +16,8 @@ namespace Graphics {
 
 	void Renderer::Shutdown()
 	{
+		// The programs go while the context is still current
+		s_ShaderLibrary->Clear();
 		Renderer2D::Shutdown();
 	}
 
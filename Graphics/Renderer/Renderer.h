@@ -37,6 +37,9 @@ namespace Graphics {
 		static void SetStencilOp(unsigned int sfail, unsigned int dpfail, unsigned int dppass);
 
 		static RendererAPI::API GetAPI() { return RendererAPI::GetAPI(); }
+
+		// Shared by everything that compiles shader files, so one variant is compiled once
+		static ShaderLibrary& GetShaderLibrary() { return *s_ShaderLibrary; }
 	private:
 		struct SceneData
 		{
@@ -44,5 +47,6 @@ namespace Graphics {
 		};
 
 		static Scope<SceneData> s_SceneData;
+		static Scope<ShaderLibrary> s_ShaderLibrary;
 	};
 }
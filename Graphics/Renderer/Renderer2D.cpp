@@ -4,6 +4,7 @@
 #include "Renderer/Shader.h"
 #include "Renderer/UniformBuffer.h"
 #include "Renderer/RenderCommand.h"
+#include "Renderer/TextureArrayAtlas.h"
 
 #include <glm/gtc/matrix_transform.hpp>
 #define GLM_ENABLE_EXPERIMENTAL
@@ -19,7 +20,9 @@ namespace Graphics {
 		glm::vec3 Position;
 		glm::vec4 Color;
 		glm::vec2 TexCoord;
-		float TexIndex;
+		// Where the texture sits in the atlas, layer -1 is untextured
+		glm::vec4 TexRect;
+		float TexLayer;
 		float TilingFactor;
 		
 		// Editor-only
@@ -64,7 +67,6 @@ namespace Graphics {
 		static const uint32_t MaxQuads = 400000;
 		static const uint32_t MaxVertices = MaxQuads * 4;
 		static const uint32_t MaxIndices = MaxQuads * 6;
-		static const uint32_t MaxTextureSlots = 32; // TODO: RenderCaps
 
 		bool updateData = true;
 		int currentRenderMode = 0x1B02; // this is GL_FILL the default opengl polygon mode
@@ -72,7 +74,8 @@ namespace Graphics {
 		Ref<VertexArray> QuadVertexArray;
 		Ref<VertexBuffer> QuadVertexBuffer;
 		Ref<Shader> QuadShader;
-		Ref<Texture2D> WhiteTexture;
+		// Every texture drawn on quads, bound once to slot 0
+		Ref<TextureArrayAtlas> TextureAtlas;
 
 		Ref<VertexArray> TriangleVertexArray;
 		Ref<VertexBuffer> TriangleVertexBuffer;
@@ -104,9 +107,6 @@ namespace Graphics {
 
 		float LineWidth = 2.0f;
 
-		std::array<Ref<Texture2D>, MaxTextureSlots> TextureSlots;
-		uint32_t TextureSlotIndex = 1; // 0 = white texture
-
 		glm::vec4 QuadVertexPositions[4];
 		glm::vec3 TriangleVertexPositions[3];
 
@@ -133,7 +133,8 @@ namespace Graphics {
 			{ ShaderDataType::Float3, "a_Position"     },
 			{ ShaderDataType::Float4, "a_Color"        },
 			{ ShaderDataType::Float2, "a_TexCoord"     },
-			{ ShaderDataType::Float,  "a_TexIndex"     },
+			{ ShaderDataType::Float4, "a_TexRect"      },
+			{ ShaderDataType::Float,  "a_TexLayer"     },
 			{ ShaderDataType::Float,  "a_TilingFactor" },
 			{ ShaderDataType::Int,    "a_EntityID"     }
 		});
@@ -222,13 +223,7 @@ namespace Graphics {
 		s_Data.LineVertexArray->AddVertexBuffer(s_Data.LineVertexBuffer);
 		s_Data.LineVertexBufferBase = new LineVertex[s_Data.MaxVertices];
 
-		//s_Data.WhiteTexture = Texture2D::Create(1, 1);
-		//uint32_t whiteTextureData = 0xffffffff;
-		//s_Data.WhiteTexture->SetData(&whiteTextureData, sizeof(uint32_t));
-
-		//int32_t samplers[s_Data.MaxTextureSlots];
-		//for (uint32_t i = 0; i < s_Data.MaxTextureSlots; i++)
-		//	samplers[i] = i;
+		s_Data.TextureAtlas = TextureArrayAtlas::Create();
 
 		//s_Data.QuadShader = Shader::Create("Resources/Shaders/BasicShader.glsl");
 
@@ -237,9 +232,6 @@ namespace Graphics {
 		s_Data.CircleShader = Shader::Create("resources/Shaders/Renderer2D_Circle.glsl");
 		s_Data.LineShader = Shader::Create("resources/Shaders/Renderer2D_Line.glsl");
 
-		// Set first texture slot to 0
-		s_Data.TextureSlots[0] = s_Data.WhiteTexture;
-
 		s_Data.QuadVertexPositions[0] = { -0.5f, -0.5f, 0.0f, 1.0f };
 		s_Data.QuadVertexPositions[1] = {  0.5f, -0.5f, 0.0f, 1.0f };
 		s_Data.QuadVertexPositions[2] = {  0.5f,  0.5f, 0.0f, 1.0f };
@@ -257,6 +249,7 @@ namespace Graphics {
 
 		delete[] s_Data.QuadVertexBufferBase;
 		delete[] s_Data.TriangleVertexBufferBase;
+		s_Data.TextureAtlas.reset();
 
 	}
 
@@ -319,8 +312,6 @@ namespace Graphics {
 
 		s_Data.LineVertexCount = 0;
 		s_Data.LineVertexBufferPtr = s_Data.LineVertexBufferBase;
-
-		s_Data.TextureSlotIndex = 1;
 	}
 
 	void Renderer2D::Flush()
@@ -330,9 +321,7 @@ namespace Graphics {
 			uint32_t dataSize = (uint32_t)((uint8_t*)s_Data.QuadVertexBufferPtr - (uint8_t*)s_Data.QuadVertexBufferBase);
 			s_Data.QuadVertexBuffer->SetData(s_Data.QuadVertexBufferBase, dataSize);
 
-			// Bind textures
-			for (uint32_t i = 0; i < s_Data.TextureSlotIndex; i++)
-				s_Data.TextureSlots[i]->Bind(i);
+			s_Data.TextureAtlas->Bind(0);
 
 			s_Data.QuadShader->Bind();
 			RenderCommand::DrawIndexed(s_Data.QuadVertexArray, s_Data.QuadIndexCount);
@@ -344,10 +333,6 @@ namespace Graphics {
 			uint32_t dataSize = (uint32_t)((uint8_t*)s_Data.TriangleVertexBufferPtr - (uint8_t*)s_Data.TriangleVertexBufferBase);
 			s_Data.TriangleVertexBuffer->SetData(s_Data.TriangleVertexBufferBase, dataSize);
 
-			// Bind textures
-			for (uint32_t i = 0; i < s_Data.TextureSlotIndex; i++)
-				s_Data.TextureSlots[i]->Bind(i);
-
 			s_Data.TriangleShader->Bind();
 			RenderCommand::DrawIndexed(s_Data.TriangleVertexArray, s_Data.TriangleIndexCount);
 			s_Data.Stats.DrawCalls++;
@@ -444,7 +429,7 @@ namespace Graphics {
 		
 
 		size_t quadVertexCount = 4;
-		const float textureIndex = 0.0f; // White Texture
+		const float textureLayer = -1.0f; // Untextured
 		glm::vec2 textureCoords[] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
 		const float tilingFactor = 1.0f;
 
@@ -456,7 +441,8 @@ namespace Graphics {
 			s_Data.QuadVertexBufferPtr->Position = transform * s_Data.QuadVertexPositions[i];
 			s_Data.QuadVertexBufferPtr->Color = color;
 			s_Data.QuadVertexBufferPtr->TexCoord = textureCoords[i];
-			s_Data.QuadVertexBufferPtr->TexIndex = textureIndex;
+			s_Data.QuadVertexBufferPtr->TexRect = glm::vec4(0.0f);
+			s_Data.QuadVertexBufferPtr->TexLayer = textureLayer;
 			s_Data.QuadVertexBufferPtr->TilingFactor = tilingFactor;
 			s_Data.QuadVertexBufferPtr->EntityID = entityID;
 			s_Data.QuadVertexBufferPtr++;
@@ -477,32 +463,27 @@ namespace Graphics {
 		if (s_Data.QuadIndexCount >= Renderer2DData::MaxIndices)
 			NextBatch();
 
-		float textureIndex = 0.0f;
-		for (uint32_t i = 1; i < s_Data.TextureSlotIndex; i++)
+		// Any number of textures share the atlas, only a full atlas ends the batch: the quads queued so far
+		// reference its current layout, so they are drawn before it is packed again
+		TextureAtlasEntry entry = s_Data.TextureAtlas->Get(texture);
+		if (entry.Status == TextureAtlasStatus::Full)
 		{
-			if (*s_Data.TextureSlots[i] == *texture)
-			{
-				textureIndex = (float)i;
-				break;
-			}
+			NextBatch();
+			s_Data.TextureAtlas->Reset();
+			entry = s_Data.TextureAtlas->Get(texture);
 		}
 
-		if (textureIndex == 0.0f)
-		{
-			if (s_Data.TextureSlotIndex >= Renderer2DData::MaxTextureSlots)
-				NextBatch();
-
-			textureIndex = (float)s_Data.TextureSlotIndex;
-			s_Data.TextureSlots[s_Data.TextureSlotIndex] = texture;
-			s_Data.TextureSlotIndex++;
-		}
+		// Still loading or larger than an atlas layer
+		if (!entry.IsValid())
+			return;
 
 		for (size_t i = 0; i < quadVertexCount; i++)
 		{
 			s_Data.QuadVertexBufferPtr->Position = transform * s_Data.QuadVertexPositions[i];
 			s_Data.QuadVertexBufferPtr->Color = tintColor;
 			s_Data.QuadVertexBufferPtr->TexCoord = textureCoords[i];
-			s_Data.QuadVertexBufferPtr->TexIndex = textureIndex;
+			s_Data.QuadVertexBufferPtr->TexRect = entry.UVRect;
+			s_Data.QuadVertexBufferPtr->TexLayer = entry.Layer;
 			s_Data.QuadVertexBufferPtr->TilingFactor = tilingFactor;
 			s_Data.QuadVertexBufferPtr->EntityID = entityID;
 			s_Data.QuadVertexBufferPtr++;
@@ -1,11 +1,42 @@
 #pragma once
 
 #include "Renderer/VertexArray.h"
+#include "Renderer/Pipeline.h"
+#include "Renderer/StorageBuffer.h"
 
 #include <glm/glm.hpp>
 
+// windows.h defines MemoryBarrier as a macro
+#ifdef MemoryBarrier
+#undef MemoryBarrier
+#endif
+
 namespace Graphics {
 
+	// Which later reads have to see what shaders wrote before the barrier
+	enum class BarrierBits : uint32_t
+	{
+		None              = 0,
+		VertexAttribArray = 1 << 0,
+		ElementArray      = 1 << 1,
+		Uniform           = 1 << 2,
+		TextureFetch      = 1 << 3,
+		ShaderImageAccess = 1 << 4,
+		Command           = 1 << 5, // indirect draw and dispatch arguments
+		BufferUpdate      = 1 << 6, // StorageBuffer::GetData and other buffer reads and copies
+		ShaderStorage     = 1 << 7,
+		All               = 0xFFFFFFFF
+	};
+
+	inline BarrierBits operator|(BarrierBits a, BarrierBits b) { return (BarrierBits)((uint32_t)a | (uint32_t)b); }
+	inline bool operator&(BarrierBits a, BarrierBits b) { return ((uint32_t)a & (uint32_t)b) != 0; }
+
+	struct StateCacheStatistics
+	{
+		uint32_t Issued = 0;
+		uint32_t Elided = 0;
+	};
+
 	class RendererAPI
 	{
 	public:
@@ -30,6 +61,8 @@ namespace Graphics {
 		virtual void SetStencilFunc(unsigned int func, bool ref, uint8_t mask) = 0;
 		virtual void SetStencilOp(unsigned int sfail, unsigned int dpfail, unsigned int dppass) = 0;
 
+		// Draws with the topology of pipeline, which has to be bound already. Indexed when the vertex array has an index buffer.
+		virtual void Draw(const Pipeline& pipeline, const Ref<VertexArray>& vertexArray, uint32_t count) = 0;
 		virtual void DrawNonIndexed(const Ref<VertexArray>& vertexArray, uint32_t count = 0, uint32_t start = 0) = 0;
 		virtual void DrawIndexed(const Ref<VertexArray>& vertexArray, uint32_t indexCount = 0) = 0;
 		virtual void DrawLines(const Ref<VertexArray>& vertexArray, uint32_t vertexCount) = 0;
@@ -37,12 +70,24 @@ namespace Graphics {
 		virtual void DrawLinesInstancedBaseInstance(const Ref<VertexArray>& vertexArray, uint32_t filrst, uint32_t vertexCount, uint32_t instanceCount, uint32_t baseInstance) = 0;
 		virtual void DrawWireFrameCube(const std::vector<glm::dvec3>& cube, const float& thickness) = 0;
 		virtual void DrawGridTriangles() = 0;
+
+		// Runs the bound compute shader over groupsX * groupsY * groupsZ work groups
+		virtual void Dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) = 0;
+		// Group counts are three uints at offset of arguments, usually written by an earlier dispatch
+		virtual void DispatchIndirect(const Ref<StorageBuffer>& arguments, uint32_t offset = 0) = 0;
+		virtual void MemoryBarrier(BarrierBits barriers) = 0;
+		// Blocks until every command issued so far has completed
+		virtual void Finish() = 0;
 		
 		virtual void SetLineWidth(float width) = 0;
 
 		virtual void SetRendererMode(int mode) = 0;
 		virtual void SetRendererModeToDefault() = 0;
 
+		virtual StateCacheStatistics GetStateCacheStats() const = 0;
+		virtual void ResetStateCacheStats() = 0;
+		virtual void InvalidateStateCache() = 0;
+
 		static API GetAPI() { return s_API; }
 		static Scope<RendererAPI> Create();
 	private:
@@ -6,12 +6,77 @@
 
 namespace Graphics {
 
+	ShaderVariant& ShaderVariant::Define(const std::string& name, const std::string& value)
+	{
+		auto it = std::find_if(Defines.begin(), Defines.end(), [&](const auto& define) { return define.first == name; });
+		if (it != Defines.end())
+			it->second = value;
+		else
+			Defines.emplace_back(name, value);
+		return *this;
+	}
+
+	ShaderVariant& ShaderVariant::Constant(uint32_t id, uint32_t value)
+	{
+		auto it = std::find_if(Constants.begin(), Constants.end(), [&](const auto& constant) { return constant.first == id; });
+		if (it != Constants.end())
+			it->second = value;
+		else
+			Constants.emplace_back(id, value);
+		return *this;
+	}
+
+	ShaderVariant& ShaderVariant::Constant(uint32_t id, float value)
+	{
+		// Specialization constants are passed as raw 32 bit words
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		return Constant(id, bits);
+	}
+
+	std::string ShaderVariant::GetKey() const
+	{
+		auto defines = Defines;
+		auto constants = Constants;
+		std::sort(defines.begin(), defines.end());
+		std::sort(constants.begin(), constants.end());
+
+		std::string key;
+		for (const auto& [name, value] : defines)
+			key += "D" + name + "=" + value + ";";
+		for (const auto& [id, value] : constants)
+			key += "C" + std::to_string(id) + "=" + std::to_string(value) + ";";
+		return key;
+	}
+
 	Ref<Shader> Shader::Create(const std::string& filepath, bool cache)
+	{
+		return Create(filepath, ShaderVariant(), cache);
+	}
+
+	Ref<Shader> Shader::Create(const std::string& filepath, const ShaderVariant& variant, bool cache)
 	{
 		switch (Renderer::GetAPI())
 		{
 			case RendererAPI::API::None:    GRAPHICS_CORE_ASSERT(false, "RendererAPI::None is currently not supported!"); return nullptr;
-			case RendererAPI::API::OpenGL:  return CreateRef<OpenGLShader>(filepath, cache);
+			case RendererAPI::API::OpenGL:  return CreateRef<OpenGLShader>(filepath, variant, cache);
+		}
+
+		GRAPHICS_CORE_ASSERT(false, "Unknown RendererAPI!");
+		return nullptr;
+	}
+
+	Ref<Shader> Shader::CreateAsync(const std::string& filepath, bool cache)
+	{
+		return CreateAsync(filepath, ShaderVariant(), cache);
+	}
+
+	Ref<Shader> Shader::CreateAsync(const std::string& filepath, const ShaderVariant& variant, bool cache)
+	{
+		switch (Renderer::GetAPI())
+		{
+			case RendererAPI::API::None:    GRAPHICS_CORE_ASSERT(false, "RendererAPI::None is currently not supported!"); return nullptr;
+			case RendererAPI::API::OpenGL:  return CreateRef<OpenGLShader>(filepath, variant, cache, true);
 		}
 
 		GRAPHICS_CORE_ASSERT(false, "Unknown RendererAPI!");
@@ -62,9 +127,27 @@ namespace Graphics {
 		return m_Shaders[name];
 	}
 
+	Ref<Shader> ShaderLibrary::GetVariant(const std::string& filepath, const ShaderVariant& variant, bool recompile)
+	{
+		const std::string key = filepath + "|" + variant.GetKey();
+		auto it = m_Variants.find(key);
+		if (it != m_Variants.end() && !recompile)
+			return it->second;
+
+		Ref<Shader> shader = Shader::CreateAsync(filepath, variant);
+		m_Variants[key] = shader;
+		return shader;
+	}
+
 	bool ShaderLibrary::Exists(const std::string& name) const
 	{
 		return m_Shaders.find(name) != m_Shaders.end();
 	}
 
+	void ShaderLibrary::Clear()
+	{
+		m_Shaders.clear();
+		m_Variants.clear();
+	}
+
 }
\ No newline at end of file
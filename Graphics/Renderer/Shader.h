@@ -2,12 +2,55 @@
 
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <glm/glm.hpp>
 #include "GraphicsCore.h"
 
 namespace Graphics {
 
+	// Compile time configuration of a shader file. Defines are handed to the GLSL preprocessor, specialization
+	// constants ("layout(constant_id = N) const ...") are fixed when the SPIR-V is specialized, so the driver
+	// folds branches on them away. Every distinct variant is its own program.
+	struct ShaderVariant
+	{
+		std::vector<std::pair<std::string, std::string>> Defines;
+		std::vector<std::pair<uint32_t, uint32_t>> Constants;
+
+		ShaderVariant& Define(const std::string& name, const std::string& value = "1");
+		ShaderVariant& Constant(uint32_t id, uint32_t value);
+		ShaderVariant& Constant(uint32_t id, int32_t value) { return Constant(id, (uint32_t)value); }
+		ShaderVariant& Constant(uint32_t id, float value);
+		ShaderVariant& Constant(uint32_t id, bool value) { return Constant(id, (uint32_t)value); }
+
+		bool IsDefault() const { return Defines.empty() && Constants.empty(); }
+		// Order independent, identical variants always produce the same key
+		std::string GetKey() const;
+	};
+
+	// Uniform name with its hash, computed at compile time for constexpr names. Setters look the hash up in the
+	// location table reflected from the SPIR-V, hoist names used in hot loops into static constexpr variables.
+	struct ShaderUniformName
+	{
+		uint64_t Hash;
+		const char* Name;
+
+		constexpr ShaderUniformName(const char* name) : Hash(HashName(name)), Name(name) {}
+		ShaderUniformName(const std::string& name) : ShaderUniformName(name.c_str()) {}
+
+		// 64 bit FNV-1a
+		static constexpr uint64_t HashName(const char* name)
+		{
+			uint64_t hash = 14695981039346656037ull;
+			for (; *name; name++)
+			{
+				hash ^= (uint8_t)*name;
+				hash *= 1099511628211ull;
+			}
+			return hash;
+		}
+	};
+
 	class Shader
 	{
 	public:
@@ -16,20 +59,46 @@ namespace Graphics {
 		virtual void Bind() const = 0;
 		virtual void Unbind() const = 0;
 
-		virtual void SetInt(const std::string& name, int value) = 0;
-		virtual void SetIntArray(const std::string& name, int* values, uint32_t count) = 0;
-		virtual void SetFloat(const std::string& name, float value) = 0;
-		virtual void SetFloat2(const std::string& name, const glm::vec2& value) = 0;
-		virtual void SetFloat3(const std::string& name, const glm::vec3& value) = 0;
-		virtual void SetFloat4(const std::string& name, const glm::vec4& value) = 0;
-		virtual void SetMat4(const std::string& name, const glm::mat4& value) = 0;
+		// False while an async shader is still compiling or linking, polling also advances the link.
+		// A shader that failed to compile is ready and binds program 0. Bind() on a pending shader blocks.
+		virtual bool IsReady() = 0;
+		virtual void WaitUntilReady() = 0;
+
+		// Recompiles from disk in the background, the current program stays in use until ApplyReload swaps the
+		// new one in. A reload that fails to compile or link is dropped and the current program is kept.
+		virtual void Reload() = 0;
+		virtual bool IsReloading() const = 0;
+		// Call at a frame boundary, returns true when a new program was swapped in
+		virtual bool ApplyReload() = 0;
+
+		virtual void SetInt(const ShaderUniformName& name, int value) = 0;
+		virtual void SetIntArray(const ShaderUniformName& name, int* values, uint32_t count) = 0;
+		virtual void SetFloat(const ShaderUniformName& name, float value) = 0;
+		virtual void SetFloat2(const ShaderUniformName& name, const glm::vec2& value) = 0;
+		virtual void SetFloat3(const ShaderUniformName& name, const glm::vec3& value) = 0;
+		virtual void SetFloat4(const ShaderUniformName& name, const glm::vec4& value) = 0;
+		virtual void SetMat4(const ShaderUniformName& name, const glm::mat4& value) = 0;
 
 		virtual const std::string& GetName() const = 0;
+		// Empty for shaders created from source strings
+		virtual const std::string& GetFilePath() const = 0;
+		// Every header pulled in through #include, only complete once the shader IsReady()
+		virtual const std::vector<std::string>& GetDependencies() const = 0;
 		virtual const uint32_t& GetId() const = 0;
 
 		virtual const uint32_t& GetVertexAttributeLocation(const std::string& name) const = 0;
+		// Every vertex shader input by name, blocks until reflection has run
+		virtual const std::unordered_map<std::string, int>& GetVertexAttributeLocations() const = 0;
+		// local_size_x/y/z of a "#type compute" shader, zero for graphics shaders. Blocks until reflection has run.
+		virtual glm::uvec3 GetWorkGroupSize() const = 0;
+
+		virtual const ShaderVariant& GetVariant() const = 0;
 
 		static Ref<Shader> Create(const std::string& filepath, bool cache = true);
+		static Ref<Shader> Create(const std::string& filepath, const ShaderVariant& variant, bool cache = true);
+		// Returns immediately, GLSL to SPIR-V compilation and reflection run on the shared thread pool
+		static Ref<Shader> CreateAsync(const std::string& filepath, bool cache = true);
+		static Ref<Shader> CreateAsync(const std::string& filepath, const ShaderVariant& variant, bool cache = true);
 		static Ref<Shader> Create(const std::string& name, const std::string& vertexSrc, const std::string& fragmentSrc);
 	};
 
@@ -42,10 +111,15 @@ namespace Graphics {
 		Ref<Shader> Load(const std::string& name, const std::string& filepath);
 
 		Ref<Shader> Get(const std::string& name);
+		// Variants are compiled on first request (in the background) and shared by every later request. recompile
+		// replaces the shared one with a fresh compile from disk, holders of the old one keep it.
+		Ref<Shader> GetVariant(const std::string& filepath, const ShaderVariant& variant = {}, bool recompile = false);
 
 		bool Exists(const std::string& name) const;
+		void Clear();
 	private:
 		std::unordered_map<std::string, Ref<Shader>> m_Shaders;
+		std::unordered_map<std::string, Ref<Shader>> m_Variants;
 	};
 
 }
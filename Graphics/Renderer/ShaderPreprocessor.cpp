@@ -0,0 +1,157 @@
+#include "Renderer/ShaderPreprocessor.h"
+
+#include <Logger.h>
+#include <fstream>
+#include <mutex>
+
+namespace Graphics {
+
+	static const char* s_LineDirectiveExtension = "#extension GL_GOOGLE_cpp_style_line_directive : require\n";
+
+	struct CachedInclude
+	{
+		std::filesystem::file_time_type WriteTime;
+		Ref<const std::string> Contents;
+	};
+
+	static std::mutex s_IncludeCacheMutex;
+	static std::unordered_map<std::string, CachedInclude> s_IncludeCache;
+
+	namespace Utils {
+
+		static Ref<const std::string> LoadInclude(const std::string& path)
+		{
+			std::error_code error;
+			const auto writeTime = std::filesystem::last_write_time(path, error);
+			if (error)
+				return nullptr;
+
+			{
+				std::scoped_lock<std::mutex> lock(s_IncludeCacheMutex);
+				auto it = s_IncludeCache.find(path);
+				if (it != s_IncludeCache.end() && it->second.WriteTime == writeTime)
+					return it->second.Contents;
+			}
+
+			std::ifstream in(path, std::ios::in | std::ios::binary);
+			if (!in)
+				return nullptr;
+			Ref<const std::string> contents = CreateRef<const std::string>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+			LOG_TRACE_STREAM << "Loaded shader include " << path;
+			std::scoped_lock<std::mutex> lock(s_IncludeCacheMutex);
+			s_IncludeCache[path] = { writeTime, contents };
+			return contents;
+		}
+
+		static std::string LineDirective(uint32_t line, const std::string& file)
+		{
+			return "#line " + std::to_string(line) + " \"" + file + "\"\n";
+		}
+
+		static std::string_view Trim(std::string_view text)
+		{
+			const size_t begin = text.find_first_not_of(" \t\r");
+			if (begin == std::string_view::npos)
+				return {};
+			return text.substr(begin, text.find_last_not_of(" \t\r") - begin + 1);
+		}
+
+		// Accepts #include <path> and #include "path", false for every other line
+		static bool ParseInclude(std::string_view line, std::string& path)
+		{
+			line = Trim(line);
+			if (line.substr(0, 8) != "#include")
+				return false;
+
+			line = Trim(line.substr(8));
+			if (line.size() < 2 || (line[0] != '<' && line[0] != '"'))
+				return false;
+
+			const size_t end = line.find(line[0] == '<' ? '>' : '"', 1);
+			if (end == std::string_view::npos)
+				return false;
+
+			path = line.substr(1, end - 1);
+			return true;
+		}
+
+		static void Expand(std::string_view source, const std::string& file, uint32_t firstLine, ShaderPreprocessor::Result& result)
+		{
+			uint32_t line = firstLine;
+			size_t begin = 0;
+			std::string includePath;
+			while (begin < source.size())
+			{
+				size_t end = source.find('\n', begin);
+				if (end == std::string_view::npos)
+					end = source.size();
+				const std::string_view text = source.substr(begin, end - begin);
+				begin = end + 1;
+
+				if (ParseInclude(text, includePath))
+				{
+					// Already pasted into this stage, a blank line keeps the numbering intact
+					if (std::find(result.Dependencies.begin(), result.Dependencies.end(), includePath) != result.Dependencies.end())
+					{
+						result.Source += '\n';
+					}
+					else
+					{
+						result.Dependencies.push_back(includePath);
+						Ref<const std::string> contents = LoadInclude(includePath);
+						if (!contents)
+							throw std::runtime_error(file + ":" + std::to_string(line) + ": could not open include " + includePath);
+
+						result.Source += LineDirective(1, includePath);
+						Expand(*contents, includePath, 1, result);
+						result.Source += LineDirective(line + 1, file);
+					}
+				}
+				else if (Trim(text) == "#pragma once")
+				{
+					result.Source += '\n';
+				}
+				else
+				{
+					result.Source.append(text);
+					result.Source += '\n';
+				}
+				line++;
+			}
+		}
+
+	}
+
+	ShaderPreprocessor::Result ShaderPreprocessor::Process(std::string_view source, const std::string& file, uint32_t firstLine)
+	{
+		Result result;
+		result.Source.reserve(source.size() * 2);
+
+		// #version has to stay in front, the extension and any #line directive can only follow it
+		size_t bodyBegin = 0;
+		uint32_t bodyLine = firstLine;
+		const size_t versionPos = source.find("#version");
+		if (versionPos != std::string_view::npos)
+		{
+			const size_t versionEnd = source.find('\n', versionPos);
+			bodyBegin = versionEnd == std::string_view::npos ? source.size() : versionEnd + 1;
+			bodyLine += (uint32_t)std::count(source.begin(), source.begin() + bodyBegin, '\n');
+			result.Source.append(source.substr(0, bodyBegin));
+			if (versionEnd == std::string_view::npos)
+				result.Source += '\n';
+		}
+
+		result.Source += s_LineDirectiveExtension;
+		result.Source += Utils::LineDirective(bodyLine, file);
+		Utils::Expand(source.substr(bodyBegin), file, bodyLine, result);
+		return result;
+	}
+
+	void ShaderPreprocessor::ClearCache()
+	{
+		std::scoped_lock<std::mutex> lock(s_IncludeCacheMutex);
+		s_IncludeCache.clear();
+	}
+
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "GraphicsCore.h"
+
+#include <string_view>
+
+namespace Graphics {
+
+	// Expands #include <path> and #include "path" in a single pass over the source. Every header is pasted at most
+	// once per stage (#pragma once semantics whether or not the header says so). Headers are read from disk once
+	// and served from memory until their write time changes. #line directives (GL_GOOGLE_cpp_style_line_directive)
+	// keep compiler messages pointing at the right file and line. Thread safe, compile jobs call this concurrently.
+	class ShaderPreprocessor
+	{
+	public:
+		struct Result
+		{
+			std::string Source;
+			// Every header pulled in, in include order
+			std::vector<std::string> Dependencies;
+		};
+
+		// source is one stage of file starting at firstLine. Throws std::runtime_error for headers that can not be read.
+		static Result Process(std::string_view source, const std::string& file, uint32_t firstLine = 1);
+
+		static void ClearCache();
+	};
+
+}
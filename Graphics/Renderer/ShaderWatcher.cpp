@@ -0,0 +1,211 @@
+#include "Renderer/ShaderWatcher.h"
+
+#include <Logger.h>
+#include <chrono>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace Graphics {
+
+	// Editors save in several steps (truncate, write, rename), wait for the directory to go quiet
+	static const std::chrono::milliseconds s_SettleTime(100);
+	// Without inotify the directory is scanned for new write times at this interval
+	static const std::chrono::milliseconds s_ScanInterval(500);
+
+	struct ShaderWatcherData
+	{
+		bool Initialized = false;
+		std::filesystem::path Directory;
+		std::vector<std::weak_ptr<Shader>> Shaders;
+
+		std::vector<std::filesystem::path> ChangedFiles;
+		std::chrono::steady_clock::time_point LastChange;
+
+		int NotifyHandle = -1;
+		std::unordered_map<std::string, std::filesystem::file_time_type> WriteTimes;
+		std::chrono::steady_clock::time_point LastScan;
+	};
+
+	static ShaderWatcherData s_Data;
+
+	namespace Utils {
+
+		// Shaders and includes are referenced with relative paths ("./Resources/...", "Resources/..."), events
+		// carry directory relative names. Compare absolute paths, the file may be gone mid save.
+		static std::filesystem::path NormalizePath(const std::filesystem::path& path)
+		{
+			std::error_code error;
+			std::filesystem::path normalized = std::filesystem::weakly_canonical(path, error);
+			return error ? path.lexically_normal() : normalized;
+		}
+
+		static void AddChange(const std::filesystem::path& path)
+		{
+			std::filesystem::path normalized = NormalizePath(path);
+			if (std::find(s_Data.ChangedFiles.begin(), s_Data.ChangedFiles.end(), normalized) == s_Data.ChangedFiles.end())
+				s_Data.ChangedFiles.push_back(std::move(normalized));
+			s_Data.LastChange = std::chrono::steady_clock::now();
+		}
+
+		static void ScanWriteTimes(bool reportChanges)
+		{
+			std::error_code error;
+			for (const auto& entry : std::filesystem::directory_iterator(s_Data.Directory, error))
+			{
+				if (!entry.is_regular_file(error))
+					continue;
+
+				const auto writeTime = entry.last_write_time(error);
+				if (error)
+					continue;
+
+				auto [it, inserted] = s_Data.WriteTimes.try_emplace(entry.path().string(), writeTime);
+				if (!inserted && it->second != writeTime)
+				{
+					it->second = writeTime;
+					if (reportChanges)
+						AddChange(entry.path());
+				}
+				else if (inserted && reportChanges)
+				{
+					AddChange(entry.path());
+				}
+			}
+		}
+
+		static void CollectChanges()
+		{
+#ifdef __linux__
+			if (s_Data.NotifyHandle >= 0)
+			{
+				alignas(inotify_event) char buffer[4096];
+				ssize_t length;
+				while ((length = read(s_Data.NotifyHandle, buffer, sizeof(buffer))) > 0)
+				{
+					for (const char* it = buffer; it < buffer + length;)
+					{
+						const inotify_event* event = (const inotify_event*)it;
+						if (event->len > 0)
+							AddChange(s_Data.Directory / event->name);
+						it += sizeof(inotify_event) + event->len;
+					}
+				}
+				return;
+			}
+#endif
+			const auto now = std::chrono::steady_clock::now();
+			if (now - s_Data.LastScan < s_ScanInterval)
+				return;
+			s_Data.LastScan = now;
+			ScanWriteTimes(true);
+		}
+
+		static bool IsAffected(Shader& shader, const std::vector<std::filesystem::path>& changedFiles)
+		{
+			if (shader.GetFilePath().empty())
+				return false;
+
+			auto changed = [&](const std::string& file) {
+				return std::find(changedFiles.begin(), changedFiles.end(), NormalizePath(file)) != changedFiles.end();
+			};
+			if (changed(shader.GetFilePath()))
+				return true;
+
+			// The dependency list is written by the compile job, a shader still compiling only reacts to its own file
+			if (!shader.IsReady())
+				return false;
+
+			const auto& dependencies = shader.GetDependencies();
+			return std::any_of(dependencies.begin(), dependencies.end(), changed);
+		}
+
+	}
+
+	void ShaderWatcher::Init(const std::filesystem::path& directory)
+	{
+		s_Data.Directory = Utils::NormalizePath(directory);
+		if (!std::filesystem::is_directory(s_Data.Directory))
+		{
+			LOG_WARN_STREAM << "Shader hot reload disabled, " << s_Data.Directory << " is not a directory";
+			return;
+		}
+
+#ifdef __linux__
+		s_Data.NotifyHandle = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (s_Data.NotifyHandle >= 0 && inotify_add_watch(s_Data.NotifyHandle, s_Data.Directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0)
+		{
+			close(s_Data.NotifyHandle);
+			s_Data.NotifyHandle = -1;
+		}
+		if (s_Data.NotifyHandle < 0)
+			LOG_WARN_STREAM << "inotify unavailable, polling " << s_Data.Directory << " for shader changes";
+#endif
+		if (s_Data.NotifyHandle < 0)
+			Utils::ScanWriteTimes(false);
+
+		s_Data.Initialized = true;
+		LOG_DEBUG_STREAM << "Watching " << s_Data.Directory << " for shader changes";
+	}
+
+	void ShaderWatcher::Shutdown()
+	{
+#ifdef __linux__
+		if (s_Data.NotifyHandle >= 0)
+			close(s_Data.NotifyHandle);
+#endif
+		s_Data = ShaderWatcherData();
+	}
+
+	void ShaderWatcher::Watch(const Ref<Shader>& shader)
+	{
+		if (std::none_of(s_Data.Shaders.begin(), s_Data.Shaders.end(), [&](const std::weak_ptr<Shader>& watched) { return watched.lock() == shader; }))
+			s_Data.Shaders.push_back(shader);
+	}
+
+	bool ShaderWatcher::Poll()
+	{
+		if (!s_Data.Initialized)
+			return false;
+
+		std::erase_if(s_Data.Shaders, [](const std::weak_ptr<Shader>& watched) { return watched.expired(); });
+
+		Utils::CollectChanges();
+		if (!s_Data.ChangedFiles.empty() && std::chrono::steady_clock::now() - s_Data.LastChange >= s_SettleTime)
+		{
+			for (const std::filesystem::path& file : s_Data.ChangedFiles)
+				LOG_DEBUG_STREAM << "Shader source changed " << file;
+
+			for (const std::weak_ptr<Shader>& watched : s_Data.Shaders)
+			{
+				Ref<Shader> shader = watched.lock();
+				if (Utils::IsAffected(*shader, s_Data.ChangedFiles))
+					shader->Reload();
+			}
+			s_Data.ChangedFiles.clear();
+		}
+
+		bool replaced = false;
+		for (const std::weak_ptr<Shader>& watched : s_Data.Shaders)
+		{
+			Ref<Shader> shader = watched.lock();
+			if (shader->IsReloading())
+				replaced |= shader->ApplyReload();
+		}
+		return replaced;
+	}
+
+	bool ShaderWatcher::IsReloadPending()
+	{
+		if (!s_Data.ChangedFiles.empty())
+			return true;
+
+		return std::any_of(s_Data.Shaders.begin(), s_Data.Shaders.end(), [](const std::weak_ptr<Shader>& watched) {
+			Ref<Shader> shader = watched.lock();
+			return shader && shader->IsReloading();
+		});
+	}
+
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "GraphicsCore.h"
+#include "Renderer/Shader.h"
+
+namespace Graphics {
+
+	// Hot reload for shaders loaded from disk. Watches the shader directory (inotify on Linux, write time polling
+	// elsewhere) and only reloads the programs whose source or one of its #include dependencies changed.
+	// Reloads compile on the thread pool, Poll() swaps them in at the frame boundary it is called from.
+	class ShaderWatcher
+	{
+	public:
+		static void Init(const std::filesystem::path& directory);
+		static void Shutdown();
+
+		// Watched shaders are held weakly, recreated shaders just have to be watched again
+		static void Watch(const Ref<Shader>& shader);
+
+		// Returns true when any program was replaced, the caller has to redraw
+		static bool Poll();
+		// Changes waiting to settle or reloads still compiling, keep polling while true
+		static bool IsReloadPending();
+	};
+
+}
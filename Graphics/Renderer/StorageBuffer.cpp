@@ -0,0 +1,21 @@
+#include "GraphicsCore.h"
+#include "StorageBuffer.h"
+
+#include "Renderer/Renderer.h"
+#include "Platform/OpenGL/OpenGLStorageBuffer.h"
+
+namespace Graphics {
+
+	Ref<StorageBuffer> StorageBuffer::Create(uint32_t size, uint32_t binding)
+	{
+		switch (Renderer::GetAPI())
+		{
+			case RendererAPI::API::None:    GRAPHICS_CORE_ASSERT(false, "RendererAPI::None is currently not supported!"); return nullptr;
+			case RendererAPI::API::OpenGL:  return CreateRef<OpenGLStorageBuffer>(size, binding);
+		}
+
+		GRAPHICS_CORE_ASSERT(false, "Unknown RendererAPI!");
+		return nullptr;
+	}
+
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "GraphicsCore.h"
+#include <cstdint>
+
+namespace Graphics {
+
+	// Shader storage buffer, read and written by shaders through a "buffer" block at its binding point. Also the
+	// argument buffer for RenderCommand::DispatchIndirect. Writes from compute shaders are only visible to later
+	// commands after a RenderCommand::MemoryBarrier with the matching bits.
+	class StorageBuffer
+	{
+	public:
+		virtual ~StorageBuffer() {}
+		virtual void SetData(const void* data, uint32_t size, uint32_t offset = 0) = 0;
+		// Stalls until the GPU has finished writing the buffer, keep it to small results (picking, counters)
+		virtual void GetData(void* data, uint32_t size, uint32_t offset = 0) const = 0;
+		// Zero fills the buffer on the GPU, resets counters without an upload
+		virtual void Clear() = 0;
+
+		// Rebinds to binding, the binding given to Create is bound on creation
+		virtual void Bind(uint32_t binding) const = 0;
+
+		virtual uint32_t GetSize() const = 0;
+		virtual uint32_t GetRendererID() const = 0;
+
+		static Ref<StorageBuffer> Create(uint32_t size, uint32_t binding);
+	};
+
+}
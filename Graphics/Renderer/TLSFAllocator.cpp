@@ -0,0 +1,279 @@
+#include "GraphicsCore.h"
+#include "Renderer/TLSFAllocator.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace Graphics {
+
+	namespace Utils {
+
+		static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+		{
+			return (value + alignment - 1) / alignment * alignment;
+		}
+
+		static uint32_t HighestBit(uint64_t value)
+		{
+			return 63 - (uint32_t)std::countl_zero(value);
+		}
+
+	}
+
+	TLSFAllocator::TLSFAllocator(uint64_t capacity)
+	{
+		Reset(capacity);
+	}
+
+	void TLSFAllocator::Reset(uint64_t capacity)
+	{
+		m_Capacity = capacity;
+		m_Blocks.clear();
+		m_UnusedNodes.clear();
+		m_FirstLevelBitmap = 0;
+		m_SecondLevelBitmaps.fill(0);
+		for (auto& lists : m_FreeLists)
+			lists.fill(InvalidNode);
+		m_UsedBytes = 0;
+		m_AllocationCount = 0;
+		m_FreeBlockCount = 0;
+
+		if (capacity == 0)
+			return;
+
+		const uint32_t node = CreateNode();
+		m_Blocks[node].Offset = 0;
+		m_Blocks[node].Size = capacity;
+		InsertFree(node);
+	}
+
+	void TLSFAllocator::Mapping(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel)
+	{
+		// Sizes below SecondLevelCount get one exact class each, above that every power of two range is split
+		// into SecondLevelCount linear classes
+		if (size < SecondLevelCount)
+		{
+			firstLevel = 0;
+			secondLevel = (uint32_t)size;
+			return;
+		}
+
+		const uint32_t bit = Utils::HighestBit(size);
+		firstLevel = bit - SecondLevelLog2 + 1;
+		secondLevel = (uint32_t)(size >> (bit - SecondLevelLog2)) - SecondLevelCount;
+	}
+
+	uint32_t TLSFAllocator::CreateNode()
+	{
+		if (!m_UnusedNodes.empty())
+		{
+			const uint32_t node = m_UnusedNodes.back();
+			m_UnusedNodes.pop_back();
+			m_Blocks[node] = Block();
+			return node;
+		}
+
+		m_Blocks.emplace_back();
+		return (uint32_t)m_Blocks.size() - 1;
+	}
+
+	void TLSFAllocator::ReleaseNode(uint32_t node)
+	{
+		m_UnusedNodes.push_back(node);
+	}
+
+	void TLSFAllocator::InsertFree(uint32_t node)
+	{
+		uint32_t firstLevel, secondLevel;
+		Mapping(m_Blocks[node].Size, firstLevel, secondLevel);
+
+		uint32_t& head = m_FreeLists[firstLevel][secondLevel];
+		Block& block = m_Blocks[node];
+		block.Free = true;
+		block.PrevFree = InvalidNode;
+		block.NextFree = head;
+		if (head != InvalidNode)
+			m_Blocks[head].PrevFree = node;
+		head = node;
+
+		m_FirstLevelBitmap |= 1ull << firstLevel;
+		m_SecondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+		m_FreeBlockCount++;
+	}
+
+	void TLSFAllocator::RemoveFree(uint32_t node)
+	{
+		uint32_t firstLevel, secondLevel;
+		Mapping(m_Blocks[node].Size, firstLevel, secondLevel);
+
+		Block& block = m_Blocks[node];
+		if (block.PrevFree != InvalidNode)
+			m_Blocks[block.PrevFree].NextFree = block.NextFree;
+		if (block.NextFree != InvalidNode)
+			m_Blocks[block.NextFree].PrevFree = block.PrevFree;
+
+		uint32_t& head = m_FreeLists[firstLevel][secondLevel];
+		if (head == node)
+		{
+			head = block.NextFree;
+			if (head == InvalidNode)
+			{
+				m_SecondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+				if (!m_SecondLevelBitmaps[firstLevel])
+					m_FirstLevelBitmap &= ~(1ull << firstLevel);
+			}
+		}
+
+		block.Free = false;
+		block.PrevFree = block.NextFree = InvalidNode;
+		m_FreeBlockCount--;
+	}
+
+	uint32_t TLSFAllocator::FindFree(uint64_t size) const
+	{
+		// Round up to the next class boundary so that any block in the class found is large enough
+		if (size >= SecondLevelCount)
+			size += (1ull << (Utils::HighestBit(size) - SecondLevelLog2)) - 1;
+
+		uint32_t firstLevel, secondLevel;
+		Mapping(size, firstLevel, secondLevel);
+		if (firstLevel >= FirstLevelCount)
+			return InvalidNode;
+
+		uint32_t secondLevelMap = m_SecondLevelBitmaps[firstLevel] & (~0u << secondLevel);
+		if (!secondLevelMap)
+		{
+			const uint64_t firstLevelMap = firstLevel + 1 < FirstLevelCount ? m_FirstLevelBitmap & (~0ull << (firstLevel + 1)) : 0;
+			if (!firstLevelMap)
+				return InvalidNode;
+
+			firstLevel = (uint32_t)std::countr_zero(firstLevelMap);
+			secondLevelMap = m_SecondLevelBitmaps[firstLevel];
+		}
+
+		secondLevel = (uint32_t)std::countr_zero(secondLevelMap);
+		return m_FreeLists[firstLevel][secondLevel];
+	}
+
+	void TLSFAllocator::SplitTail(uint32_t node, uint64_t size)
+	{
+		const uint32_t tail = CreateNode();
+		Block& block = m_Blocks[node];
+		Block& remainder = m_Blocks[tail];
+
+		remainder.Offset = block.Offset + size;
+		remainder.Size = block.Size - size;
+		remainder.PrevPhysical = node;
+		remainder.NextPhysical = block.NextPhysical;
+		if (block.NextPhysical != InvalidNode)
+			m_Blocks[block.NextPhysical].PrevPhysical = tail;
+		block.NextPhysical = tail;
+		block.Size = size;
+
+		InsertFree(tail);
+	}
+
+	TLSFAllocator::Allocation TLSFAllocator::Allocate(uint64_t size, uint64_t alignment)
+	{
+		if (size == 0)
+			size = 1;
+		if (alignment == 0)
+			alignment = 1;
+
+		// Worst case the block starts one byte past an aligned offset
+		const uint32_t node = FindFree(size + alignment - 1);
+		if (node == InvalidNode)
+			return {};
+		RemoveFree(node);
+
+		const uint64_t padding = Utils::AlignUp(m_Blocks[node].Offset, alignment) - m_Blocks[node].Offset;
+		if (padding)
+		{
+			// The padding goes back as a free block of its own. The block in front of a free block is never free
+			// (they would have merged), so the padding has no free neighbour to merge with.
+			const uint32_t front = CreateNode();
+			Block& block = m_Blocks[node];
+			Block& pad = m_Blocks[front];
+			pad.Offset = block.Offset;
+			pad.Size = padding;
+			pad.PrevPhysical = block.PrevPhysical;
+			pad.NextPhysical = node;
+			if (block.PrevPhysical != InvalidNode)
+				m_Blocks[block.PrevPhysical].NextPhysical = front;
+			block.PrevPhysical = front;
+			block.Offset += padding;
+			block.Size -= padding;
+			InsertFree(front);
+		}
+
+		if (m_Blocks[node].Size > size)
+			SplitTail(node, size);
+
+		m_UsedBytes += size;
+		m_AllocationCount++;
+
+		Allocation allocation;
+		allocation.Offset = m_Blocks[node].Offset;
+		allocation.Size = size;
+		allocation.Node = node;
+		return allocation;
+	}
+
+	void TLSFAllocator::Free(const Allocation& allocation)
+	{
+		if (!allocation.IsValid())
+			return;
+
+		uint32_t node = allocation.Node;
+		GRAPHICS_CORE_ASSERT(node < m_Blocks.size() && !m_Blocks[node].Free, "Freeing a TLSF block twice!");
+
+		m_UsedBytes -= m_Blocks[node].Size;
+		m_AllocationCount--;
+
+		const uint32_t prev = m_Blocks[node].PrevPhysical;
+		if (prev != InvalidNode && m_Blocks[prev].Free)
+		{
+			RemoveFree(prev);
+			m_Blocks[prev].Size += m_Blocks[node].Size;
+			m_Blocks[prev].NextPhysical = m_Blocks[node].NextPhysical;
+			if (m_Blocks[node].NextPhysical != InvalidNode)
+				m_Blocks[m_Blocks[node].NextPhysical].PrevPhysical = prev;
+			ReleaseNode(node);
+			node = prev;
+		}
+
+		const uint32_t next = m_Blocks[node].NextPhysical;
+		if (next != InvalidNode && m_Blocks[next].Free)
+		{
+			RemoveFree(next);
+			m_Blocks[node].Size += m_Blocks[next].Size;
+			m_Blocks[node].NextPhysical = m_Blocks[next].NextPhysical;
+			if (m_Blocks[next].NextPhysical != InvalidNode)
+				m_Blocks[m_Blocks[next].NextPhysical].PrevPhysical = node;
+			ReleaseNode(next);
+		}
+
+		InsertFree(node);
+	}
+
+	TLSFAllocator::Statistics TLSFAllocator::GetStatistics() const
+	{
+		Statistics stats;
+		stats.Capacity = m_Capacity;
+		stats.UsedBytes = m_UsedBytes;
+		stats.FreeBytes = m_Capacity - m_UsedBytes;
+		stats.AllocationCount = m_AllocationCount;
+		stats.FreeBlockCount = m_FreeBlockCount;
+
+		// The largest block sits in the highest non empty class, that class still spans a range of sizes
+		if (m_FirstLevelBitmap)
+		{
+			const uint32_t firstLevel = Utils::HighestBit(m_FirstLevelBitmap);
+			const uint32_t secondLevel = 31 - (uint32_t)std::countl_zero(m_SecondLevelBitmaps[firstLevel]);
+			for (uint32_t node = m_FreeLists[firstLevel][secondLevel]; node != InvalidNode; node = m_Blocks[node].NextFree)
+				stats.LargestFreeBlock = std::max(stats.LargestFreeBlock, m_Blocks[node].Size);
+		}
+		return stats;
+	}
+
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace Graphics {
+
+	// Two level segregated fit allocator over an abstract [0, capacity) range, it never touches the memory it
+	// manages. Allocation and free are O(1): free blocks sit in size class lists found through two bitmaps,
+	// freed blocks merge with free neighbours right away.
+	class TLSFAllocator
+	{
+	public:
+		static constexpr uint32_t InvalidNode = UINT32_MAX;
+
+		struct Allocation
+		{
+			uint64_t Offset = 0;
+			uint64_t Size = 0;
+			uint32_t Node = InvalidNode;
+
+			bool IsValid() const { return Node != InvalidNode; }
+		};
+
+		struct Statistics
+		{
+			uint64_t Capacity = 0;
+			uint64_t UsedBytes = 0;
+			uint64_t FreeBytes = 0;
+			uint64_t LargestFreeBlock = 0;
+			uint32_t AllocationCount = 0;
+			uint32_t FreeBlockCount = 0;
+
+			// 0 when all free space is one block, approaches 1 as it splinters
+			float GetFragmentation() const { return FreeBytes ? 1.0f - (float)((double)LargestFreeBlock / (double)FreeBytes) : 0.0f; }
+		};
+
+	public:
+		TLSFAllocator(uint64_t capacity = 0);
+
+		// alignment does not have to be a power of two (vertex strides). Returns an invalid allocation when no
+		// free block is large enough.
+		Allocation Allocate(uint64_t size, uint64_t alignment = 1);
+		void Free(const Allocation& allocation);
+		// Forgets every allocation
+		void Reset(uint64_t capacity);
+
+		uint64_t GetCapacity() const { return m_Capacity; }
+		Statistics GetStatistics() const;
+	private:
+		static constexpr uint32_t SecondLevelLog2 = 4;
+		static constexpr uint32_t SecondLevelCount = 1 << SecondLevelLog2;
+		static constexpr uint32_t FirstLevelCount = 64 - SecondLevelLog2 + 1;
+
+		struct Block
+		{
+			uint64_t Offset = 0;
+			uint64_t Size = 0;
+			uint32_t PrevPhysical = InvalidNode, NextPhysical = InvalidNode;
+			uint32_t PrevFree = InvalidNode, NextFree = InvalidNode;
+			bool Free = false;
+		};
+
+		static void Mapping(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel);
+
+		uint32_t CreateNode();
+		void ReleaseNode(uint32_t node);
+		void InsertFree(uint32_t node);
+		void RemoveFree(uint32_t node);
+		uint32_t FindFree(uint64_t size) const;
+		// Splits size bytes off the front of node, the remainder becomes a new free block
+		void SplitTail(uint32_t node, uint64_t size);
+	private:
+		uint64_t m_Capacity = 0;
+		std::vector<Block> m_Blocks;
+		std::vector<uint32_t> m_UnusedNodes;
+
+		uint64_t m_FirstLevelBitmap = 0;
+		std::array<uint32_t, FirstLevelCount> m_SecondLevelBitmaps = {};
+		std::array<std::array<uint32_t, SecondLevelCount>, FirstLevelCount> m_FreeLists;
+
+		uint64_t m_UsedBytes = 0;
+		uint32_t m_AllocationCount = 0;
+		uint32_t m_FreeBlockCount = 0;
+	};
+
+}
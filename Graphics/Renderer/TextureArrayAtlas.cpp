@@ -0,0 +1,21 @@
+#include "GraphicsCore.h"
+#include "TextureArrayAtlas.h"
+
+#include "Renderer/Renderer.h"
+#include "Platform/OpenGL/OpenGLTextureArrayAtlas.h"
+
+namespace Graphics {
+
+	Ref<TextureArrayAtlas> TextureArrayAtlas::Create(const TextureArrayAtlasSpecification& spec)
+	{
+		switch (Renderer::GetAPI())
+		{
+			case RendererAPI::API::None:    GRAPHICS_CORE_ASSERT(false, "RendererAPI::None is currently not supported!"); return nullptr;
+			case RendererAPI::API::OpenGL:  return CreateRef<OpenGLTextureArrayAtlas>(spec);
+		}
+
+		GRAPHICS_CORE_ASSERT(false, "Unknown RendererAPI!");
+		return nullptr;
+	}
+
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "GraphicsCore.h"
+#include "Renderer/Texture.h"
+
+#include <glm/ext/vector_float4.hpp>
+#include <cstdint>
+
+namespace Graphics {
+
+	struct TextureArrayAtlasSpecification
+	{
+		// Width and height of every layer, textures larger than this are not packed
+		uint32_t LayerSize = 2048;
+		// The array starts with one layer and doubles up to this, clamped to what the driver supports
+		uint32_t MaxLayers = 16;
+		// Empty texels around each texture
+		uint32_t Padding = 1;
+	};
+
+	enum class TextureAtlasStatus
+	{
+		Packed,
+		// Not uploaded yet (TextureManager placeholder), ask again next frame
+		Loading,
+		TooLarge,
+		// Every layer is in use, Reset and pack again
+		Full
+	};
+
+	struct TextureAtlasEntry
+	{
+		TextureAtlasStatus Status = TextureAtlasStatus::Full;
+		float Layer = -1.0f;
+		// (u0, v0, u1, v1) over the texel centers of the packed texture, local 0..1 coordinates map onto it
+		glm::vec4 UVRect = glm::vec4(0.0f);
+
+		bool IsValid() const { return Status == TextureAtlasStatus::Packed; }
+	};
+
+	// Packs many small textures into the layers of one 2D array texture (shelf packing), so any number of them
+	// can be drawn from a single binding. Textures are copied in on first use and looked up by pointer afterwards.
+	// Space is not reclaimed when a texture goes away, Reset drops every entry.
+	class TextureArrayAtlas
+	{
+	public:
+		virtual ~TextureArrayAtlas() = default;
+
+		virtual TextureAtlasEntry Get(const Ref<Texture2D>& texture) = 0;
+		virtual void Reset() = 0;
+
+		virtual void Bind(uint32_t slot = 0) const = 0;
+
+		virtual uint32_t GetRendererID() const = 0;
+		virtual uint32_t GetLayerCount() const = 0;
+		virtual const TextureArrayAtlasSpecification& GetSpecification() const = 0;
+
+		static Ref<TextureArrayAtlas> Create(const TextureArrayAtlasSpecification& spec = {});
+	};
+
+}
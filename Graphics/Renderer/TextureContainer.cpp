@@ -0,0 +1,409 @@
+#include "Renderer/TextureContainer.h"
+
+#include <Logger.h>
+#include <cstring>
+#include <algorithm>
+#include <bit>
+
+namespace Graphics {
+
+	static const uint8_t s_Ktx2Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+	static const uint8_t s_DdsMagic[4] = { 'D', 'D', 'S', ' ' };
+
+	namespace Utils {
+
+		template<typename T>
+		static T GetLE(const std::vector<uint8_t>& bytes, size_t offset)
+		{
+			T value = 0;
+			for (size_t i = 0; i < sizeof(T); i++)
+				value |= (T)bytes[offset + i] << (i * 8);
+			return value;
+		}
+
+		static constexpr uint32_t FourCC(const char code[5])
+		{
+			return (uint32_t)code[0] | ((uint32_t)code[1] << 8) | ((uint32_t)code[2] << 16) | ((uint32_t)code[3] << 24);
+		}
+
+		static TextureContainerFormat FormatFromVk(uint32_t vkFormat)
+		{
+			switch (vkFormat)
+			{
+				case 37:  // VK_FORMAT_R8G8B8A8_UNORM
+				case 43:  return TextureContainerFormat::RGBA8;
+				case 131: // VK_FORMAT_BC1_RGB_UNORM_BLOCK
+				case 132: return TextureContainerFormat::BC1;
+				case 133: // VK_FORMAT_BC1_RGBA_UNORM_BLOCK
+				case 134: return TextureContainerFormat::BC1A;
+				case 137: // VK_FORMAT_BC3_UNORM_BLOCK
+				case 138: return TextureContainerFormat::BC3;
+				case 139: return TextureContainerFormat::BC4; // VK_FORMAT_BC4_UNORM_BLOCK
+				case 141: return TextureContainerFormat::BC5; // VK_FORMAT_BC5_UNORM_BLOCK
+				case 145: // VK_FORMAT_BC7_UNORM_BLOCK
+				case 146: return TextureContainerFormat::BC7;
+			}
+			return TextureContainerFormat::None;
+		}
+
+		static TextureContainerFormat FormatFromDxgi(uint32_t dxgiFormat)
+		{
+			switch (dxgiFormat)
+			{
+				case 28: // DXGI_FORMAT_R8G8B8A8_UNORM
+				case 29: return TextureContainerFormat::RGBA8;
+				case 71: // DXGI_FORMAT_BC1_UNORM
+				case 72: return TextureContainerFormat::BC1A;
+				case 77: // DXGI_FORMAT_BC3_UNORM
+				case 78: return TextureContainerFormat::BC3;
+				case 80: return TextureContainerFormat::BC4; // DXGI_FORMAT_BC4_UNORM
+				case 83: return TextureContainerFormat::BC5; // DXGI_FORMAT_BC5_UNORM
+				case 98: // DXGI_FORMAT_BC7_UNORM
+				case 99: return TextureContainerFormat::BC7;
+			}
+			return TextureContainerFormat::None;
+		}
+
+		static uint64_t LevelSize(TextureContainerFormat format, uint32_t width, uint32_t height)
+		{
+			if (format == TextureContainerFormat::RGBA8)
+				return (uint64_t)width * height * 4;
+			return (uint64_t)((width + 3) / 4) * ((height + 3) / 4) * TextureContainer::GetBlockSize(format);
+		}
+
+		// Levels of a full chain down to 1x1, GL refuses longer chains
+		static uint32_t MaxLevels(uint32_t width, uint32_t height)
+		{
+			return (uint32_t)std::bit_width(std::max(width, height));
+		}
+
+		// Appends the payload of one level stored at offset, false if it runs past the end of the file
+		static bool AddLevel(TextureContainer& container, const std::vector<uint8_t>& bytes, uint64_t offset, uint32_t level)
+		{
+			TextureContainer::Level entry;
+			entry.Width = std::max(container.Width >> level, 1u);
+			entry.Height = std::max(container.Height >> level, 1u);
+			entry.Size = LevelSize(container.Format, entry.Width, entry.Height);
+			entry.Offset = container.Data.size();
+			// offset comes from the file, offset + entry.Size could wrap
+			if (offset > bytes.size() || entry.Size > bytes.size() - offset)
+				return false;
+
+			container.Data.insert(container.Data.end(), bytes.begin() + offset, bytes.begin() + offset + entry.Size);
+			container.Levels.push_back(entry);
+			return true;
+		}
+
+		static bool ReadKtx2(const std::vector<uint8_t>& bytes, TextureContainer& container, const std::string& path)
+		{
+			if (bytes.size() < 80)
+			{
+				LOG_FATAL_STREAM << "Texture " << path << " has a truncated KTX2 header";
+				return false;
+			}
+
+			const uint32_t vkFormat = GetLE<uint32_t>(bytes, 12);
+			const uint32_t width = GetLE<uint32_t>(bytes, 20);
+			const uint32_t height = GetLE<uint32_t>(bytes, 24);
+			const uint32_t depth = GetLE<uint32_t>(bytes, 28);
+			const uint32_t layers = GetLE<uint32_t>(bytes, 32);
+			const uint32_t faces = GetLE<uint32_t>(bytes, 36);
+			const uint32_t levels = std::max(GetLE<uint32_t>(bytes, 40), 1u);
+			const uint32_t supercompression = GetLE<uint32_t>(bytes, 44);
+
+			if (supercompression != 0)
+			{
+				LOG_FATAL_STREAM << "Texture " << path << " is supercompressed (scheme " << supercompression << "), only plain KTX2 payloads are supported";
+				return false;
+			}
+			if (width == 0 || height == 0 || depth > 1 || layers > 1 || faces != 1)
+			{
+				LOG_FATAL_STREAM << "Texture " << path << " is not a single 2D image";
+				return false;
+			}
+
+			container.Format = FormatFromVk(vkFormat);
+			if (container.Format == TextureContainerFormat::None)
+			{
+				LOG_FATAL_STREAM << "Texture " << path << " has unsupported VkFormat " << vkFormat;
+				return false;
+			}
+
+			if (levels > MaxLevels(width, height))
+			{
+				LOG_FATAL_STREAM << "Texture " << path << " has " << levels << " levels, more than a " << width << "x" << height << " mip chain";
+				return false;
+			}
+
+			container.Width = width;
+			container.Height = height;
+			if (bytes.size() < 80 + (size_t)levels * 24)
+			{
+				LOG_FATAL_STREAM << "Texture " << path << " has a truncated KTX2 level index";
+				return false;
+			}
+
+			for (uint32_t level = 0; level < levels; level++)
+			{
+				if (!AddLevel(container, bytes, GetLE<uint64_t>(bytes, 80 + level * 24), level))
+				{
+					LOG_FATAL_STREAM << "Texture " << path << " level " << level << " runs past the end of the file";
+					return false;
+				}
+			}
+			return true;
+		}
+
+		static bool ReadDds(const std::vector<uint8_t>& bytes, TextureContainer& container, const std::string& path)
+		{
+			// Magic, DDS_HEADER, then DDS_HEADER_DXT10 when the pixel format says DX10
+			if (bytes.size() < 128 || GetLE<uint32_t>(bytes, 4) != 124)
+			{
+				LOG_FATAL_STREAM << "Texture " << path << " has a truncated DDS header";
+				return false;
+			}
+
+			const uint32_t flags = GetLE<uint32_t>(bytes, 8);
+			const uint32_t height = GetLE<uint32_t>(bytes, 12);
+			const uint32_t width = GetLE<uint32_t>(bytes, 16);
+			const uint32_t mipCount = GetLE<uint32_t>(bytes, 28);
+			const uint32_t pixelFlags = GetLE<uint32_t>(bytes, 80);
+			const uint32_t fourCC = GetLE<uint32_t>(bytes, 84);
+			const uint32_t caps2 = GetLE<uint32_t>(bytes, 112);
+
+			// DDSD_DEPTH, DDSCAPS2_CUBEMAP, DDSCAPS2_VOLUME
+			if (width == 0 || height == 0 || (flags & 0x800000) || (caps2 & (0x200 | 0x200000)))
+			{
+				LOG_FATAL_STREAM << "Texture " << path << " is not a single 2D image";
+				return false;
+			}
+
+			uint64_t offset = 128;
+			if (pixelFlags & 0x4) // DDPF_FOURCC
+			{
+				if (fourCC == FourCC("DX10"))
+				{
+					if (bytes.size() < 148 || GetLE<uint32_t>(bytes, 132) != 3 || GetLE<uint32_t>(bytes, 140) > 1)
+					{
+						LOG_FATAL_STREAM << "Texture " << path << " is not a single 2D image";
+						return false;
+					}
+					container.Format = FormatFromDxgi(GetLE<uint32_t>(bytes, 128));
+					offset = 148;
+				}
+				else if (fourCC == FourCC("DXT1"))
+					container.Format = TextureContainerFormat::BC1A;
+				else if (fourCC == FourCC("DXT5"))
+					container.Format = TextureContainerFormat::BC3;
+				else if (fourCC == FourCC("ATI1") || fourCC == FourCC("BC4U"))
+					container.Format = TextureContainerFormat::BC4;
+				else if (fourCC == FourCC("ATI2") || fourCC == FourCC("BC5U"))
+					container.Format = TextureContainerFormat::BC5;
+			}
+			else if ((pixelFlags & 0x40) && GetLE<uint32_t>(bytes, 88) == 32 && GetLE<uint32_t>(bytes, 92) == 0xFF
+				&& GetLE<uint32_t>(bytes, 96) == 0xFF00 && GetLE<uint32_t>(bytes, 100) == 0xFF0000)
+			{
+				// DDPF_RGB with the channels in RGBA byte order
+				container.Format = TextureContainerFormat::RGBA8;
+			}
+
+			if (container.Format == TextureContainerFormat::None)
+			{
+				LOG_FATAL_STREAM << "Texture " << path << " has an unsupported DDS pixel format";
+				return false;
+			}
+
+			container.Width = width;
+			container.Height = height;
+			// DDSD_MIPMAPCOUNT
+			const uint32_t levels = (flags & 0x20000) ? std::max(mipCount, 1u) : 1;
+			if (levels > MaxLevels(width, height))
+			{
+				LOG_FATAL_STREAM << "Texture " << path << " has " << levels << " levels, more than a " << width << "x" << height << " mip chain";
+				return false;
+			}
+			for (uint32_t level = 0; level < levels; level++)
+			{
+				if (!AddLevel(container, bytes, offset, level))
+				{
+					LOG_FATAL_STREAM << "Texture " << path << " level " << level << " runs past the end of the file";
+					return false;
+				}
+				offset += container.Levels.back().Size;
+			}
+			return true;
+		}
+
+		static void Unpack565(uint16_t color, uint8_t* rgba)
+		{
+			const uint8_t r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+			rgba[0] = (uint8_t)((r << 3) | (r >> 2));
+			rgba[1] = (uint8_t)((g << 2) | (g >> 4));
+			rgba[2] = (uint8_t)((b << 3) | (b >> 2));
+			rgba[3] = 255;
+		}
+
+		// 4x4 texels, 4 bytes each, row by row
+		static void DecodeColorBlock(const uint8_t* block, uint8_t* texels, bool threeColorMode, bool punchThrough)
+		{
+			const uint16_t c0 = (uint16_t)(block[0] | (block[1] << 8));
+			const uint16_t c1 = (uint16_t)(block[2] | (block[3] << 8));
+
+			uint8_t palette[4][4];
+			Unpack565(c0, palette[0]);
+			Unpack565(c1, palette[1]);
+			for (int channel = 0; channel < 3; channel++)
+			{
+				const int a = palette[0][channel], b = palette[1][channel];
+				if (c0 > c1 || !threeColorMode)
+				{
+					palette[2][channel] = (uint8_t)((2 * a + b) / 3);
+					palette[3][channel] = (uint8_t)((a + 2 * b) / 3);
+				}
+				else
+				{
+					palette[2][channel] = (uint8_t)((a + b) / 2);
+					palette[3][channel] = 0;
+				}
+			}
+			palette[2][3] = 255;
+			palette[3][3] = (c0 <= c1 && threeColorMode && punchThrough) ? 0 : 255;
+
+			const uint32_t indices = (uint32_t)block[4] | ((uint32_t)block[5] << 8) | ((uint32_t)block[6] << 16) | ((uint32_t)block[7] << 24);
+			for (int i = 0; i < 16; i++)
+				memcpy(texels + i * 4, palette[(indices >> (i * 2)) & 3], 4);
+		}
+
+		// BC4 and the alpha half of BC3, writes one channel of the 4x4 texels
+		static void DecodeChannelBlock(const uint8_t* block, uint8_t* texels, int channel)
+		{
+			const int r0 = block[0], r1 = block[1];
+			uint8_t palette[8] = { (uint8_t)r0, (uint8_t)r1 };
+			if (r0 > r1)
+			{
+				for (int i = 1; i < 7; i++)
+					palette[i + 1] = (uint8_t)(((7 - i) * r0 + i * r1) / 7);
+			}
+			else
+			{
+				for (int i = 1; i < 5; i++)
+					palette[i + 1] = (uint8_t)(((5 - i) * r0 + i * r1) / 5);
+				palette[6] = 0;
+				palette[7] = 255;
+			}
+
+			uint64_t indices = 0;
+			for (int i = 0; i < 6; i++)
+				indices |= (uint64_t)block[2 + i] << (i * 8);
+			for (int i = 0; i < 16; i++)
+				texels[i * 4 + channel] = palette[(indices >> (i * 3)) & 7];
+		}
+
+		static void DecodeBlock(TextureContainerFormat format, const uint8_t* block, uint8_t* texels)
+		{
+			switch (format)
+			{
+				case TextureContainerFormat::BC1:
+				case TextureContainerFormat::BC1A:
+					DecodeColorBlock(block, texels, true, format == TextureContainerFormat::BC1A);
+					break;
+				case TextureContainerFormat::BC3:
+					DecodeColorBlock(block + 8, texels, false, false);
+					DecodeChannelBlock(block, texels, 3);
+					break;
+				case TextureContainerFormat::BC4:
+				case TextureContainerFormat::BC5:
+					for (int i = 0; i < 16; i++)
+					{
+						texels[i * 4 + 1] = texels[i * 4 + 2] = 0;
+						texels[i * 4 + 3] = 255;
+					}
+					DecodeChannelBlock(block, texels, 0);
+					if (format == TextureContainerFormat::BC5)
+						DecodeChannelBlock(block + 8, texels, 1);
+					break;
+				default:
+					break;
+			}
+		}
+
+	}
+
+	bool TextureContainer::IsContainer(const std::vector<uint8_t>& bytes)
+	{
+		return (bytes.size() >= sizeof(s_Ktx2Identifier) && memcmp(bytes.data(), s_Ktx2Identifier, sizeof(s_Ktx2Identifier)) == 0)
+			|| (bytes.size() >= sizeof(s_DdsMagic) && memcmp(bytes.data(), s_DdsMagic, sizeof(s_DdsMagic)) == 0);
+	}
+
+	bool TextureContainer::Read(const std::vector<uint8_t>& bytes, TextureContainer& container, const std::string& path)
+	{
+		container = TextureContainer();
+		if (bytes.size() >= sizeof(s_Ktx2Identifier) && memcmp(bytes.data(), s_Ktx2Identifier, sizeof(s_Ktx2Identifier)) == 0)
+			return Utils::ReadKtx2(bytes, container, path);
+		if (bytes.size() >= sizeof(s_DdsMagic) && memcmp(bytes.data(), s_DdsMagic, sizeof(s_DdsMagic)) == 0)
+			return Utils::ReadDds(bytes, container, path);
+
+		LOG_FATAL_STREAM << "Texture " << path << " is neither KTX2 nor DDS";
+		return false;
+	}
+
+	bool TextureContainer::Transcode(TextureContainer& container)
+	{
+		if (!container.IsCompressed())
+			return true;
+		if (container.Format == TextureContainerFormat::BC7)
+			return false;
+
+		const uint32_t blockSize = GetBlockSize(container.Format);
+		std::vector<uint8_t> data;
+		std::vector<Level> levels;
+		for (const Level& level : container.Levels)
+		{
+			Level decoded = level;
+			decoded.Offset = data.size();
+			decoded.Size = (uint64_t)level.Width * level.Height * 4;
+			data.resize(data.size() + decoded.Size);
+
+			const uint32_t blocksX = (level.Width + 3) / 4, blocksY = (level.Height + 3) / 4;
+			const uint8_t* block = container.Data.data() + level.Offset;
+			uint8_t texels[16 * 4];
+			for (uint32_t by = 0; by < blocksY; by++)
+			{
+				for (uint32_t bx = 0; bx < blocksX; bx++, block += blockSize)
+				{
+					Utils::DecodeBlock(container.Format, block, texels);
+
+					// Blocks on the last column and row of levels that are not a multiple of 4 hang over the image
+					const uint32_t columns = std::min(4u, level.Width - bx * 4);
+					const uint32_t rows = std::min(4u, level.Height - by * 4);
+					for (uint32_t row = 0; row < rows; row++)
+					{
+						uint8_t* out = data.data() + decoded.Offset + (((uint64_t)by * 4 + row) * level.Width + bx * 4) * 4;
+						memcpy(out, texels + row * 16, columns * 4);
+					}
+				}
+			}
+			levels.push_back(decoded);
+		}
+
+		container.Format = TextureContainerFormat::RGBA8;
+		container.Levels = std::move(levels);
+		container.Data = std::move(data);
+		return true;
+	}
+
+	uint32_t TextureContainer::GetBlockSize(TextureContainerFormat format)
+	{
+		switch (format)
+		{
+			case TextureContainerFormat::BC1:
+			case TextureContainerFormat::BC1A:
+			case TextureContainerFormat::BC4:  return 8;
+			case TextureContainerFormat::BC3:
+			case TextureContainerFormat::BC5:
+			case TextureContainerFormat::BC7:  return 16;
+			default:                           return 0;
+		}
+	}
+
+}
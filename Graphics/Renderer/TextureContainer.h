@@ -0,0 +1,58 @@
+#pragma once
+
+#include "GraphicsCore.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Graphics {
+
+	enum class TextureContainerFormat
+	{
+		None = 0,
+		RGBA8,
+		// BC1 without alpha, the fourth palette entry is opaque black
+		BC1,
+		// BC1 with punch-through alpha
+		BC1A,
+		BC3,
+		// RGTC, one and two channel masks
+		BC4,
+		BC5,
+		BC7
+	};
+
+	// A 2D image read from a KTX2 or DDS file, with its mip chain as stored. sRGB formats are read as their UNORM
+	// counterparts, like PNGs the texels are used as they are and the renderer never linearizes. Block compressed
+	// images cannot be flipped, they are used as stored: author them with the first row at the bottom.
+	struct TextureContainer
+	{
+		struct Level
+		{
+			uint64_t Offset = 0, Size = 0;
+			uint32_t Width = 0, Height = 0;
+		};
+
+		TextureContainerFormat Format = TextureContainerFormat::None;
+		uint32_t Width = 0, Height = 0;
+		std::vector<Level> Levels;
+		// Payload of every level, Level::Offset is relative to its start
+		std::vector<uint8_t> Data;
+
+		bool IsCompressed() const { return Format != TextureContainerFormat::None && Format != TextureContainerFormat::RGBA8; }
+
+		// Checks the magic number, a false return means the bytes are for stb_image
+		static bool IsContainer(const std::vector<uint8_t>& bytes);
+
+		// Supercompressed KTX2 (BasisLZ, zstd), cube maps, arrays and volumes are rejected with a logged reason
+		static bool Read(const std::vector<uint8_t>& bytes, TextureContainer& container, const std::string& path);
+
+		// Decodes BC1 to BC5 into RGBA8 in place, for drivers without the format. BC4 lands in red and BC5 in red
+		// and green, the other channels read like sampling the compressed texture would (0, 0, 1). False for BC7.
+		static bool Transcode(TextureContainer& container);
+
+		static uint32_t GetBlockSize(TextureContainerFormat format);
+	};
+
+}
@@ -0,0 +1,40 @@
+#include "GraphicsCore.h"
+#include "TextureManager.h"
+
+#include "Renderer/Renderer.h"
+#include "Platform/OpenGL/OpenGLTextureManager.h"
+
+namespace Graphics {
+
+	static Scope<TextureManager> s_TextureManager;
+
+	void TextureManager::Init(const TextureManagerSpecification& spec)
+	{
+		GRAPHICS_CORE_ASSERT(!s_TextureManager, "TextureManager already initialized!");
+		s_TextureManager = Create(spec);
+	}
+
+	void TextureManager::Shutdown()
+	{
+		s_TextureManager.reset();
+	}
+
+	TextureManager& TextureManager::Get()
+	{
+		GRAPHICS_CORE_ASSERT(s_TextureManager, "TextureManager::Init has not been called!");
+		return *s_TextureManager;
+	}
+
+	Scope<TextureManager> TextureManager::Create(const TextureManagerSpecification& spec)
+	{
+		switch (Renderer::GetAPI())
+		{
+			case RendererAPI::API::None:    GRAPHICS_CORE_ASSERT(false, "RendererAPI::None is currently not supported!"); return nullptr;
+			case RendererAPI::API::OpenGL:  return CreateScope<OpenGLTextureManager>(spec);
+		}
+
+		GRAPHICS_CORE_ASSERT(false, "Unknown RendererAPI!");
+		return nullptr;
+	}
+
+}
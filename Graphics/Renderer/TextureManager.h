@@ -0,0 +1,53 @@
+#pragma once
+
+#include "GraphicsCore.h"
+#include "Renderer/Texture.h"
+
+#include <cstdint>
+#include <string>
+
+namespace Graphics {
+
+	struct TextureLoadOptions
+	{
+		// KTX2 and DDS files bring their own chain, only a single uncompressed level gets one generated
+		bool GenerateMips = true;
+		// Ignored for KTX2 and DDS, see TextureContainer
+		bool FlipVertically = true;
+	};
+
+	struct TextureManagerSpecification
+	{
+		// Persistently mapped pixel unpack buffer the decoded images are streamed through
+		uint64_t StagingBufferSize = 32ull * 1024 * 1024;
+		// Bytes uploaded per Update, keeps a burst of loads from stalling a frame
+		uint64_t UploadBudget = 16ull * 1024 * 1024;
+	};
+
+	// Loads textures without blocking the caller. Files are read and decoded on the thread pool, Update streams the
+	// decoded images to the GPU on the main thread. Load hands out the texture at once: it shows a placeholder
+	// (IsLoaded false) until its image is uploaded, then GetRendererID and the size change. Requests for a path that
+	// is still referenced return the same texture, images with the same content share one GPU texture.
+	class TextureManager
+	{
+	public:
+		virtual ~TextureManager() = default;
+
+		virtual Ref<Texture2D> Load(const std::string& path, const TextureLoadOptions& options = {}) = 0;
+
+		// Main thread, once per frame. Returns true when a texture was swapped in, the caller has to redraw
+		virtual bool Update() = 0;
+		// Blocks until every requested texture is decoded and uploaded
+		virtual void Flush() = 0;
+
+		// Decodes still running plus images waiting for upload
+		virtual uint32_t GetPendingCount() const = 0;
+
+		static void Init(const TextureManagerSpecification& spec = {});
+		static void Shutdown();
+		static TextureManager& Get();
+	private:
+		static Scope<TextureManager> Create(const TextureManagerSpecification& spec);
+	};
+
+}
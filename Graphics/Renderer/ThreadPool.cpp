@@ -0,0 +1,97 @@
+#include "Renderer/ThreadPool.h"
+
+#include <Logger.h>
+
+namespace Graphics {
+
+	ThreadPool::ThreadPool(uint32_t threadCount)
+	{
+		if (threadCount == 0)
+		{
+			uint32_t hardwareThreads = std::thread::hardware_concurrency();
+			threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+		}
+
+		m_Threads.reserve(threadCount);
+		for (uint32_t i = 0; i < threadCount; i++)
+			m_Threads.emplace_back(&ThreadPool::WorkerLoop, this);
+
+		LOG_DEBUG_STREAM << "Started thread pool with " << threadCount << " workers";
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::scoped_lock<std::mutex> lock(m_Mutex);
+			m_Stopping = true;
+		}
+		m_JobAvailable.notify_all();
+
+		for (std::thread& thread : m_Threads)
+			thread.join();
+	}
+
+	void ThreadPool::Submit(Job job)
+	{
+		{
+			std::scoped_lock<std::mutex> lock(m_Mutex);
+			m_Jobs.emplace_back(std::move(job));
+		}
+		m_JobAvailable.notify_one();
+	}
+
+	void ThreadPool::WaitIdle()
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_Idle.wait(lock, [this]() { return m_Jobs.empty() && m_ActiveJobs == 0; });
+	}
+
+	uint32_t ThreadPool::GetPendingCount() const
+	{
+		std::scoped_lock<std::mutex> lock(m_Mutex);
+		return (uint32_t)m_Jobs.size() + m_ActiveJobs;
+	}
+
+	ThreadPool& ThreadPool::Get()
+	{
+		static ThreadPool s_Pool;
+		return s_Pool;
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		while (true)
+		{
+			Job job;
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_JobAvailable.wait(lock, [this]() { return m_Stopping || !m_Jobs.empty(); });
+
+				// Drain the queue before stopping so no submitted work is lost
+				if (m_Jobs.empty())
+					return;
+
+				job = std::move(m_Jobs.front());
+				m_Jobs.pop_front();
+				m_ActiveJobs++;
+			}
+
+			try
+			{
+				job();
+			}
+			catch (const std::exception& e)
+			{
+				LOG_FATAL_STREAM << "Thread pool job failed: " << e.what();
+			}
+
+			{
+				std::scoped_lock<std::mutex> lock(m_Mutex);
+				m_ActiveJobs--;
+				if (m_Jobs.empty() && m_ActiveJobs == 0)
+					m_Idle.notify_all();
+			}
+		}
+	}
+
+}
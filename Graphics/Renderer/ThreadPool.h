@@ -0,0 +1,48 @@
+#pragma once
+
+#include "GraphicsCore.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+namespace Graphics {
+
+	// Fixed size pool of worker threads for CPU side background work (encoding, compiling, decoding).
+	// Jobs must not touch GL, hand results back to the main thread instead.
+	class ThreadPool
+	{
+	public:
+		using Job = std::function<void()>;
+
+		// 0 picks hardware_concurrency - 1, leaving a core for the main thread
+		explicit ThreadPool(uint32_t threadCount = 0);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		void Submit(Job job);
+
+		// Blocks until the queue is empty and every worker is idle
+		void WaitIdle();
+
+		uint32_t GetPendingCount() const;
+		uint32_t GetThreadCount() const { return (uint32_t)m_Threads.size(); }
+
+		// Shared pool used by the renderer for background jobs
+		static ThreadPool& Get();
+	private:
+		void WorkerLoop();
+	private:
+		std::vector<std::thread> m_Threads;
+		std::deque<Job> m_Jobs;
+		mutable std::mutex m_Mutex;
+		std::condition_variable m_JobAvailable;
+		std::condition_variable m_Idle;
+		uint32_t m_ActiveJobs = 0;
+		bool m_Stopping = false;
+	};
+
+}
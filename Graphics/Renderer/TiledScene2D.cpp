@@ -0,0 +1,520 @@
+#include "TiledScene2D.h"
+#include "Renderer/ThreadPool.h"
+
+#include <Logger.h>
+#include <algorithm>
+#include <cmath>
+
+namespace Graphics {
+
+	namespace Utils {
+
+		// Node, level (0 to 63) and whether the tile holds the whole subtree or the node's own primitives
+		static uint64_t TileKey(uint32_t node, uint32_t level, bool subtree)
+		{
+			return ((uint64_t)node << 8) | (subtree ? 0x80 : 0) | level;
+		}
+
+		static uint32_t TileNode(uint64_t key) { return (uint32_t)(key >> 8); }
+		static uint32_t TileLevel(uint64_t key) { return (uint32_t)(key & 0x3F); }
+		static bool TileSubtree(uint64_t key) { return (key & 0x80) != 0; }
+
+		static bool Overlaps(const TiledScene2D::Node& node, const glm::dvec2& min, const glm::dvec2& max)
+		{
+			return node.Min.x <= max.x && node.Min.y <= max.y && node.Min.x + node.Size >= min.x && node.Min.y + node.Size >= min.y;
+		}
+
+		static double SegmentDistance2(const glm::dvec2& p, const glm::dvec2& a, const glm::dvec2& b)
+		{
+			const glm::dvec2 ab = b - a;
+			const double length2 = glm::dot(ab, ab);
+			const double t = length2 > 0.0 ? std::clamp(glm::dot(p - a, ab) / length2, 0.0, 1.0) : 0.0;
+			const glm::dvec2 d = p - (a + ab * t);
+			return glm::dot(d, d);
+		}
+
+		// Douglas-Peucker, keeps the points further than tolerance from the line through the kept ones around them
+		static void Simplify(const glm::dvec2* points, uint32_t count, double tolerance, std::vector<glm::dvec2>& result)
+		{
+			result.clear();
+			if (count < 3)
+			{
+				result.assign(points, points + count);
+				return;
+			}
+
+			std::vector<bool> keep(count, false);
+			keep[0] = keep[count - 1] = true;
+			std::vector<std::pair<uint32_t, uint32_t>> stack = { { 0, count - 1 } };
+			const double tolerance2 = tolerance * tolerance;
+			while (!stack.empty())
+			{
+				auto [first, last] = stack.back();
+				stack.pop_back();
+
+				double farthest = tolerance2;
+				uint32_t index = 0;
+				for (uint32_t i = first + 1; i < last; i++)
+				{
+					const double distance = SegmentDistance2(points[i], points[first], points[last]);
+					if (distance > farthest)
+					{
+						farthest = distance;
+						index = i;
+					}
+				}
+
+				if (index)
+				{
+					keep[index] = true;
+					stack.push_back({ first, index });
+					stack.push_back({ index, last });
+				}
+			}
+
+			for (uint32_t i = 0; i < count; i++)
+				if (keep[i])
+					result.push_back(points[i]);
+		}
+
+		static TiledScene2D::TileContent BuildTile(const TiledScene2D::Tree& tree, uint64_t key, const TiledScene2DSpecification& spec)
+		{
+			using Content = TiledScene2D::TileContent;
+			const TiledScene2D::Node& node = tree.Nodes[TileNode(key)];
+
+			Content content;
+			content.Key = key;
+			content.Generation = tree.Generation;
+			content.Origin = node.Min + node.Size * 0.5;
+
+			// World units of one pixel when the tile is drawn TilePixels * 2^level wide
+			const double tolerance = node.Size / (spec.TilePixels * std::ldexp(1.0, TileLevel(key))) * spec.TolerancePixels;
+
+			std::vector<uint32_t> primitives = node.Primitives;
+			if (TileSubtree(key) && node.Children)
+			{
+				std::vector<uint32_t> nodes = { node.Children, node.Children + 1, node.Children + 2, node.Children + 3 };
+				while (!nodes.empty())
+				{
+					const TiledScene2D::Node& child = tree.Nodes[nodes.back()];
+					nodes.pop_back();
+					primitives.insert(primitives.end(), child.Primitives.begin(), child.Primitives.end());
+					if (child.Children)
+						for (uint32_t i = 0; i < 4; i++)
+							nodes.push_back(child.Children + i);
+				}
+			}
+
+			auto local = [&](const glm::dvec2& p) { return glm::vec2(p - content.Origin); };
+
+			// Shapes under the tolerance become one quad per tolerance sized cell, the first shape in it gives the color
+			std::unordered_set<uint64_t> cells;
+			std::vector<glm::dvec2> simplified;
+			for (uint32_t index : primitives)
+			{
+				const TiledScene2D::Primitive& primitive = tree.Primitives[index];
+				const glm::dvec2 extent = primitive.Max - primitive.Min;
+				if (std::max(extent.x, extent.y) < tolerance)
+				{
+					content.Exact = false;
+					const glm::dvec2 cell = glm::floor(((primitive.Min + primitive.Max) * 0.5 - node.Min) / tolerance);
+					if (cells.insert(((uint64_t)(uint32_t)cell.x << 32) | (uint32_t)cell.y).second)
+						content.Quads.push_back({ local(node.Min + (cell + 0.5) * tolerance), glm::vec2((float)tolerance), primitive.Color, primitive.ID });
+					continue;
+				}
+
+				const glm::dvec2* points = &tree.Points[primitive.FirstPoint];
+				switch (primitive.Type)
+				{
+					case TiledScene2D::PrimitiveType::Line:
+						content.Lines.push_back({ local(points[0]), local(points[1]), primitive.Color, primitive.ID });
+						break;
+					case TiledScene2D::PrimitiveType::Polyline:
+					{
+						std::vector<glm::dvec2> strip(points, points + primitive.PointCount);
+						if (primitive.Closed)
+							strip.push_back(points[0]);
+						Simplify(strip.data(), (uint32_t)strip.size(), tolerance, simplified);
+						content.Exact &= simplified.size() == strip.size();
+						for (size_t i = 1; i < simplified.size(); i++)
+							content.Lines.push_back({ local(simplified[i - 1]), local(simplified[i]), primitive.Color, primitive.ID });
+						break;
+					}
+					case TiledScene2D::PrimitiveType::Quad:
+						content.Quads.push_back({ local(points[0]), glm::vec2(primitive.Size), primitive.Color, primitive.ID });
+						break;
+					case TiledScene2D::PrimitiveType::Circle:
+						content.Circles.push_back({ local(points[0]), (float)primitive.Size.x, primitive.Color, primitive.ID });
+						break;
+				}
+			}
+
+			return content;
+		}
+
+	}
+
+	TiledScene2D::TiledScene2D(const TiledScene2DSpecification& spec)
+		: m_Specification(spec), m_Queue(CreateRef<BuildQueue>())
+	{
+		m_Specification.MaxPrimitivesPerTile = std::max(m_Specification.MaxPrimitivesPerTile, 1u);
+		m_Specification.TilePixels = std::max(m_Specification.TilePixels, 1.0f);
+	}
+
+	void TiledScene2D::AddLine(const glm::dvec2& from, const glm::dvec2& to, const glm::vec4& color, int id)
+	{
+		Primitive& primitive = m_Source.Primitives.emplace_back();
+		primitive.Type = PrimitiveType::Line;
+		primitive.ID = id;
+		primitive.Color = color;
+		primitive.Min = glm::min(from, to);
+		primitive.Max = glm::max(from, to);
+		primitive.FirstPoint = (uint32_t)m_Source.Points.size();
+		primitive.PointCount = 2;
+		m_Source.Points.push_back(from);
+		m_Source.Points.push_back(to);
+		m_Dirty = true;
+	}
+
+	void TiledScene2D::AddPolyline(const std::vector<glm::dvec2>& points, const glm::vec4& color, int id, bool closed)
+	{
+		if (points.size() < 2)
+			return;
+
+		Primitive& primitive = m_Source.Primitives.emplace_back();
+		primitive.Type = PrimitiveType::Polyline;
+		primitive.Closed = closed;
+		primitive.ID = id;
+		primitive.Color = color;
+		primitive.Min = primitive.Max = points[0];
+		for (const glm::dvec2& point : points)
+		{
+			primitive.Min = glm::min(primitive.Min, point);
+			primitive.Max = glm::max(primitive.Max, point);
+		}
+		primitive.FirstPoint = (uint32_t)m_Source.Points.size();
+		primitive.PointCount = (uint32_t)points.size();
+		m_Source.Points.insert(m_Source.Points.end(), points.begin(), points.end());
+		m_Dirty = true;
+	}
+
+	void TiledScene2D::AddQuad(const glm::dvec2& center, const glm::dvec2& size, const glm::vec4& color, int id)
+	{
+		Primitive& primitive = m_Source.Primitives.emplace_back();
+		primitive.Type = PrimitiveType::Quad;
+		primitive.ID = id;
+		primitive.Color = color;
+		primitive.Min = center - size * 0.5;
+		primitive.Max = center + size * 0.5;
+		primitive.FirstPoint = (uint32_t)m_Source.Points.size();
+		primitive.PointCount = 1;
+		primitive.Size = size;
+		m_Source.Points.push_back(center);
+		m_Dirty = true;
+	}
+
+	void TiledScene2D::AddCircle(const glm::dvec2& center, double radius, const glm::vec4& color, int id)
+	{
+		Primitive& primitive = m_Source.Primitives.emplace_back();
+		primitive.Type = PrimitiveType::Circle;
+		primitive.ID = id;
+		primitive.Color = color;
+		primitive.Min = center - radius;
+		primitive.Max = center + radius;
+		primitive.FirstPoint = (uint32_t)m_Source.Points.size();
+		primitive.PointCount = 1;
+		primitive.Size = glm::dvec2(radius, 0.0);
+		m_Source.Points.push_back(center);
+		m_Dirty = true;
+	}
+
+	void TiledScene2D::Clear()
+	{
+		m_Source = Tree();
+		m_Dirty = true;
+	}
+
+	void TiledScene2D::Build()
+	{
+		Ref<Tree> tree = CreateRef<Tree>();
+		tree->Primitives = m_Source.Primitives;
+		tree->Points = m_Source.Points;
+		tree->Generation = ++m_Generation;
+
+		// Tiles of the previous tree are dropped, builds still running for it are ignored when they come back
+		m_Tiles.clear();
+		m_LRU.clear();
+		m_Building.clear();
+		m_Ready.clear();
+		m_ResidentBytes = 0;
+		m_Dirty = false;
+
+		if (!tree->Primitives.empty())
+		{
+			glm::dvec2 min = tree->Primitives[0].Min, max = tree->Primitives[0].Max;
+			for (const Primitive& primitive : tree->Primitives)
+			{
+				min = glm::min(min, primitive.Min);
+				max = glm::max(max, primitive.Max);
+			}
+
+			Node& root = tree->Nodes.emplace_back();
+			root.Min = min;
+			root.Size = std::max(std::max(max.x - min.x, max.y - min.y), 1e-9);
+
+			struct Split { uint32_t Node; std::vector<uint32_t> Items; uint32_t Depth; };
+			std::vector<Split> stack;
+			stack.push_back({ 0, std::vector<uint32_t>(tree->Primitives.size()), 0 });
+			for (uint32_t i = 0; i < (uint32_t)tree->Primitives.size(); i++)
+				stack.back().Items[i] = i;
+
+			while (!stack.empty())
+			{
+				Split split = std::move(stack.back());
+				stack.pop_back();
+
+				tree->Nodes[split.Node].SubtreeCount = (uint32_t)split.Items.size();
+				if (split.Items.size() <= m_Specification.MaxPrimitivesPerTile || split.Depth >= m_Specification.MaxDepth)
+				{
+					tree->Nodes[split.Node].Primitives = std::move(split.Items);
+					continue;
+				}
+
+				const uint32_t children = (uint32_t)tree->Nodes.size();
+				const glm::dvec2 nodeMin = tree->Nodes[split.Node].Min;
+				const double half = tree->Nodes[split.Node].Size * 0.5;
+				const glm::dvec2 mid = nodeMin + half;
+				tree->Nodes[split.Node].Children = children;
+				for (uint32_t i = 0; i < 4; i++)
+				{
+					Node& child = tree->Nodes.emplace_back();
+					child.Min = nodeMin + glm::dvec2(i & 1 ? half : 0.0, i & 2 ? half : 0.0);
+					child.Size = half;
+				}
+
+				// A primitive goes down only when it lies in one quadrant, the ones across the middle stay here
+				std::vector<uint32_t> items[4], own;
+				for (uint32_t index : split.Items)
+				{
+					const Primitive& primitive = tree->Primitives[index];
+					const int x = primitive.Min.x >= mid.x ? 1 : (primitive.Max.x <= mid.x ? 0 : -1);
+					const int y = primitive.Min.y >= mid.y ? 1 : (primitive.Max.y <= mid.y ? 0 : -1);
+					if (x < 0 || y < 0)
+						own.push_back(index);
+					else
+						items[x + 2 * y].push_back(index);
+				}
+				tree->Nodes[split.Node].Primitives = std::move(own);
+
+				for (uint32_t i = 0; i < 4; i++)
+					if (!items[i].empty())
+						stack.push_back({ children + i, std::move(items[i]), split.Depth + 1 });
+			}
+		}
+
+		LOG_DEBUG_STREAM << "Tiled " << tree->Primitives.size() << " primitives into " << tree->Nodes.size() << " nodes";
+		m_Tree = tree;
+	}
+
+	uint32_t TiledScene2D::GetLevel(double pixels) const
+	{
+		if (pixels <= m_Specification.TilePixels)
+			return 0;
+		return (uint32_t)std::min(std::ceil(std::log2(pixels / m_Specification.TilePixels)), 63.0);
+	}
+
+	void TiledScene2D::RequestTile(uint64_t key)
+	{
+		if (m_Building.count(key) || m_Building.size() >= m_Specification.MaxPendingBuilds)
+			return;
+		m_Building.insert(key);
+
+		ThreadPool::Get().Submit([queue = m_Queue, tree = m_Tree, key, spec = m_Specification]() {
+			TileContent content = Utils::BuildTile(*tree, key, spec);
+			std::scoped_lock<std::mutex> lock(queue->Mutex);
+			queue->Built.push_back(std::move(content));
+		});
+	}
+
+	void TiledScene2D::Upload()
+	{
+		{
+			std::scoped_lock<std::mutex> lock(m_Queue->Mutex);
+			for (TileContent& content : m_Queue->Built)
+				if (content.Generation == m_Generation)
+					m_Ready.push_back(std::move(content));
+			m_Queue->Built.clear();
+		}
+
+		const size_t count = std::min<size_t>(m_Ready.size(), m_Specification.UploadsPerFrame);
+		for (size_t i = 0; i < count; i++)
+		{
+			const TileContent& content = m_Ready[i];
+			m_Building.erase(content.Key);
+			if (m_Tiles.count(content.Key))
+				continue;
+
+			BatchRenderer::BeginRetained(glm::dvec3(content.Origin, 0.0));
+			for (const TileContent::Quad& quad : content.Quads)
+				BatchRenderer::DrawQuad(glm::vec3(quad.Center, 0.0f), quad.Size, quad.Color, quad.ID);
+			for (const TileContent::Circle& circle : content.Circles)
+				BatchRenderer::DrawCircle(glm::vec3(circle.Center, 0.0f), circle.Radius, circle.Color, circle.ID);
+			for (const TileContent::Line& line : content.Lines)
+				BatchRenderer::DrawLine(glm::vec3(line.From, 0.0f), glm::vec3(line.To, 0.0f), line.Color, line.ID);
+
+			Tile& tile = m_Tiles[content.Key];
+			tile.Batch = BatchRenderer::EndRetained();
+			tile.Exact = content.Exact;
+			m_LRU.push_front(content.Key);
+			tile.LRU = m_LRU.begin();
+			m_ResidentBytes += tile.Batch->GetSize();
+		}
+		m_Ready.erase(m_Ready.begin(), m_Ready.begin() + count);
+	}
+
+	void TiledScene2D::Evict()
+	{
+		// Tiles drawn by any viewport in the last frame are still in use, they stay even over the budget
+		while (m_ResidentBytes > m_Specification.MemoryBudget && !m_LRU.empty())
+		{
+			auto it = m_Tiles.find(m_LRU.back());
+			if (it->second.LastFrame == m_Frame)
+				break;
+			m_ResidentBytes -= it->second.Batch->GetSize();
+			m_Tiles.erase(it);
+			m_LRU.pop_back();
+		}
+	}
+
+	bool TiledScene2D::IsResident(uint64_t key)
+	{
+		if (m_Tiles.count(key))
+			return true;
+		RequestTile(key);
+		return false;
+	}
+
+	bool TiledScene2D::DrawTile(uint64_t key)
+	{
+		auto it = m_Tiles.find(key);
+		if (it == m_Tiles.end())
+		{
+			// A shallower level that came out exact looks the same, otherwise the nearest resident level stands in
+			// while this one builds
+			const uint32_t node = Utils::TileNode(key), level = Utils::TileLevel(key);
+			const bool subtree = Utils::TileSubtree(key);
+			for (uint32_t i = level; i-- > 0 && it == m_Tiles.end();)
+			{
+				auto shallower = m_Tiles.find(Utils::TileKey(node, i, subtree));
+				if (shallower != m_Tiles.end() && shallower->second.Exact)
+					it = shallower;
+			}
+
+			if (it == m_Tiles.end())
+			{
+				m_Missing = true;
+				RequestTile(key);
+				for (uint32_t distance = 1; distance < 64 && it == m_Tiles.end(); distance++)
+				{
+					if (level + distance < 64)
+						it = m_Tiles.find(Utils::TileKey(node, level + distance, subtree));
+					if (it == m_Tiles.end() && distance <= level)
+						it = m_Tiles.find(Utils::TileKey(node, level - distance, subtree));
+				}
+				if (it == m_Tiles.end())
+					return false;
+			}
+		}
+
+		Tile& tile = it->second;
+		tile.LastFrame = m_Frame;
+		m_LRU.splice(m_LRU.begin(), m_LRU, tile.LRU);
+		BatchRenderer::DrawRetained(*tile.Batch);
+		m_Stats.DrawnTiles++;
+		return true;
+	}
+
+	void TiledScene2D::DrawNode(uint32_t index, const glm::dvec2& viewMin, const glm::dvec2& viewMax, double pixelSize)
+	{
+		const Node& node = m_Tree->Nodes[index];
+		if (!node.SubtreeCount || !Utils::Overlaps(node, viewMin, viewMax))
+			return;
+
+		const double pixels = node.Size / pixelSize;
+		const uint32_t level = GetLevel(pixels);
+		if (node.Children)
+		{
+			const uint64_t subtreeKey = Utils::TileKey(index, 0, true);
+			if (pixels <= m_Specification.TilePixels)
+			{
+				// Until the subtree tile is built its children stand in, they are resident after zooming out
+				if (DrawTile(subtreeKey))
+					return;
+			}
+			else if (m_Tiles.count(subtreeKey))
+			{
+				// Zooming in: the subtree tile stands in until this node's own tile and every child's are built
+				bool ready = node.Primitives.empty() || IsResident(Utils::TileKey(index, level, false));
+				for (uint32_t i = 0; i < 4; i++)
+				{
+					const uint32_t childIndex = node.Children + i;
+					const Node& child = m_Tree->Nodes[childIndex];
+					if (!child.SubtreeCount || !Utils::Overlaps(child, viewMin, viewMax))
+						continue;
+					const uint64_t childKey = child.Children ? Utils::TileKey(childIndex, 0, true) : Utils::TileKey(childIndex, GetLevel(pixels * 0.5), false);
+					ready &= IsResident(childKey);
+				}
+				if (!ready)
+				{
+					m_Missing = true;
+					DrawTile(subtreeKey);
+					return;
+				}
+			}
+		}
+
+		if (!node.Primitives.empty())
+			DrawTile(Utils::TileKey(index, level, false));
+
+		if (node.Children)
+			for (uint32_t i = 0; i < 4; i++)
+				DrawNode(node.Children + i, viewMin, viewMax, pixelSize);
+	}
+
+	void TiledScene2D::BeginFrame()
+	{
+		Evict();
+
+		m_Frame++;
+		m_Missing = false;
+		m_Stats.DrawnTiles = 0;
+		m_Stats.ResidentTiles = (uint32_t)m_Tiles.size();
+		m_Stats.ResidentBytes = m_ResidentBytes;
+	}
+
+	bool TiledScene2D::Draw()
+	{
+		const Camera* camera = BatchRenderer::GetSceneCamera();
+		if (!camera)
+			return false;
+
+		if (m_Dirty || !m_Tree)
+			Build();
+		Upload();
+
+		// The camera bounds are relative to its eye
+		const glm::dvec2 eye = glm::dvec2(camera->GetEyePosition());
+		const glm::dvec2 viewMin = eye + glm::dvec2(camera->getWorldXmin(), camera->getWorldYmin());
+		const glm::dvec2 viewMax = eye + glm::dvec2(camera->getWorldXmax(), camera->getWorldYmax());
+		const double pixelSize = (viewMax.x - viewMin.x) / camera->getViewport().x;
+		if (!m_Tree->Nodes.empty() && pixelSize > 0.0)
+			DrawNode(0, viewMin, viewMax, pixelSize);
+
+		m_Stats.Nodes = (uint32_t)m_Tree->Nodes.size();
+		m_Stats.ResidentTiles = (uint32_t)m_Tiles.size();
+		m_Stats.PendingTiles = (uint32_t)(m_Building.size());
+		m_Stats.ResidentBytes = m_ResidentBytes;
+		return m_Missing || !m_Ready.empty();
+	}
+
+}
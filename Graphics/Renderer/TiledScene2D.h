@@ -0,0 +1,167 @@
+#pragma once
+
+#include "GraphicsCore.h"
+#include "Renderer/BatchRenderer.h"
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace Graphics {
+
+	struct TiledScene2DSpecification
+	{
+		// A tile is split into four once it holds more primitives than this
+		uint32_t MaxPrimitivesPerTile = 2048;
+		uint32_t MaxDepth = 16;
+		// Width in pixels a tile is drawn at before its children are drawn instead
+		float TilePixels = 256.0f;
+		// Simplification error of a tile in pixels. Polylines are decimated to it, shapes smaller than it are merged
+		// into one quad per cell of that size.
+		float TolerancePixels = 1.0f;
+		// GPU bytes of resident tiles, the least recently drawn ones are evicted above it
+		uint64_t MemoryBudget = 128ull * 1024 * 1024;
+		// Tiles uploaded per Draw, and tiles being simplified on the thread pool at once
+		uint32_t UploadsPerFrame = 8;
+		uint32_t MaxPendingBuilds = 64;
+	};
+
+	// Primitives of a 2D viewport kept in a quadtree of tiles, so a frame costs what is on screen instead of the
+	// whole dataset. Each tile is simplified for the zoom it is seen at on the thread pool and uploaded as a
+	// RetainedBatch relative to its own origin. Tiles are dropped by least recent use under the memory budget, a tile
+	// still building is shown with another level of the same tile when one is resident.
+	class TiledScene2D
+	{
+	public:
+		struct Statistics
+		{
+			uint32_t Nodes = 0;
+			uint32_t ResidentTiles = 0;
+			// By every viewport of the current frame
+			uint32_t DrawnTiles = 0;
+			uint32_t PendingTiles = 0;
+			uint64_t ResidentBytes = 0;
+		};
+
+		TiledScene2D(const TiledScene2DSpecification& spec = {});
+
+		// Adding after a Draw rebuilds the tree and its tiles on the next one
+		void AddLine(const glm::dvec2& from, const glm::dvec2& to, const glm::vec4& color, int id = -1);
+		void AddPolyline(const std::vector<glm::dvec2>& points, const glm::vec4& color, int id = -1, bool closed = false);
+		void AddQuad(const glm::dvec2& center, const glm::dvec2& size, const glm::vec4& color, int id = -1);
+		void AddCircle(const glm::dvec2& center, double radius, const glm::vec4& color, int id = -1);
+		void Clear();
+
+		// Once per application frame before its viewports are drawn (GUI::Layer::OnDrawBegin). Evicts over the budget
+		// what no viewport drew in the frame before, and starts counting the tiles drawn.
+		void BeginFrame();
+		// Between BatchRenderer::BeginScene and EndScene of a TwoD viewport, draws the tiles in its view. Returns true
+		// while some of them are still building: keep redrawing (GUI::Layer::UpdateLayer) until it returns false.
+		bool Draw();
+
+		const Statistics& GetStats() const { return m_Stats; }
+		const TiledScene2DSpecification& GetSpecification() const { return m_Specification; }
+	public:
+		enum class PrimitiveType : uint8_t { Line, Polyline, Quad, Circle };
+
+		struct Primitive
+		{
+			PrimitiveType Type;
+			bool Closed = false;
+			int ID = -1;
+			glm::vec4 Color;
+			glm::dvec2 Min, Max;
+			// Line and polyline points, the center of quads and circles
+			uint32_t FirstPoint = 0, PointCount = 0;
+			// Quad size, circle radius in x
+			glm::dvec2 Size = glm::dvec2(0.0);
+		};
+
+		struct Node
+		{
+			glm::dvec2 Min;
+			double Size = 0.0;
+			// Index of the first of four children, 0 for a leaf
+			uint32_t Children = 0;
+			// Primitives that fit no child, every primitive of a leaf
+			std::vector<uint32_t> Primitives;
+			uint32_t SubtreeCount = 0;
+		};
+
+		// Immutable once built, shared with the builds running on the thread pool
+		struct Tree
+		{
+			std::vector<Primitive> Primitives;
+			std::vector<glm::dvec2> Points;
+			std::vector<Node> Nodes;
+			uint64_t Generation = 0;
+		};
+
+		// Simplified primitives of one tile, relative to the tile center
+		struct TileContent
+		{
+			struct Quad { glm::vec2 Center, Size; glm::vec4 Color; int ID; };
+			struct Circle { glm::vec2 Center; float Radius; glm::vec4 Color; int ID; };
+			struct Line { glm::vec2 From, To; glm::vec4 Color; int ID; };
+
+			uint64_t Key = 0;
+			uint64_t Generation = 0;
+			glm::dvec2 Origin;
+			// Nothing was decimated or merged, deeper levels of the tile would come out the same
+			bool Exact = true;
+			std::vector<Quad> Quads;
+			std::vector<Circle> Circles;
+			std::vector<Line> Lines;
+		};
+	private:
+		struct Tile
+		{
+			Ref<RetainedBatch> Batch;
+			std::list<uint64_t>::iterator LRU;
+			uint64_t LastFrame = 0;
+			bool Exact = false;
+		};
+
+		struct BuildQueue
+		{
+			std::mutex Mutex;
+			std::vector<TileContent> Built;
+		};
+
+		void Build();
+		void Upload();
+		void Evict();
+		void DrawNode(uint32_t node, const glm::dvec2& viewMin, const glm::dvec2& viewMax, double pixelSize);
+		// False when neither the tile nor a stand-in is resident, the tile is requested then
+		bool DrawTile(uint64_t key);
+		bool IsResident(uint64_t key);
+		void RequestTile(uint64_t key);
+		uint32_t GetLevel(double pixels) const;
+	private:
+		TiledScene2DSpecification m_Specification;
+
+		// Everything added, copied into a new tree by Build
+		Tree m_Source;
+		bool m_Dirty = false;
+		Ref<const Tree> m_Tree;
+		uint64_t m_Generation = 0;
+		uint64_t m_Frame = 0;
+
+		std::unordered_map<uint64_t, Tile> m_Tiles;
+		// Most recently drawn first
+		std::list<uint64_t> m_LRU;
+		std::unordered_set<uint64_t> m_Building;
+		Ref<BuildQueue> m_Queue;
+		// Built and waiting for their upload
+		std::vector<TileContent> m_Ready;
+		uint64_t m_ResidentBytes = 0;
+		bool m_Missing = false;
+
+		Statistics m_Stats;
+	};
+
+}
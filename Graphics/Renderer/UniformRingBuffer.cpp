@@ -0,0 +1,21 @@
+#include "GraphicsCore.h"
+#include "UniformRingBuffer.h"
+
+#include "Renderer/Renderer.h"
+#include "Platform/OpenGL/OpenGLUniformRingBuffer.h"
+
+namespace Graphics {
+
+	Ref<UniformRingBuffer> UniformRingBuffer::Create(uint32_t frameSize, uint32_t binding)
+	{
+		switch (Renderer::GetAPI())
+		{
+			case RendererAPI::API::None:    GRAPHICS_CORE_ASSERT(false, "RendererAPI::None is currently not supported!"); return nullptr;
+			case RendererAPI::API::OpenGL:  return CreateRef<OpenGLUniformRingBuffer>(frameSize, binding);
+		}
+
+		GRAPHICS_CORE_ASSERT(false, "Unknown RendererAPI!");
+		return nullptr;
+	}
+
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "GraphicsCore.h"
+#include <cstdint>
+
+namespace Graphics {
+
+	// A block written into a UniformRingBuffer
+	struct UniformAllocation
+	{
+		uint32_t Offset = 0;
+		uint32_t Size = 0;
+		uint64_t Frame = UINT64_MAX;
+		uint32_t Generation = 0;
+
+		bool IsValid() const { return Frame != UINT64_MAX; }
+	};
+
+	// Persistently mapped uniform memory split into one region per frame in flight. Blocks are appended to the
+	// current frame's region and bound with a range at their aligned offset, so writing a block never waits on
+	// draws still reading an earlier one. A region is only reused once the GPU is done with every frame that read it.
+	class UniformRingBuffer
+	{
+	public:
+		virtual ~UniformRingBuffer() = default;
+
+		// Blocks only when the GPU still reads the region this frame is about to reuse
+		virtual void BeginFrame() = 0;
+		virtual void EndFrame() = 0;
+
+		// Copies size bytes into the current frame's region, the region grows if it is full
+		virtual UniformAllocation Push(const void* data, uint32_t size) = 0;
+		// True while allocation can still be bound, false once its region is about to be recycled. A block that
+		// did not change is bound again instead of pushed again while this holds.
+		virtual bool IsResident(const UniformAllocation& allocation) const = 0;
+		// Binds allocation to the binding point the buffer was created for
+		virtual void Bind(const UniformAllocation& allocation) = 0;
+
+		static Ref<UniformRingBuffer> Create(uint32_t frameSize, uint32_t binding);
+	};
+
+}
@@ -11,6 +11,11 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <Renderer/Texture.h>
 #include <Renderer/BatchRenderer.h>
+#include <Renderer/TiledScene2D.h>
+#include <Renderer/2DCamera.h>
+#include <cmath>
+#include <charconv>
+#include <cstdlib>
 
 namespace GUI {
 
@@ -74,8 +79,8 @@ namespace GUI {
 
 		virtual void OnAttach() override {
 
-            m_BasicShader = Graphics::Shader::Create("./Resources/Shaders/BasicShader.glsl", false);
-            m_SelectedObjectShader = Graphics::Shader::Create("./Resources/Shaders/SelectedObject.glsl", false);
+            m_BasicShader = Graphics::Shader::Create("./Resources/Shaders/BasicShader.glsl");
+            m_SelectedObjectShader = Graphics::Shader::Create("./Resources/Shaders/SelectedObject.glsl");
 
             ///////////////If using a vertex buffer/////////////////////////////////////////////////////////////////////////////////////////////
             ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -193,14 +198,83 @@ namespace GUI {
         }
 
         void createShader() {
-            m_BasicShader = Graphics::Shader::Create("./Resources/Shaders/BasicShader.glsl", false);
-            m_SelectedObjectShader = Graphics::Shader::Create("./Resources/Shaders/SelectedObject.glsl", false);
+            m_BasicShader = Graphics::Shader::Create("./Resources/Shaders/BasicShader.glsl");
+            m_SelectedObjectShader = Graphics::Shader::Create("./Resources/Shaders/SelectedObject.glsl");
         }
 
         virtual void OnImGuiRender() override {
             // ImGui window
             ImGui::Begin("Triangle Color");
-            ImGui::ColorEdit4("Color", glm::value_ptr(uboDataFragment.triangleColor));
+            if (ImGui::ColorEdit4("Color", glm::value_ptr(uboDataFragment.triangleColor)))
+                AbstractApplication::Get().RequestRedraw();
+            ImGui::End();
+        }
+
+	};
+
+
+	// A board of traces, vias and pads drawn through a TiledScene2D in 2D viewports, too much to redraw every frame
+	class TiledSceneLayer : public Layer {
+
+        static const int BoardCells = 64;
+        static constexpr double CellSize = 10.0;
+
+        Graphics::TiledScene2D m_Scene;
+        bool m_Loading = false;
+
+	public:
+		TiledSceneLayer() : Layer("TiledSceneLayer") {
+		}
+
+		virtual void OnAttach() override {
+            std::vector<glm::dvec2> trace(64);
+            for (int y = 0; y < BoardCells; y++) {
+                for (int x = 0; x < BoardCells; x++) {
+                    const glm::dvec2 cell = glm::dvec2(x, y) * CellSize;
+                    const glm::vec4 color = glm::vec4(0.2f + 0.6f * x / BoardCells, 0.5f, 0.2f + 0.6f * y / BoardCells, 1.0f);
+
+                    for (size_t i = 0; i < trace.size(); i++) {
+                        const double t = (double)i / (trace.size() - 1);
+                        trace[i] = cell + glm::dvec2(t * CellSize, CellSize * (0.5 + 0.3 * std::sin(t * 6.283185307 * (1 + (x + y) % 4))));
+                    }
+                    m_Scene.AddPolyline(trace, color);
+
+                    for (int i = 0; i < 4; i++)
+                        m_Scene.AddCircle(cell + glm::dvec2(1.0 + 2.5 * i, 1.0), 0.4, { 0.8f, 0.7f, 0.2f, 1.0f });
+                    m_Scene.AddQuad(cell + glm::dvec2(2.0, 9.0), { 1.5, 0.8 }, { 0.7f, 0.2f, 0.2f, 1.0f });
+                    m_Scene.AddQuad(cell + glm::dvec2(8.0, 9.0), { 1.5, 0.8 }, { 0.7f, 0.2f, 0.2f, 1.0f });
+                }
+            }
+		}
+
+        virtual void OnDetach() override {}
+
+        virtual void OnUpdateLayer() override {}
+
+        virtual void OnEvent(Application::Event& event) override {}
+
+		virtual void OnDrawUpdate() override {
+            // 2D viewports run OnDrawUpdate under and over their grid, the tiles go over it
+            if (Graphics::BatchRenderer::GetSceneDepthTest() || !dynamic_cast<const Graphics::TwoDCamera*>(Graphics::BatchRenderer::GetSceneCamera()))
+                return;
+
+            // Tiles still building, draw again until they are all in
+            m_Loading = m_Scene.Draw();
+            if (m_Loading)
+                Layer::UpdateLayer();
+		}
+
+        virtual void OnDrawBegin() override {
+            m_Scene.BeginFrame();
+        }
+
+        virtual void OnSelection(int objectId, bool state) override {}
+
+        virtual void OnImGuiRender() override {
+            const Graphics::TiledScene2D::Statistics& stats = m_Scene.GetStats();
+            ImGui::Begin("Tiled Scene");
+            ImGui::Text("Nodes %u | Tiles drawn %u | resident %u | building %u", stats.Nodes, stats.DrawnTiles, stats.ResidentTiles, stats.PendingTiles);
+            ImGui::Text("Resident %.1f MB%s", stats.ResidentBytes / (1024.0 * 1024.0), m_Loading ? " | loading" : "");
             ImGui::End();
         }
 
@@ -214,6 +288,7 @@ namespace GUI {
 			:AbstractApplication(spec)
 		{ 
             PushLayer(new ObjectLayer());
+            PushLayer(new TiledSceneLayer());
 		}
 
 		~TestGUI() {
@@ -222,11 +297,52 @@ namespace GUI {
 	};
 
 	
+	// Parses a positive number from the start of text, moves text past it
+	static bool ParseCount(std::string_view& text, uint32_t& value)
+	{
+		const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+		if (error != std::errc() || value == 0)
+			return false;
+		text.remove_prefix(end - text.data());
+		return true;
+	}
+
+	static void ExitWithBadArgument(const std::string& arg)
+	{
+		LOG_FATAL_STREAM << "Invalid argument " << arg << ", expected --frames=N or --size=WxH with positive numbers";
+		std::exit(EXIT_FAILURE);
+	}
+
 	TestGUI* CreateApplication(ApplicationCommandLineArgs args)
 	{
 		ApplicationSpecification spec;
 		spec.Name = "TestGUI";
 		spec.CommandLineArgs = args;
+
+		// --headless [--frames=N] [--size=WxH] renders without a window, e.g. on CI. --grid-lines draws the 2D grid as lines,
+		// --render-thread draws on a thread of its own while the next frame is built
+		for (int i = 1; i < args.Count; i++) {
+			const std::string arg = args[i];
+			if (arg == "--headless")
+				spec.Headless = true;
+			else if (arg.starts_with("--frames=")) {
+				std::string_view text = std::string_view(arg).substr(9);
+				if (!ParseCount(text, spec.HeadlessFrameCount) || !text.empty())
+					ExitWithBadArgument(arg);
+			}
+			else if (arg.starts_with("--size=")) {
+				std::string_view text = std::string_view(arg).substr(7);
+				if (!ParseCount(text, spec.HeadlessWidth) || !text.starts_with('x'))
+					ExitWithBadArgument(arg);
+				text.remove_prefix(1);
+				if (!ParseCount(text, spec.HeadlessHeight) || !text.empty())
+					ExitWithBadArgument(arg);
+			}
+			else if (arg == "--grid-lines")
+				spec.GridLines = true;
+			else if (arg == "--render-thread")
+				spec.RenderThread = true;
+		}
 		return new TestGUI(spec);
 	}
 }
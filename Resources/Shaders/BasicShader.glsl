@@ -4,6 +4,7 @@ layout(location = 0) in int aID;
 layout(location = 1) in vec3 aPos;
 layout(location = 2) in vec3 aNormal;
 layout(location = 3) in vec3 aColor;
+layout(location = 4) in int aOrigin;
 
 #include <Resources/Shaders/GLBufferDeclarations.h>
 
@@ -13,9 +14,11 @@ layout(location = 2) out flat int  FragID;
 
 void main()
 {
+    // aPos is relative to its mesh origin, moved to be relative to the eye: the view matrix without translation
+    vec3 position = aPos + in_RenderOrigins[aOrigin].xyz;
     FragNormal = mat3(transpose(inverse(ubo.viewMatrix))) * aNormal;
-    FragPosition = vec3(ubo.viewMatrix * vec4(aPos, 1.0));
-    gl_Position = ubo.projViewMatrix * vec4(aPos, 1.0);
+    FragPosition = mat3(ubo.viewMatrix) * position;
+    gl_Position = ubo.projViewMatrixRTE * vec4(position, 1.0);
     FragID = aID;
 }
 
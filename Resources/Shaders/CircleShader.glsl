@@ -1,13 +1,8 @@
 #type vertex
 #version 450 core
-layout(location = 0) in int aID;
-layout(location = 1) in vec3 aPos;
-layout(location = 2) in vec3 aCirclePos;
-layout(location = 3) in vec3 aNormal;
-layout(location = 4) in vec4 aColor;
-layout(location = 5) in float aRadius;
 
 #include <Resources/Shaders/GLBufferDeclarations.h>
+#include <Resources/Shaders/PulledPrimitives.h>
 
 layout(location = 0) out vec3 FragNormal;
 layout(location = 1) out vec3 FragPosition;
@@ -19,13 +14,16 @@ layout(location = 5) out flat int  FragID;
 
 void main()
 {
-    FragID = aID;
-    FragNormal = mat3(transpose(inverse(ubo.viewMatrix))) * aNormal;
-    FragPosition = aPos;
-    gl_Position = ubo.projViewMatrix * vec4(aPos, 1.0);
-    CirclePosition = aCirclePos;
-    Radius = aRadius;
-    Color = aColor;
+    CircleRecord circle = in_Circles[gl_VertexID / 6];
+    vec3 position = PullCirclePosition(circle, gl_VertexID);
+
+    FragID = circle.id;
+    FragNormal = vec3(0.0);
+    FragPosition = position;
+    gl_Position = ubo.projViewMatrixRTE * vec4(position, 1.0);
+    CirclePosition = PullCircleCenter(circle);
+    Radius = circle.radius;
+    Color = circle.color;
 }
 
 #type fragment
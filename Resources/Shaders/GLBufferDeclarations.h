@@ -2,6 +2,7 @@
 
 layout(std140, binding = UBO_SCENE) uniform SceneDataUBO {
 	mat4 projViewMatrix;
+	mat4 projViewMatrixRTE; // projViewMatrix for positions relative to the eye, what the batch renderer uploads
 	mat4 viewMatrix;
 	mat4 viewMatrixInverse;
 	mat4 viewMatrixInverseTranspose;
@@ -11,6 +12,7 @@ layout(std140, binding = UBO_SCENE) uniform SceneDataUBO {
 	vec4 viewDirection;
 	vec4 gridMinMax;
 	vec4 viewport; // (width, height, width*height, 0)
+	vec4 gridLod; // (world units per pixel, lod0 cell size, lod fade, 0), computed on the CPU for the 2D grid
 	float aspectRatio;
 	float gridMajor;
 	float gridMinor;
@@ -44,3 +46,12 @@ layout(std430, binding = 2) restrict readonly buffer Matrices
 {
 	mat4 in_ModelMatrices[];
 };
+
+// Offset of each render origin from the eye (xyz), taken in double on the CPU. Stored meshes and retained batches
+// are relative to their origin, so panning rewrites this buffer and never their vertices. Slot 0 is the eye.
+#define SSBO_RENDER_ORIGINS 6
+
+layout(std430, binding = SSBO_RENDER_ORIGINS) restrict readonly buffer RenderOrigins
+{
+	vec4 in_RenderOrigins[];
+};
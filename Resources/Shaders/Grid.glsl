@@ -1,6 +1,8 @@
 #type vertex
 #version 460 core
 
+// Variants: GRID_2D draws the screen aligned 2D grid with axis labels, otherwise the 3D ground plane
+
 #include <Resources/Shaders/GLBufferDeclarations.h>
 #include <Resources/Shaders/GridParameters.h>
 
@@ -12,6 +14,14 @@ void main()
 	mat4 MVP = ubo.projViewMatrix;
 
 	int idx = indices[gl_VertexID];
+#ifdef GRID_2D
+	vec3 position = pos2D[idx];
+	
+	out_camPos = ubo.cameraPos.xy;
+
+	gl_Position = vec4(pos2D[idx], 1.0);
+	uv = (inverse(MVP) * vec4(position, 1.0)).xy;
+#else
 	vec3 position = pos[idx] * 1000;
 
 
@@ -19,19 +29,77 @@ void main()
 
 	gl_Position = MVP * (vec4(position, 1.0));
 	uv = position.xz;
+#endif
 }
 
 #type fragment
 #version 460 core
 
+#ifdef GRID_2D
+#include <Resources/Shaders/GLBufferDeclarations.h>
+#endif
 #include <Resources/Shaders/GridParameters.h>
 #include <Resources/Shaders/GridCalculation.h>
+#ifdef GRID_2D
+#include <Resources/Shaders/Text.h>
+#endif
 
 layout (location=0) in vec2 uv;
 layout (location=1) in vec2 camPos;
 layout (location=0) out vec4 out_FragColor;
 
+#ifdef GRID_2D
+// Labels sit on an axis at every major line from start to end. A label spans less than one step, so a pixel can
+// only be covered by the label of the line at or before it and the minus sign of the next one.
+vec4 axisLabels(int axis, float start, float end, float stepSize, float fontSize)
+{
+	vec4 color = vec4(0.0);
+	float scale = 32.0 / fontSize;
+	float across = uv[1 - axis] * scale;
+	if (stepSize <= 0.0 || across < -0.5 || across > 5.0)
+		return color;
+
+	float first = floor((uv[axis] - start) / stepSize);
+	for (float k = max(first, 0.0); k <= first + 1.0; k++)
+	{
+		float i = start + k * stepSize;
+		if (i >= end)
+			break;
+		vec2 position = axis == 0 ? vec2(i, 0) : vec2(0, i);
+		color += pFloat((uv - position) * scale, i);
+	}
+	return color;
+}
+#endif
+
 void main()
 {
+#ifdef GRID_2D
+	mat4 transform = inverse(ubo.viewMatrix);
+	float FontSize = ubo.gridMajor * 2;
+	float zoom = ubo.gridZoom;
+	vec4 GMin = vec4(ubo.gridMinMax.x,ubo.gridMinMax.z * ubo.aspectRatio,0.0,1.0);
+	vec4 GMax = vec4(ubo.gridMinMax.y,ubo.gridMinMax.w * ubo.aspectRatio,0.0,1.0);
+	float panXint = 0.0;
+	float panXFrac = modf(camPos.x, panXint);
+	float panYint = 0.0;
+	float panYFrac = modf(camPos.y, panYint);
+	vec2 gMin = (transform * GMin).xy;
+	vec2 gMax = (transform * GMax).xy;
+	float Xoffset = mod(zoom-panXFrac,ubo.gridMajor);
+	float Yoffset = mod(zoom-panYFrac,ubo.gridMajor);
+
+	float stepSize = ubo.gridMajor;
+	float Xstart = gMin.x + Xoffset - (mod(panXint,ubo.gridMajor));
+	float Xend = gMax.x;
+	float Ystart = gMin.y + Yoffset - (mod(panYint,ubo.gridMajor));
+	float Yend = gMax.y;
+
+	vec4 textColor = axisLabels(1, Ystart, Yend, stepSize, FontSize) + axisLabels(0, Xstart, Xend, stepSize, FontSize);
+
+	// The view is orthographic, LOD and pixel size are the same everywhere and come from the CPU
+	out_FragColor = gridColorLod(uv, camPos, ubo.gridLod.xx, ubo.gridLod.y, ubo.gridLod.z) + textColor.xxxx;
+#else
 	out_FragColor = gridColor(uv, camPos);
+#endif
 };
\ No newline at end of file
@@ -18,18 +18,10 @@ float max2(vec2 v)
 	return max(v.x, v.y);
 }
 
-vec4 gridColor(vec2 uv, vec2 camPos)
+// dudv: world size of a pixel along u and v, lod0: cell size of the current LOD, lodFade: progress towards the next one
+vec4 gridColorLod(vec2 uv, vec2 camPos, vec2 dudv, float lod0, float lodFade)
 {
-	vec2 dudv = vec2(
-		length(vec2(dFdx(uv.x), dFdy(uv.x))),
-		length(vec2(dFdx(uv.y), dFdy(uv.y)))
-	);
-
-	float lodLevel = max(0.0, log10((length(dudv) * gridMinPixelsBetweenCells) / gridMajorSize) + 1.0);
-	float lodFade = fract(lodLevel);
-
-	// cell sizes for lod0, lod1 and lod2
-	float lod0 = gridMajorSize * pow(10.0, floor(lodLevel));
+	// cell sizes for lod1 and lod2
 	float lodA1 = lod0 * gridMinorSize;
 	float lodA2 = lodA1 * gridMinorSize;
 
@@ -68,3 +60,18 @@ vec4 gridColor(vec2 uv, vec2 camPos)
 	return c;
 }
 
+vec4 gridColor(vec2 uv, vec2 camPos)
+{
+	vec2 dudv = vec2(
+		length(vec2(dFdx(uv.x), dFdy(uv.x))),
+		length(vec2(dFdx(uv.y), dFdy(uv.y)))
+	);
+
+	float lodLevel = max(0.0, log10((length(dudv) * gridMinPixelsBetweenCells) / gridMajorSize) + 1.0);
+	float lodFade = fract(lodLevel);
+
+	// cell size for lod0
+	float lod0 = gridMajorSize * pow(10.0, floor(lodLevel));
+
+	return gridColorLod(uv, camPos, dudv, lod0, lodFade);
+}
@@ -0,0 +1,75 @@
+#type vertex
+#version 460 core
+
+// Variants: GRID_LABELS draws one quad per axis label, otherwise one instanced line per visible grid line.
+// Nothing is read from vertex buffers, lines and labels are placed from their index.
+
+#include <Resources/Shaders/GLBufferDeclarations.h>
+#include <Resources/Shaders/GridParameters.h>
+
+// Index of the first line along x and y (multiples of u_Spacing), then the line counts along x and y
+layout(location = 0) uniform vec4 u_Lines;
+// Visible world rectangle (xmin, ymin, xmax, ymax)
+layout(location = 1) uniform vec4 u_Bounds;
+layout(location = 2) uniform float u_Spacing;
+
+#ifdef GRID_LABELS
+layout(location = 3) uniform float u_FontSize;
+
+layout (location=0) out vec2 v_Text;
+layout (location=1) out flat float v_Value;
+#else
+// Every u_MajorEvery-th line is thick, the thin ones fade out as they get closer together
+layout(location = 3) uniform float u_MajorEvery;
+layout(location = 4) uniform float u_MinorAlpha;
+
+layout (location=0) out vec4 v_Color;
+#endif
+
+void main()
+{
+#ifdef GRID_LABELS
+	int label = gl_VertexID / 6;
+	int corner = indices[gl_VertexID % 6];
+	bool xAxis = label < int(u_Lines.z);
+	float value = (xAxis ? u_Lines.x + label : u_Lines.y + label - u_Lines.z) * u_Spacing;
+	vec2 position = xAxis ? vec2(value, 0.0) : vec2(0.0, value);
+
+	// Text space of pFloat, the minus sign starts at x -0.5 and the last decimal ends at 5
+	v_Text = vec2(corner == 0 || corner == 3 ? -0.5 : 5.0, corner < 2 ? 0.0 : 1.0);
+	v_Value = value;
+	gl_Position = ubo.projViewMatrix * vec4(position + v_Text * u_FontSize / 32.0, 0.0, 1.0);
+#else
+	bool vertical = gl_InstanceID < int(u_Lines.z);
+	float index = vertical ? u_Lines.x + gl_InstanceID : u_Lines.y + gl_InstanceID - u_Lines.z;
+	float coord = index * u_Spacing;
+	vec2 position = vertical ? vec2(coord, gl_VertexID == 0 ? u_Bounds.y : u_Bounds.w)
+	                         : vec2(gl_VertexID == 0 ? u_Bounds.x : u_Bounds.z, coord);
+
+	v_Color = mod(index, u_MajorEvery) < 0.5 ? gridColorThick : vec4(gridColorThin.rgb, gridColorThin.a * u_MinorAlpha);
+	gl_Position = ubo.projViewMatrix * vec4(position, 0.0, 1.0);
+#endif
+}
+
+#type fragment
+#version 460 core
+
+#ifdef GRID_LABELS
+#include <Resources/Shaders/Text.h>
+
+layout (location=0) in vec2 v_Text;
+layout (location=1) in flat float v_Value;
+#else
+layout (location=0) in vec4 v_Color;
+#endif
+
+layout (location=0) out vec4 out_FragColor;
+
+void main()
+{
+#ifdef GRID_LABELS
+	out_FragColor = pFloat(v_Text, v_Value).xxxx;
+#else
+	out_FragColor = v_Color;
+#endif
+}
@@ -3,21 +3,36 @@
 
 #include <Resources/Shaders/GridParameters.h>
 
+// Specialization constant 0: seed from the selection buffer bound to unit 2 instead of filling the whole target
+layout(constant_id = 0) const bool SAMPLE_SELECTION = false;
+
+layout(location = 0) out vec2 UV;
 
 void main()
 {
 	int idx = indices[gl_VertexID];
+	vec4 pos = vec4(pos2D[idx], 1.0);
+	UV = tex[idx];
 
-	gl_Position = vec4(pos2D[idx], 1.0);
+	gl_Position = pos;
 }
 
 #type fragment
 #version 450 core
 
+layout(constant_id = 0) const bool SAMPLE_SELECTION = false;
+
+layout(location = 0) in vec2 UV;
+
+layout(binding = 2) uniform sampler2D tex;
+
 layout(location = 0) out vec4 FragColor;
 
+
 void main()
 {
-
-	FragColor = vec4(1);
+	if (SAMPLE_SELECTION)
+		FragColor = texture(tex, UV);
+	else
+		FragColor = vec4(1);
 }
\ No newline at end of file
@@ -1,19 +1,32 @@
 #type vertex
 #version 450 core
+// PULL_LINES reads line records instead of vertex attributes
+#ifndef PULL_LINES
 layout(location = 0) in int aID;
 layout(location = 1) in vec3 aPos;
 layout(location = 2) in vec4 aColor;
+#endif
 
 layout(location = 0) out vec4 vColor;
 layout(location = 1) out flat int  FragID;
 
 #include <Resources/Shaders/GLBufferDeclarations.h>
+#ifdef PULL_LINES
+#include <Resources/Shaders/PulledPrimitives.h>
+#endif
 
 void main()
 {
+#ifdef PULL_LINES
+    LineRecord line = in_Lines[gl_VertexID / 2];
+    FragID = line.id;
+    gl_Position = ubo.projViewMatrixRTE * vec4(PullLinePosition(line, gl_VertexID), 1.0);
+    vColor = line.color;
+#else
     FragID = aID;
-    gl_Position = ubo.projViewMatrix * vec4(aPos, 1.0);
+    gl_Position = ubo.projViewMatrixRTE * vec4(aPos, 1.0);
     vColor = aColor;
+#endif
 }
 
 #type fragment
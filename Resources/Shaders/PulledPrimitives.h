@@ -0,0 +1,88 @@
+// Primitive records read by the vertex pulling shaders, one record per quad, circle or line. There is no vertex
+// input, the draw is glDrawArrays over an empty vertex array and gl_VertexID picks the record and its corner:
+// 6 vertices per quad and circle (two triangles), 2 per line. Layouts match the records in BatchRenderer.cpp.
+// Positions are relative to the render origin slot of the record (in_RenderOrigins of GLBufferDeclarations.h),
+// slot 0 is the eye itself.
+#define SSBO_PULLED_QUADS 3
+#define SSBO_PULLED_CIRCLES 4
+#define SSBO_PULLED_LINES 5
+
+struct QuadRecord
+{
+	vec3 p0;
+	int id;
+	vec3 p1;
+	int origin;
+	vec3 p2;
+	float _pad1;
+	vec3 p3;
+	float _pad2;
+	vec4 color;
+};
+
+struct CircleRecord
+{
+	vec3 center;
+	float radius;
+	vec4 color;
+	int id;
+	int origin;
+	float _pad0;
+	float _pad1;
+};
+
+struct LineRecord
+{
+	vec3 from;
+	int id;
+	vec3 to;
+	int origin;
+	vec4 color;
+};
+
+layout(std430, binding = SSBO_PULLED_QUADS) restrict readonly buffer PulledQuads
+{
+	QuadRecord in_Quads[];
+};
+
+layout(std430, binding = SSBO_PULLED_CIRCLES) restrict readonly buffer PulledCircles
+{
+	CircleRecord in_Circles[];
+};
+
+layout(std430, binding = SSBO_PULLED_LINES) restrict readonly buffer PulledLines
+{
+	LineRecord in_Lines[];
+};
+
+// Corner of each of the 6 vertices, the same 0 1 2 / 2 3 0 split the quad index buffer used
+const int PulledQuadCorners[6] = int[6](0, 1, 2, 2, 3, 0);
+// Circle corners as offsets from the center in radii, counter clockwise from the bottom left
+const vec2 PulledCircleOffsets[4] = vec2[4](vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0));
+
+vec3 PullQuadPosition(QuadRecord quad, int vertex)
+{
+	vec3 origin = in_RenderOrigins[quad.origin].xyz;
+	switch (PulledQuadCorners[vertex % 6])
+	{
+		case 0:  return origin + quad.p0;
+		case 1:  return origin + quad.p1;
+		case 2:  return origin + quad.p2;
+		default: return origin + quad.p3;
+	}
+}
+
+vec3 PullCircleCenter(CircleRecord circle)
+{
+	return in_RenderOrigins[circle.origin].xyz + circle.center;
+}
+
+vec3 PullCirclePosition(CircleRecord circle, int vertex)
+{
+	return PullCircleCenter(circle) + vec3(PulledCircleOffsets[PulledQuadCorners[vertex % 6]] * circle.radius, 0.0);
+}
+
+vec3 PullLinePosition(LineRecord line, int vertex)
+{
+	return in_RenderOrigins[line.origin].xyz + ((vertex & 1) == 0 ? line.from : line.to);
+}
@@ -0,0 +1,65 @@
+#type vertex
+#version 450 core
+layout(location = 0) in vec3 a_Position;
+layout(location = 1) in vec4 a_Color;
+layout(location = 2) in vec2 a_TexCoord;
+layout(location = 3) in vec4 a_TexRect;
+layout(location = 4) in float a_TexLayer;
+layout(location = 5) in float a_TilingFactor;
+layout(location = 6) in int a_EntityID;
+
+layout(std140, binding = 3) uniform Camera
+{
+    mat4 u_ViewProjection;
+};
+
+layout(location = 0) out vec4 v_Color;
+layout(location = 1) out vec2 v_TexCoord;
+layout(location = 2) out flat vec4 v_TexRect;
+layout(location = 3) out flat float v_TexLayer;
+layout(location = 4) out flat float v_TilingFactor;
+layout(location = 5) out flat int v_EntityID;
+
+void main()
+{
+    v_Color = a_Color;
+    v_TexCoord = a_TexCoord;
+    v_TexRect = a_TexRect;
+    v_TexLayer = a_TexLayer;
+    v_TilingFactor = a_TilingFactor;
+    v_EntityID = a_EntityID;
+    gl_Position = u_ViewProjection * vec4(a_Position, 1.0);
+}
+
+#type fragment
+#version 450 core
+
+layout(location = 0) in vec4 v_Color;
+layout(location = 1) in vec2 v_TexCoord;
+layout(location = 2) in flat vec4 v_TexRect;
+layout(location = 3) in flat float v_TexLayer;
+layout(location = 4) in flat float v_TilingFactor;
+layout(location = 5) in flat int v_EntityID;
+
+// Texture array atlas, every texture of the batch is a rect in one of its layers
+layout(binding = 0) uniform sampler2DArray u_Atlas;
+
+layout(location = 0) out vec4 o_Color;
+layout(location = 1) out int o_EntityID;
+
+void main()
+{
+    vec4 color = v_Color;
+    if (v_TexLayer >= 0.0)
+    {
+        // Tiling wraps inside the rect, hardware repeat would run into the neighbouring textures
+        vec2 local = v_TilingFactor == 1.0 ? v_TexCoord : fract(v_TexCoord * v_TilingFactor);
+        color *= texture(u_Atlas, vec3(mix(v_TexRect.xy, v_TexRect.zw, local), v_TexLayer));
+    }
+
+    if (color.a == 0.0)
+        discard;
+
+    o_Color = color;
+    o_EntityID = v_EntityID;
+}
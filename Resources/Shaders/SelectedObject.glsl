@@ -1,16 +1,48 @@
 #type vertex
 #version 450 core
+// PULL_QUADS, PULL_CIRCLES or PULL_LINES mask the records of that family instead of vertex attributes,
+// RENDER_ORIGINS masks the stored meshes whose positions are relative to their origin
+#if defined(PULL_QUADS) || defined(PULL_CIRCLES) || defined(PULL_LINES)
+#define PULLED
+#endif
+
+#ifndef PULLED
 layout(location = 0) in int aID;
 layout(location = 1) in vec3 aPos;
+#endif
+#ifdef RENDER_ORIGINS
+layout(location = 4) in int aOrigin;
+#endif
 
 layout(location = 0) out flat int  FragID;
 
 #include <Resources/Shaders/GLBufferDeclarations.h>
+#ifdef PULLED
+#include <Resources/Shaders/PulledPrimitives.h>
+#endif
 
 void main()
 {
+#if defined(PULL_QUADS)
+    QuadRecord quad = in_Quads[gl_VertexID / 6];
+    FragID = quad.id;
+    gl_Position = ubo.projViewMatrixRTE * vec4(PullQuadPosition(quad, gl_VertexID), 1.0);
+#elif defined(PULL_CIRCLES)
+    CircleRecord circle = in_Circles[gl_VertexID / 6];
+    FragID = circle.id;
+    gl_Position = ubo.projViewMatrixRTE * vec4(PullCirclePosition(circle, gl_VertexID), 1.0);
+#elif defined(PULL_LINES)
+    LineRecord line = in_Lines[gl_VertexID / 2];
+    FragID = line.id;
+    gl_Position = ubo.projViewMatrixRTE * vec4(PullLinePosition(line, gl_VertexID), 1.0);
+#else
     FragID = aID;
-    gl_Position = ubo.projViewMatrix * vec4(aPos, 1.0);
+#ifdef RENDER_ORIGINS
+    gl_Position = ubo.projViewMatrixRTE * vec4(aPos + in_RenderOrigins[aOrigin].xyz, 1.0);
+#else
+    gl_Position = ubo.projViewMatrixRTE * vec4(aPos, 1.0);
+#endif
+#endif
 }
 
 #type fragment